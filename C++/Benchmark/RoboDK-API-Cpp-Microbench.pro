@@ -0,0 +1,27 @@
+#-------------------------------------------------
+#
+# Microbenchmarks for the hot paths of the RoboDK C++ API.
+# Network benchmarks run against the in-process mock server (../MockServer),
+# RoboDK does not need to be installed or running.
+# Results are written as JSON: RoboDK-API-Cpp-Microbench -o results.json
+#
+#-------------------------------------------------
+
+QT       += core gui
+QT += network
+
+TARGET = RoboDK-API-Cpp-Microbench
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../MockServer/robodk_mock.pri)
+
+SOURCES += \
+        bench_micro.cpp \
+    ../Example/robodk_api.cpp
+
+HEADERS += \
+    ../Example/robodk_api.h
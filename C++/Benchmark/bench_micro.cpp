@@ -0,0 +1,303 @@
+// Microbenchmarks for the hot paths of the RoboDK C++ API (robodk_api.cpp):
+// - Mat compose, inverse, ToXYZRPW and XYZRPW_2_Mat
+// - tJoints construction, ToString and FromString
+// - Matrix2D_Set_Size and Matrix2D_Add growth
+// - _send_Matrix2D and _recv_Matrix2D serialization (AddShape and InstructionListJoints, with a new or a reused matrix) against a loopback peer
+// - round trips of single commands against a local stub
+// The loopback peer is the in-process RoboDKMock, RoboDK does not need to be installed or running.
+//
+// Results are written as JSON so they can be compared release over release:
+// {"suite":"robodk_api", "qt":"5.x.y", "build":"release", "min_time_s":0.5, "results":[{"name":..., "iterations":..., "ns_per_op":..., "mb_per_s":...}, ...]}
+// Progress is reported on stderr.
+//
+// Usage: RoboDK-API-Cpp-Microbench [-o results.json] [-t min_time_s] [-f name_filter]
+
+#include "robodk_api.h"
+#include "robodk_mock.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <cstdio>
+
+#ifndef RDK_SKIP_NAMESPACE
+using namespace RoboDK_API;
+#endif
+
+
+/// Result of one benchmark
+struct tBenchResult {
+    QString name;
+    qint64 iterations;
+    double ns_per_op;
+
+    /// Bytes transferred per operation (0 if not relevant)
+    double bytes_per_op;
+};
+
+
+/// <summary>
+/// Runs the benchmarks and collects the results.
+/// Each benchmark is repeated until it runs for at least the minimum time, so fast and slow operations get comparable accuracy.
+/// </summary>
+class BenchSuite {
+public:
+    BenchSuite() : MinTime(0.5), Sink(0.0) {}
+
+    /// Minimum measured time per benchmark (s)
+    double MinTime;
+
+    /// Only run the benchmarks that contain this text (all if empty)
+    QString Filter;
+
+    /// Results in the order they were run
+    QList<tBenchResult> Results;
+
+    /// Values computed by the benchmarks, so the compiler can not remove them
+    volatile double Sink;
+
+    template<class F>
+    void Run(const QString &name, F op, double bytes_per_op = 0.0){
+        if (!Filter.isEmpty() && !name.contains(Filter)){
+            return;
+        }
+        op(); // warm up
+        QElapsedTimer timer;
+        qint64 niter = 1;
+        forever {
+            timer.start();
+            for (qint64 i=0; i<niter; i++){
+                op();
+            }
+            qint64 ns = timer.nsecsElapsed();
+            if (ns >= MinTime * 1e9 || niter >= (Q_INT64_C(1) << 32)){
+                tBenchResult result;
+                result.name = name;
+                result.iterations = niter;
+                result.ns_per_op = (double) ns / niter;
+                result.bytes_per_op = bytes_per_op;
+                Results.append(result);
+                fprintf(stderr, "%-40s %12lld %14.1f ns/op\n", name.toUtf8().constData(), niter, result.ns_per_op);
+                return;
+            }
+            // aim 20% above the minimum time with the rate measured so far
+            if (ns < 1000000){
+                niter *= 10;
+            } else {
+                niter = qMax(niter * 2, (qint64) (niter * MinTime * 1.2e9 / ns));
+            }
+        }
+    }
+
+    QString Json() const {
+#ifdef QT_NO_DEBUG
+        const char *build = "release";
+#else
+        const char *build = "debug";
+#endif
+        QString json = QString("{\"suite\":\"robodk_api\",\"qt\":\"%1\",\"build\":\"%2\",\"min_time_s\":%3,\"results\":[")
+                .arg(qVersion()).arg(build).arg(MinTime);
+        for (int i=0; i<Results.length(); i++){
+            const tBenchResult &result = Results[i];
+            json.append(i == 0 ? "\n" : ",\n");
+            // the name is concatenated so that % markers in it are not replaced by arg
+            json.append("{\"name\":\"" + result.name + "\"");
+            json.append(QString(",\"iterations\":%1,\"ns_per_op\":%2").arg(result.iterations).arg(result.ns_per_op, 0, 'f', 2));
+            if (result.bytes_per_op > 0){
+                json.append(QString(",\"mb_per_s\":%1").arg(result.bytes_per_op * 1e3 / result.ns_per_op, 0, 'f', 2));
+            }
+            json.append("}");
+        }
+        json.append("\n]}\n");
+        return json;
+    }
+};
+
+
+static void BenchMat(BenchSuite &suite){
+    Mat a = Mat::XYZRPW_2_Mat(100, 200, 300, 10, 20, 30);
+    Mat b = Mat::XYZRPW_2_Mat(-50, 25, 400, -45, 5, 90);
+    suite.Run("mat/compose", [&](){
+        Mat c = a * b;
+        suite.Sink = suite.Sink + c.Get(0, 3);
+    });
+    suite.Run("mat/inv", [&](){
+        Mat c = a.inv();
+        suite.Sink = suite.Sink + c.Get(0, 3);
+    });
+    suite.Run("mat/ToXYZRPW", [&](){
+        tXYZWPR xyzwpr;
+        a.ToXYZRPW(xyzwpr);
+        suite.Sink = suite.Sink + xyzwpr[5];
+    });
+    double x = 100.0;
+    suite.Run("mat/XYZRPW_2_Mat", [&](){
+        Mat c = Mat::XYZRPW_2_Mat(x, 200, 300, 10, 20, 30);
+        suite.Sink = suite.Sink + c.Get(0, 3);
+    });
+}
+
+
+static void BenchJoints(BenchSuite &suite){
+    const double values[6] = { 10.5, -20.25, 30.125, -40.0, 50.75, -60.5 };
+    suite.Run("joints/construct", [&](){
+        tJoints joints(values, 6);
+        suite.Sink = suite.Sink + joints.Length();
+    });
+    tJoints joints(values, 6);
+    suite.Run("joints/ToString", [&](){
+        QString str = joints.ToString();
+        suite.Sink = suite.Sink + str.length();
+    });
+    QString str = joints.ToString(", ", 6);
+    suite.Run("joints/FromString", [&](){
+        tJoints parsed;
+        parsed.FromString(str);
+        suite.Sink = suite.Sink + parsed.Length();
+    });
+}
+
+
+static void BenchMatrix2D(BenchSuite &suite){
+    const int ncols = 1000;
+    const double column[6] = { 1, 2, 3, 4, 5, 6 };
+    suite.Run("matrix2d/Set_Size_6x1000", [&](){
+        tMatrix2D *mat = Matrix2D_Create();
+        for (int i=1; i<=ncols; i++){
+            Matrix2D_Set_Size(mat, 6, i);
+        }
+        suite.Sink = suite.Sink + Matrix2D_Get_ncols(mat);
+        Matrix2D_Delete(&mat);
+    });
+    suite.Run("matrix2d/Add_6x1000", [&](){
+        tMatrix2D *mat = Matrix2D_Create();
+        Matrix2D_Set_Size(mat, 6, 0);
+        for (int i=0; i<ncols; i++){
+            Matrix2D_Add(mat, column, 6);
+        }
+        suite.Sink = suite.Sink + Matrix2D_Get_ncols(mat);
+        Matrix2D_Delete(&mat);
+    });
+}
+
+
+static void BenchLink(BenchSuite &suite, RoboDKMock &mock, RoboDK &rdk){
+    // _send_Matrix2D: triangles sent with AddShape
+    const int send_cols[2] = { 1000, 100000 };
+    for (int s=0; s<2; s++){
+        tMatrix2D *triangles = Matrix2D_Create();
+        Matrix2D_Set_Size(triangles, 3, send_cols[s]);
+        for (int i=0; i<3*send_cols[s]; i++){
+            triangles->data[i] = i * 0.01;
+        }
+        suite.Run(QString("link/send_Matrix2D_3x%1").arg(send_cols[s]), [&](){
+            Item shape = rdk.AddShape(triangles);
+            suite.Sink = suite.Sink + shape.Valid();
+        }, 3.0 * send_cols[s] * sizeof(double));
+        Matrix2D_Delete(&triangles);
+    }
+
+    // _recv_Matrix2D: joint list returned by InstructionListJoints, in a new matrix for every call (alloc) or in a matrix provided by the caller
+    Item prog(&rdk, 1, RoboDK::ITEM_TYPE_PROGRAM);
+    const int recv_cols[3] = { 1000, 10000, 100000 };
+    for (int s=0; s<3; s++){
+        mock.setJointListSize(10, recv_cols[s]);
+        QString error_msg;
+        suite.Run(QString("link/recv_Matrix2D_alloc_10x%1").arg(recv_cols[s]), [&](){
+            tMatrix2D *joint_list = nullptr;
+            suite.Sink = suite.Sink + prog.InstructionListJoints(error_msg, &joint_list);
+            Matrix2D_Delete(&joint_list);
+        }, 10.0 * recv_cols[s] * sizeof(double));
+        tMatrix2D *joint_list = Matrix2D_Create();
+        Matrix2D_Set_Size(joint_list, 10, recv_cols[s]);
+        suite.Run(QString("link/recv_Matrix2D_10x%1").arg(recv_cols[s]), [&](){
+            suite.Sink = suite.Sink + prog.InstructionListJointsInto(error_msg, joint_list);
+        }, 10.0 * recv_cols[s] * sizeof(double));
+        Matrix2D_Delete(&joint_list);
+    }
+}
+
+
+static void BenchRoundTrip(BenchSuite &suite, RoboDK &rdk){
+    Item robot = rdk.getItem("Robot");
+    if (!robot.Valid()){
+        fprintf(stderr, "The robot of the mock server was not found\n");
+        return;
+    }
+    tJoints joints = robot.Joints();
+    Mat pose = robot.SolveFK(joints);
+    suite.Run("roundtrip/getItem", [&](){
+        suite.Sink = suite.Sink + rdk.getItem("Robot").Valid();
+    });
+    suite.Run("roundtrip/Pose", [&](){
+        suite.Sink = suite.Sink + robot.Pose().Get(0, 3);
+    });
+    suite.Run("roundtrip/setPose", [&](){
+        robot.setPose(pose);
+    });
+    suite.Run("roundtrip/Joints", [&](){
+        suite.Sink = suite.Sink + robot.Joints().Length();
+    });
+    suite.Run("roundtrip/setJoints", [&](){
+        robot.setJoints(joints);
+    });
+    suite.Run("roundtrip/SolveFK", [&](){
+        suite.Sink = suite.Sink + robot.SolveFK(joints).Get(0, 3);
+    });
+    suite.Run("roundtrip/SolveIK", [&](){
+        suite.Sink = suite.Sink + robot.SolveIK(pose).Length();
+    });
+}
+
+
+int main(int argc, char *argv[]){
+    QCoreApplication app(argc, argv);
+    BenchSuite suite;
+    QString output;
+    QStringList args = app.arguments();
+    for (int i=1; i<args.length(); i++){
+        if (args[i] == "-o" && i+1 < args.length()){
+            output = args[++i];
+        } else if (args[i] == "-t" && i+1 < args.length()){
+            suite.MinTime = args[++i].toDouble();
+        } else if (args[i] == "-f" && i+1 < args.length()){
+            suite.Filter = args[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [-o results.json] [-t min_time_s] [-f name_filter]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    BenchMat(suite);
+    BenchJoints(suite);
+    BenchMatrix2D(suite);
+
+    RoboDKMock mock;
+    mock.AddItem("Robot", RoboDK::ITEM_TYPE_ROBOT, QVector<double>(6, 10.0));
+    if (!mock.Listen()){
+        fprintf(stderr, "Could not start the mock server\n");
+        return 1;
+    }
+    RoboDK rdk("127.0.0.1", mock.Port());
+    if (!rdk.Connected()){
+        fprintf(stderr, "Could not connect to the mock server\n");
+        return 1;
+    }
+    // round trips first: every AddShape adds an item to the mock station
+    BenchRoundTrip(suite, rdk);
+    BenchLink(suite, mock, rdk);
+    rdk.Disconnect();
+    mock.Close();
+
+    QByteArray json = suite.Json().toUtf8();
+    if (output.isEmpty()){
+        fwrite(json.constData(), 1, json.size(), stdout);
+    } else {
+        QFile file(output);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()){
+            fprintf(stderr, "Could not write %s\n", output.toUtf8().constData());
+            return 1;
+        }
+        fprintf(stderr, "Results saved to %s\n", output.toUtf8().constData());
+    }
+    return 0;
+}
@@ -32,11 +32,13 @@ MainWindow::MainWindow(QWidget *parent) :
     if (!RDK->Connected()){
         qDebug() << "Failed to start RoboDK API!!";
     }
+    RDK_ASYNC = new RoboDKAsync(RDK, this);
 
 }
 
 MainWindow::~MainWindow() {
     robodk_window_clear();
+    delete RDK_ASYNC;
     RDK->CloseRoboDK();
     delete ui;
     delete RDK;
@@ -126,7 +128,8 @@ void MainWindow::on_btnMoveJoints_clicked(){
 
     bool blocking = true;
 
-    ROBOT->MoveJ(joints, blocking);
+    // the movement runs in the background: the window stays responsive
+    MOVE_PENDING = RDK_ASYNC->MoveJ(*ROBOT, joints, blocking);
 
 }
 
@@ -139,7 +142,7 @@ void MainWindow::on_btnMovePose_clicked(){
 
     bool blocking = true;
 
-    ROBOT->MoveJ(pose, blocking);
+    MOVE_PENDING = RDK_ASYNC->MoveJ(*ROBOT, pose, blocking);
 
 }
 
@@ -148,7 +151,7 @@ void MainWindow::on_btnProgRun_clicked(){
 
     QString program_name = ui->txtProgName->text();
 
-    RDK->RunProgram(program_name);
+    RDK_ASYNC->RunProgram(program_name);
 }
 
 // Example to run a second instance of the RoboDK api in parallel:
@@ -373,6 +376,12 @@ void MainWindow::IncrementalMove(int id, double sense){
         return;
     }
 
+    // the robot is still moving: the current pose is not the target of the previous move.
+    // Ignore the click so that steps do not add up on an intermediate pose or queue without limit.
+    if (!MOVE_PENDING.isFinished()){
+        return;
+    }
+
     // calculate the relative movement
     double step = sense * ui->spnStep->value();
 
@@ -393,7 +402,7 @@ void MainWindow::IncrementalMove(int id, double sense){
     // apply relative to the TCP:
     pose_robot_new = pose_robot * pose_increment;
 
-    ROBOT->MoveJ(pose_robot_new);
+    MOVE_PENDING = RDK_ASYNC->MoveJ(*ROBOT, pose_robot_new);
 
 }
 
@@ -79,6 +79,12 @@ private:
     /// Pointer to RoboDK
     RoboDK *RDK;
 
+    /// Asynchronous calls to RoboDK (movements do not block the user interface)
+    RoboDKAsync *RDK_ASYNC;
+
+    /// Last movement started from the panel (incremental moves wait until it finished)
+    QFuture<int> MOVE_PENDING;
+
     /// Pointer to the robot item
     Item *ROBOT;
 
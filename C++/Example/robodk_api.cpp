@@ -1,9 +1,53 @@
 #include "robodk_api.h"
 #include <QtNetwork/QTcpSocket>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QLocalSocket>
+#include <QtNetwork/QLocalServer>
 #include <QtCore/QProcess>
+#include <QtCore/QtEndian>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QVector>
+#include <QtCore/QFutureInterface>
+#include <QtCore/QSharedMemory>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFileInfo>
+#include <QtCore/QEventLoop>
+#include <QtCore/QTimer>
 #include <cmath>
 #include <algorithm>
+#include <climits>
+#include <cstring>
 #include <QFile>
+#ifndef RDK_SKIP_QTGUI
+#include <QtGui/QMatrix4x4>
+#endif
+
+// SIMD kernels to convert arrays of doubles to/from the byte order of the RoboDK protocol (big endian) and to multiply poses
+// Define ROBODK_API_NO_SIMD to build the scalar code only (for example to test it)
+#ifndef ROBODK_API_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ROBODK_API_SIMD_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+#define ROBODK_API_SIMD_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define ROBODK_API_SIMD_NEON
+#include <arm_neon.h>
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define ROBODK_API_SIMD_NEON64 // NEON with double precision vectors
+#endif
+#endif
+#endif
 
 
 #ifdef _WIN32
@@ -28,6 +72,35 @@
 #define ROBODK_API_READY_STRING "READY"
 #define ROBODK_API_LF "\n"
 
+// Trace recorded by RoboDK::StartCapture and served by RoboDKReplay: the magic string and the version (uint32), then records of
+// type (1 byte), size (uint32) and data. Integers are big endian like the RoboDK protocol.
+#define ROBODK_TRACE_MAGIC "RDKTRACE"
+#define ROBODK_TRACE_VERSION 1
+#define ROBODK_TRACE_COMMAND 'C'  // name of the command (first line sent by an API call)
+#define ROBODK_TRACE_SEND 'S'     // bytes sent to RoboDK
+#define ROBODK_TRACE_RECV 'R'     // bytes received from RoboDK
+
+#define ROBODK_API_SEND_BUFFER_SIZE 1024 // initial capacity of the send buffer (grows as needed)
+#define ROBODK_API_PIPELINE_FLUSH_SIZE 65536 // in pipelined mode, write the send buffer once it holds this many bytes
+#define ROBODK_API_FK_BLOCK 8 // number of joint vectors evaluated together by Kinematics::SolveFK
+#define ROBODK_API_FK_CHUNK 1024 // minimum number of joint vectors given to a thread by Kinematics::SolveFK
+#define ROBODK_API_IK_CHUNK 256 // minimum number of poses given to a thread by Kinematics::SolveIK
+#define ROBODK_API_IK_REMOTE_GROUP 256 // number of G_IK_cmpl requests sent at once by Item::SolveIK_All
+#define ROBODK_API_RMAP_CHUNK 8192 // number of poses solved at once to build a ReachabilityMap
+#define ROBODK_API_FK_STEP 90.0 // joint step used to retrieve the kinematics of a robot (deg or mm)
+#define ROBODK_API_FK_TOLERANCE 1e-9 // maximum error of the local kinematics (relative to the pose values)
+#define ROBODK_API_IK_TOLERANCE 1e-3 // maximum joint error (deg) of the local inverse kinematics compared to RoboDK (it only has to tell the solution branches apart, RoboDK may round the joints it returns)
+#define ROBODK_API_CANCEL_POLL 20 // interval to check the cancellation token while waiting for RoboDK (ms)
+#define ROBODK_API_PROBE_TIMEOUT 250 // connection timeout of each probe while RoboDK starts (ms)
+#define ROBODK_API_PROBE_DELAY_MIN 10 // first delay between probes while RoboDK starts (doubled after each probe, ms)
+#define ROBODK_API_PROBE_DELAY_MAX 500 // maximum delay between probes while RoboDK starts (ms)
+#define ROBODK_API_START_TIMEOUT 120000 // maximum time to wait for RoboDK to start (ms)
+#define ROBODK_API_LOCAL_NAME "RoboDK_API_" // prefix of the local server name of LocalTransport and SharedMemoryTransport (followed by the port)
+#define ROBODK_API_SHM_STRING "RDK_SHM" // first line sent by SharedMemoryTransport to a RoboDKRelay, followed by the shared memory key
+#define ROBODK_API_SHM_SPIN 2000 // polls of a ring buffer before sleeping until the peer wakes the reader through the control socket
+#define ROBODK_API_SHM_SLEEP_US 20 // sleep between polls of a full ring buffer once spinning failed (us)
+#define ROBODK_API_SHM_STOP_POLL 100 // interval to check if an idle relay thread must stop (ms)
+
 
 
 #define M_PI 3.14159265358979323846264338327950288
@@ -48,6 +121,10 @@ tJoints::tJoints(int ndofs){
 tJoints::tJoints(const tJoints &copy){
     SetValues(copy._Values, copy._nDOFs);
 }
+tJoints &tJoints::operator=(const tJoints &copy){
+    SetValues(copy._Values, copy._nDOFs);
+    return *this;
+}
 tJoints::tJoints(const double *joints, int ndofs){
     SetValues(joints, ndofs);
 }
@@ -186,37 +263,61 @@ Mat rotz(double rz){
     return Mat::rotz(rz);
 }
 
-Mat::Mat() : QMatrix4x4() {
+Mat::Mat() {
     _valid = true;
     setToIdentity();
 }
-Mat::Mat(bool valid) : QMatrix4x4() {
+Mat::Mat(bool valid) {
     _valid = valid;
     setToIdentity();
 }
 
-Mat::Mat(const QMatrix4x4 &matrix) : QMatrix4x4(matrix) {
-    // just copy
+#ifndef RDK_SKIP_QTGUI
+Mat::Mat(const QMatrix4x4 &matrix) {
+    // QMatrix4x4 is also stored in column-major order
+    const float *values = matrix.constData();
+    for (int i=0; i<16; i++){
+        _data[i] = values[i];
+    }
     _valid = true;
 }
-Mat::Mat(const Mat &matrix) : QMatrix4x4(matrix) {
+QMatrix4x4 Mat::toQMatrix4x4() const {
+    float values[16];
+    Values(values);
+    // the QMatrix4x4 constructor takes the values row by row
+    return QMatrix4x4(values).transposed();
+}
+Mat::operator QMatrix4x4() const {
+    return toQMatrix4x4();
+}
+#endif
+
+Mat::Mat(const Mat &matrix) {
     // just copy
+    memcpy(_data, matrix._data, sizeof(_data));
     _valid = matrix._valid;
 }
+Mat &Mat::operator=(const Mat &matrix) {
+    memcpy(_data, matrix._data, sizeof(_data));
+    _valid = matrix._valid;
+    return *this;
+}
 
-Mat::Mat(double nx, double ox, double ax, double tx, double ny, double oy, double ay, double ty, double nz, double oz, double az, double tz) :
-    QMatrix4x4(nx, ox, ax, tx, ny, oy, ay, ty, nz, oz, az, tz, 0,0,0,1)
-{
+Mat::Mat(double nx, double ox, double ax, double tx, double ny, double oy, double ay, double ty, double nz, double oz, double az, double tz) {
+    _data[0] = nx; _data[4] = ox; _data[8]  = ax; _data[12] = tx;
+    _data[1] = ny; _data[5] = oy; _data[9]  = ay; _data[13] = ty;
+    _data[2] = nz; _data[6] = oz; _data[10] = az; _data[14] = tz;
+    _data[3] = 0;  _data[7] = 0;  _data[11] = 0;  _data[15] = 1;
     _valid = true;
 }
-Mat::Mat(const double v[16]) :
-    QMatrix4x4(v[0], v[4], v[8], v[12], v[1], v[5], v[9], v[13], v[2], v[6], v[10], v[14], v[3], v[7], v[11], v[15])
-{
+Mat::Mat(const double v[16]) {
+    memcpy(_data, v, sizeof(_data));
     _valid = true;
 }
-Mat::Mat(const float v[16]) :
-    QMatrix4x4(v[0], v[4], v[8], v[12], v[1], v[5], v[9], v[13], v[2], v[6], v[10], v[14], v[3], v[7], v[11], v[15])
-{
+Mat::Mat(const float v[16]) {
+    for (int i=0; i<16; i++){
+        _data[i] = v[i];
+    }
     _valid = true;
 }
 
@@ -291,23 +392,171 @@ void Mat::setPos(double xyz[3]){
 }
 
 void Mat::Set(int i, int j, double value){
-    QVector4D rw(this->row(i));
-    rw[j] = value;
-    setRow(i, rw);
-    // the following should not crash!!
-    //float **dt_ok = (float**) data();
-    //dt_ok[i][j] = value;
+    _data[j*4 + i] = value;
 }
 
 double Mat::Get(int i, int j) const{
-    return row(i)[j];
-    // the following hsould be allowed!!
-    //return ((const float**)data())[i][j];
+    return _data[j*4 + i];
+}
+
+double &Mat::operator()(int i, int j){
+    return _data[j*4 + i];
+}
+
+double Mat::operator()(int i, int j) const{
+    return _data[j*4 + i];
+}
+
+double *Mat::data(){
+    return _data;
+}
+
+const double *Mat::data() const{
+    return _data;
+}
+
+const double *Mat::constData() const{
+    return _data;
 }
 
+void Mat::setToIdentity(){
+    for (int i=0; i<16; i++){
+        _data[i] = (i % 5 == 0) ? 1.0 : 0.0;
+    }
+}
 
 Mat Mat::inv() const{
-    return this->inverted();
+    // rigid transformation: inv([R t; 0 1]) = [R' -R'*t; 0 1]
+    const double *m = _data;
+    Mat mat(m[0], m[1], m[2], -(m[0]*m[12] + m[1]*m[13] + m[2]*m[14]),
+            m[4], m[5], m[6], -(m[4]*m[12] + m[5]*m[13] + m[6]*m[14]),
+            m[8], m[9], m[10], -(m[8]*m[12] + m[9]*m[13] + m[10]*m[14]));
+    mat._valid = _valid;
+    return mat;
+}
+
+Mat Mat::inverted(bool *invertible) const{
+    // inverse given the adjugate matrix (cofactors)
+    const double *m = _data;
+    double r[16];
+    r[0] = m[5]*m[10]*m[15] - m[5]*m[11]*m[14] - m[9]*m[6]*m[15] + m[9]*m[7]*m[14] + m[13]*m[6]*m[11] - m[13]*m[7]*m[10];
+    r[4] = -m[4]*m[10]*m[15] + m[4]*m[11]*m[14] + m[8]*m[6]*m[15] - m[8]*m[7]*m[14] - m[12]*m[6]*m[11] + m[12]*m[7]*m[10];
+    r[8] = m[4]*m[9]*m[15] - m[4]*m[11]*m[13] - m[8]*m[5]*m[15] + m[8]*m[7]*m[13] + m[12]*m[5]*m[11] - m[12]*m[7]*m[9];
+    r[12] = -m[4]*m[9]*m[14] + m[4]*m[10]*m[13] + m[8]*m[5]*m[14] - m[8]*m[6]*m[13] - m[12]*m[5]*m[10] + m[12]*m[6]*m[9];
+    r[1] = -m[1]*m[10]*m[15] + m[1]*m[11]*m[14] + m[9]*m[2]*m[15] - m[9]*m[3]*m[14] - m[13]*m[2]*m[11] + m[13]*m[3]*m[10];
+    r[5] = m[0]*m[10]*m[15] - m[0]*m[11]*m[14] - m[8]*m[2]*m[15] + m[8]*m[3]*m[14] + m[12]*m[2]*m[11] - m[12]*m[3]*m[10];
+    r[9] = -m[0]*m[9]*m[15] + m[0]*m[11]*m[13] + m[8]*m[1]*m[15] - m[8]*m[3]*m[13] - m[12]*m[1]*m[11] + m[12]*m[3]*m[9];
+    r[13] = m[0]*m[9]*m[14] - m[0]*m[10]*m[13] - m[8]*m[1]*m[14] + m[8]*m[2]*m[13] + m[12]*m[1]*m[10] - m[12]*m[2]*m[9];
+    r[2] = m[1]*m[6]*m[15] - m[1]*m[7]*m[14] - m[5]*m[2]*m[15] + m[5]*m[3]*m[14] + m[13]*m[2]*m[7] - m[13]*m[3]*m[6];
+    r[6] = -m[0]*m[6]*m[15] + m[0]*m[7]*m[14] + m[4]*m[2]*m[15] - m[4]*m[3]*m[14] - m[12]*m[2]*m[7] + m[12]*m[3]*m[6];
+    r[10] = m[0]*m[5]*m[15] - m[0]*m[7]*m[13] - m[4]*m[1]*m[15] + m[4]*m[3]*m[13] + m[12]*m[1]*m[7] - m[12]*m[3]*m[5];
+    r[14] = -m[0]*m[5]*m[14] + m[0]*m[6]*m[13] + m[4]*m[1]*m[14] - m[4]*m[2]*m[13] - m[12]*m[1]*m[6] + m[12]*m[2]*m[5];
+    r[3] = -m[1]*m[6]*m[11] + m[1]*m[7]*m[10] + m[5]*m[2]*m[11] - m[5]*m[3]*m[10] - m[9]*m[2]*m[7] + m[9]*m[3]*m[6];
+    r[7] = m[0]*m[6]*m[11] - m[0]*m[7]*m[10] - m[4]*m[2]*m[11] + m[4]*m[3]*m[10] + m[8]*m[2]*m[7] - m[8]*m[3]*m[6];
+    r[11] = -m[0]*m[5]*m[11] + m[0]*m[7]*m[9] + m[4]*m[1]*m[11] - m[4]*m[3]*m[9] - m[8]*m[1]*m[7] + m[8]*m[3]*m[5];
+    r[15] = m[0]*m[5]*m[10] - m[0]*m[6]*m[9] - m[4]*m[1]*m[10] + m[4]*m[2]*m[9] + m[8]*m[1]*m[6] - m[8]*m[2]*m[5];
+    double det = m[0]*r[0] + m[1]*r[4] + m[2]*r[8] + m[3]*r[12];
+    if (det == 0.0){
+        if (invertible != nullptr){
+            *invertible = false;
+        }
+        return Mat();
+    }
+    if (invertible != nullptr){
+        *invertible = true;
+    }
+    double inv_det = 1.0 / det;
+    for (int i=0; i<16; i++){
+        r[i] *= inv_det;
+    }
+    Mat mat(r);
+    mat._valid = _valid;
+    return mat;
+}
+
+Mat Mat::operator*(const Mat &mat) const{
+    Mat result(_valid && mat._valid);
+    const double *a = _data;
+    const double *b = mat._data;
+    double *c = result._data;
+    // column j of the result is the combination of the columns of a weighted by column j of b
+#if defined(ROBODK_API_SIMD_SSE2)
+    __m128d a0l = _mm_loadu_pd(a + 0),  a0h = _mm_loadu_pd(a + 2);
+    __m128d a1l = _mm_loadu_pd(a + 4),  a1h = _mm_loadu_pd(a + 6);
+    __m128d a2l = _mm_loadu_pd(a + 8),  a2h = _mm_loadu_pd(a + 10);
+    __m128d a3l = _mm_loadu_pd(a + 12), a3h = _mm_loadu_pd(a + 14);
+    for (int j=0; j<4; j++){
+        __m128d b0 = _mm_set1_pd(b[j*4 + 0]);
+        __m128d b1 = _mm_set1_pd(b[j*4 + 1]);
+        __m128d b2 = _mm_set1_pd(b[j*4 + 2]);
+        __m128d b3 = _mm_set1_pd(b[j*4 + 3]);
+        __m128d cl = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a0l, b0), _mm_mul_pd(a1l, b1)), _mm_add_pd(_mm_mul_pd(a2l, b2), _mm_mul_pd(a3l, b3)));
+        __m128d ch = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a0h, b0), _mm_mul_pd(a1h, b1)), _mm_add_pd(_mm_mul_pd(a2h, b2), _mm_mul_pd(a3h, b3)));
+        _mm_storeu_pd(c + j*4, cl);
+        _mm_storeu_pd(c + j*4 + 2, ch);
+    }
+#elif defined(ROBODK_API_SIMD_NEON64)
+    float64x2_t a0l = vld1q_f64(a + 0),  a0h = vld1q_f64(a + 2);
+    float64x2_t a1l = vld1q_f64(a + 4),  a1h = vld1q_f64(a + 6);
+    float64x2_t a2l = vld1q_f64(a + 8),  a2h = vld1q_f64(a + 10);
+    float64x2_t a3l = vld1q_f64(a + 12), a3h = vld1q_f64(a + 14);
+    for (int j=0; j<4; j++){
+        float64x2_t cl = vmulq_n_f64(a0l, b[j*4 + 0]);
+        float64x2_t ch = vmulq_n_f64(a0h, b[j*4 + 0]);
+        cl = vaddq_f64(cl, vmulq_n_f64(a1l, b[j*4 + 1]));
+        ch = vaddq_f64(ch, vmulq_n_f64(a1h, b[j*4 + 1]));
+        cl = vaddq_f64(cl, vmulq_n_f64(a2l, b[j*4 + 2]));
+        ch = vaddq_f64(ch, vmulq_n_f64(a2h, b[j*4 + 2]));
+        cl = vaddq_f64(cl, vmulq_n_f64(a3l, b[j*4 + 3]));
+        ch = vaddq_f64(ch, vmulq_n_f64(a3h, b[j*4 + 3]));
+        vst1q_f64(c + j*4, cl);
+        vst1q_f64(c + j*4 + 2, ch);
+    }
+#else
+    for (int j=0; j<4; j++){
+        for (int i=0; i<4; i++){
+            c[j*4 + i] = a[i]*b[j*4] + a[4 + i]*b[j*4 + 1] + a[8 + i]*b[j*4 + 2] + a[12 + i]*b[j*4 + 3];
+        }
+    }
+#endif
+    return result;
+}
+
+Mat &Mat::operator*=(const Mat &mat){
+    *this = *this * mat;
+    return *this;
+}
+
+bool Mat::operator==(const Mat &mat) const{
+    return memcmp(_data, mat._data, sizeof(_data)) == 0 && _valid == mat._valid;
+}
+
+bool Mat::operator!=(const Mat &mat) const{
+    return !(*this == mat);
+}
+
+void Mat::translate(double x, double y, double z){
+    for (int i=0; i<4; i++){
+        _data[12 + i] += _data[i]*x + _data[4 + i]*y + _data[8 + i]*z;
+    }
+}
+
+void Mat::rotate(double angle, double x, double y, double z){
+    double norm = sqrt(x*x + y*y + z*z);
+    if (norm == 0.0){
+        return;
+    }
+    x /= norm;
+    y /= norm;
+    z /= norm;
+    double a = angle * M_PI / 180.0;
+    double c = cos(a);
+    double s = sin(a);
+    double t = 1.0 - c;
+    Mat rot(t*x*x + c,   t*x*y - s*z, t*x*z + s*y, 0,
+            t*x*y + s*z, t*y*y + c,   t*y*z - s*x, 0,
+            t*x*z - s*y, t*y*z + s*x, t*z*z + c,   0);
+    *this *= rot;
 }
 
 bool Mat::isHomogeneous() const {
@@ -431,7 +680,7 @@ QString Mat::ToString(const QString &separator, int precision, bool xyzwpr_only)
     for (int i=0; i<4; i++){
         str.append("[");
         for (int j=0; j<4; j++){
-            str.append(QString::number(row(i)[j], 'f', precision));
+            str.append(QString::number(Get(i,j), 'f', precision));
             if (j < 3){
                 str.append(separator);
             }
@@ -479,45 +728,30 @@ Mat Mat::XYZRPW_2_Mat(tXYZWPR xyzwpr){
 
 void Mat::FromXYZRPW(tXYZWPR xyzwpr){
     Mat newmat = Mat::XYZRPW_2_Mat(xyzwpr[0], xyzwpr[1], xyzwpr[2], xyzwpr[3], xyzwpr[4], xyzwpr[5]);
-    for (int i=0; i<4; i++){
-        for (int j=0; j<4; j++){
-            this->Set(i,j, newmat.Get(i,j));
-        }
-    }
+    memcpy(_data, newmat._data, sizeof(_data));
 }
 
 const double* Mat::ValuesD() const {
-    double* _ddata16_non_const = (double*) _ddata16;
-    for(int i=0; i<16; ++i){
-        _ddata16_non_const[i] = constData()[i];
-    }
-    return _ddata16;
+    return _data;
 }
-const float* Mat::ValuesF() const {
-    return constData();
+void Mat::ValuesF(float values[16]) const {
+    Values(values);
 }
 
-#ifdef ROBODK_API_FLOATS
-const float* Mat::Values() const {
-    return constData();
-}
-#else
+#ifndef ROBODK_API_FLOATS
 const double* Mat::Values() const {
     return ValuesD();
 }
-
 #endif
 
 
 
 void Mat::Values(double data[16]) const{
-    for(int i=0; i<16; ++i){
-        data[i] = constData()[i];
-    }
+    memcpy(data, _data, sizeof(_data));
 }
 void Mat::Values(float data[16]) const{
     for(int i=0; i<16; ++i){
-        data[i] = constData()[i];
+        data[i] = (float) _data[i];
     }
 }
 bool Mat::Valid() const{
@@ -553,3168 +787,8025 @@ Mat Mat::rotz(double rz){
 
 
 //---------------------------------------------------------------------------------------------------
-//---------------------------------------------------------------------------------------------------
-//---------------------------------------------------------------------------------------------------
-//---------------------------------------------------------------------------------------------------
-/////////////////////////////////// Item CLASS ////////////////////////////////////////////////////
-Item::Item(RoboDK *rdk, quint64 ptr, qint32 type) {
-    _RDK = rdk;
-    _PTR = ptr;
-    _TYPE = type;
-}
-Item::Item(const Item &other) {
-    _RDK = other._RDK;
-    _PTR = other._PTR;
-    _TYPE = other._TYPE;
+/////////////////////////////////// Kinematics CLASS //////////////////////////////////////////////
+
+/// Shared state of a Kinematics::SolveFK or Kinematics::SolveIK call split among several threads.
+/// Each thread takes chunks of joint vectors (or poses) until all chunks are taken.
+struct tKinematicsBatch {
+    const Kinematics *kin;
+    bool ik;              // true to solve the inverse kinematics, false for the forward kinematics
+    const double *input;  // joint vectors (FK) or poses (IK)
+    int stride;           // distance between consecutive joint vectors (FK)
+    int count;
+    double *output;       // poses (FK) or joint solutions (IK)
+    int *nsolutions;
+    int *configs;
+    Mat tool;
+    Mat ref;
+    bool has_tool;
+    bool has_ref;
+    int chunk;
+    int nchunks;
+    QAtomicInt next;
+    QSemaphore done;
+};
+
+static void Kinematics_Batch_Run(tKinematicsBatch &batch){
+    const Mat *tool = batch.has_tool ? &batch.tool : nullptr;
+    const Mat *ref = batch.has_ref ? &batch.ref : nullptr;
+    int i;
+    while ((i = batch.next.fetchAndAddRelaxed(1)) < batch.nchunks){
+        qint64 first = (qint64) i * batch.chunk;
+        int n = qMin(batch.chunk, batch.count - (int) first);
+        if (batch.ik){
+            batch.kin->SolveIK(batch.input + first*16, n, batch.output + first*8*6, batch.nsolutions + first,
+                               batch.configs != nullptr ? batch.configs + first*8 : nullptr, tool, ref, 1);
+        } else {
+            batch.kin->SolveFK(batch.input + first*batch.stride, batch.stride, n, batch.output + first*16, tool, ref, 1);
+        }
+        batch.done.release();
+    }
 }
-Item::~Item(){
 
-}
+/// Worker of a multi-threaded Kinematics call (runs in the global QThreadPool).
+class KinematicsBatchRunnable : public QRunnable {
+public:
+    KinematicsBatchRunnable(const QSharedPointer<tKinematicsBatch> &batch) : _batch(batch) {}
+    void run() override {
+        Kinematics_Batch_Run(*_batch);
+    }
+private:
+    QSharedPointer<tKinematicsBatch> _batch;
+};
 
-QString Item::ToString() const {
-    if (this->Valid()){
-        return QString("Item(&RDK, %1, %2); // %3").arg(_PTR).arg(_TYPE).arg(Name());
+/// Runs a batch with up to the given number of threads. The calling thread also takes chunks: the call can't block if the pool is busy.
+static void Kinematics_Batch_Exec(const QSharedPointer<tKinematicsBatch> &batch, const Mat *tool, const Mat *ref, int threads){
+    batch->has_tool = tool != nullptr;
+    batch->has_ref = ref != nullptr;
+    if (tool != nullptr){
+        batch->tool = *tool;
     }
-    return "Item(Invalid)";
+    if (ref != nullptr){
+        batch->ref = *ref;
+    }
+    batch->nchunks = (batch->count + batch->chunk - 1) / batch->chunk;
+    int nworkers = qMin(threads, batch->nchunks) - 1;
+    for (int i=0; i<nworkers; i++){
+        QThreadPool::globalInstance()->start(new KinematicsBatchRunnable(batch));
+    }
+    Kinematics_Batch_Run(*batch);
+    batch->done.acquire(batch->nchunks);
 }
 
+Kinematics::Kinematics(){
+    _nDOFs = 0;
+    _HOME = Mat(false);
+    _CONFIG_MASK = 0;
+    _IK_DISABLED = false;
+}
 
-/// <summary>
-/// Returns the RoboDK link Robolink().
-/// </summary>
-/// <returns></returns>
-RoboDK* Item::RDK(){
-    return _RDK;
+bool Kinematics::Valid() const {
+    return _nDOFs > 0 && _HOME.Valid();
 }
 
-/// <summary>
-/// Create a new communication link for RoboDK. Use this for robots if you use a multithread application running multiple robots at the same time.
-/// </summary>
-void Item::NewLink(){
-    _RDK = new RoboDK();
+int Kinematics::DOFs() const {
+    return _nDOFs;
 }
 
-//////// GENERIC ITEM CALLS
-/// <summary>
-/// Returns the type of an item (robot, object, target, reference frame, ...)
-/// </summary>
-/// <returns></returns>
-int Item::Type(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Item_Type");
-    _RDK->_send_Item(this);
-    int itemtype = _RDK->_recv_Int();
-    _RDK->_check_status();
-    return itemtype;
+void Kinematics::clear(){
+    _nDOFs = 0;
+    _HOME = Mat(false);
+    _LOWER_LIMITS = tJoints();
+    _UPPER_LIMITS = tJoints();
+    _CONFIG_MASK = 0;
+    _IK_DISABLED = false;
 }
 
-////// add more methods
+bool Kinematics::addJoint(const tXYZ axis, const tXYZ point, bool prismatic){
+    if (_nDOFs >= RDK_SIZE_JOINTS_MAX){
+        return false;
+    }
+    double norm = sqrt(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+    if (norm < 1e-12){
+        return false;
+    }
+    for (int i=0; i<3; i++){
+        _AXIS[_nDOFs][i] = axis[i] / norm;
+        _POINT[_nDOFs][i] = (point != nullptr && !prismatic) ? point[i] : 0.0;
+    }
+    _PRISMATIC[_nDOFs] = prismatic;
+    _nDOFs++;
+    return true;
+}
 
-/// <summary>
-/// Save a station or object to a file
-/// </summary>
-/// <param name="filename"></param>
-void Item::Save(const QString &filename){
-    _RDK->Save(filename, this);
+void Kinematics::setHome(const Mat &flange){
+    _HOME = flange;
 }
 
-/// <summary>
-/// Deletes an item and its childs from the station.
-/// </summary>
-void Item::Delete(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("Remove");
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
-    _PTR = 0;
-    _TYPE = -1;
+bool Kinematics::setDHM(const tMatrix2D *dhm, const Mat &base, const Mat &tool){
+    clear();
+    if (dhm == nullptr || Matrix2D_Get_nrows(dhm) < 4){
+        return false;
+    }
+    const double deg2rad = M_PI / 180.0;
+    int rows = Matrix2D_Get_nrows(dhm);
+    int ndofs = Matrix2D_Get_ncols(dhm);
+    Mat frame(base);
+    for (int j=0; j<ndofs; j++){
+        const double *dhm_j = dhm->data + j*rows;
+        // the joint rotates around the Z axis of the frame after rotx(alpha)*transl(a,0,0)
+        frame = frame * Mat::rotx(dhm_j[0] * deg2rad) * Mat::transl(dhm_j[1], 0, 0);
+        tXYZ axis;
+        tXYZ point;
+        frame.VZ(axis);
+        frame.Pos(point);
+        if (!addJoint(axis, point, false)){
+            clear();
+            return false;
+        }
+        frame = frame * Mat::rotz(dhm_j[2] * deg2rad) * Mat::transl(0, 0, dhm_j[3]);
+    }
+    setHome(frame * tool);
+    return _nDOFs > 0;
 }
 
-/// <summary>
-/// Checks if the item is valid. An invalid item will be returned by an unsuccessful function call.
-/// </summary>
-/// <returns>true if valid, false if invalid</returns>
-bool Item::Valid() const {
-    return _PTR != 0;
+bool Kinematics::JointAxis(int joint, tXYZ axis, tXYZ point) const {
+    if (joint < 0 || joint >= _nDOFs){
+        return false;
+    }
+    for (int i=0; i<3; i++){
+        if (axis != nullptr){
+            axis[i] = _AXIS[joint][i];
+        }
+        if (point != nullptr){
+            point[i] = _POINT[joint][i];
+        }
+    }
+    return _PRISMATIC[joint];
 }
-/// <summary>
-/// Attaches the item to a new parent while maintaining the relative position with its parent. The absolute position is changed.
-/// </summary>
-/// <param name="parent"></param>
-void Item::setParent(Item parent){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Parent");
-    _RDK->_send_Item(this);
-    _RDK->_send_Item(parent);
-    _RDK->_check_status();
+
+Mat Kinematics::Home() const {
+    return _HOME;
 }
 
-/// <summary>
-/// Attaches the item to another parent while maintaining the current absolute position in the station.
-/// The relationship between this item and its parent is changed to maintain the abosolute position.
-/// </summary>
-/// <param name="parent">parent item to attach this item</param>
-void Item::setParentStatic(Item parent) {
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Parent_Static");
-    _RDK->_send_Item(this);
-    _RDK->_send_Item(parent);
-    _RDK->_check_status();
+Mat Kinematics::SolveFK(const tJoints &joints, const Mat *tool, const Mat *ref) const {
+    Mat pose(false);
+    if (!Valid() || joints.Length() < _nDOFs){
+        return pose;
+    }
+    double values[16];
+    SolveFK(joints.ValuesD(), _nDOFs, 1, values, tool, ref, 1);
+    return Mat(values);
 }
 
-/// <summary>
-/// Attach the closest object to the tool. Returns the item that was attached.
-/// </summary>
-/// <returns>Attached item</returns>
-Item Item::AttachClosest() {
-    _RDK->_check_connection();
-    _RDK->_send_Line("Attach_Closest");
-    _RDK->_send_Item(this);
-    Item item_attached = _RDK->_recv_Item();
-    _RDK->_check_status();
-    return item_attached;
+QList<Mat> Kinematics::SolveFK(const tMatrix2D *joint_list, const Mat *tool, const Mat *ref, int threads) const {
+    QList<Mat> poses;
+    if (joint_list == nullptr || Matrix2D_Get_nrows(joint_list) < _nDOFs){
+        return poses;
+    }
+    int count = Matrix2D_Get_ncols(joint_list);
+    QVector<double> values(16 * count);
+    if (!SolveFK(joint_list->data, Matrix2D_Get_nrows(joint_list), count, values.data(), tool, ref, threads)){
+        return poses;
+    }
+    poses.reserve(count);
+    for (int i=0; i<count; i++){
+        poses.append(Mat(values.constData() + 16*i));
+    }
+    return poses;
 }
 
-/// <summary>
-/// Detach the closest object attached to the tool (see also setParentStatic).
-/// </summary>
-/// <returns>Detached item</returns>
-Item Item::DetachClosest(Item parent) {
-    _RDK->_check_connection();
-    _RDK->_send_Line("Detach_Closest");
-    _RDK->_send_Item(this);
-    _RDK->_send_Item(parent);
-    Item item_detached = _RDK->_recv_Item();
-    _RDK->_check_status();
-    return item_detached;
+bool Kinematics::SolveFK(const double *joints, int stride, int count, double *poses, const Mat *tool, const Mat *ref, int threads) const {
+    if (!Valid() || stride < _nDOFs || count < 0 || (count > 0 && (joints == nullptr || poses == nullptr))){
+        return false;
+    }
+    if (threads <= 0){
+        threads = QThread::idealThreadCount();
+    }
+    int chunk = qMax(ROBODK_API_FK_CHUNK, count / (4 * qMax(threads, 1)));
+    int nchunks = (count + chunk - 1) / chunk;
+    if (threads <= 1 || nchunks <= 1){
+        _solveFK(joints, stride, count, poses, tool != nullptr ? _HOME * (*tool) : _HOME, ref != nullptr ? ref->inv() : Mat());
+        return true;
+    }
+
+    QSharedPointer<tKinematicsBatch> batch(new tKinematicsBatch);
+    batch->kin = this;
+    batch->ik = false;
+    batch->input = joints;
+    batch->stride = stride;
+    batch->count = count;
+    batch->output = poses;
+    batch->nsolutions = nullptr;
+    batch->configs = nullptr;
+    batch->chunk = chunk;
+    Kinematics_Batch_Exec(batch, tool, ref, threads);
+    return true;
 }
 
 /// <summary>
-/// Detach any object attached to a tool.
-/// </summary>
-void Item::DetachAll(Item parent) {
-    _RDK->_check_connection();
-    _RDK->_send_Line("Detach_All");
-    _RDK->_send_Item(this);
-    _RDK->_send_Item(parent);
-    _RDK->_check_status();
+/// Forward kinematics of a range of joint vectors (single thread): ref_inv * exp(joint 1) * ... * exp(joint n) * flange.
+/// Joint vectors are processed in blocks of ROBODK_API_FK_BLOCK as a structure of arrays, the inner loops run over the block so the compiler can vectorize them.
+/// </summary>
+void Kinematics::_solveFK(const double *joints, int stride, int count, double *poses, const Mat &flange, const Mat &ref_inv) const {
+    const double deg2rad = M_PI / 180.0;
+    const int B = ROBODK_API_FK_BLOCK;
+
+    // rotation of a rotative joint: R = I + sin(q)*K + (1-cos(q))*K^2, translation: (I-R)*point = -sin(q)*K*point - (1-cos(q))*K^2*point
+    // K is the skew matrix of the joint axis (row-major)
+    double K[RDK_SIZE_JOINTS_MAX][9];
+    double K2[RDK_SIZE_JOINTS_MAX][9];
+    double Kp[RDK_SIZE_JOINTS_MAX][3];
+    double K2p[RDK_SIZE_JOINTS_MAX][3];
+    for (int j=0; j<_nDOFs; j++){
+        const double *w = _AXIS[j];
+        const double *p = _POINT[j];
+        double k[9] = { 0, -w[2], w[1], w[2], 0, -w[0], -w[1], w[0], 0 };
+        for (int r=0; r<3; r++){
+            for (int c=0; c<3; c++){
+                K[j][3*r+c] = k[3*r+c];
+                K2[j][3*r+c] = w[r]*w[c] - (r == c ? 1.0 : 0.0);
+            }
+            Kp[j][r] = k[3*r]*p[0] + k[3*r+1]*p[1] + k[3*r+2]*p[2];
+        }
+        for (int r=0; r<3; r++){
+            K2p[j][r] = k[3*r]*Kp[j][0] + k[3*r+1]*Kp[j][1] + k[3*r+2]*Kp[j][2];
+        }
+    }
+    const double *F = flange.ValuesD();
+    const double *L = ref_inv.ValuesD();
+
+    for (int first=0; first<count; first+=B){
+        int n = qMin(B, count - first);
+        double R[9][B];
+        double P[3][B];
+        double E[9][B];
+        double Ep[3][B];
+        double T[9][B];
+        double q[B];
+        double s[B];
+        double v[B];
+        for (int m=0; m<9; m++){
+            for (int k=0; k<B; k++){
+                R[m][k] = (m % 4 == 0) ? 1.0 : 0.0;
+            }
+        }
+        for (int m=0; m<3; m++){
+            for (int k=0; k<B; k++){
+                P[m][k] = 0.0;
+            }
+        }
+        for (int j=0; j<_nDOFs; j++){
+            for (int k=0; k<B; k++){
+                q[k] = (k < n) ? joints[(qint64)(first + k) * stride + j] : 0.0;
+            }
+            if (_PRISMATIC[j]){
+                const double *w = _AXIS[j];
+                for (int r=0; r<3; r++){
+                    for (int k=0; k<B; k++){
+                        P[r][k] += (R[3*r][k]*w[0] + R[3*r+1][k]*w[1] + R[3*r+2][k]*w[2]) * q[k];
+                    }
+                }
+                continue;
+            }
+            for (int k=0; k<B; k++){
+                double angle = q[k] * deg2rad;
+                s[k] = sin(angle);
+                v[k] = 1.0 - cos(angle);
+            }
+            for (int m=0; m<9; m++){
+                double id = (m % 4 == 0) ? 1.0 : 0.0;
+                for (int k=0; k<B; k++){
+                    E[m][k] = id + s[k]*K[j][m] + v[k]*K2[j][m];
+                }
+            }
+            for (int m=0; m<3; m++){
+                for (int k=0; k<B; k++){
+                    Ep[m][k] = -s[k]*Kp[j][m] - v[k]*K2p[j][m];
+                }
+            }
+            for (int r=0; r<3; r++){
+                for (int k=0; k<B; k++){
+                    P[r][k] += R[3*r][k]*Ep[0][k] + R[3*r+1][k]*Ep[1][k] + R[3*r+2][k]*Ep[2][k];
+                }
+                for (int c=0; c<3; c++){
+                    for (int k=0; k<B; k++){
+                        T[3*r+c][k] = R[3*r][k]*E[c][k] + R[3*r+1][k]*E[3+c][k] + R[3*r+2][k]*E[6+c][k];
+                    }
+                }
+            }
+            memcpy(R, T, sizeof(R));
+        }
+
+        // pose = ref_inv * chain * flange (poses are rigid transformations, column-major)
+        for (int k=0; k<n; k++){
+            double A[12]; // chain * flange, 3x4 column-major
+            for (int c=0; c<4; c++){
+                for (int r=0; r<3; r++){
+                    A[3*c+r] = R[3*r][k]*F[4*c] + R[3*r+1][k]*F[4*c+1] + R[3*r+2][k]*F[4*c+2] + (c == 3 ? P[r][k] : 0.0);
+                }
+            }
+            double *pose = poses + (qint64)(first + k) * 16;
+            for (int c=0; c<4; c++){
+                for (int r=0; r<3; r++){
+                    pose[4*c+r] = L[r]*A[3*c] + L[4+r]*A[3*c+1] + L[8+r]*A[3*c+2] + (c == 3 ? L[12+r] : 0.0);
+                }
+                pose[4*c+3] = (c == 3) ? 1.0 : 0.0;
+            }
+        }
+    }
 }
 
 
-/// <summary>
-/// Return the parent item of this item
-/// </summary>
-/// <returns>Parent item</returns>
-Item Item::Parent() const {
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Parent");
-    _RDK->_send_Item(this);
-    Item itm_parent = _RDK->_recv_Item();
-    _RDK->_check_status();
-    return itm_parent;
+
+//------------------------- Kinematics: closed form inverse kinematics --------------------------
+// The joint axes are known with all joints at 0 (w: axis, r: point of the axis).
+// With H = target * home^-1 = exp(joint 1) * ... * exp(joint 6) and p_w the wrist center (intersection of axes 4, 5 and 6):
+//  - joint 1 makes H*p_w match the plane reached by joints 2 and 3 (both parallel, they keep the coordinate along w2)
+//  - joint 3 sets the distance from the wrist center to axis 2, joint 2 rotates the wrist center to its position
+//  - joints 4 and 5 orient axis 6, joint 6 sets the rotation around axis 6
+// Each step has up to 2 solutions (rear, lower arm and flip), which gives up to 8 solutions.
+
+/// Joint axes and wrist center used by the closed form inverse kinematics
+struct tKinematicsIK {
+    double w[6][3];
+    double r[6][3];
+    double pw[3];       // wrist center
+    double x6[3];       // vector perpendicular to axis 6
+    double front[3];    // direction of the wrist center from axis 1 with all joints at 0
+    double elbow_home;  // elbow side with all joints at 0
+    Mat home_inv;
+};
+
+static inline double Vec3_Dot(const double *a, const double *b){
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
 }
 
+static inline void Vec3_Cross(const double *a, const double *b, double *out){
+    double x = a[1]*b[2] - a[2]*b[1];
+    double y = a[2]*b[0] - a[0]*b[2];
+    double z = a[0]*b[1] - a[1]*b[0];
+    out[0] = x; out[1] = y; out[2] = z;
+}
 
-////// add more methods
-/// <summary>
-/// Returns a list of the item childs that are attached to the provided item.
-/// </summary>
-/// <returns>item x n -> list of child items</returns>
-QList<Item> Item::Childs() const {
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Childs");
-    _RDK->_send_Item(this);
-    int nitems = _RDK->_recv_Int();
-    QList<Item> itemlist;
-    for (int i = 0; i < nitems; i++)
-    {
-        itemlist.append(_RDK->_recv_Item());
+/// Rotation matrix (row-major) of an angle (rad) around a unit axis
+static void Rot3_Axis(const double *w, double angle, double R[9]){
+    double s = sin(angle);
+    double v = 1.0 - cos(angle);
+    R[0] = 1.0 + v*(w[0]*w[0] - 1.0); R[1] = -s*w[2] + v*w[0]*w[1];    R[2] = s*w[1] + v*w[0]*w[2];
+    R[3] = s*w[2] + v*w[0]*w[1];      R[4] = 1.0 + v*(w[1]*w[1] - 1.0); R[5] = -s*w[0] + v*w[1]*w[2];
+    R[6] = -s*w[1] + v*w[0]*w[2];     R[7] = s*w[0] + v*w[1]*w[2];     R[8] = 1.0 + v*(w[2]*w[2] - 1.0);
+}
+
+static inline void Rot3_Mult(const double *A, const double *B, double *out){
+    for (int r=0; r<3; r++){
+        for (int c=0; c<3; c++){
+            out[3*r+c] = A[3*r]*B[c] + A[3*r+1]*B[3+c] + A[3*r+2]*B[6+c];
+        }
     }
-    _RDK->_check_status();
-    return itemlist;
 }
 
-/// <summary>
-/// Returns 1 if the item is visible, otherwise, returns 0.
-/// </summary>
-/// <returns>true if visible, false if not visible</returns>
-bool Item::Visible() const {
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Visible");
-    _RDK->_send_Item(this);
-    int visible = _RDK->_recv_Int();
-    _RDK->_check_status();
-    return (visible != 0);
-}
-/// <summary>
-/// Sets the item visiblity status
-/// </summary>
-/// <param name="visible"></param>
-/// <param name="visible_frame">srt the visible reference frame (1) or not visible (0)</param>
-void Item::setVisible(bool visible, int visible_frame){
-    if (visible_frame < 0)
-    {
-        visible_frame = visible ? 1 : 0;
+/// out = A^T * B
+static inline void Rot3_MultTA(const double *A, const double *B, double *out){
+    for (int r=0; r<3; r++){
+        for (int c=0; c<3; c++){
+            out[3*r+c] = A[r]*B[c] + A[3+r]*B[3+c] + A[6+r]*B[6+c];
+        }
     }
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Visible");
-    _RDK->_send_Item(this);
-    _RDK->_send_Int(visible ? 1 : 0);
-    _RDK->_send_Int(visible_frame);
-    _RDK->_check_status();
 }
 
-/// <summary>
-/// Returns the name of an item. The name of the item is always displayed in the RoboDK station tree
-/// </summary>
-/// <returns>name of the item</returns>
-QString Item::Name() const {
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Name");
-    _RDK->_send_Item(this);
-    QString name = _RDK->_recv_Line();
-    _RDK->_check_status();
-    return name;
+static inline void Rot3_Apply(const double *R, const double *v, double *out){
+    double x = R[0]*v[0] + R[1]*v[1] + R[2]*v[2];
+    double y = R[3]*v[0] + R[4]*v[1] + R[5]*v[2];
+    double z = R[6]*v[0] + R[7]*v[1] + R[8]*v[2];
+    out[0] = x; out[1] = y; out[2] = z;
 }
 
-/// <summary>
-/// Set the name of a RoboDK item.
-/// </summary>
-/// <param name="name"></param>
-void Item::setName(const QString &name){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Name");
-    _RDK->_send_Item(this);
-    _RDK->_send_Line(name);
-    _RDK->_check_status();
+/// Rotates a point p around the axis (w, r) by an angle (rad)
+static inline void Point_Rotate(const double *w, const double *r, double angle, const double *p, double *out){
+    double R[9];
+    double d[3] = { p[0] - r[0], p[1] - r[1], p[2] - r[2] };
+    Rot3_Axis(w, angle, R);
+    Rot3_Apply(R, d, out);
+    out[0] += r[0]; out[1] += r[1]; out[2] += r[2];
 }
 
-// add more methods
+/// Angle (rad) that rotates the vector u to the vector v around the unit axis w (only the components perpendicular to w are used)
+static inline double Angle_Rotate(const double *w, const double *u, const double *v){
+    double uw = Vec3_Dot(u, w);
+    double vw = Vec3_Dot(v, w);
+    double up[3] = { u[0] - uw*w[0], u[1] - uw*w[1], u[2] - uw*w[2] };
+    double vp[3] = { v[0] - vw*w[0], v[1] - vw*w[1], v[2] - vw*w[2] };
+    double uxv[3];
+    Vec3_Cross(up, vp, uxv);
+    return atan2(Vec3_Dot(w, uxv), Vec3_Dot(up, vp));
+}
 
-/// <summary>
-/// Sets the local position (pose) of an object, target or reference frame. For example, the position of an object/frame/target with respect to its parent.
-/// If a robot is provided, it will set the pose of the end efector.
-/// </summary>
-/// <param name="pose">4x4 homogeneous matrix</param>
-void Item::setPose(Mat pose){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Hlocal");
-    _RDK->_send_Item(this);
-    _RDK->_send_Pose(pose);
-    _RDK->_check_status();
+/// Angle in deg in the range (-180, 180]
+static inline double Angle_Normalize(double angle_deg){
+    angle_deg = fmod(angle_deg, 360.0);
+    if (angle_deg > 180.0){
+        angle_deg -= 360.0;
+    } else if (angle_deg <= -180.0){
+        angle_deg += 360.0;
+    }
+    return angle_deg;
 }
 
-/// <summary>
-/// Returns the local position (pose) of an object, target or reference frame. For example, the position of an object/frame/target with respect to its parent.
-/// If a robot is provided, it will get the pose of the end efector
-/// </summary>
-/// <returns>4x4 homogeneous matrix (pose)</returns>
-Mat Item::Pose() const {
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Hlocal");
-    _RDK->_send_Item(this);
-    Mat pose = _RDK->_recv_Pose();
-    _RDK->_check_status();
-    return pose;
+/// Elbow side: sign of the rotation from axis 2 to axis 3 to the wrist center (joint 3 in rad)
+static double Kinematics_IK_Elbow(const tKinematicsIK &ik, double joint3){
+    double p3[3];
+    Point_Rotate(ik.w[2], ik.r[2], joint3, ik.pw, p3);
+    double a[3] = { ik.r[2][0] - ik.r[1][0], ik.r[2][1] - ik.r[1][1], ik.r[2][2] - ik.r[1][2] };
+    double b[3] = { p3[0] - ik.r[2][0], p3[1] - ik.r[2][1], p3[2] - ik.r[2][2] };
+    double axb[3];
+    Vec3_Cross(a, b, axb);
+    return Vec3_Dot(ik.w[1], axb);
 }
 
-/// <summary>
-/// Sets the position (pose) the object geometry with respect to its own reference frame. This procedure works for tools and objects.
-/// </summary>
-/// <param name="pose">4x4 homogeneous matrix</param>
-void Item::setGeometryPose(Mat pose){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Hgeom");
-    _RDK->_send_Item(this);
-    _RDK->_send_Pose(pose);
-    _RDK->_check_status();
+/// Configuration of a joint solution (joints in rad): bit 0 is REAR, bit 1 is LOWERARM and bit 2 is FLIP
+static int Kinematics_IK_Config(const tKinematicsIK &ik, const double *joints){
+    // wrist center moved by joints 2 and 3 (joint 1 does not change the side)
+    double p3[3];
+    double p2[3];
+    Point_Rotate(ik.w[2], ik.r[2], joints[2], ik.pw, p3);
+    Point_Rotate(ik.w[1], ik.r[1], joints[1], p3, p2);
+    double d[3] = { p2[0] - ik.r[0][0], p2[1] - ik.r[0][1], p2[2] - ik.r[0][2] };
+    int config = 0;
+    if (Vec3_Dot(d, ik.front) < 0){
+        config |= 1;
+    }
+    double elbow = Kinematics_IK_Elbow(ik, joints[2]);
+    if ((ik.elbow_home != 0.0) ? (elbow * ik.elbow_home < 0) : (elbow < 0)){
+        config |= 2;
+    }
+    if (Angle_Normalize(joints[4] * 180.0 / M_PI) < 0){
+        config |= 4;
+    }
+    return config;
 }
 
-/// <summary>
-/// Returns the position (pose) the object geometry with respect to its own reference frame. This procedure works for tools and objects.
-/// </summary>
-/// <returns>4x4 homogeneous matrix (pose)</returns>
-Mat Item::GeometryPose(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Hgeom");
-    _RDK->_send_Item(this);
-    Mat pose = _RDK->_recv_Pose();
-    _RDK->_check_status();
-    return pose;
+/// Retrieves the joint axes used by the closed form inverse kinematics. Returns false if the robot is not supported.
+static bool Kinematics_IK_Setup(const Kinematics &kin, tKinematicsIK &ik){
+    if (!kin.Valid() || kin.DOFs() != 6){
+        return false;
+    }
+    for (int j=0; j<6; j++){
+        if (kin.JointAxis(j, ik.w[j], ik.r[j])){
+            return false; // prismatic joint
+        }
+    }
+    const double tol = 1e-9;
+    double c[3];
+    Vec3_Cross(ik.w[1], ik.w[2], c);
+    if (sqrt(Vec3_Dot(c, c)) > tol){
+        return false; // joints 2 and 3 are not parallel
+    }
+    Vec3_Cross(ik.w[0], ik.w[1], c);
+    if (sqrt(Vec3_Dot(c, c)) < 1e-6){
+        return false; // joints 1 and 2 are parallel
+    }
+    double w45[3];
+    Vec3_Cross(ik.w[3], ik.w[4], w45);
+    double n45 = Vec3_Dot(w45, w45);
+    if (n45 < 1e-12){
+        return false; // joints 4 and 5 are parallel
+    }
+    // wrist center: intersection of axes 4 and 5, it must be on axis 6
+    double d[3] = { ik.r[4][0] - ik.r[3][0], ik.r[4][1] - ik.r[3][1], ik.r[4][2] - ik.r[3][2] };
+    double dxw5[3];
+    Vec3_Cross(d, ik.w[4], dxw5);
+    double t4 = Vec3_Dot(dxw5, w45) / n45;
+    for (int i=0; i<3; i++){
+        ik.pw[i] = ik.r[3][i] + t4 * ik.w[3][i];
+    }
+    double e[3];
+    for (int j=4; j<6; j++){
+        for (int i=0; i<3; i++){
+            d[i] = ik.pw[i] - ik.r[j][i];
+        }
+        Vec3_Cross(d, ik.w[j], e);
+        if (sqrt(Vec3_Dot(e, e)) > 1e-6){
+            return false; // not a spherical wrist
+        }
+    }
+
+    // any vector perpendicular to axis 6
+    double other[3] = { 1, 0, 0 };
+    if (fabs(ik.w[5][0]) > 0.9){
+        other[0] = 0;
+        other[1] = 1;
+    }
+    Vec3_Cross(ik.w[5], other, ik.x6);
+
+    for (int i=0; i<3; i++){
+        d[i] = ik.pw[i] - ik.r[0][i];
+    }
+    double dw = Vec3_Dot(d, ik.w[0]);
+    for (int i=0; i<3; i++){
+        ik.front[i] = d[i] - dw * ik.w[0][i];
+    }
+    ik.elbow_home = Kinematics_IK_Elbow(ik, 0.0);
+    if (fabs(ik.elbow_home) < 1e-9){
+        ik.elbow_home = 0.0;
+    }
+    ik.home_inv = kin.Home().inv();
+    return true;
 }
-/*
-/// <summary>
-/// Obsolete: Use setPoseTool(pose) instead. Sets the tool pose of a tool item. If a robot is provided it will set the tool pose of the active tool held by the robot.
-/// </summary>
-/// <param name="pose">4x4 homogeneous matrix (pose)</param>
-void Item::setHtool(Mat pose){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Htool");
-    _RDK->_send_Item(this);
-    _RDK->_send_Pose(pose);
-    _RDK->_check_status();
+
+void Kinematics::setJointLimits(const tJoints &lower_limits, const tJoints &upper_limits){
+    _LOWER_LIMITS = lower_limits;
+    _UPPER_LIMITS = upper_limits;
 }
 
-/// <summary>
-/// Obsolete: Use PoseTool() instead.
-/// Returns the tool pose of an item. If a robot is provided it will get the tool pose of the active tool held by the robot.
-/// </summary>
-/// <returns>4x4 homogeneous matrix (pose)</returns>
-Mat Item::Htool(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Htool");
-    _RDK->_send_Item(this);
-    Mat pose = _RDK->_recv_Pose();
-    _RDK->_check_status();
-    return pose;
+void Kinematics::JointLimits(tJoints *lower_limits, tJoints *upper_limits) const {
+    if (lower_limits != nullptr){
+        *lower_limits = _LOWER_LIMITS;
+    }
+    if (upper_limits != nullptr){
+        *upper_limits = _UPPER_LIMITS;
+    }
 }
-*/
-/// <summary>
-/// Returns the tool pose of an item. If a robot is provided it will get the tool pose of the active tool held by the robot.
-/// </summary>
-/// <returns>4x4 homogeneous matrix (pose)</returns>
-Mat Item::PoseTool(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Tool");
-    _RDK->_send_Item(this);
-    Mat pose = _RDK->_recv_Pose();
-    _RDK->_check_status();
-    return pose;
+
+bool Kinematics::CanSolveIK() const {
+    tKinematicsIK ik;
+    return !_IK_DISABLED && Kinematics_IK_Setup(*this, ik);
 }
 
-/// <summary>
-/// Returns the reference frame pose of an item. If a robot is provided it will get the tool pose of the active reference frame used by the robot.
-/// </summary>
-/// <returns>4x4 homogeneous matrix (pose)</returns>
-Mat Item::PoseFrame(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Frame");
-    _RDK->_send_Item(this);
-    Mat pose = _RDK->_recv_Pose();
-    _RDK->_check_status();
-    return pose;
+void Kinematics::JointsConfig(const tJoints &joints, tConfig config) const {
+    for (int i=0; i<RDK_SIZE_MAX_CONFIG; i++){
+        config[i] = 0;
+    }
+    tKinematicsIK ik;
+    if (joints.Length() < 6 || !Kinematics_IK_Setup(*this, ik)){
+        return;
+    }
+    double joints_rad[6];
+    for (int j=0; j<6; j++){
+        joints_rad[j] = joints.ValuesD()[j] * M_PI / 180.0;
+    }
+    int flags = Kinematics_IK_Config(ik, joints_rad) ^ _CONFIG_MASK;
+    for (int i=0; i<3; i++){
+        config[i] = (flags >> i) & 1;
+    }
 }
 
-/// <summary>
-/// Sets the reference frame of a robot(user frame). The frame can be either an item or a pose.
-/// If "frame" is an item, it links the robot to the frame item. If frame is a pose, it updates the linked pose of the robot frame (with respect to the robot reference frame).
-/// </summary>
-/// <param name="frame_pose">4x4 homogeneous matrix (pose)</param>
-void Item::setPoseFrame(Mat frame_pose){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Frame");
-    _RDK->_send_Pose(frame_pose);
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
+QList<tJoints> Kinematics::SolveIK_All(const Mat &pose, const Mat *tool, const Mat *ref) const {
+    QList<tJoints> solutions;
+    double values[8*6];
+    int nsolutions = 0;
+    if (!SolveIK(pose.ValuesD(), 1, values, &nsolutions, nullptr, tool, ref, 1)){
+        return solutions;
+    }
+    for (int i=0; i<nsolutions; i++){
+        solutions.append(tJoints(values + 6*i, 6));
+    }
+    return solutions;
 }
 
-/// <summary>
-/// Sets the tool of a robot or a tool object (Tool Center Point, or TCP). The tool pose can be either an item or a 4x4 Matrix.
-/// If the item is a tool, it links the robot to the tool item.If tool is a pose, it updates the current robot TCP.
-/// </summary>
-/// <param name="pose">4x4 homogeneous matrix (pose)</param>
-void Item::setPoseFrame(Item frame_item){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Frame_ptr");
-    _RDK->_send_Item(frame_item);
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
+/// Index of the solution closest to the joints (-1 if there are no solutions): the solution with the smallest maximum joint move (deg).
+/// The joints of a joint move are synchronized, so the largest move sets the duration of the movement. Ties keep the first solution.
+static int Kinematics_Closest(const QList<tJoints> &solutions, const tJoints &joints){
+    int best = -1;
+    double best_move = 0;
+    for (int i=0; i<solutions.length(); i++){
+        double move = 0;
+        for (int j=0; j<solutions[i].Length() && j<joints.Length(); j++){
+            move = qMax(move, fabs(solutions[i].ValuesD()[j] - joints.ValuesD()[j]));
+        }
+        if (best < 0 || move < best_move){
+            best = i;
+            best_move = move;
+        }
+    }
+    return best;
 }
 
-/// <summary>
-/// Sets the tool of a robot or a tool object (Tool Center Point, or TCP). The tool pose can be either an item or a 4x4 Matrix.
-/// If the item is a tool, it links the robot to the tool item.If tool is a pose, it updates the current robot TCP.
-/// </summary>
-/// <param name="tool_pose">4x4 homogeneous matrix (pose)</param>
-void Item::setPoseTool(Mat tool_pose){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Tool");
-    _RDK->_send_Pose(tool_pose);
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
+tJoints Kinematics::SolveIK(const Mat &pose, const tJoints &joints_approx, const Mat *tool, const Mat *ref) const {
+    QList<tJoints> solutions = SolveIK_All(pose, tool, ref);
+    int best = Kinematics_Closest(solutions, joints_approx);
+    if (best < 0){
+        return tJoints();
+    }
+    return solutions[best];
 }
 
-/// <summary>
-/// Sets the tool of a robot or a tool object (Tool Center Point, or TCP). The tool pose can be either an item or a 4x4 Matrix.
-/// If the item is a tool, it links the robot to the tool item.If tool is a pose, it updates the current robot TCP.
-/// </summary>
-/// <param name="tool_item">Tool item</param>
-void Item::setPoseTool(Item tool_item){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Tool_ptr");
-    _RDK->_send_Item(tool_item);
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
+bool Kinematics::SolveIK(const double *poses, int count, double *solutions, int *nsolutions, int *configs, const Mat *tool, const Mat *ref, int threads) const {
+    if (!CanSolveIK() || count < 0 || (count > 0 && (poses == nullptr || solutions == nullptr || nsolutions == nullptr))){
+        return false;
+    }
+    if (threads <= 0){
+        threads = QThread::idealThreadCount();
+    }
+    int chunk = qMax(ROBODK_API_IK_CHUNK, count / (4 * qMax(threads, 1)));
+    int nchunks = (count + chunk - 1) / chunk;
+    if (threads <= 1 || nchunks <= 1){
+        _solveIK(poses, count, solutions, nsolutions, configs, tool != nullptr ? tool->inv() : Mat(), ref != nullptr ? *ref : Mat());
+        return true;
+    }
+    QSharedPointer<tKinematicsBatch> batch(new tKinematicsBatch);
+    batch->kin = this;
+    batch->ik = true;
+    batch->input = poses;
+    batch->stride = 16;
+    batch->count = count;
+    batch->output = solutions;
+    batch->nsolutions = nsolutions;
+    batch->configs = configs;
+    batch->chunk = chunk;
+    Kinematics_Batch_Exec(batch, tool, ref, threads);
+    return true;
 }
 
 /// <summary>
-/// Sets the global position (pose) of an item. For example, the position of an object/frame/target with respect to the station origin.
+/// Inverse kinematics of a range of poses (single thread). The flange pose is ref * pose * tool_inv.
 /// </summary>
-/// <param name="pose">4x4 homogeneous matrix (pose)</param>
-void Item::setPoseAbs(Mat pose){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Hlocal_Abs");
-    _RDK->_send_Item(this);
-    _RDK->_send_Pose(pose);
-    _RDK->_check_status();
+void Kinematics::_solveIK(const double *poses, int count, double *solutions, int *nsolutions, int *configs, const Mat &tool_inv, const Mat &ref) const {
+    tKinematicsIK ik;
+    if (!Kinematics_IK_Setup(*this, ik)){
+        for (int i=0; i<count; i++){
+            nsolutions[i] = 0;
+        }
+        return;
+    }
+    const double tol = 1e-12;
+    const double rad2deg = 180.0 / M_PI;
+    const double *w1 = ik.w[0], *w2 = ik.w[1], *w3 = ik.w[2], *w4 = ik.w[3], *w5 = ik.w[4], *w6 = ik.w[5];
+    const double *r1 = ik.r[0], *r2 = ik.r[1], *r3 = ik.r[2];
+    bool limits = _LOWER_LIMITS.Length() >= 6 && _UPPER_LIMITS.Length() >= 6;
+    const double *lower = _LOWER_LIMITS.ValuesD();
+    const double *upper = _UPPER_LIMITS.ValuesD();
+
+    // constants of joint 3 (rotation of the wrist center around axis 3) and of the wrist (joints 4 and 5 to orient axis 6)
+    double u3[3] = { ik.pw[0] - r3[0], ik.pw[1] - r3[1], ik.pw[2] - r3[2] };
+    double v3[3] = { r2[0] - r3[0], r2[1] - r3[1], r2[2] - r3[2] };
+    double u3w = Vec3_Dot(u3, w3);
+    double v3w = Vec3_Dot(v3, w3);
+    double u3p[3] = { u3[0] - u3w*w3[0], u3[1] - u3w*w3[1], u3[2] - u3w*w3[2] };
+    double v3p[3] = { v3[0] - v3w*w3[0], v3[1] - v3w*w3[1], v3[2] - v3w*w3[2] };
+    double nu3 = sqrt(Vec3_Dot(u3p, u3p));
+    double nv3 = sqrt(Vec3_Dot(v3p, v3p));
+    double j3_offset = Angle_Rotate(w3, u3p, v3p);
+    double dz3 = u3w - v3w; // distance from the wrist center to axis 2 along the axis
+    double k45 = Vec3_Dot(w4, w5);
+    double w45[3];
+    Vec3_Cross(w4, w5, w45);
+    double n45 = Vec3_Dot(w45, w45);
+
+    for (int i=0; i<count; i++){
+        Mat target = ref * Mat(poses + 16*i) * tool_inv;
+        Mat H = target * ik.home_inv;
+        const double *h = H.ValuesD();
+        double HR[9] = { h[0], h[4], h[8], h[1], h[5], h[9], h[2], h[6], h[10] };
+        double q[3];
+        Rot3_Apply(HR, ik.pw, q);
+        q[0] += h[12]; q[1] += h[13]; q[2] += h[14];
+        double *sol = solutions + (qint64) i * 8 * 6;
+        int *sol_config = configs != nullptr ? configs + (qint64) i * 8 : nullptr;
+        int nsol = 0;
+
+        // joint 1: w2 . (exp(-joint1) * q) = w2 . p_w
+        double v[3] = { q[0] - r1[0], q[1] - r1[1], q[2] - r1[2] };
+        double vw = Vec3_Dot(v, w1);
+        double vperp[3] = { v[0] - vw*w1[0], v[1] - vw*w1[1], v[2] - vw*w1[2] };
+        double w1xv[3];
+        Vec3_Cross(w1, vperp, w1xv);
+        double a = Vec3_Dot(w2, vperp);
+        double b = Vec3_Dot(w2, w1xv);
+        double c = Vec3_Dot(w2, ik.pw) - Vec3_Dot(w2, r1) - vw * Vec3_Dot(w2, w1);
+        double rho = sqrt(a*a + b*b);
+        if (rho < tol || fabs(c) > rho * (1.0 + tol)){
+            nsolutions[i] = 0; // shoulder singularity or out of reach
+            continue;
+        }
+        double phi0 = atan2(b, a);
+        double dphi = acos(qBound(-1.0, c / rho, 1.0));
+        for (int s1=0; s1<2; s1++){
+            double joint1 = -(phi0 + (s1 == 0 ? dphi : -dphi));
+            double q1[3];
+            Point_Rotate(w1, r1, -joint1, q, q1);
+
+            // joint 3: distance from the wrist center to axis 2 (law of cosines in the plane of the arm)
+            double d[3] = { q1[0] - r2[0], q1[1] - r2[1], q1[2] - r2[2] };
+            double delta2 = Vec3_Dot(d, d) - dz3*dz3;
+            if (nu3 < tol || nv3 < tol){
+                continue;
+            }
+            double cos3 = (nu3*nu3 + nv3*nv3 - delta2) / (2.0 * nu3 * nv3);
+            if (fabs(cos3) > 1.0 + 1e-9){
+                continue; // out of reach
+            }
+            double dj3 = acos(qBound(-1.0, cos3, 1.0));
+            for (int s3=0; s3<2; s3++){
+                double joint3 = j3_offset + (s3 == 0 ? dj3 : -dj3);
+
+                // joint 2: rotate the wrist center to its position
+                double p3[3];
+                Point_Rotate(w3, r3, joint3, ik.pw, p3);
+                double u2[3] = { p3[0] - r2[0], p3[1] - r2[1], p3[2] - r2[2] };
+                double joint2 = Angle_Rotate(w2, u2, d);
+
+                // wrist: R4*R5*R6 = (R1*R2*R3)^T * HR
+                double R1[9], R2[9], R3[9], R12[9], R123[9], Rw[9];
+                Rot3_Axis(w1, joint1, R1);
+                Rot3_Axis(w2, joint2, R2);
+                Rot3_Axis(w3, joint3, R3);
+                Rot3_Mult(R1, R2, R12);
+                Rot3_Mult(R12, R3, R123);
+                Rot3_MultTA(R123, HR, Rw);
+                double v6[3];
+                Rot3_Apply(Rw, w6, v6);
+
+                // joints 4 and 5: R5*w6 = R4^T*v6 = alpha*w4 + beta*w5 + gamma*(w4 x w5)
+                double A = Vec3_Dot(w4, v6);
+                double B = Vec3_Dot(w5, w6);
+                double den = 1.0 - k45*k45;
+                double alpha = (A - k45*B) / den;
+                double beta = (B - k45*A) / den;
+                double gamma2 = (1.0 - alpha*alpha - beta*beta - 2.0*alpha*beta*k45) / n45;
+                if (gamma2 < -1e-9){
+                    continue;
+                }
+                double gamma = sqrt(qMax(0.0, gamma2));
+                for (int s5=0; s5<2; s5++){
+                    double g = (s5 == 0) ? gamma : -gamma;
+                    double cw[3];
+                    for (int k=0; k<3; k++){
+                        cw[k] = alpha*w4[k] + beta*w5[k] + g*w45[k];
+                    }
+                    double joint5 = Angle_Rotate(w5, w6, cw);
+                    double joint4 = Angle_Rotate(w4, cw, v6);
+
+                    // joint 6: remaining rotation around axis 6
+                    double R4[9], R5[9], R45[9], R6[9];
+                    Rot3_Axis(w4, joint4, R4);
+                    Rot3_Axis(w5, joint5, R5);
+                    Rot3_Mult(R4, R5, R45);
+                    Rot3_MultTA(R45, Rw, R6);
+                    double x6r[3];
+                    Rot3_Apply(R6, ik.x6, x6r);
+                    double joint6 = Angle_Rotate(w6, ik.x6, x6r);
+
+                    double joints_rad[6] = { joint1, joint2, joint3, joint4, joint5, joint6 };
+                    double *out = sol + nsol*6;
+                    bool ok = true;
+                    for (int j=0; j<6 && ok; j++){
+                        double value = Angle_Normalize(joints_rad[j] * rad2deg);
+                        if (limits && (value < lower[j] || value > upper[j])){
+                            // try the same angle one turn before or after
+                            double shifted = value + (value < lower[j] ? 360.0 : -360.0);
+                            ok = shifted >= lower[j] && shifted <= upper[j];
+                            value = shifted;
+                        }
+                        out[j] = value;
+                    }
+                    if (!ok){
+                        continue;
+                    }
+                    if (sol_config != nullptr){
+                        sol_config[nsol] = Kinematics_IK_Config(ik, joints_rad) ^ _CONFIG_MASK;
+                    }
+                    nsol++;
+                }
+            }
+        }
+        nsolutions[i] = nsol;
+    }
+}
+
+
 
+//---------------------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// PipelineScope CLASS ///////////////////////////////////////////
+PipelineScope::PipelineScope(RoboDK *rdk, int max_pending){
+    _RDK = rdk;
+    _ACTIVE = !_RDK->PipelineActive();
+    if (_ACTIVE){
+        _RDK->PipelineStart(max_pending);
+    }
 }
 
-/// <summary>
-/// Returns the global position (pose) of an item. For example, the position of an object/frame/target with respect to the station origin.
-/// </summary>
-/// <returns>4x4 homogeneous matrix (pose)</returns>
-Mat Item::PoseAbs(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Hlocal_Abs");
-    _RDK->_send_Item(this);
-    Mat pose = _RDK->_recv_Pose();
-    _RDK->_check_status();
-    return pose;
+PipelineScope::~PipelineScope(){
+    End();
 }
 
-/// <summary>
-/// Set the color of an object, tool or robot.
-/// A color must in the format COLOR=[R,G,B,(A=1)] where all values range from 0 to 1.
-/// <summary>
-void Item::setColor(double colorRGBA[4]){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Color");
-    _RDK->_send_Item(this);
-    _RDK->_send_Array(colorRGBA, 4);
-    _RDK->_check_status();
+int PipelineScope::End(QList<tPipelineError> *errors){
+    if (!_ACTIVE){
+        return 0;
+    }
+    _ACTIVE = false;
+    return _RDK->PipelineEnd(errors);
+}
 
+
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// DeadlineScope CLASS ///////////////////////////////////////////
+CancelToken::CancelToken() :
+    _STATE(new QAtomicInt(0))
+{
 }
 
-///--------------------------------- add curve, scale, recolor, ...
-///
-///
-///
+void CancelToken::Cancel(){
+    _STATE->storeRelease(1);
+}
 
+void CancelToken::Reset(){
+    _STATE->storeRelease(0);
+}
 
-/// <summary>
-/// Apply a scale to an object to make it bigger or smaller.
-/// The scale can be uniform (if scale is a float value) or per axis (if scale is a vector).
-/// </summary>
-/// <param name="scale">scale to apply as scale or [scale_x, scale_y, scale_z]</param>
-void Item::Scale(double scale){
-    double scale_xyz[3];
-    scale_xyz[0] = scale;
-    scale_xyz[1] = scale;
-    scale_xyz[2] = scale;
-    Scale(scale_xyz);
+bool CancelToken::Cancelled() const {
+    return _STATE->loadAcquire() != 0;
 }
 
-/// <summary>
-/// Apply a per-axis scale to an object to make it bigger or smaller.
-/// The scale can be uniform (if scale is a float value) or per axis (if scale is a vector).
-/// </summary>
-/// <param name="scale">scale to apply as [scale_x, scale_y, scale_z]</param>
-void Item::Scale(double scale_xyz[3]){
-    _RDK->_check_connection();
-    _RDK->_send_Line("Scale");
-    _RDK->_send_Item(this);
-    _RDK->_send_Array(scale_xyz, 3);
-    _RDK->_check_status();
+
+DeadlineScope::DeadlineScope(RoboDK *rdk, int timeout_ms, const CancelToken &token){
+    _RDK = rdk;
+    _ABORT_COUNT = _RDK->_ABORT_COUNT;
+    _PREV_DEADLINE = _RDK->_DEADLINE;
+    _PREV_CANCEL = _RDK->_CANCEL;
+    _PREV_CANCEL_SET = _RDK->_CANCEL_SET;
+    _RDK->setDeadline(timeout_ms, token);
+    if (_PREV_DEADLINE >= 0 && (_RDK->_DEADLINE < 0 || _PREV_DEADLINE < _RDK->_DEADLINE)){
+        // nested scopes can not extend the deadline of the outer scope
+        _RDK->_DEADLINE = _PREV_DEADLINE;
+    }
 }
 
+DeadlineScope::~DeadlineScope(){
+    _RDK->_DEADLINE = _PREV_DEADLINE;
+    _RDK->_CANCEL = _PREV_CANCEL;
+    _RDK->_CANCEL_SET = _PREV_CANCEL_SET;
+}
 
+bool DeadlineScope::Aborted() const {
+    return _RDK->_ABORT_COUNT != _ABORT_COUNT;
+}
 
 
-/// <summary>
-/// Update the robot milling path input and parameters. Parameter input can be an NC file (G-code or APT file) or an object item in RoboDK. A curve or a point follow project will be automatically set up for a robot manufacturing project.
-/// Tip: Use getLink() and setLink() to get/set the robot tool, reference frame, robot and program linked to the project.
-/// Tip: Use setPose() and setJoints() to update the path to tool orientation or the preferred start joints.
-/// </summary>
-/// <param name="ncfile">path to the NC (G-code/APT/Point cloud) file to load (optional)</param>
-/// <param name="part_obj">object holding curves or points to automatically set up a curve/point follow project (optional)</param>
-/// <param name="options">Additional options (optional)</param>
-/// <returns>Program linked to the project (invalid item if failed to update). Use Update() to retrieve the result</returns>
-Item Item::setMachiningParameters(QString ncfile, Item part_obj, QString options)
+
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// RoboDKPool CLASS ////////////////////////////////////////////////
+RoboDKPool::RoboDKPool(const QString &robodk_ip, int com_port, int max_links, QSharedPointer<RoboDKTransport> transport) :
+    _IP(robodk_ip),
+    _PORT(com_port),
+    _MAX_LINKS(qMax(max_links, 0)),
+    _TRANSPORT(transport),
+    _CREATING(0)
 {
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_MachiningParams");
-    _RDK->_send_Item(this);
-    _RDK->_send_Line(ncfile);
-    _RDK->_send_Item(part_obj);
-    _RDK->_send_Line("NO_UPDATE " + options);
-    _RDK->_TIMEOUT = 3600 * 1000;
-    Item program = _RDK->_recv_Item();
-    _RDK->_TIMEOUT = ROBODK_API_TIMEOUT;
-    double status = _RDK->_recv_Int() / 1000.0;
-    _RDK->_check_status();
-    return program;
 }
 
-/// <summary>
-/// Sets a target as a cartesian target. A cartesian target moves to cartesian coordinates.
-/// </summary>
-void Item::setAsCartesianTarget(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Target_As_RT");
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
+RoboDKPool::~RoboDKPool(){
+    QMutexLocker lock(&_MUTEX);
+    if (!_LEASES.isEmpty()){
+        qDebug() << "RoboDKPool deleted while" << _LEASES.size() << "links are leased";
+    }
+    for (int i=0; i<_LINKS.length(); i++){
+        // sockets must be deleted from the thread they belong to (or a detached socket)
+        _LINKS[i]->_attach_thread();
+        _LINKS[i]->_POOL = nullptr;
+    }
+    qDeleteAll(_LINKS);
+    _LINKS.clear();
+    _IDLE.clear();
+    _LEASES.clear();
 }
 
-/// <summary>
-/// Sets a target as a joint target. A joint target moves to a joints position without regarding the cartesian coordinates.
-/// </summary>
-void Item::setAsJointTarget(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Target_As_JT");
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
+RoboDK *RoboDKPool::Link(){
+    return _lease(nullptr);
 }
 
 /// <summary>
-/// Returns True if a target is a joint target (green icon). Otherwise, the target is a Cartesian target (red icon).
+/// Returns the link of the calling thread, leasing a released link or creating a new one if needed.
 /// </summary>
-bool Item::isJointTarget() const {
-    _RDK->_check_connection();
-    _RDK->_send_Line("Target_Is_JT");
-    _RDK->_send_Item(this);
-    int is_jt = _RDK->_recv_Int();
-    _RDK->_check_status();
-    return is_jt > 0;
+RoboDK *RoboDKPool::_lease(bool *leased_now){
+    Qt::HANDLE thread_id = QThread::currentThreadId();
+    if (leased_now != nullptr){
+        *leased_now = false;
+    }
+    QMutexLocker lock(&_MUTEX);
+    RoboDK *link = _LEASES.value(thread_id, nullptr);
+    if (link != nullptr){
+        return link;
+    }
+    while (_IDLE.isEmpty() && _MAX_LINKS > 0 && _LINKS.length() + _CREATING >= _MAX_LINKS){
+        _RELEASED.wait(&_MUTEX);
+    }
+    if (!_IDLE.isEmpty()){
+        link = _IDLE.takeLast();
+        link->_attach_thread();
+    } else {
+        // connecting may take a while: create the link outside the lock
+        _CREATING++;
+        lock.unlock();
+        link = new RoboDK(_TRANSPORT, _IP, _PORT);
+        lock.relock();
+        _CREATING--;
+        link->_POOL = this;
+        _LINKS.append(link);
+    }
+    _LEASES.insert(thread_id, link);
+    if (leased_now != nullptr){
+        *leased_now = true;
+    }
+    return link;
+}
+
+void RoboDKPool::Release(){
+    Qt::HANDLE thread_id = QThread::currentThreadId();
+    QMutexLocker lock(&_MUTEX);
+    RoboDK *link = _LEASES.take(thread_id);
+    if (link == nullptr){
+        return;
+    }
+    link->_detach_thread();
+    _IDLE.append(link);
+    _RELEASED.wakeOne();
 }
 
-//#####Robot item calls####
+int RoboDKPool::Count() const {
+    QMutexLocker lock(&_MUTEX);
+    return _LINKS.length();
+}
 
-/// <summary>
-/// Returns the current joints of a robot or the joints of a target. If the item is a cartesian target, it returns the preferred joints (configuration) to go to that cartesian position.
-/// </summary>
-/// <returns>double x n -> joints matrix</returns>
-tJoints Item::Joints() const {
-    tJoints jnts;
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Thetas");
-    _RDK->_send_Item(this);
-    _RDK->_recv_Array(&jnts);
-    _RDK->_check_status();
-    return jnts;
+int RoboDKPool::Leased() const {
+    QMutexLocker lock(&_MUTEX);
+    return _LEASES.size();
 }
 
-// add more methods
 
-/// <summary>
-/// Returns the home joints of a robot. These joints can be manually set in the robot "Parameters" menu, then select "Set home position"
-/// </summary>
-/// <returns>double x n -> joints array</returns>
-tJoints Item::JointsHome() const {
-    tJoints jnts;
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Home");
-    _RDK->_send_Item(this);
-    _RDK->_recv_Array(&jnts);
-    _RDK->_check_status();
-    return jnts;
+RoboDKLease::RoboDKLease(RoboDKPool &pool) :
+    _POOL(&pool),
+    _RELEASE(false)
+{
+    _LINK = _POOL->_lease(&_RELEASE);
 }
 
-
-/// <summary>
-/// Sets the joint position of the "home" joints for a robot.
-/// </summary>
-/// <param name="joints"></param>
-void Item::setJointsHome(const tJoints &jnts){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Home");
-    _RDK->_send_Array(&jnts);
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
+RoboDKLease::~RoboDKLease(){
+    if (_RELEASE){
+        _POOL->Release();
+    }
 }
 
-/// <summary>
-/// Returns an item pointer (:class:`.Item`) to a robot link. This is useful to show/hide certain robot links or alter their geometry.
-/// </summary>
-/// <param name="link_id">link index(0 for the robot base, 1 for the first link, ...)</param>
-/// <returns></returns>
-Item Item::ObjectLink(int link_id){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_LinkObjId");
-    _RDK->_send_Item(this);
-    _RDK->_send_Int(link_id);
-    Item item = _RDK->_recv_Item();
-    _RDK->_check_status();
-    return item;
+RoboDK *RoboDKLease::Link() const {
+    return _LINK;
 }
 
-/// <summary>
-/// Returns an item pointer (Item class) to a robot, object, tool or program. This is useful to retrieve the relationship between programs, robots, tools and other specific projects.
-/// </summary>
-/// <param name="type_linked">type of linked object to retrieve</param>
-/// <returns></returns>
-Item Item::getLink(int type_linked){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_LinkType");
-    _RDK->_send_Item(this);
-    _RDK->_send_Int(type_linked);
-    Item item = _RDK->_recv_Item();
-    _RDK->_check_status();
-    return item;
+RoboDK *RoboDKLease::operator->() const {
+    return _LINK;
 }
 
 
-/// <summary>
-/// Sets the current joints of a robot or the joints of a target. It the item is a cartesian target, it returns the preferred joints (configuration) to go to that cartesian position.
-/// </summary>
-/// <param name="joints"></param>
-void Item::setJoints(const tJoints &jnts){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Thetas");
-    _RDK->_send_Array(&jnts);
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
-}
 
-/// <summary>
-/// Returns the joint limits of a robot
-/// </summary>
-/// <param name="lower_limits"></param>
-/// <param name="upper_limits"></param>
-void Item::JointLimits(tJoints *lower_limits, tJoints *upper_limits){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_RobLimits");
-    _RDK->_send_Item(this);
-    _RDK->_recv_Array(lower_limits);
-    _RDK->_recv_Array(upper_limits);
-    double joints_type = _RDK->_recv_Int() / 1000.0;
-    _RDK->_check_status();
-}
 
-/// <summary>
-/// Sets the robot of a program or a target. You must set the robot linked to a program or a target every time you copy paste these objects.
-/// If the robot is not provided, the first available robot will be chosen automatically.
-/// </summary>
-/// <param name="robot">Robot item</param>
-void Item::setRobot(const Item &robot){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Robot");
-    _RDK->_send_Item(this);
-    _RDK->_send_Item(robot);
-    _RDK->_check_status();
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// RoboDKInstancePool CLASS ////////////////////////////////////////
+
+/// Thread running a task for one instance of a RoboDKInstancePool
+class InstancePoolThread : public QThread {
+public:
+    InstancePoolThread(const std::function<void(int)> &task, int index) :
+        _TASK(task),
+        _INDEX(index)
+    {
+    }
+
+protected:
+    void run() override {
+        _TASK(_INDEX);
+    }
+
+private:
+    std::function<void(int)> _TASK;
+    int _INDEX;
+};
+
+/// Jobs assigned to one instance. The owner takes jobs from the front, other instances steal from the back.
+struct tInstanceJobQueue {
+    QMutex mutex;
+    QList<int> jobs;
+};
+
+static bool InstancePool_IsLocal(const QString &robodk_ip){
+    return robodk_ip.isEmpty() || robodk_ip == "127.0.0.1" || robodk_ip == "localhost";
 }
 
+RoboDKInstancePool::RoboDKInstancePool(int instances, int first_port, const QString &robodk_ip, const QString &args, const QString &path) :
+    _COUNT(qMax(instances, 1)),
+    _FIRST_PORT(first_port),
+    _IP(robodk_ip),
+    _ARGS(args),
+    _PATH(path)
+{
+}
 
-/// <summary>
-/// Adds an empty tool to the robot provided the tool pose (4x4 Matrix) and the tool name.
-/// </summary>
-/// <param name="tool_pose">pose -> TCP as a 4x4 Matrix (pose of the tool frame)</param>
-/// <param name="tool_name">New tool name</param>
-/// <returns>new item created</returns>
-Item Item::AddTool(const Mat &tool_pose, const QString &tool_name){
-    _RDK->_check_connection();
-    _RDK->_send_Line("AddToolEmpty");
-    _RDK->_send_Item(this);
-    _RDK->_send_Pose(tool_pose);
-    _RDK->_send_Line(tool_name);
-    Item newtool = _RDK->_recv_Item();
-    _RDK->_check_status();
-    return newtool;
+RoboDKInstancePool::~RoboDKInstancePool(){
+    for (int i=0; i<_LINKS.length(); i++){
+        if (_LINKS[i] != nullptr){
+            _LINKS[i]->_attach_thread();
+            delete _LINKS[i];
+        }
+    }
+    _LINKS.clear();
 }
 
 /// <summary>
-/// Computes the forward kinematics of the robot for the provided joints. The tool and the reference frame are not taken into account.
+/// Run a task for each instance, each one in its own thread, and wait until all the tasks finished.
 /// </summary>
-/// <param name="joints"></param>
-/// <returns>4x4 homogeneous matrix: pose of the robot flange with respect to the robot base</returns>
-Mat Item::SolveFK(const tJoints &joints, const Mat *tool, const Mat *ref){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_FK");
-    _RDK->_send_Array(&joints);
-    _RDK->_send_Item(this);
-    Mat pose = _RDK->_recv_Pose();
-    Mat base2flange(pose);
-    if (tool != nullptr){
-        base2flange = pose*(*tool);
+void RoboDKInstancePool::_each(const std::function<void(int)> &task){
+    QList<InstancePoolThread*> threads;
+    for (int i=0; i<_LINKS.length(); i++){
+        InstancePoolThread *thread = new InstancePoolThread(task, i);
+        threads.append(thread);
+        thread->start();
     }
-    if (ref != nullptr){
-        base2flange = ref->inv() * base2flange;
+    for (int i=0; i<threads.length(); i++){
+        threads[i]->wait();
     }
-    _RDK->_check_status();
-    return base2flange;
+    qDeleteAll(threads);
 }
 
-/// <summary>
-/// Returns the robot configuration state for a set of robot joints.
-/// </summary>
-/// <param name="joints">array of joints</param>
-/// <returns>3-array -> configuration status as [REAR, LOWERARM, FLIP]</returns>
-void Item::JointsConfig(const tJoints &joints, tConfig config){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_Thetas_Config");
-    _RDK->_send_Array(&joints);
-    _RDK->_send_Item(this);
-    int sz = RDK_SIZE_MAX_CONFIG;
-    _RDK->_recv_Array(config, &sz);
-    _RDK->_check_status();
-    //return config;
+int RoboDKInstancePool::Start(const QString &station){
+    if (_LINKS.isEmpty()){
+        for (int i=0; i<_COUNT; i++){
+            _LINKS.append(nullptr);
+        }
+    }
+    // connecting may start RoboDK: start all the instances at the same time
+    QAtomicInt ready(0);
+    _each([&](int i){
+        if (_LINKS[i] == nullptr){
+            RoboDK *link = new RoboDK(_IP, _FIRST_PORT + i, _ARGS, _PATH);
+            if (!link->Connected()){
+                qDebug() << "RoboDKInstancePool: instance on port" << _FIRST_PORT + i << "is not available";
+                delete link;
+                return;
+            }
+            _LINKS[i] = link;
+        } else {
+            _LINKS[i]->_attach_thread();
+        }
+        ready.fetchAndAddOrdered(1);
+        _LINKS[i]->_detach_thread();
+    });
+    if (!station.isEmpty()){
+        return LoadStation(station);
+    }
+    return ready.load();
+}
+
+int RoboDKInstancePool::LoadStation(const QString &station){
+    bool local = InstancePool_IsLocal(_IP);
+    QString file_remote = QFileInfo(station).fileName();
+    QAtomicInt loaded(0);
+    _each([&](int i){
+        RoboDK *link = _LINKS[i];
+        if (link == nullptr){
+            return;
+        }
+        link->_attach_thread();
+        bool ok;
+        if (local){
+            ok = link->AddFile(station).Valid();
+        } else {
+            ok = link->FileSet(station, file_remote, true);
+        }
+        if (ok){
+            loaded.fetchAndAddOrdered(1);
+        } else {
+            qDebug() << "RoboDKInstancePool: could not load" << station << "on port" << _FIRST_PORT + i;
+        }
+        link->_detach_thread();
+    });
+    return loaded.load();
 }
 
-/// <summary>
-/// Computes the inverse kinematics for the specified robot and pose. The joints returned are the closest to the current robot configuration (see SolveIK_All())
-/// </summary>
-/// <param name="pose">4x4 matrix -> pose of the robot flange with respect to the robot base frame</param>
-/// <param name="tool">4x4 matrix -> Optionally provide a tool, otherwise, the robot flange is used. Tip: use robot.PoseTool() to retrieve the active robot tool.</param>
-/// <param name="reference">4x4 matrix -> Optionally provide a reference, otherwise, the robot base is used. Tip: use robot.PoseFrame() to retrieve the active robot reference frame.</param>
-/// <returns>array of joints</returns>
-tJoints Item::SolveIK(const Mat &pose, const Mat *tool, const Mat *ref){
-    tJoints jnts;
-    Mat base2flange(pose);
-    if (tool != nullptr){
-        base2flange = pose*tool->inv();
+int RoboDKInstancePool::Run(int njobs, const tJob &job, QList<tInstanceJobResult> *results){
+    QVector<tInstanceJobResult> done(qMax(njobs, 0));
+    for (int j=0; j<done.size(); j++){
+        done[j].job = j;
+        done[j].instance = -1;
+        done[j].ok = false;
+        done[j].elapsed = 0;
     }
-    if (ref != nullptr){
-        base2flange = (*ref) * base2flange;
-    }
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_IK");
-    _RDK->_send_Pose(base2flange);
-    _RDK->_send_Item(this);
-    _RDK->_recv_Array(&jnts);
-    _RDK->_check_status();
-    return jnts;
-}
 
+    // deal the jobs in blocks so that each instance starts with neighbouring jobs
+    QList<int> running;
+    for (int i=0; i<_LINKS.length(); i++){
+        if (_LINKS[i] != nullptr){
+            running.append(i);
+        }
+    }
+    if (running.isEmpty()){
+        qDebug() << "RoboDKInstancePool: no instance available, call Start() first";
+    } else {
+        int nqueues = running.length();
+        QVector<tInstanceJobQueue*> queues(nqueues);
+        for (int q=0; q<nqueues; q++){
+            queues[q] = new tInstanceJobQueue();
+        }
+        for (int j=0; j<njobs; j++){
+            queues[(int)(((qint64) j * nqueues) / njobs)]->jobs.append(j);
+        }
 
+        QList<InstancePoolThread*> threads;
+        std::function<void(int)> worker = [&](int q){
+            RoboDK *link = _LINKS[running[q]];
+            link->_attach_thread();
+            QElapsedTimer timer;
+            forever {
+                int j = -1;
+                {
+                    QMutexLocker lock(&queues[q]->mutex);
+                    if (!queues[q]->jobs.isEmpty()){
+                        j = queues[q]->jobs.takeFirst();
+                    }
+                }
+                for (int k=1; j < 0 && k<nqueues; k++){
+                    tInstanceJobQueue *other = queues[(q + k) % nqueues];
+                    QMutexLocker lock(&other->mutex);
+                    if (!other->jobs.isEmpty()){
+                        j = other->jobs.takeLast();
+                    }
+                }
+                if (j < 0){
+                    break;
+                }
+                timer.start();
+                bool ok = false;
+                try {
+                    ok = job(link, j);
+                } catch (...) {
+                    qDebug() << "RoboDKInstancePool: job" << j << "failed on port" << _FIRST_PORT + running[q];
+                }
+                done[j].instance = running[q];
+                done[j].ok = ok;
+                done[j].elapsed = timer.elapsed();
+            }
+            link->_detach_thread();
+        };
+        for (int q=0; q<nqueues; q++){
+            InstancePoolThread *thread = new InstancePoolThread(worker, q);
+            threads.append(thread);
+            thread->start();
+        }
+        for (int q=0; q<nqueues; q++){
+            threads[q]->wait();
+        }
+        qDeleteAll(threads);
+        qDeleteAll(queues);
+    }
 
-/// <summary>
-/// Computes the inverse kinematics for the specified robot and pose. The joints returned are the closest to the current robot configuration (see SolveIK_All())
-/// </summary>
-/// <param name="pose">4x4 matrix -> pose of the robot flange with respect to the robot base frame</param>
-/// <param name="joints_approx">Aproximate solution. Leave empty to return the closest match to the current robot position.</param>
-/// <param name="tool">4x4 matrix -> Optionally provide a tool, otherwise, the robot flange is used. Tip: use robot.PoseTool() to retrieve the active robot tool.</param>
-/// <param name="reference">4x4 matrix -> Optionally provide a reference, otherwise, the robot base is used. Tip: use robot.PoseFrame() to retrieve the active robot reference frame.</param>
-/// <returns>array of joints</returns>
-tJoints Item::SolveIK(const Mat pose, tJoints joints_approx, const Mat *tool, const Mat *ref){
-    Mat base2flange(pose);
-    if (tool != nullptr){
-        base2flange = pose*tool->inv();
+    int failed = 0;
+    for (int j=0; j<done.size(); j++){
+        if (!done[j].ok){
+            failed++;
+        }
     }
-    if (ref != nullptr){
-        base2flange = (*ref) * base2flange;
+    if (results != nullptr){
+        *results = done.toList();
     }
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_IK_jnts");
-    _RDK->_send_Pose(base2flange);
-    _RDK->_send_Array(&joints_approx);
-    _RDK->_send_Item(this);
-    tJoints jnts;
-    _RDK->_recv_Array(&jnts);
-    _RDK->_check_status();
-    return jnts;
+    return failed;
 }
 
+int RoboDKInstancePool::Count() const {
+    int count = 0;
+    for (int i=0; i<_LINKS.length(); i++){
+        if (_LINKS[i] != nullptr){
+            count++;
+        }
+    }
+    return count;
+}
 
-/// <summary>
-/// Computes the inverse kinematics for the specified robot and pose. The function returns all available joint solutions as a 2D matrix.
-/// </summary>
-/// <param name="pose">4x4 matrix -> pose of the robot tool with respect to the robot frame</param>
-/// <returns>double x n x m -> joint list (2D matrix)</returns>
-tMatrix2D* Item::SolveIK_All_Mat2D(const Mat &pose, const Mat *tool, const Mat *ref){
-    tMatrix2D *mat2d = nullptr;
-    Mat base2flange(pose);
-    if (tool != nullptr){
-        base2flange = pose*tool->inv();
+RoboDK *RoboDKInstancePool::Link(int index) const {
+    if (index < 0 || index >= _LINKS.length()){
+        return nullptr;
     }
-    if (ref != nullptr){
-        base2flange = (*ref) * base2flange;
+    RoboDK *link = _LINKS[index];
+    if (link != nullptr){
+        link->_attach_thread();
     }
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_IK_cmpl");
-    _RDK->_send_Pose(base2flange);
-    _RDK->_send_Item(this);
-    _RDK->_recv_Matrix2D(&mat2d);
-    _RDK->_check_status();
-    return mat2d;
+    return link;
 }
-QList<tJoints> Item::SolveIK_All(const Mat &pose, const Mat *tool, const Mat *ref){
-    tMatrix2D *mat2d = SolveIK_All_Mat2D(pose, tool, ref);
-    QList<tJoints> jnts_list;
-    int ndofs = Matrix2D_Size(mat2d, 1) - 2;
-    int nsol = Matrix2D_Size(mat2d, 2);
-    for (int i=0; i<nsol; i++){
-        tJoints jnts = tJoints(mat2d, i);
-        jnts.setLength(jnts.Length() - 2);
-        jnts_list.append(jnts);
+
+void RoboDKInstancePool::Close(){
+    for (int i=0; i<_LINKS.length(); i++){
+        if (_LINKS[i] != nullptr){
+            _LINKS[i]->_attach_thread();
+            _LINKS[i]->CloseRoboDK();
+            delete _LINKS[i];
+        }
     }
-    return jnts_list;
+    _LINKS.clear();
 }
 
-/// <summary>
-/// Connect to a real robot using the robot driver.
-/// </summary>
-/// <param name="robot_ip">IP of the robot to connect. Leave empty to use the one defined in RoboDK</param>
-/// <returns>status -> true if connected successfully, false if connection failed</returns>
-bool Item::Connect(const QString &robot_ip){
+
+MotionQueue::MotionQueue(const Item &robot, int max_in_flight, double timeout_sec) :
+    _ROBOT(robot)
+{
+    _RDK = _ROBOT.RDK();
+    _MAX_IN_FLIGHT = qMax(max_in_flight, 1);
+    _TIMEOUT = (int)(timeout_sec * 1000.0);
+    _COUNT = 0;
+}
+
+MotionQueue::~MotionQueue(){
+    WaitDone();
+}
+
+void MotionQueue::MoveJ(const Item &itemtarget){
+    _RDK->_motion_wait(&_ROBOT, _MAX_IN_FLIGHT - 1);
     _RDK->_check_connection();
-    _RDK->_send_Line("Connect");
-    _RDK->_send_Item(this);
-    _RDK->_send_Line(robot_ip);
-    int status = _RDK->_recv_Int();
-    _RDK->_check_status();
-    return status != 0;
+    _RDK->_send_MoveX(&itemtarget, nullptr, nullptr, &_ROBOT, 1, true);
+    _queued();
 }
 
-/// <summary>
-/// Disconnect from a real robot (when the robot driver is used)
-/// </summary>
-/// <returns>status -> true if disconnected successfully, false if it failed. It can fail if it was previously disconnected manually for example.</returns>
-bool Item::Disconnect(){
+void MotionQueue::MoveJ(const tJoints &joints){
+    _RDK->_motion_wait(&_ROBOT, _MAX_IN_FLIGHT - 1);
     _RDK->_check_connection();
-    _RDK->_send_Line("Disconnect");
-    _RDK->_send_Item(this);
-    int status = _RDK->_recv_Int();
-    _RDK->_check_status();
-    return status != 0;
+    _RDK->_send_MoveX(nullptr, &joints, nullptr, &_ROBOT, 1, true);
+    _queued();
 }
 
-/// <summary>
-/// Moves a robot to a specific target ("Move Joint" mode). By default, this function blocks until the robot finishes its movements.
-/// </summary>
-/// <param name="target">target -> target to move to as a target item (RoboDK target item)</param>
-/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
-void Item::MoveJ(const Item &itemtarget, bool blocking){
-    if (_TYPE == RoboDK::ITEM_TYPE_PROGRAM){
-        _RDK->_check_connection();
-        _RDK->_send_Line("Add_INSMOVE");
-        _RDK->_send_Item(itemtarget);
-        _RDK->_send_Item(this);
-        _RDK->_send_Int(1);
-        _RDK->_check_status();
-    } else {
-        _RDK->_moveX(&itemtarget, nullptr, nullptr, this, 1, blocking);
-    }
+void MotionQueue::MoveJ(const Mat &target){
+    _RDK->_motion_wait(&_ROBOT, _MAX_IN_FLIGHT - 1);
+    _RDK->_check_connection();
+    _RDK->_send_MoveX(nullptr, nullptr, &target, &_ROBOT, 1, true);
+    _queued();
 }
 
-/// <summary>
-/// Moves a robot to a specific target ("Move Joint" mode). By default, this function blocks until the robot finishes its movements.
-/// </summary>
-/// <param name="target">joints -> joint target to move to.</param>
-/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
-void Item::MoveJ(const tJoints &joints, bool blocking){
-    _RDK->_moveX(nullptr, &joints, nullptr, this, 1, blocking);
+void MotionQueue::MoveL(const Item &itemtarget){
+    _RDK->_motion_wait(&_ROBOT, _MAX_IN_FLIGHT - 1);
+    _RDK->_check_connection();
+    _RDK->_send_MoveX(&itemtarget, nullptr, nullptr, &_ROBOT, 2, true);
+    _queued();
 }
 
-/// <summary>
-/// Moves a robot to a specific target ("Move Joint" mode). By default, this function blocks until the robot finishes its movements.
-/// </summary>
-/// <param name="target">pose -> pose target to move to. It must be a 4x4 Homogeneous matrix</param>
-/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
-void Item::MoveJ(const Mat &target, bool blocking){
-    _RDK->_moveX(nullptr, nullptr, &target, this, 1, blocking);
+void MotionQueue::MoveL(const tJoints &joints){
+    _RDK->_motion_wait(&_ROBOT, _MAX_IN_FLIGHT - 1);
+    _RDK->_check_connection();
+    _RDK->_send_MoveX(nullptr, &joints, nullptr, &_ROBOT, 2, true);
+    _queued();
 }
 
-/// <summary>
-/// Moves a robot to a specific target ("Move Linear" mode). By default, this function blocks until the robot finishes its movements.
-/// </summary>
-/// <param name="itemtarget">target -> target to move to as a target item (RoboDK target item)</param>
-/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
-void Item::MoveL(const Item &itemtarget, bool blocking){
-    if (_TYPE == RoboDK::ITEM_TYPE_PROGRAM){
-        _RDK->_check_connection();
-        _RDK->_send_Line("Add_INSMOVE");
-        _RDK->_send_Item(itemtarget);
-        _RDK->_send_Item(this);
-        _RDK->_send_Int(2);
-        _RDK->_check_status();
-    } else {
-        _RDK->_moveX(&itemtarget, nullptr, nullptr, this, 2, blocking);
-    }
+void MotionQueue::MoveL(const Mat &target){
+    _RDK->_motion_wait(&_ROBOT, _MAX_IN_FLIGHT - 1);
+    _RDK->_check_connection();
+    _RDK->_send_MoveX(nullptr, nullptr, &target, &_ROBOT, 2, true);
+    _queued();
 }
 
-/// <summary>
-/// Moves a robot to a specific target ("Move Linear" mode). By default, this function blocks until the robot finishes its movements.
-/// </summary>
-/// <param name="joints">joints -> joint target to move to.</param>
-/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
-void Item::MoveL(const tJoints &joints, bool blocking){
-    _RDK->_moveX(nullptr, &joints, nullptr, this, 2, blocking);
+void MotionQueue::MoveC(const Item &itemtarget1, const Item &itemtarget2){
+    _RDK->_motion_wait(&_ROBOT, _MAX_IN_FLIGHT - 1);
+    _RDK->_check_connection();
+    _RDK->_send_MoveC(&itemtarget1, nullptr, nullptr, &itemtarget2, nullptr, nullptr, &_ROBOT, true);
+    _queued();
 }
 
-/// <summary>
-/// Moves a robot to a specific target ("Move Linear" mode). By default, this function blocks until the robot finishes its movements.
-/// </summary>
-/// <param name="target">pose -> pose target to move to. It must be a 4x4 Homogeneous matrix</param>
-/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
-void Item::MoveL(const Mat &target, bool blocking){
-    _RDK->_moveX(nullptr, nullptr, &target, this, 2, blocking);
+void MotionQueue::MoveC(const tJoints &joints1, const tJoints &joints2){
+    _RDK->_motion_wait(&_ROBOT, _MAX_IN_FLIGHT - 1);
+    _RDK->_check_connection();
+    _RDK->_send_MoveC(nullptr, &joints1, nullptr, nullptr, &joints2, nullptr, &_ROBOT, true);
+    _queued();
 }
 
-/// <summary>
-/// Moves a robot to a specific target ("Move Circular" mode). By default, this function blocks until the robot finishes its movements.
-/// </summary>
-/// <param name="itemtarget1">target -> intermediate target to move to as a target item (RoboDK target item)</param>
-/// <param name="itemtarget2">target -> final target to move to as a target item (RoboDK target item)</param>
-/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
-void Item::MoveC(const Item &itemtarget1, const Item &itemtarget2, bool blocking){
-    _RDK->_moveC(&itemtarget1, nullptr, nullptr, &itemtarget2, nullptr, nullptr, this, blocking);
+void MotionQueue::MoveC(const Mat &target1, const Mat &target2){
+    _RDK->_motion_wait(&_ROBOT, _MAX_IN_FLIGHT - 1);
+    _RDK->_check_connection();
+    _RDK->_send_MoveC(nullptr, nullptr, &target1, nullptr, nullptr, &target2, &_ROBOT, true);
+    _queued();
 }
 
-/// <summary>
-/// Moves a robot to a specific target ("Move Circular" mode). By default, this function blocks until the robot finishes its movements.
-/// </summary>
-/// <param name="joints1">joints -> intermediate joint target to move to.</param>
-/// <param name="joints2">joints -> final joint target to move to.</param>
-/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
-void Item::MoveC(const tJoints &joints1, const tJoints &joints2, bool blocking){
-    _RDK->_moveC(nullptr, &joints1, nullptr, nullptr, &joints2, nullptr, this, blocking);
+int MotionQueue::InFlight() const {
+    return _RDK->_motion_in_flight(&_ROBOT);
 }
 
-/// <summary>
-/// Moves a robot to a specific target ("Move Circular" mode). By default, this function blocks until the robot finishes its movements.
-/// </summary>
-/// <param name="target1">pose -> intermediate pose target to move to. It must be a 4x4 Homogeneous matrix</param>
-/// <param name="target2">pose -> final pose target to move to. It must be a 4x4 Homogeneous matrix</param>
-/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
-void Item::MoveC(const Mat &target1, const Mat &target2, bool blocking){
-    _RDK->_moveC(nullptr, nullptr, &target1, nullptr, nullptr, &target2, this, blocking);
+int MotionQueue::Count() const {
+    return _COUNT;
 }
 
-/// <summary>
-/// Checks if a joint movement is free of collision.
-/// </summary>
-/// <param name="j1">joints -> start joints</param>
-/// <param name="j2">joints -> destination joints</param>
-/// <param name="minstep_deg">(optional): maximum joint step in degrees</param>
-/// <returns>collision : returns 0 if the movement is free of collision. Otherwise it returns the number of pairs of objects that collided if there was a collision.</returns>
-int Item::MoveJ_Test(const tJoints &j1, const tJoints &j2, double minstep_deg){
-    _RDK->_check_connection();
-    _RDK->_send_Line("CollisionMove");
-    _RDK->_send_Item(this);
-    _RDK->_send_Array(&j1);
-    _RDK->_send_Array(&j2);
-    _RDK->_send_Int((int)(minstep_deg * 1000.0));
-    _RDK->_TIMEOUT = 3600 * 1000;
-    int collision = _RDK->_recv_Int();
-    _RDK->_TIMEOUT = ROBODK_API_TIMEOUT;
-    _RDK->_check_status();
-    return collision;
+int MotionQueue::WaitDone(QList<tPipelineError> *errors){
+    _RDK->_motion_wait(&_ROBOT, 0);
+    return _RDK->_motion_errors(&_ROBOT, errors);
 }
 
-/// <summary>
-/// Checks if a linear movement is free of collision.
-/// </summary>
-/// <param name="j1">joints -> start joints</param>
-/// <param name="pose2">joints -> destination pose (active tool with respect to the active reference frame)</param>
-/// <param name="minstep_mm">(optional): maximum joint step in degrees</param>
-/// <returns>collision : returns 0 if the movement is free of collision. Otherwise it returns the number of pairs of objects that collided if there was a collision.</returns>
-int Item::MoveL_Test(const tJoints &j1, const Mat &pose2, double minstep_deg){
-    _RDK->_check_connection();
-    _RDK->_send_Line("CollisionMoveL");
-    _RDK->_send_Item(this);
-    _RDK->_send_Array(&j1);
-    _RDK->_send_Pose(pose2);
-    _RDK->_send_Int((int)(minstep_deg * 1000.0));
-    _RDK->_TIMEOUT = 3600 * 1000;
-    int collision = _RDK->_recv_Int();
-    _RDK->_TIMEOUT = ROBODK_API_TIMEOUT;
-    _RDK->_check_status();
-    return collision;
+void MotionQueue::_queued(){
+    _RDK->_motion_push(&_ROBOT, _COUNT++, _TIMEOUT);
 }
 
 
-/// <summary>
-/// Sets the speed and/or the acceleration of a robot.
-/// </summary>
-/// <param name="speed_linear">linear speed in mm/s (-1 = no change)</param>
-/// <param name="accel_linear">linear acceleration in mm/s2 (-1 = no change)</param>
-/// <param name="speed_joints">joint speed in deg/s (-1 = no change)</param>
-/// <param name="accel_joints">joint acceleration in deg/s2 (-1 = no change)</param>
-void Item::setSpeed(double speed_linear, double accel_linear, double speed_joints, double accel_joints){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_Speed4");
-    _RDK->_send_Item(this);
-    double speed_accel[4];
-    speed_accel[0] = speed_linear;
-    speed_accel[1] = accel_linear;
-    speed_accel[2] = speed_joints;
-    speed_accel[3] = accel_joints;
-    _RDK->_send_Array(speed_accel, 4);
-    _RDK->_check_status();
-}
 
-/// <summary>
-/// Sets the robot movement smoothing accuracy (also known as zone data value).
-/// </summary>
-/// <param name="zonedata">zonedata value (int) (robot dependent, set to -1 for fine movements)</param>
-void Item::setRounding(double zonedata){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_ZoneData");
-    _RDK->_send_Int((int)(zonedata * 1000.0));
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
+/// Command sent for each instruction type of a ProgramBuilder (same order as ProgramBuilder::INS_*)
+static const char *const ProgramBuilder_Commands[] = {
+    "MoveX", "MoveX", "MoveX", "MoveX",
+    "S_Speed4", "S_ZoneData", "setDO", "setAO", "waitDI", "RunPause", "RunCode2"
+};
+
+ProgramBuilder::ProgramBuilder(int reserve){
+    Reserve(reserve);
 }
 
-/// <summary>
-/// Displays a sequence of joints
-/// </summary>
-/// <param name="sequence">joint sequence as a 6xN matrix or instruction sequence as a 7xN matrix</param>
-void Item::ShowSequence(tMatrix2D *sequence){
-    _RDK->_check_connection();
-    _RDK->_send_Line("Show_Seq");
-    _RDK->_send_Matrix2D(sequence);
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
+void ProgramBuilder::Reserve(int instructions){
+    _TYPE.reserve(instructions);
+    _VALUE_START.reserve(instructions);
+    _TEXT_START.reserve(instructions);
+    _VALUES.reserve(instructions * 6);
 }
 
+void ProgramBuilder::MoveJ(const tJoints &joints){
+    _add(INS_MOVEJ_JOINTS, joints.ValuesD(), joints.Length());
+}
 
-/// <summary>
-/// Checks if a robot or program is currently running (busy or moving)
-/// </summary>
-/// <returns>busy status (true=moving, false=stopped)</returns>
-bool Item::Busy(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("IsBusy");
-    _RDK->_send_Item(this);
-    int busy = _RDK->_recv_Int();
-    _RDK->_check_status();
-    return (busy > 0);
+void ProgramBuilder::MoveJ(const Mat &target){
+    _add(INS_MOVEJ_POSE, target.ValuesD(), 16);
 }
 
-/// <summary>
-/// Stops a program or a robot
-/// </summary>
-/// <returns></returns>
-void Item::Stop(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("Stop");
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
+void ProgramBuilder::MoveL(const tJoints &joints){
+    _add(INS_MOVEL_JOINTS, joints.ValuesD(), joints.Length());
 }
 
-/// <summary>
-/// Waits (blocks) until the robot finishes its movement.
-/// </summary>
-/// <param name="timeout_sec">timeout -> Max time to wait for robot to finish its movement (in seconds)</param>
-void Item::WaitMove(double timeout_sec) const{
-    _RDK->_check_connection();
-    _RDK->_send_Line("WaitMove");
-    _RDK->_send_Item(this);
-    _RDK->_check_status();
-    _RDK->_TIMEOUT = (int)(timeout_sec * 1000.0);
-    _RDK->_check_status();//will wait here;
-    _RDK->_TIMEOUT = ROBODK_API_TIMEOUT;
-    //int isbusy = _RDK->Busy(this);
-    //while (isbusy)
-    //{
-    //    busy = _RDK->Busy(item);
-    //}
+void ProgramBuilder::MoveL(const Mat &target){
+    _add(INS_MOVEL_POSE, target.ValuesD(), 16);
 }
 
+void ProgramBuilder::setSpeed(double speed_linear, double accel_linear, double speed_joints, double accel_joints){
+    double speed_accel[4] = { speed_linear, accel_linear, speed_joints, accel_joints };
+    _add(INS_SPEED, speed_accel, 4);
+}
 
-/// <summary>
-/// Sets the accuracy of the robot active or inactive. A robot must have been calibrated to properly use this option.
-/// </summary>
-/// <param name="accurate">set to 1 to use the accurate model or 0 to use the nominal model</param>
-void Item::setAccuracyActive(int accurate){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_AbsAccOn");
-    _RDK->_send_Item(this);
-    _RDK->_send_Int(accurate);
-    _RDK->_check_status();
+void ProgramBuilder::setRounding(double zonedata){
+    _add(INS_ROUNDING, &zonedata, 1);
 }
 
-///////// ADD MORE METHODS
+void ProgramBuilder::setDO(const QString &io_var, const QString &io_value){
+    _add(INS_SET_DO, nullptr, 0);
+    _TEXTS.append(io_var);
+    _TEXTS.append(io_value);
+}
 
+void ProgramBuilder::setAO(const QString &io_var, const QString &io_value){
+    _add(INS_SET_AO, nullptr, 0);
+    _TEXTS.append(io_var);
+    _TEXTS.append(io_value);
+}
 
-// ---- Program item calls -----
+void ProgramBuilder::waitDI(const QString &io_var, const QString &io_value, double timeout_ms){
+    _add(INS_WAIT_DI, &timeout_ms, 1);
+    _TEXTS.append(io_var);
+    _TEXTS.append(io_value);
+}
 
-/// <summary>
-/// Saves a program to a file.
-/// </summary>
-/// <param name="filename">File path of the program</param>
-/// <returns>success</returns>
-bool Item::MakeProgram(const QString &filename){
-    _RDK->_check_connection();
-    _RDK->_send_Line("MakeProg");
-    _RDK->_send_Item(this);
-    _RDK->_send_Line(filename);
-    int prog_status = _RDK->_recv_Int();
-    QString prog_log_str = _RDK->_recv_Line();
-    _RDK->_check_status();
-    bool success = false;
-    if (prog_status > 1) {
-        success = true;
-    }
-    return success; // prog_log_str
+void ProgramBuilder::Pause(double time_ms){
+    _add(INS_PAUSE, &time_ms, 1);
 }
 
-/// <summary>
-/// Sets if the program will be run in simulation mode or on the real robot.
-/// Use: "PROGRAM_RUN_ON_SIMULATOR" to set the program to run on the simulator only or "PROGRAM_RUN_ON_ROBOT" to force the program to run on the robot.
-/// </summary>
-/// <returns>number of instructions that can be executed</returns>
-void Item::setRunType(int program_run_type){
-    _RDK->_check_connection();
-    _RDK->_send_Line("S_ProgRunType");
-    _RDK->_send_Item(this);
-    _RDK->_send_Int(program_run_type);
-    _RDK->_check_status();
+void ProgramBuilder::RunInstruction(const QString &code, int run_type){
+    double type = run_type;
+    _add(INS_RUN_INSTRUCTION, &type, 1);
+    _TEXTS.append(QString(code).replace("\n\n", "<br>").replace("\n", "<br>"));
 }
 
-/// <summary>
-/// Runs a program. It returns the number of instructions that can be executed successfully (a quick program check is performed before the program starts)
-/// This is a non-blocking call. Use IsBusy() to check if the program execution finished.
-/// Notes:
-/// if setRunMode(RUNMODE_SIMULATE) is used  -> the program will be simulated (default run mode)
-/// if setRunMode(RUNMODE_RUN_ROBOT) is used -> the program will run on the robot (default when RUNMODE_RUN_ROBOT is used)
-/// if setRunMode(RUNMODE_RUN_ROBOT) is used together with program.setRunType(PROGRAM_RUN_ON_ROBOT) -> the program will run sequentially on the robot the same way as if we right clicked the program and selected "Run on robot" in the RoboDK GUI
-/// </summary>
-/// <returns>number of instructions that can be executed</returns>
-int Item::RunProgram(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("RunProg");
-    _RDK->_send_Item(this);
-    int prog_status = _RDK->_recv_Int();
-    _RDK->_check_status();
-    return prog_status;
+void ProgramBuilder::Comment(const QString &comment){
+    RunInstruction(comment, RoboDK::INSTRUCTION_COMMENT);
 }
 
+int ProgramBuilder::Count() const {
+    return _TYPE.size();
+}
 
-/// <summary>
-/// Runs a program. It returns the number of instructions that can be executed successfully (a quick program check is performed before the program starts)
-/// Program parameters can be provided for Python calls.
-/// This is a non-blocking call.Use IsBusy() to check if the program execution finished.
-/// Notes: if setRunMode(RUNMODE_SIMULATE) is used  -> the program will be simulated (default run mode)
-/// if setRunMode(RUNMODE_RUN_ROBOT) is used ->the program will run on the robot(default when RUNMODE_RUN_ROBOT is used)
-/// if setRunMode(RUNMODE_RUN_ROBOT) is used together with program.setRunType(PROGRAM_RUN_ON_ROBOT) -> the program will run sequentially on the robot the same way as if we right clicked the program and selected "Run on robot" in the RoboDK GUI
-/// </summary>
-/// <param name="parameters">Number of instructions that can be executed</param>
-int Item::RunCode(const QString &parameters){
-    _RDK->_check_connection();
-    if (parameters.isEmpty()){
-        _RDK->_send_Line("RunProg");
-        _RDK->_send_Item(this);
-    } else {
-        _RDK->_send_Line("RunProgParam");
-        _RDK->_send_Item(this);
-        _RDK->_send_Line(parameters);
-    }
-    int progstatus = _RDK->_recv_Int();
-    _RDK->_check_status();
-    return progstatus;
+void ProgramBuilder::Clear(){
+    _TYPE.resize(0);
+    _VALUE_START.resize(0);
+    _TEXT_START.resize(0);
+    _VALUES.resize(0);
+    _TEXTS.resize(0);
 }
 
-/// <summary>
-/// Adds a program call, code, message or comment inside a program.
-/// </summary>
-/// <param name="code"><string of the code or program to run/param>
-/// <param name="run_type">INSTRUCTION_* variable to specify if the code is a progra</param>
-int Item::RunInstruction(const QString &code, int run_type){
-    _RDK->_check_connection();
-    _RDK->_send_Line("RunCode2");
-    _RDK->_send_Item(this);
-    _RDK->_send_Line(QString(code).replace("\n\n", "<br>").replace("\n", "<br>"));
-    _RDK->_send_Int(run_type);
-    int progstatus = _RDK->_recv_Int();
-    _RDK->_check_status();
-    return progstatus;
+int ProgramBuilder::Commit(const Item &program, QList<tPipelineError> *errors, int max_pending){
+    Item::tLinkScope rdk(&program);
+    QList<tPipelineError> failed;
+    QList<int> pending; // instructions sent whose status was not read yet
+    max_pending = qMax(max_pending, 1);
+    int count = _TYPE.size();
+    int next = 0;
+    // all the instructions are sent and confirmed by a single call
+    bool link_ok = rdk != nullptr;
+    while (link_ok && next < count){
+        if (!rdk->_batch_request(next)){
+            break;
+        }
+        _send(rdk, program, next);
+        pending.append(next++);
+        if (pending.length() >= max_pending){
+            link_ok = _read(rdk, pending.takeFirst(), &failed);
+        } else if (rdk->_SEND_BUFFER.size() >= ROBODK_API_PIPELINE_FLUSH_SIZE){
+            rdk->_send_Flush();
+        }
+    }
+    while (link_ok && !pending.isEmpty()){
+        link_ok = _read(rdk, pending.takeFirst(), &failed);
+    }
+    // the link was lost: the instructions that were not confirmed may be missing from the program
+    for (int i=0; i<pending.length(); i++){
+        tPipelineError error;
+        error.index = pending[i];
+        error.command = ProgramBuilder_Commands[_TYPE[pending[i]]];
+        error.status = -1;
+        error.message = "No response from RoboDK";
+        failed.append(error);
+    }
+    for (int i=next; i<count; i++){
+        tPipelineError error;
+        error.index = i;
+        error.command = ProgramBuilder_Commands[_TYPE[i]];
+        error.status = -1;
+        error.message = "Not sent: the connection with RoboDK was lost";
+        failed.append(error);
+    }
+    if (errors != nullptr){
+        *errors = failed;
+    }
+    return failed.length();
 }
 
-/// <summary>
-/// Generates a pause instruction for a robot or a program when generating code. Set it to -1 (default) if you want the robot to stop and let the user resume the program anytime.
-/// </summary>
-/// <param name="time_ms">Time in milliseconds</param>
-void Item::Pause(double time_ms){
-    _RDK->_check_connection();
-    _RDK->_send_Line("RunPause");
-    _RDK->_send_Item(this);
-    _RDK->_send_Int((int)(time_ms * 1000.0));
-    _RDK->_check_status();
+void ProgramBuilder::_add(int type, const double *values, int nvalues){
+    _TYPE.append((quint8) type);
+    _VALUE_START.append(_VALUES.size());
+    _TEXT_START.append(_TEXTS.size());
+    for (int i=0; i<nvalues; i++){
+        _VALUES.append(values[i]);
+    }
+}
+
+// Write the request of an instruction (same requests as the Item methods, without waiting for their status)
+void ProgramBuilder::_send(RoboDK *rdk, const Item &program, int ins) const {
+    int type = _TYPE[ins];
+    const double *values = _VALUES.constData() + _VALUE_START[ins];
+    int nvalues = (ins + 1 < _TYPE.size() ? _VALUE_START[ins + 1] : _VALUES.size()) - _VALUE_START[ins];
+    const QString *texts = _TEXTS.constData() + _TEXT_START[ins];
+    rdk->_send_Line(ProgramBuilder_Commands[type]);
+    switch (type){
+    case INS_MOVEJ_JOINTS:
+    case INS_MOVEJ_POSE:
+    case INS_MOVEL_JOINTS:
+    case INS_MOVEL_POSE:
+        // same request as _send_MoveX for a joint or pose target
+        rdk->_send_Int((type == INS_MOVEJ_JOINTS || type == INS_MOVEJ_POSE) ? 1 : 2);
+        rdk->_send_Int((type == INS_MOVEJ_JOINTS || type == INS_MOVEL_JOINTS) ? 1 : 2);
+        rdk->_send_Array(values, nvalues);
+        rdk->_send_Item(nullptr);
+        rdk->_send_Item(&program);
+        break;
+    case INS_SPEED:
+        rdk->_send_Item(&program);
+        rdk->_send_Array(values, 4);
+        break;
+    case INS_ROUNDING:
+        rdk->_send_Int((int)(values[0] * 1000.0));
+        rdk->_send_Item(&program);
+        break;
+    case INS_SET_DO:
+    case INS_SET_AO:
+        rdk->_send_Item(&program);
+        rdk->_send_Line(texts[0]);
+        rdk->_send_Line(texts[1]);
+        break;
+    case INS_WAIT_DI:
+        rdk->_send_Item(&program);
+        rdk->_send_Line(texts[0]);
+        rdk->_send_Line(texts[1]);
+        rdk->_send_Int((int)(values[0] * 1000.0));
+        break;
+    case INS_PAUSE:
+        rdk->_send_Item(&program);
+        rdk->_send_Int((int)(values[0] * 1000.0));
+        break;
+    case INS_RUN_INSTRUCTION:
+        rdk->_send_Item(&program);
+        rdk->_send_Line(texts[0]);
+        rdk->_send_Int((int) values[0]);
+        break;
+    }
+}
+
+// Read the response of an instruction. Returns false if the link was lost (the instruction is reported as failed).
+bool ProgramBuilder::_read(RoboDK *rdk, int ins, QList<tPipelineError> *errors) const {
+    if (_TYPE[ins] == INS_RUN_INSTRUCTION){
+        rdk->_recv_Int(); // program status
+    }
+    QString message;
+    int status = rdk->_recv_Status(message);
+    bool link_ok = !rdk->_ABORTED && !rdk->_DESYNC && rdk->_connected();
+    if (!link_ok){
+        status = -1;
+        message = "No response from RoboDK";
+    }
+    if (status != 0){
+        tPipelineError error;
+        error.index = ins;
+        error.command = ProgramBuilder_Commands[_TYPE[ins]];
+        error.status = status;
+        error.message = message;
+        errors->append(error);
+    }
+    return link_ok;
 }
 
 
-/// <summary>
-/// Sets a variable (output) to a given value. This can also be used to set any variables to a desired value.
-/// </summary>
-/// <param name="io_var">io_var -> digital output (string or number)</param>
-/// <param name="io_value">io_value -> value (string or number)</param>
-void Item::setDO(const QString &io_var, const QString &io_value){
-    _RDK->_check_connection();
-    _RDK->_send_Line("setDO");
-    _RDK->_send_Item(this);
-    _RDK->_send_Line(io_var);
-    _RDK->_send_Line(io_value);
-    _RDK->_check_status();
-}
-/// <summary>
-/// Set an analog Output
-/// </summary>
-/// <param name="io_var">Analog Output</param>
-/// <param name="io_value">Value as a string</param>
-void Item::setAO(const QString &io_var, const QString &io_value){
-    _RDK->_check_connection();
-    _RDK->_send_Line("setAO");
-    _RDK->_send_Item(this);
-    _RDK->_send_Line(io_var);
-    _RDK->_send_Line(io_value);
-    _RDK->_check_status();
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// ReachabilityMap CLASS /////////////////////////////////////////
+
+/// Header of a reachability map file, followed by the orientations (16 doubles each),
+/// the orientation bitsets (quint64 per voxel) and the solution counts (quint16 per voxel). Values are stored in the byte order of the host.
+struct tReachabilityMapHeader {
+    char magic[8];
+    qint32 byte_order;
+    qint32 version;
+    qint32 size[3];
+    qint32 norientations;
+    double origin[3];
+    double voxel;
+};
+
+static const char ReachabilityMap_Magic[8] = { 'R', 'D', 'K', 'R', 'M', 'A', 'P', '\0' };
+
+ReachabilityMap::ReachabilityMap(){
+    _ORIGIN[0] = _ORIGIN[1] = _ORIGIN[2] = 0;
+    _VOXEL = 0;
+    _SIZE[0] = _SIZE[1] = _SIZE[2] = 0;
+    _FILE = nullptr;
+    _MAP = nullptr;
+    _BITS = nullptr;
+    _COUNT = nullptr;
+}
+
+ReachabilityMap::~ReachabilityMap(){
+    Close();
+}
+
+void ReachabilityMap::_clearData(){
+    if (_FILE != nullptr){
+        if (_MAP != nullptr){
+            _FILE->unmap(_MAP);
+        }
+        _FILE->close();
+        delete _FILE;
+        _FILE = nullptr;
+    }
+    _MAP = nullptr;
+    _BITS_DATA.clear();
+    _COUNT_DATA.clear();
+    _BITS = nullptr;
+    _COUNT = nullptr;
 }
 
-/// <summary>
-/// Get a Digital Input (DI). This function is only useful when connected to a real robot using the robot driver. It returns a string related to the state of the Digital Input (1=True, 0=False). This function returns an empty string if the script is not executed on the robot.
-/// </summary>
-/// <param name="io_var">io_var -> digital input (string or number as a string)</param>
-QString Item::getDI(const QString &io_var){
-    _RDK->_check_connection();
-    _RDK->_send_Line("getDI");
-    _RDK->_send_Item(this);
-    _RDK->_send_Line(io_var);
-    QString io_value(_RDK->_recv_Line());
-    _RDK->_check_status();
-    return io_value;
+bool ReachabilityMap::setGrid(const tXYZ origin, double voxel_size, int nx, int ny, int nz){
+    _clearData();
+    if (voxel_size <= 0 || nx <= 0 || ny <= 0 || nz <= 0 || (qint64) nx * ny * nz > INT_MAX){
+        _SIZE[0] = _SIZE[1] = _SIZE[2] = 0;
+        return false;
+    }
+    for (int i=0; i<3; i++){
+        _ORIGIN[i] = origin[i];
+    }
+    _VOXEL = voxel_size;
+    _SIZE[0] = nx;
+    _SIZE[1] = ny;
+    _SIZE[2] = nz;
+    return true;
 }
 
-/// <summary>
-/// Get an Analog Input (AI). This function is only useful when connected to a real robot using the robot driver. It returns a string related to the state of the Digital Input (0-1 or other range depending on the robot driver). This function returns an empty string if the script is not executed on the robot.
-/// </summary>
-/// <param name="io_var">io_var -> analog input (string or number as a string)</param>
-QString Item::getAI(const QString &io_var){
-    _RDK->_check_connection();
-    _RDK->_send_Line("getAI");
-    _RDK->_send_Item(this);
-    _RDK->_send_Line(io_var);
-    QString di_value(_RDK->_recv_Line());
-    _RDK->_check_status();
-    return di_value;
+bool ReachabilityMap::setOrientations(const QList<Mat> &orientations){
+    _clearData();
+    if (orientations.length() > 64){
+        qDebug() << "A reachability map supports up to 64 orientations";
+        return false;
+    }
+    _ORIENTATIONS = orientations;
+    return true;
 }
 
-/// <summary>
-/// Waits for an input io_id to attain a given value io_value. Optionally, a timeout can be provided.
-/// </summary>
-/// <param name="io_var">io_var -> digital output (string or number)</param>
-/// <param name="io_value">io_value -> value (string or number)</param>
-/// <param name="timeout_ms">int (optional) -> timeout in miliseconds</param>
-void Item::waitDI(const QString &io_var, const QString &io_value, double timeout_ms){
-    _RDK->_check_connection();
-    _RDK->_send_Line("waitDI");
-    _RDK->_send_Item(this);
-    _RDK->_send_Line(io_var);
-    _RDK->_send_Line(io_value);
-    _RDK->_send_Int((int)(timeout_ms * 1000.0));
-    _RDK->_check_status();
+int ReachabilityMap::Build(Item &robot, const Mat *tool, const Mat *ref){
+    _clearData();
+    int nvoxels = Size();
+    int norient = _ORIENTATIONS.length();
+    if (nvoxels <= 0 || norient <= 0){
+        return -1;
+    }
+    _BITS_DATA.fill(0, nvoxels);
+    _COUNT_DATA.fill(0, nvoxels);
+
+    // voxels are solved in chunks: all orientations of a voxel belong to the same chunk
+    int chunk_voxels = qMax(1, ROBODK_API_RMAP_CHUNK / norient);
+    int chunk_poses = chunk_voxels * norient;
+    QVector<double> poses(16 * chunk_poses);
+    QVector<double> solutions(8 * 6 * chunk_poses);
+    QVector<int> nsolutions(chunk_poses);
+    int reachable = 0;
+    for (int first=0; first<nvoxels; first+=chunk_voxels){
+        int n = qMin(chunk_voxels, nvoxels - first);
+        for (int v=0; v<n; v++){
+            tXYZ xyz;
+            VoxelCenter(first + v, xyz);
+            for (int o=0; o<norient; o++){
+                double *pose = poses.data() + 16 * (v*norient + o);
+                memcpy(pose, _ORIENTATIONS[o].ValuesD(), 16 * sizeof(double));
+                pose[12] = xyz[0];
+                pose[13] = xyz[1];
+                pose[14] = xyz[2];
+            }
+        }
+        if (!robot.SolveIK_All(poses.constData(), n * norient, solutions.data(), nsolutions.data(), nullptr, tool, ref)){
+            _clearData();
+            return -1;
+        }
+        for (int v=0; v<n; v++){
+            quint64 bits = 0;
+            int count = 0;
+            for (int o=0; o<norient; o++){
+                int nsol = nsolutions[v*norient + o];
+                if (nsol > 0){
+                    bits |= (quint64(1) << o);
+                    count += nsol;
+                }
+            }
+            _BITS_DATA[first + v] = bits;
+            _COUNT_DATA[first + v] = (quint16) qMin(count, 65535);
+            if (bits != 0){
+                reachable++;
+            }
+        }
+    }
+    _BITS = _BITS_DATA.constData();
+    _COUNT = _COUNT_DATA.constData();
+    return reachable;
 }
 
+bool ReachabilityMap::Save(const QString &filename) const {
+    if (!Valid()){
+        return false;
+    }
+    tReachabilityMapHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ReachabilityMap_Magic, sizeof(header.magic));
+    header.byte_order = 0x01020304;
+    header.version = 1;
+    for (int i=0; i<3; i++){
+        header.size[i] = _SIZE[i];
+        header.origin[i] = _ORIGIN[i];
+    }
+    header.norientations = _ORIENTATIONS.length();
+    header.voxel = _VOXEL;
 
-/// <summary>
-/// Add a custom instruction. This instruction will execute a Python file or an executable file.
-/// </summary>
-/// <param name="name"></param>
-/// <param name="path_run">path to run(relative to RoboDK/bin folder or absolute path)</param>
-/// <param name="path_icon">icon path(relative to RoboDK/bin folder or absolute path)</param>
-/// <param name="blocking">True if blocking, 0 if it is a non blocking executable trigger</param>
-/// <param name="cmd_run_on_robot">Command to run through the driver when connected to the robot</param>
-/// :param name: digital input (string or number)
-void Item::customInstruction(const QString &name, const QString &path_run, const QString &path_icon, bool blocking, const QString &cmd_run_on_robot){
-    _RDK->_check_connection();
-    _RDK->_send_Line("InsCustom2");
-    _RDK->_send_Item(this);
-    _RDK->_send_Line(name);
-    _RDK->_send_Line(path_run);
-    _RDK->_send_Line(path_icon);
-    _RDK->_send_Line(cmd_run_on_robot);
-    _RDK->_send_Int(blocking ? 1 : 0);
-    _RDK->_check_status();
+    QFile file(filename);
+    if (!file.open(QFile::WriteOnly)){
+        qDebug() << "Can't open" << filename;
+        return false;
+    }
+    qint64 nvoxels = Size();
+    bool ok = file.write((const char*) &header, sizeof(header)) == sizeof(header);
+    for (int o=0; ok && o<_ORIENTATIONS.length(); o++){
+        ok = file.write((const char*) _ORIENTATIONS[o].ValuesD(), 16 * sizeof(double)) == 16 * sizeof(double);
+    }
+    ok = ok && file.write((const char*) _BITS, nvoxels * sizeof(quint64)) == nvoxels * (qint64) sizeof(quint64);
+    ok = ok && file.write((const char*) _COUNT, nvoxels * sizeof(quint16)) == nvoxels * (qint64) sizeof(quint16);
+    file.close();
+    return ok;
 }
 
-/*
-/////// obsolete functions
-/// <summary>
-/// Adds a new robot move joint instruction to a program.
-/// </summary>
-/// <param name="itemtarget">target to move to</param>
-void Item::addMoveJ(const Item &itemtarget){
-    _RDK->_check_connection();
-    _RDK->_send_Line("Add_INSMOVE");
-    _RDK->_send_Item(itemtarget);
-    _RDK->_send_Item(this);
-    _RDK->_send_Int(1);
-    _RDK->_check_status();
+bool ReachabilityMap::Open(const QString &filename){
+    Close();
+    QFile *file = new QFile(filename);
+    if (!file->open(QFile::ReadOnly)){
+        qDebug() << "Can't open" << filename;
+        delete file;
+        return false;
+    }
+    qint64 file_size = file->size();
+    uchar *map = (file_size >= (qint64) sizeof(tReachabilityMapHeader)) ? file->map(0, file_size) : nullptr;
+    tReachabilityMapHeader header;
+    bool ok = map != nullptr;
+    if (ok){
+        memcpy(&header, map, sizeof(header));
+        ok = memcmp(header.magic, ReachabilityMap_Magic, sizeof(header.magic)) == 0 && header.byte_order == 0x01020304 && header.version == 1
+             && header.size[0] > 0 && header.size[1] > 0 && header.size[2] > 0 && header.norientations >= 0 && header.norientations <= 64;
+    }
+    qint64 nvoxels = ok ? (qint64) header.size[0] * header.size[1] * header.size[2] : 0;
+    qint64 offset_bits = ok ? sizeof(header) + (qint64) header.norientations * 16 * sizeof(double) : 0;
+    ok = ok && nvoxels <= INT_MAX && file_size == offset_bits + nvoxels * (qint64) (sizeof(quint64) + sizeof(quint16));
+    if (!ok){
+        qDebug() << "Invalid reachability map file:" << filename;
+        if (map != nullptr){
+            file->unmap(map);
+        }
+        delete file;
+        return false;
+    }
+    for (int i=0; i<3; i++){
+        _SIZE[i] = header.size[i];
+        _ORIGIN[i] = header.origin[i];
+    }
+    _VOXEL = header.voxel;
+    _ORIENTATIONS.clear();
+    for (int o=0; o<header.norientations; o++){
+        double values[16];
+        memcpy(values, map + sizeof(header) + o * 16 * sizeof(double), sizeof(values));
+        _ORIENTATIONS.append(Mat(values));
+    }
+    _FILE = file;
+    _MAP = map;
+    _BITS = (const quint64*) (map + offset_bits);
+    _COUNT = (const quint16*) (map + offset_bits + nvoxels * sizeof(quint64));
+    return true;
 }
 
-/// <summary>
-/// Adds a new robot move linear instruction to a program.
-/// </summary>
-/// <param name="itemtarget">target to move to</param>
-void Item::addMoveL(const Item &itemtarget){
-    _RDK->_check_connection();
-    _RDK->_send_Line("Add_INSMOVE");
-    _RDK->_send_Item(itemtarget);
-    _RDK->_send_Item(this);
-    _RDK->_send_Int(2);
-    _RDK->_check_status();
+void ReachabilityMap::Close(){
+    _clearData();
 }
-*/
 
-/// <summary>
-/// Show or hide instruction items of a program in the RoboDK tree
-/// </summary>
-/// <param name="show"></param>
-void Item::ShowInstructions(bool visible){
-    _RDK->_check_connection();
-    _RDK->_send_Line("Prog_ShowIns");
-    _RDK->_send_Item(this);
-    _RDK->_send_Int(visible ? 1 : 0);
-    _RDK->_check_status();
+bool ReachabilityMap::Valid() const {
+    return _BITS != nullptr;
 }
 
-/// <summary>
-/// Show or hide targets of a program in the RoboDK tree
-/// </summary>
-/// <param name="show"></param>
-void Item::ShowTargets(bool visible){
-    _RDK->_check_connection();
-    _RDK->_send_Line("Prog_ShowTargets");
-    _RDK->_send_Item(this);
-    _RDK->_send_Int(visible ? 1 : 0);
-    _RDK->_check_status();
+int ReachabilityMap::Size(int dim) const {
+    if (dim >= 0 && dim < 3){
+        return _SIZE[dim];
+    }
+    return _SIZE[0] * _SIZE[1] * _SIZE[2];
+}
+
+QList<Mat> ReachabilityMap::Orientations() const {
+    return _ORIENTATIONS;
+}
+
+int ReachabilityMap::VoxelIndex(const tXYZ xyz) const {
+    if (_VOXEL <= 0){
+        return -1;
+    }
+    int ijk[3];
+    for (int i=0; i<3; i++){
+        double t = floor((xyz[i] - _ORIGIN[i]) / _VOXEL + 0.5);
+        if (t < 0 || t >= _SIZE[i]){
+            return -1;
+        }
+        ijk[i] = (int) t;
+    }
+    return ijk[0] + _SIZE[0] * (ijk[1] + _SIZE[1] * ijk[2]);
+}
+
+void ReachabilityMap::VoxelCenter(int index, tXYZ xyz) const {
+    int i = index % _SIZE[0];
+    int j = (index / _SIZE[0]) % _SIZE[1];
+    int k = index / (_SIZE[0] * _SIZE[1]);
+    xyz[0] = _ORIGIN[0] + i * _VOXEL;
+    xyz[1] = _ORIGIN[1] + j * _VOXEL;
+    xyz[2] = _ORIGIN[2] + k * _VOXEL;
+}
+
+quint64 ReachabilityMap::ReachableBits(int index) const {
+    if (!Valid() || index < 0 || index >= Size()){
+        return 0;
+    }
+    return _BITS[index];
+}
+
+int ReachabilityMap::Solutions(int index) const {
+    if (!Valid() || index < 0 || index >= Size()){
+        return 0;
+    }
+    return _COUNT[index];
+}
+
+bool ReachabilityMap::Reachable(const tXYZ xyz, int orientation) const {
+    quint64 bits = ReachableBits(VoxelIndex(xyz));
+    if (orientation < 0){
+        return bits != 0;
+    }
+    return orientation < 64 && ((bits >> orientation) & 1) != 0;
+}
+
+
+
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// Item CLASS ////////////////////////////////////////////////////
+Item::Item(RoboDK *rdk, quint64 ptr, qint32 type) {
+    _RDK = rdk;
+    _PTR = ptr;
+    _TYPE = type;
+}
+Item::Item(const Item &other) {
+    _RDK = other._RDK;
+    _PTR = other._PTR;
+    _TYPE = other._TYPE;
+}
+Item &Item::operator=(const Item &other) {
+    _RDK = other._RDK;
+    _PTR = other._PTR;
+    _TYPE = other._TYPE;
+    return *this;
+}
+Item::~Item(){
+
+}
+
+QString Item::ToString() const {
+    if (this->Valid()){
+        return QString("Item(&RDK, %1, %2); // %3").arg(_PTR).arg(_TYPE).arg(Name());
+    }
+    return "Item(Invalid)";
 }
 
 
-////////// ADD MORE METHODS
 /// <summary>
-/// Returns the number of instructions of a program.
+/// Returns the RoboDK link Robolink().
 /// </summary>
 /// <returns></returns>
-int Item::InstructionCount(){
-    _RDK->_check_connection();
-    _RDK->_send_Line("Prog_Nins");
-    _RDK->_send_Item(this);
-    int nins = _RDK->_recv_Int();
-    _RDK->_check_status();
-    return nins;
+RoboDK* Item::RDK(){
+    return _link();
 }
 
 /// <summary>
-/// Returns the program instruction at position id
+/// Create a new communication link for RoboDK. Use this for robots if you use a multithread application running multiple robots at the same time.
 /// </summary>
-/// <param name="ins_id"></param>
-/// <param name="name"></param>
-/// <param name="instype"></param>
-/// <param name="movetype"></param>
-/// <param name="isjointtarget"></param>
-/// <param name="target"></param>
-/// <param name="joints"></param>
-void Item::Instruction(int ins_id, QString &name, int &instype, int &movetype, bool &isjointtarget, Mat &target, tJoints &joints){
-    _RDK->_check_connection();
-    _RDK->_send_Line("Prog_GIns");
-    _RDK->_send_Item(this);
-    _RDK->_send_Int(ins_id);
-    name = _RDK->_recv_Line();
-    instype = _RDK->_recv_Int();
-    movetype = 0;
-    isjointtarget = false;
-    //target = null;
-    //joints = null;
-    if (instype == RoboDK::INS_TYPE_MOVE) {
-        movetype = _RDK->_recv_Int();
-        isjointtarget = _RDK->_recv_Int() > 0 ? true : false;
-        target = _RDK->_recv_Pose();
-        _RDK->_recv_Array(&joints);
+void Item::NewLink(){
+    if (_RDK == nullptr || _RDK->_POOL != nullptr){
+        // items of a pool already use the link of the calling thread
+        return;
     }
-    _RDK->_check_status();
+    RoboDK *link = new RoboDK(_RDK->_TRANSPORT, _RDK->_IP, _RDK->_PORT);
+    _RDK->_NEW_LINKS.append(link);
+    _RDK = link;
 }
 
 /// <summary>
-/// Sets the program instruction at position id
+/// Link of the calling thread if the item belongs to a pool. The link stays leased to the thread until RoboDKPool::Release is called.
 /// </summary>
-/// <param name="ins_id"></param>
-/// <param name="name"></param>
-/// <param name="instype"></param>
-/// <param name="movetype"></param>
-/// <param name="isjointtarget"></param>
-/// <param name="target"></param>
-/// <param name="joints"></param>
-void Item::setInstruction(int ins_id, const QString &name, int instype, int movetype, bool isjointtarget, const Mat &target, const tJoints &joints){
-    _RDK->_check_connection();
-    _RDK->_send_Line("Prog_SIns");
-    _RDK->_send_Item(this);
-    _RDK->_send_Int(ins_id);
-    _RDK->_send_Line(name);
-    _RDK->_send_Int(instype);
-    if (instype == RoboDK::INS_TYPE_MOVE)
-    {
-        _RDK->_send_Int(movetype);
-        _RDK->_send_Int(isjointtarget ? 1 : 0);
-        _RDK->_send_Pose(target);
-        _RDK->_send_Array(&joints);
+RoboDK *Item::_link() const {
+    if (_RDK != nullptr && _RDK->_POOL != nullptr){
+        return _RDK->_POOL->Link();
     }
-    _RDK->_check_status();
+    return _RDK;
 }
 
-
 /// <summary>
-/// Returns the list of program instructions as an MxN matrix, where N is the number of instructions and M equals to 1 plus the number of robot axes.
+/// Link used by one call. If the item belongs to a pool and the calling thread does not hold a link yet,
+/// a link is leased for this call only and the pool is returned in release.
 /// </summary>
-/// <param name="instructions">the matrix of instructions</param>
-/// <returns>Returns 0 if success</returns>
-int Item::InstructionList(tMatrix2D *instructions){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_ProgInsList");
-    _RDK->_send_Item(this);
-    _RDK->_recv_Matrix2D(&instructions);
-    int errors = _RDK->_recv_Int();
-    _RDK->_check_status();
-    return errors;
+RoboDK *Item::_link(RoboDKPool **release) const {
+    *release = nullptr;
+    if (_RDK == nullptr || _RDK->_POOL == nullptr){
+        return _RDK;
+    }
+    bool leased_now = false;
+    RoboDK *link = _RDK->_POOL->_lease(&leased_now);
+    if (leased_now){
+        *release = _RDK->_POOL;
+    }
+    return link;
 }
 
+//////// GENERIC ITEM CALLS
+/// <summary>
+/// Returns the type of an item (robot, object, target, reference frame, ...)
+/// </summary>
+/// <returns></returns>
+int Item::Type(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_Item_Type");
+    rdk->_send_Item(this);
+    int itemtype = rdk->_recv_Int();
+    rdk->_check_status();
+    return itemtype;
+}
 
+////// add more methods
 
 /// <summary>
-/// Updates a program and returns the estimated time and the number of valid instructions.
-/// An update can also be applied to a robot machining project. The update is performed on the generated program.
+/// Save a station or object to a file
 /// </summary>
-/// <param name="collision_check">check_collisions: Check collisions (COLLISION_ON -yes- or COLLISION_OFF -no-)</param>
-/// <param name="timeout_sec">Maximum time to wait for the update to complete (in seconds)</param>
-/// <param name="out_nins_time_dist">optional double array [3] = [valid_instructions, program_time, program_distance]</param>
-/// <param name="mm_step">Maximum step in millimeters for linear movements (millimeters). Set to -1 to use the default, as specified in Tools-Options-Motion.</param>
-/// <param name="deg_step">Maximum step for joint movements (degrees). Set to -1 to use the default, as specified in Tools-Options-Motion.</param>
-/// <returns>1.0 if there are no problems with the path or less than 1.0 if there is a problem in the path (ratio of problem)</returns>
-double Item::Update(int collision_check, int timeout_sec, double *out_nins_time_dist, double mm_step, double deg_step){
-    _RDK->_check_connection();
-    _RDK->_send_Line("Update2");
-    _RDK->_send_Item(this);
-    double values[5];
-    values[0] = collision_check;
-    values[1] = mm_step;
-    values[2] = deg_step;
-    _RDK->_send_Array(values, 3);
-    _RDK->_TIMEOUT = timeout_sec * 1000;
-    double return_values[10];
-    int nvalues = 10;
-    _RDK->_recv_Array(return_values, &nvalues);
-    _RDK->_TIMEOUT = ROBODK_API_TIMEOUT;
-    QString readable_msg = _RDK->_recv_Line();
-    _RDK->_check_status();
-    double ratio_ok = return_values[3];
-    if (out_nins_time_dist != nullptr)
-    {
-        out_nins_time_dist[0] = return_values[0]; // number of correct instructions
-        out_nins_time_dist[1] = return_values[1]; // estimated time to complete the program (cycle time)
-        out_nins_time_dist[2] = return_values[2]; // estimated travel distance
-    }
-    return ratio_ok;
+/// <param name="filename"></param>
+void Item::Save(const QString &filename){
+    tLinkScope rdk(this);
+    rdk->Save(filename, this);
 }
 
-
 /// <summary>
-/// Returns a list of joints an MxN matrix, where M is the number of robot axes plus 4 columns. Linear moves are rounded according to the smoothing parameter set inside the program.
+/// Deletes an item and its childs from the station.
 /// </summary>
-/// <param name="error_msg">Returns a human readable error message (if any)</param>
-/// <param name="joint_list">Returns the list of joints as [J1, J2, ..., Jn, ERROR, MM_STEP, DEG_STEP, MOVE_ID] if a file name is not specified</param>
-/// <param name="mm_step">Maximum step in millimeters for linear movements (millimeters)</param>
-/// <param name="deg_step">Maximum step for joint movements (degrees)</param>
-/// <param name="save_to_file">Provide a file name to directly save the output to a file. If the file name is not provided it will return the matrix. If step values are very small, the returned matrix can be very large.</param>
-/// <param name="collision_check">Check for collisions</param>
-/// <param name="result_flag">set to 1 to include the timings between movements, set to 2 to also include the joint speeds (deg/s), set to 3 to also include the accelerations, set to 4 to include all previous information and make the splitting time-based.</param>
-/// <param name="time_step_s">(optional) set the time step in seconds for time based calculation. This value is only used when the result flag is set to 4 (time based).</param>
-/// <returns>Returns 0 if success, otherwise, it will return negative values</returns>
-int Item::InstructionListJoints(QString &error_msg, tMatrix2D **joint_list, double mm_step, double deg_step, const QString &save_to_file, bool collision_check, int result_flag, double time_step_s){
-    _RDK->_check_connection();
-    _RDK->_send_Line("G_ProgJointList");
-    _RDK->_send_Item(this);
-    double step_mm_deg[5] = { mm_step, deg_step, collision_check ? 1.0 : 0.0, (double) result_flag, time_step_s };
-    _RDK->_send_Array(step_mm_deg, 5);
-    _RDK->_TIMEOUT = 3600 * 1000;
-    //joint_list = save_to_file;
-    if (save_to_file.isEmpty()) {
-        _RDK->_send_Line("");
-        _RDK->_recv_Matrix2D(joint_list);
-    } else {
-        _RDK->_send_Line(save_to_file);
-        joint_list = nullptr;
-    }
-    int error_code = _RDK->_recv_Int();
-    _RDK->_TIMEOUT = ROBODK_API_TIMEOUT;
-    error_msg = _RDK->_recv_Line();
-    _RDK->_check_status();
-    return error_code;
+void Item::Delete(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Remove");
+    rdk->_send_Item(this);
+    rdk->_check_status();
+    // the index is kept by the link the item belongs to, the call may have used another link of its pool
+    _RDK->_index_remove(_PTR);
+    rdk->_KINEMATICS.remove(_PTR);
+    rdk->_ROBOT_DOFS.remove(_PTR);
+    _PTR = 0;
+    _TYPE = -1;
 }
 
 /// <summary>
-/// Set a specific item parameter.
-/// Select **Tools-Run Script-Show Commands** to see all available commands for items and the station.
-/// Note: For parameters (commands) that require a JSON string value you can also provide a dict.
+/// Checks if the item is valid. An invalid item will be returned by an unsuccessful function call.
 /// </summary>
-/// <param name="param">item parameter</param>
-/// <param name="value">value</param>
-/// <returns></returns>
-QString Item::setParam(const QString &param, const QString &value){
-    _RDK->_check_connection();
-    _RDK->_send_Line("ICMD");
-    _RDK->_send_Item(this);
-    _RDK->_send_Line(param);
-    _RDK->_send_Line(value);
-    QString result =_RDK->_recv_Line();
-    _RDK->_check_status();
-    return result;
+/// <returns>true if valid, false if invalid</returns>
+bool Item::Valid() const {
+    return _PTR != 0;
+}
+/// <summary>
+/// Attaches the item to a new parent while maintaining the relative position with its parent. The absolute position is changed.
+/// </summary>
+/// <param name="parent"></param>
+void Item::setParent(Item parent){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Parent");
+    rdk->_send_Item(this);
+    rdk->_send_Item(parent);
+    rdk->_check_status();
+    _RDK->_index_reparent(_PTR, parent);
 }
 
 /// <summary>
-/// Disconnect from the RoboDK API. This flushes any pending program generation.
+/// Attaches the item to another parent while maintaining the current absolute position in the station.
+/// The relationship between this item and its parent is changed to maintain the abosolute position.
 /// </summary>
-/// <returns></returns>
-bool Item::Finish(){
-    _RDK->Finish();
-    return true;
+/// <param name="parent">parent item to attach this item</param>
+void Item::setParentStatic(Item parent) {
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Parent_Static");
+    rdk->_send_Item(this);
+    rdk->_send_Item(parent);
+    rdk->_check_status();
+    _RDK->_index_reparent(_PTR, parent);
 }
 
-quint64 Item::GetID(){
-    return _PTR;
+/// <summary>
+/// Attach the closest object to the tool. Returns the item that was attached.
+/// </summary>
+/// <returns>Attached item</returns>
+Item Item::AttachClosest() {
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Attach_Closest");
+    rdk->_send_Item(this);
+    Item item_attached = rdk->_recv_Item();
+    rdk->_check_status();
+    return item_attached;
 }
 
-//----------------------------------------  add more
+/// <summary>
+/// Detach the closest object attached to the tool (see also setParentStatic).
+/// </summary>
+/// <returns>Detached item</returns>
+Item Item::DetachClosest(Item parent) {
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Detach_Closest");
+    rdk->_send_Item(this);
+    rdk->_send_Item(parent);
+    Item item_detached = rdk->_recv_Item();
+    rdk->_check_status();
+    return item_detached;
+}
 
+/// <summary>
+/// Detach any object attached to a tool.
+/// </summary>
+void Item::DetachAll(Item parent) {
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Detach_All");
+    rdk->_send_Item(this);
+    rdk->_send_Item(parent);
+    rdk->_check_status();
+}
 
 
+/// <summary>
+/// Return the parent item of this item
+/// </summary>
+/// <returns>Parent item</returns>
+Item Item::Parent() const {
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_Parent");
+    rdk->_send_Item(this);
+    Item itm_parent = rdk->_recv_Item();
+    rdk->_check_status();
+    return itm_parent;
+}
 
 
-
-
-
-
-
-
-
-//---------------------------------------------------------------------------------------------------
-//---------------------------------------------------------------------------------------------------
-//---------------------------------------------------------------------------------------------------
-//---------------------------------------------------------------------------------------------------
-/////////////////////////////////// RoboDK CLASS ////////////////////////////////////////////////////
-RoboDK::RoboDK(const QString &robodk_ip, int com_port, const QString &args, const QString &path) {
-    _COM = nullptr;
-    _IP = robodk_ip;
-    _TIMEOUT = ROBODK_API_TIMEOUT;
-    _PROCESS = 0;
-    _PORT = com_port;
-    _ROBODK_BIN = path;
-    if (_PORT < 0){
-        _PORT = ROBODK_DEFAULT_PORT;
-    }
-    if (_ROBODK_BIN.isEmpty()){
-        _ROBODK_BIN = ROBODK_DEFAULT_PATH_BIN;
-    }
-    _ARGUMENTS = args;
-    if (com_port > 0){
-        _ARGUMENTS.append(" /PORT=" + QString::number(com_port));
+////// add more methods
+/// <summary>
+/// Returns a list of the item childs that are attached to the provided item.
+/// </summary>
+/// <returns>item x n -> list of child items</returns>
+QList<Item> Item::Childs() const {
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_Childs");
+    rdk->_send_Item(this);
+    int nitems = rdk->_recv_Int();
+    QList<Item> itemlist;
+    for (int i = 0; i < nitems; i++)
+    {
+        itemlist.append(rdk->_recv_Item());
     }
-    _connect_smart();
+    rdk->_check_status();
+    return itemlist;
 }
 
-RoboDK::~RoboDK(){
-    _disconnect();
+/// <summary>
+/// Returns 1 if the item is visible, otherwise, returns 0.
+/// </summary>
+/// <returns>true if visible, false if not visible</returns>
+bool Item::Visible() const {
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_Visible");
+    rdk->_send_Item(this);
+    int visible = rdk->_recv_Int();
+    rdk->_check_status();
+    return (visible != 0);
 }
-
-quint64 RoboDK::ProcessID(){
-    if (_PROCESS == 0) {
-        QString response = Command("MainProcess_ID");
-        _PROCESS = response.toInt();
+/// <summary>
+/// Sets the item visiblity status
+/// </summary>
+/// <param name="visible"></param>
+/// <param name="visible_frame">srt the visible reference frame (1) or not visible (0)</param>
+void Item::setVisible(bool visible, int visible_frame){
+    tLinkScope rdk(this);
+    if (visible_frame < 0)
+    {
+        visible_frame = visible ? 1 : 0;
     }
-    return _PROCESS;
+    rdk->_check_connection();
+    rdk->_send_Line("S_Visible");
+    rdk->_send_Item(this);
+    rdk->_send_Int(visible ? 1 : 0);
+    rdk->_send_Int(visible_frame);
+    rdk->_check_status();
 }
 
-quint64 RoboDK::WindowID(){
-    qint64 window_id;
-    if (window_id == 0) {
-        QString response = Command("MainWindow_ID");
-        window_id = response.toInt();
-    }
-    return window_id;
+/// <summary>
+/// Returns the name of an item. The name of the item is always displayed in the RoboDK station tree
+/// </summary>
+/// <returns>name of the item</returns>
+QString Item::Name() const {
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_Name");
+    rdk->_send_Item(this);
+    QString name = rdk->_recv_Line();
+    rdk->_check_status();
+    return name;
 }
 
-bool RoboDK::Connected(){
-    return _connected();
+/// <summary>
+/// Set the name of a RoboDK item.
+/// </summary>
+/// <param name="name"></param>
+void Item::setName(const QString &name){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Name");
+    rdk->_send_Item(this);
+    rdk->_send_Line(name);
+    rdk->_check_status();
+    _RDK->_index_rename(_PTR, name);
 }
 
-bool RoboDK::Connect(){
-    return _connect();
-}
+// add more methods
+
 /// <summary>
-/// Disconnect from the RoboDK API. This flushes any pending program generation.
+/// Sets the local position (pose) of an object, target or reference frame. For example, the position of an object/frame/target with respect to its parent.
+/// If a robot is provided, it will set the pose of the end efector.
 /// </summary>
-/// <returns></returns>
-void RoboDK::Disconnect(){
-    _disconnect();
+/// <param name="pose">4x4 homogeneous matrix</param>
+void Item::setPose(Mat pose){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Hlocal");
+    rdk->_send_Item(this);
+    rdk->_send_Pose(pose);
+    rdk->_check_status();
 }
+
 /// <summary>
-/// Disconnect from the RoboDK API. This flushes any pending program generation.
+/// Returns the local position (pose) of an object, target or reference frame. For example, the position of an object/frame/target with respect to its parent.
+/// If a robot is provided, it will get the pose of the end efector
 /// </summary>
-/// <returns></returns>
-void RoboDK::Finish(){
-    Disconnect();
+/// <returns>4x4 homogeneous matrix (pose)</returns>
+Mat Item::Pose() const {
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_Hlocal");
+    rdk->_send_Item(this);
+    Mat pose = rdk->_recv_Pose();
+    rdk->_check_status();
+    return pose;
 }
 
-// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-// public methods
 /// <summary>
-/// Returns an item by its name. If there is no exact match it will return the last closest match.
+/// Sets the position (pose) the object geometry with respect to its own reference frame. This procedure works for tools and objects.
 /// </summary>
-/// <param name="name">Item name</param>
-/// <param name="type">Filter by item type RoboDK.ITEM_TYPE_...</param>
-/// <returns></returns>
-Item RoboDK::getItem(QString name, int itemtype){
-    _check_connection();
-    if (itemtype < 0){
-        _send_Line("G_Item");
-        _send_Line(name);
-    } else {
-        _send_Line("G_Item2");
-        _send_Line(name);
-        _send_Int(itemtype);
-    }
-    Item item = _recv_Item();
-    _check_status();
-    return item;
+/// <param name="pose">4x4 homogeneous matrix</param>
+void Item::setGeometryPose(Mat pose){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Hgeom");
+    rdk->_send_Item(this);
+    rdk->_send_Pose(pose);
+    rdk->_check_status();
 }
 
 /// <summary>
-/// Returns a list of items (list of name or pointers) of all available items in the currently open station in robodk.
-/// Optionally, use a filter to return specific items (example: getItemListNames(filter = ITEM_CASE_ROBOT))
+/// Returns the position (pose) the object geometry with respect to its own reference frame. This procedure works for tools and objects.
 /// </summary>
-/// <param name="filter">ITEM_TYPE</param>
-/// <returns></returns>
-QStringList RoboDK::getItemListNames(int filter){
-    _check_connection();
-    if (filter < 0) {
-        _send_Line("G_List_Items");
-    } else {
-        _send_Line("G_List_Items_Type");
-        _send_Int(filter);
-    }
-    qint32 numitems = _recv_Int();
-    QStringList listnames;
-    for (int i = 0; i < numitems; i++) {
-        listnames.append(_recv_Line());
-    }
-    _check_status();
-    return listnames;
+/// <returns>4x4 homogeneous matrix (pose)</returns>
+Mat Item::GeometryPose(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_Hgeom");
+    rdk->_send_Item(this);
+    Mat pose = rdk->_recv_Pose();
+    rdk->_check_status();
+    return pose;
 }
-
+/*
 /// <summary>
-/// Returns a list of items (list of name or pointers) of all available items in the currently open station in robodk.
-/// Optionally, use a filter to return specific items (example: getItemListNames(filter = ITEM_CASE_ROBOT))
+/// Obsolete: Use setPoseTool(pose) instead. Sets the tool pose of a tool item. If a robot is provided it will set the tool pose of the active tool held by the robot.
 /// </summary>
-/// <param name="filter">ITEM_TYPE</param>
-/// <returns></returns>
-QList<Item> RoboDK::getItemList(int filter) {
-    _check_connection();
-    if (filter < 0) {
-        _send_Line("G_List_Items_ptr");
-    } else {
-        _send_Line("G_List_Items_Type_ptr");
-        _send_Int(filter);
-    }
-    int numitems = _recv_Int();
-    QList<Item> listitems;
-    for (int i = 0; i < numitems; i++) {
-        listitems.append(_recv_Item());
-    }
-    _check_status();
-    return listitems;
+/// <param name="pose">4x4 homogeneous matrix (pose)</param>
+void Item::setHtool(Mat pose){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Htool");
+    rdk->_send_Item(this);
+    rdk->_send_Pose(pose);
+    rdk->_check_status();
 }
 
-/////// add more methods
-
 /// <summary>
-/// Shows a RoboDK popup to select one object from the open station.
-/// An item type can be specified to filter desired items. If no type is specified, all items are selectable.
+/// Obsolete: Use PoseTool() instead.
+/// Returns the tool pose of an item. If a robot is provided it will get the tool pose of the active tool held by the robot.
 /// </summary>
-/// <param name="message">Message to pop up</param>
-/// <param name="itemtype">optionally filter by RoboDK.ITEM_TYPE_*</param>
-/// <returns></returns>
-Item RoboDK::ItemUserPick(const QString &message, int itemtype) {
-    _check_connection();
-    _send_Line("PickItem");
-    _send_Line(message);
-    _send_Int(itemtype);
-    _TIMEOUT = 3600 * 1000;
-    Item item = _recv_Item();//item);
-    _TIMEOUT = ROBODK_API_TIMEOUT;
-    _check_status();
-    return item;
+/// <returns>4x4 homogeneous matrix (pose)</returns>
+Mat Item::Htool(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_Htool");
+    rdk->_send_Item(this);
+    Mat pose = rdk->_recv_Pose();
+    rdk->_check_status();
+    return pose;
 }
-
+*/
 /// <summary>
-/// Shows or raises the RoboDK window
+/// Returns the tool pose of an item. If a robot is provided it will get the tool pose of the active tool held by the robot.
 /// </summary>
-void RoboDK::ShowRoboDK() {
-    _check_connection();
-    _send_Line("RAISE");
-    _check_status();
+/// <returns>4x4 homogeneous matrix (pose)</returns>
+Mat Item::PoseTool(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_Tool");
+    rdk->_send_Item(this);
+    Mat pose = rdk->_recv_Pose();
+    rdk->_check_status();
+    return pose;
 }
 
 /// <summary>
-/// Hides the RoboDK window
+/// Returns the reference frame pose of an item. If a robot is provided it will get the tool pose of the active reference frame used by the robot.
 /// </summary>
-void RoboDK::HideRoboDK() {
-    _check_connection();
-    _send_Line("HIDE");
-    _check_status();
+/// <returns>4x4 homogeneous matrix (pose)</returns>
+Mat Item::PoseFrame(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_Frame");
+    rdk->_send_Item(this);
+    Mat pose = rdk->_recv_Pose();
+    rdk->_check_status();
+    return pose;
 }
 
 /// <summary>
-/// Closes RoboDK window and finishes RoboDK execution
+/// Sets the reference frame of a robot(user frame). The frame can be either an item or a pose.
+/// If "frame" is an item, it links the robot to the frame item. If frame is a pose, it updates the linked pose of the robot frame (with respect to the robot reference frame).
 /// </summary>
-void RoboDK::CloseRoboDK() {
-    _check_connection();
-    _send_Line("QUIT");
-    _check_status();
-    _disconnect();
-    _PROCESS = 0;
+/// <param name="frame_pose">4x4 homogeneous matrix (pose)</param>
+void Item::setPoseFrame(Mat frame_pose){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Frame");
+    rdk->_send_Pose(frame_pose);
+    rdk->_send_Item(this);
+    rdk->_check_status();
 }
 
-QString RoboDK::Version()
-{
-    _check_connection();
-    _send_Line("Version");
-    QString appName = _recv_Line();
-    int bitArch = _recv_Int();
-    QString ver4 = _recv_Line();
-    QString dateBuild = _recv_Line();
-    _check_status();
-    return ver4;
-
+/// <summary>
+/// Sets the tool of a robot or a tool object (Tool Center Point, or TCP). The tool pose can be either an item or a 4x4 Matrix.
+/// If the item is a tool, it links the robot to the tool item.If tool is a pose, it updates the current robot TCP.
+/// </summary>
+/// <param name="pose">4x4 homogeneous matrix (pose)</param>
+void Item::setPoseFrame(Item frame_item){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Frame_ptr");
+    rdk->_send_Item(frame_item);
+    rdk->_send_Item(this);
+    rdk->_check_status();
 }
 
-
 /// <summary>
-/// Set the state of the RoboDK window
+/// Sets the tool of a robot or a tool object (Tool Center Point, or TCP). The tool pose can be either an item or a 4x4 Matrix.
+/// If the item is a tool, it links the robot to the tool item.If tool is a pose, it updates the current robot TCP.
 /// </summary>
-/// <param name="windowstate"></param>
-void RoboDK::setWindowState(int windowstate){
-    _check_connection();
-    _send_Line("S_WindowState");
-    _send_Int(windowstate);
-    _check_status();
+/// <param name="tool_pose">4x4 homogeneous matrix (pose)</param>
+void Item::setPoseTool(Mat tool_pose){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Tool");
+    rdk->_send_Pose(tool_pose);
+    rdk->_send_Item(this);
+    rdk->_check_status();
 }
 
-
 /// <summary>
-/// Update the RoboDK flags. RoboDK flags allow defining how much access the user has to RoboDK features. Use FLAG_ROBODK_* variables to set one or more flags.
+/// Sets the tool of a robot or a tool object (Tool Center Point, or TCP). The tool pose can be either an item or a 4x4 Matrix.
+/// If the item is a tool, it links the robot to the tool item.If tool is a pose, it updates the current robot TCP.
 /// </summary>
-/// <param name="flags">state of the window(FLAG_ROBODK_*)</param>
-void RoboDK::setFlagsRoboDK(int flags){
-    _check_connection();
-    _send_Line("S_RoboDK_Rights");
-    _send_Int(flags);
-    _check_status();
+/// <param name="tool_item">Tool item</param>
+void Item::setPoseTool(Item tool_item){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Tool_ptr");
+    rdk->_send_Item(tool_item);
+    rdk->_send_Item(this);
+    rdk->_check_status();
 }
 
 /// <summary>
-/// Update item flags. Item flags allow defining how much access the user has to item-specific features. Use FLAG_ITEM_* flags to set one or more flags.
+/// Sets the global position (pose) of an item. For example, the position of an object/frame/target with respect to the station origin.
 /// </summary>
-/// <param name="item"></param>
-/// <param name="flags"></param>
-void RoboDK::setFlagsItem(Item item, int flags){
-    _check_connection();
-    _send_Line("S_Item_Rights");
-    _send_Item(item);
-    _send_Int(flags);
-    _check_status();
+/// <param name="pose">4x4 homogeneous matrix (pose)</param>
+void Item::setPoseAbs(Mat pose){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Hlocal_Abs");
+    rdk->_send_Item(this);
+    rdk->_send_Pose(pose);
+    rdk->_check_status();
+
 }
 
 /// <summary>
-/// Retrieve current item flags. Item flags allow defining how much access the user has to item-specific features. Use FLAG_ITEM_* flags to set one or more flags.
+/// Returns the global position (pose) of an item. For example, the position of an object/frame/target with respect to the station origin.
 /// </summary>
-/// <param name="item"></param>
-/// <returns></returns>
-int RoboDK::getFlagsItem(Item item){
-    _check_connection();
-    _send_Line("S_Item_Rights");
-    _send_Item(item);
-    int flags = _recv_Int();
-    _check_status();
-    return flags;
+/// <returns>4x4 homogeneous matrix (pose)</returns>
+Mat Item::PoseAbs(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_Hlocal_Abs");
+    rdk->_send_Item(this);
+    Mat pose = rdk->_recv_Pose();
+    rdk->_check_status();
+    return pose;
 }
 
 /// <summary>
-/// Show a message in RoboDK (it can be blocking or non blocking in the status bar)
-/// </summary>
-/// <param name="message">Message to display</param>
-/// <param name="popup">Set to true to make the message blocking or set to false to make it non blocking</param>
-void RoboDK::ShowMessage(const QString &message, bool popup){
-    _check_connection();
-    if (popup)
-    {
-        _send_Line("ShowMessage");
-        _send_Line(message);
-        _TIMEOUT = 3600 * 1000;
-        _check_status();
-        _TIMEOUT = ROBODK_API_TIMEOUT;
-    }
-    else
-    {
-        _send_Line("ShowMessageStatus");
-        _send_Line(message);
-        _check_status();
-    }
+/// Set the color of an object, tool or robot.
+/// A color must in the format COLOR=[R,G,B,(A=1)] where all values range from 0 to 1.
+/// <summary>
+void Item::setColor(double colorRGBA[4]){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Color");
+    rdk->_send_Item(this);
+    rdk->_send_Array(colorRGBA, 4);
+    rdk->_check_status();
 
 }
 
+///--------------------------------- add curve, scale, recolor, ...
+///
+///
+///
+
+
 /// <summary>
-/// Makes a copy of an item (same as Ctrl+C), which can be pasted (Ctrl+V) using Paste().
+/// Apply a scale to an object to make it bigger or smaller.
+/// The scale can be uniform (if scale is a float value) or per axis (if scale is a vector).
 /// </summary>
-/// <param name="tocopy">Item to copy</param>
-void RoboDK::Copy(const Item &tocopy){
-    _check_connection();
-    _send_Line("Copy");
-    _send_Item(tocopy);
-    _check_status();
+/// <param name="scale">scale to apply as scale or [scale_x, scale_y, scale_z]</param>
+void Item::Scale(double scale){
+    double scale_xyz[3];
+    scale_xyz[0] = scale;
+    scale_xyz[1] = scale;
+    scale_xyz[2] = scale;
+    Scale(scale_xyz);
 }
 
 /// <summary>
-/// Paste the copied item as a dependency of another item (same as Ctrl+V). Paste should be used after Copy(). It returns the newly created item.
+/// Apply a per-axis scale to an object to make it bigger or smaller.
+/// The scale can be uniform (if scale is a float value) or per axis (if scale is a vector).
 /// </summary>
-/// <param name="paste_to">Item to attach the copied item (optional)</param>
-/// <returns>New item created</returns>
-Item RoboDK::Paste(const Item *paste_to){
-    _check_connection();
-    _send_Line("Paste");
-    _send_Item(paste_to);
-    Item newitem = _recv_Item();
-    _check_status();
-    return newitem;
+/// <param name="scale">scale to apply as [scale_x, scale_y, scale_z]</param>
+void Item::Scale(double scale_xyz[3]){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Scale");
+    rdk->_send_Item(this);
+    rdk->_send_Array(scale_xyz, 3);
+    rdk->_check_status();
 }
 
+
+
+
 /// <summary>
-/// Loads a file and attaches it to parent. It can be any file supported by robodk.
+/// Update the robot milling path input and parameters. Parameter input can be an NC file (G-code or APT file) or an object item in RoboDK. A curve or a point follow project will be automatically set up for a robot manufacturing project.
+/// Tip: Use getLink() and setLink() to get/set the robot tool, reference frame, robot and program linked to the project.
+/// Tip: Use setPose() and setJoints() to update the path to tool orientation or the preferred start joints.
 /// </summary>
-/// <param name="filename">absolute path of the file</param>
-/// <param name="parent">parent to attach. Leave empty for new stations or to load an object at the station root</param>
-/// <returns>Newly added object. Check with item.Valid() for a successful load</returns>
-Item RoboDK::AddFile(const QString &filename, const Item *parent){
-    _check_connection();
-    _send_Line("Add");
-    _send_Line(filename);
-    _send_Item(parent);
-    Item newitem = _recv_Item();
-    _check_status();
-    return newitem;
+/// <param name="ncfile">path to the NC (G-code/APT/Point cloud) file to load (optional)</param>
+/// <param name="part_obj">object holding curves or points to automatically set up a curve/point follow project (optional)</param>
+/// <param name="options">Additional options (optional)</param>
+/// <returns>Program linked to the project (invalid item if failed to update). Use Update() to retrieve the result</returns>
+Item Item::setMachiningParameters(QString ncfile, Item part_obj, QString options)
+{
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_MachiningParams");
+    rdk->_send_Item(this);
+    rdk->_send_Line(ncfile);
+    rdk->_send_Item(part_obj);
+    rdk->_send_Line("NO_UPDATE " + options);
+    rdk->_TIMEOUT = 3600 * 1000;
+    Item program = rdk->_recv_Item();
+    rdk->_TIMEOUT = rdk->_DEFAULT_TIMEOUT;
+    double status = rdk->_recv_Int() / 1000.0;
+    rdk->_check_status();
+    return program;
 }
 
 /// <summary>
-/// Save an item to a file. If no item is provided, the open station is saved.
+/// Sets a target as a cartesian target. A cartesian target moves to cartesian coordinates.
 /// </summary>
-/// <param name="filename">absolute path to save the file</param>
-/// <param name="itemsave">object or station to save. Leave empty to automatically save the current station.</param>
-void RoboDK::Save(const QString &filename, const Item *itemsave){
-    _check_connection();
-    _send_Line("Save");
-    _send_Line(filename);
-    _send_Item(itemsave);
-    _check_status();
+void Item::setAsCartesianTarget(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Target_As_RT");
+    rdk->_send_Item(this);
+    rdk->_check_status();
 }
 
 /// <summary>
-///     Adds a shape provided triangle coordinates. Triangles must be provided as a list of vertices. A vertex normal can
-///     be provided optionally.
+/// Sets a target as a joint target. A joint target moves to a joints position without regarding the cartesian coordinates.
 /// </summary>
-/// <param name="trianglePoints">
-///     List of vertices grouped by triangles (3xN or 6xN matrix, N must be multiple of 3 because
-///     vertices must be stacked by groups of 3)
-/// </param>
-/// <param name="addTo">item to attach the newly added geometry (optional). Leave empty to create a new object.</param>
-/// <param name="shapeOverride">Set to true to replace any other existing geometry</param>
-/// <param name="color">Color of the added shape</param>
-/// <returns>added object/shape (use item.Valid() to check if item is valid.)</returns>
-Item RoboDK::AddShape(tMatrix2D *trianglePoints, Item *addTo, bool shapeOverride, Color *color)
-{
-    double colorArray[4] = {0.6,0.6,0.8,1.0};
-    if (color != nullptr){
-        colorArray[0] = color->r;
-        colorArray[1] = color->g;
-        colorArray[2] = color->b;
-        colorArray[3] = color->a;
-    }
-    _check_connection();
-    _send_Line("AddShape3");
-    _send_Matrix2D(trianglePoints);
-    _send_Item(addTo);
-    _send_Int(shapeOverride? 1 : 0);
-    _send_Array(colorArray,4);
-    Item newitem = _recv_Item();
-    _check_status();
-    return newitem;
+void Item::setAsJointTarget(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Target_As_JT");
+    rdk->_send_Item(this);
+    rdk->_check_status();
 }
 
 /// <summary>
-/// Adds a curve provided point coordinates.
-/// The provided points must be a list of vertices.
-/// A vertex normal can be provided optionally.
+/// Returns True if a target is a joint target (green icon). Otherwise, the target is a Cartesian target (red icon).
 /// </summary>
-/// <param name="curvePoints">matrix 3xN or 6xN -> N must be multiple of 3</param>
-/// <param name="referenceObject">object to add the curve and/or project the curve to the surface</param>
-/// <param name="addToRef">
-///     If True, the curve will be added as part of the object in the RoboDK item tree (a reference
-///     object must be provided)
-/// </param>
-/// <param name="projectionType">
-///     Type of projection. For example:  ProjectionType.AlongNormalRecalc will project along the
-///     point normal and recalculate the normal vector on the surface projected.
-/// </param>
-/// <returns>added object/curve (use item.Valid() to check if item is valid.)</returns>
-Item RoboDK::AddCurve(tMatrix2D *curvePoints, Item *referenceObject, bool addToRef, int ProjectionType)
-{
-    _check_connection();
-    _send_Line("AddWire");
-    _send_Matrix2D(curvePoints);
-    _send_Item(referenceObject);
-    _send_Int(addToRef ? 1:0);
-    _send_Int(ProjectionType);
-    Item newitem = _recv_Item();
-    _check_status();
-    return newitem;
+bool Item::isJointTarget() const {
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Target_Is_JT");
+    rdk->_send_Item(this);
+    int is_jt = rdk->_recv_Int();
+    rdk->_check_status();
+    return is_jt > 0;
 }
 
+//#####Robot item calls####
+
 /// <summary>
-/// Adds a list of points to an object. The provided points must be a list of vertices. A vertex normal can be provided optionally.
+/// Returns the current joints of a robot or the joints of a target. If the item is a cartesian target, it returns the preferred joints (configuration) to go to that cartesian position.
 /// </summary>
-/// <param name="points">list of points as a matrix (3xN matrix, or 6xN to provide point normals as ijk vectors)</param>
-/// <param name="referenceObject">item to attach the newly added geometry (optional)</param>
-/// <param name="addToRef">If True, the points will be added as part of the object in the RoboDK item tree (a reference object must be provided)</param>
-/// <param name="projectionType">Type of projection.Use the PROJECTION_* flags.</param>
-/// <returns>added object/shape (0 if failed)</returns>
-Item RoboDK::AddPoints(tMatrix2D *points, Item *referenceObject, bool addToRef, int ProjectionType)
-{
-    _check_connection();
-    _send_Line("AddPoints");
-    _send_Matrix2D(points);
-    _send_Item(referenceObject);
-    _send_Int(addToRef? 1 : 0);
-    _send_Int(ProjectionType);Item newitem = _recv_Item();
-    _check_status();
-    return newitem;
+/// <returns>double x n -> joints matrix</returns>
+tJoints Item::Joints() const {
+    tLinkScope rdk(this);
+    tJoints jnts;
+    rdk->_check_connection();
+    rdk->_send_Line("G_Thetas");
+    rdk->_send_Item(this);
+    rdk->_recv_Array(&jnts);
+    rdk->_check_status();
+    return jnts;
 }
 
-void RoboDK::ProjectPoints(tMatrix2D *points, tMatrix2D **projected, Item objectProject, int ProjectionType)
-{
-    _check_connection();
-    _send_Line("ProjectPoints");
-    _send_Matrix2D(points);
-    _send_Item(objectProject);
-    _send_Int(ProjectionType);
-    _recv_Matrix2D(projected);
-    _check_status();
-}
+// add more methods
 
 /// <summary>
-/// Add a new empty station.
+/// Returns the home joints of a robot. These joints can be manually set in the robot "Parameters" menu, then select "Set home position"
 /// </summary>
-/// <param name="name">Name of the station</param>
-/// <returns>Newly created station IItem</returns>
-Item RoboDK::AddStation(QString name)
-{
-    _check_connection();
-    _send_Line("NewStation");
-    Item newitem = _recv_Item();
-    _check_status();
-    return newitem;
+/// <returns>double x n -> joints array</returns>
+tJoints Item::JointsHome() const {
+    tLinkScope rdk(this);
+    tJoints jnts;
+    rdk->_check_connection();
+    rdk->_send_Line("G_Home");
+    rdk->_send_Item(this);
+    rdk->_recv_Array(&jnts);
+    rdk->_check_status();
+    return jnts;
 }
 
 
-
-
 /// <summary>
-/// Closes the current station without suggesting to save
+/// Sets the joint position of the "home" joints for a robot.
 /// </summary>
-void RoboDK::CloseStation(){
-    _check_connection();
-    _send_Line("RemoveStn");
-    _check_status();
+/// <param name="joints"></param>
+void Item::setJointsHome(const tJoints &jnts){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Home");
+    rdk->_send_Array(&jnts);
+    rdk->_send_Item(this);
+    rdk->_check_status();
 }
 
 /// <summary>
-/// Adds a new target that can be reached with a robot.
+/// Returns an item pointer (:class:`.Item`) to a robot link. This is useful to show/hide certain robot links or alter their geometry.
 /// </summary>
-/// <param name="name">name of the target</param>
-/// <param name="itemparent">parent to attach to (such as a frame)</param>
-/// <param name="itemrobot">main robot that will be used to go to self target</param>
-/// <returns>the new target created</returns>
-Item RoboDK::AddTarget(const QString &name, Item *itemparent, Item *itemrobot){
-    _check_connection();
-    _send_Line("Add_TARGET");
-    _send_Line(name);
-    _send_Item(itemparent);
-    _send_Item(itemrobot);
-    Item newitem = _recv_Item();
-    _check_status();
-    return newitem;
+/// <param name="link_id">link index(0 for the robot base, 1 for the first link, ...)</param>
+/// <returns></returns>
+Item Item::ObjectLink(int link_id){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_LinkObjId");
+    rdk->_send_Item(this);
+    rdk->_send_Int(link_id);
+    Item item = rdk->_recv_Item();
+    rdk->_check_status();
+    return item;
 }
 
 /// <summary>
-/// Adds a new Frame that can be referenced by a robot.
+/// Returns an item pointer (Item class) to a robot, object, tool or program. This is useful to retrieve the relationship between programs, robots, tools and other specific projects.
 /// </summary>
-/// <param name="name">name of the reference frame</param>
-/// <param name="itemparent">parent to attach to (such as the robot base frame)</param>
-/// <returns>the new reference frame created</returns>
-Item RoboDK::AddFrame(const QString &name, Item *itemparent){
-    _check_connection();
-    _send_Line("Add_FRAME");
-    _send_Line(name);
-    _send_Item(itemparent);
-    Item newitem = _recv_Item();
-    _check_status();
-    return newitem;
+/// <param name="type_linked">type of linked object to retrieve</param>
+/// <returns></returns>
+Item Item::getLink(int type_linked){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_LinkType");
+    rdk->_send_Item(this);
+    rdk->_send_Int(type_linked);
+    Item item = rdk->_recv_Item();
+    rdk->_check_status();
+    return item;
 }
 
+
 /// <summary>
-/// Adds a new Frame that can be referenced by a robot.
+/// Sets the current joints of a robot or the joints of a target. It the item is a cartesian target, it returns the preferred joints (configuration) to go to that cartesian position.
 /// </summary>
-/// <param name="name">name of the program</param>
-/// <param name="itemparent">robot that will be used</param>
-/// <returns>the new program created</returns>
-Item RoboDK::AddProgram(const QString &name, Item *itemrobot){
-    _check_connection();
-    _send_Line("Add_PROG");
-    _send_Line(name);
-    _send_Item(itemrobot);
-    Item newitem = _recv_Item();
-    _check_status();
-    return newitem;
+/// <param name="joints"></param>
+void Item::setJoints(const tJoints &jnts){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Thetas");
+    rdk->_send_Array(&jnts);
+    rdk->_send_Item(this);
+    rdk->_check_status();
 }
 
 /// <summary>
-/// Add a new robot machining project. Machining projects can also be used for 3D printing, following curves and following points.
-/// It returns the newly created :class:`.IItem` containing the project settings.
-/// Tip: Use the macro /RoboDK/Library/Macros/MoveRobotThroughLine.py to see an example that creates a new "curve follow project" given a list of points to follow(Option 4).
+/// Returns the joint limits of a robot
 /// </summary>
-/// <param name="name">Name of the project settings</param>
-/// <param name="itemrobot">Robot to use for the project settings(optional). It is not required to specify the robot if only one robot or mechanism is available in the RoboDK station.</param>
-/// <returns></returns>
-Item RoboDK::AddMachiningProject(QString name, Item *itemrobot)
-{
-    _check_connection();
-    _send_Line("Add_MACHINING");
-    _send_Line(name);
-    _send_Item(itemrobot);
-    Item newitem = _recv_Item();
-    _check_status();
-    return newitem;
+/// <param name="lower_limits"></param>
+/// <param name="upper_limits"></param>
+void Item::JointLimits(tJoints *lower_limits, tJoints *upper_limits){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_RobLimits");
+    rdk->_send_Item(this);
+    rdk->_recv_Array(lower_limits);
+    rdk->_recv_Array(upper_limits);
+    double joints_type = rdk->_recv_Int() / 1000.0;
+    rdk->_check_status();
 }
 
-
-
-QList<Item> RoboDK::getOpenStation()
-{
-    _check_connection();
-    _send_Line("G_AllStn");
-    int nstn = _recv_Int();
-    QList<Item> *listStn = new QList<Item>();
-    for (int i = 0;i < nstn;i++){
-        Item station = _recv_Item();
-        listStn->append(station);
-    }
-    _check_status();
-    return *listStn;
+/// <summary>
+/// Sets the robot of a program or a target. You must set the robot linked to a program or a target every time you copy paste these objects.
+/// If the robot is not provided, the first available robot will be chosen automatically.
+/// </summary>
+/// <param name="robot">Robot item</param>
+void Item::setRobot(const Item &robot){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Robot");
+    rdk->_send_Item(this);
+    rdk->_send_Item(robot);
+    rdk->_check_status();
 }
 
 
 /// <summary>
-/// Returns the active station item (station currently visible)
+/// Adds an empty tool to the robot provided the tool pose (4x4 Matrix) and the tool name.
 /// </summary>
-/// <returns></returns>
-Item RoboDK::getActiveStation() {
-    _check_connection();
-    _send_Line("G_ActiveStn");
-    Item station = _recv_Item();
-    _check_status();
-    return station;
+/// <param name="tool_pose">pose -> TCP as a 4x4 Matrix (pose of the tool frame)</param>
+/// <param name="tool_name">New tool name</param>
+/// <returns>new item created</returns>
+Item Item::AddTool(const Mat &tool_pose, const QString &tool_name){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("AddToolEmpty");
+    rdk->_send_Item(this);
+    rdk->_send_Pose(tool_pose);
+    rdk->_send_Line(tool_name);
+    Item newtool = rdk->_recv_Item();
+    rdk->_check_status();
+    return newtool;
 }
 
 /// <summary>
-/// Set the active station (project currently visible)
+/// Computes the forward kinematics of the robot for the provided joints. The tool and the reference frame are not taken into account.
 /// </summary>
-/// <param name="station">station item, it can be previously loaded as an RDK file</param>
-void RoboDK::setActiveStation(Item station) {
-    _check_connection();
-    _send_Line("S_ActiveStn");
-    _send_Item(station);
-    _check_status();
+/// <param name="joints"></param>
+/// <returns>4x4 homogeneous matrix: pose of the robot flange with respect to the robot base</returns>
+Mat Item::SolveFK(const tJoints &joints, const Mat *tool, const Mat *ref){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_FK");
+    rdk->_send_Array(&joints);
+    rdk->_send_Item(this);
+    Mat pose = rdk->_recv_Pose();
+    Mat base2flange(pose);
+    if (tool != nullptr){
+        base2flange = pose*(*tool);
+    }
+    if (ref != nullptr){
+        base2flange = ref->inv() * base2flange;
+    }
+    rdk->_check_status();
+    return base2flange;
 }
 
+/// <summary>
+/// Computes the forward kinematics of the robot for a list of joints (locally if possible).
+/// </summary>
+QList<Mat> Item::SolveFK(const tMatrix2D *joint_list, const Mat *tool, const Mat *ref){
+    tLinkScope rdk(this);
+    Kinematics kin = rdk->_kinematics(*this, false);
+    if (kin.Valid()){
+        return kin.SolveFK(joint_list, tool, ref);
+    }
+    // send all the requests at once and read the results
+    QList<Mat> poses;
+    if (joint_list == nullptr || Matrix2D_Get_ncols(joint_list) <= 0){
+        return poses;
+    }
+    // the number of joints is kept by the link even if the kinematics can't be computed locally
+    int ndofs = qMin(Matrix2D_Get_nrows(joint_list), rdk->_ROBOT_DOFS.value(_PTR));
+    int count = Matrix2D_Get_ncols(joint_list);
+    Mat ref_inv = (ref != nullptr) ? ref->inv() : Mat();
+    poses.reserve(count);
+    for (int i=0; i<count; i++){
+        tJoints joints(joint_list, i, ndofs);
+        rdk->_batch_request(i);
+        rdk->_send_Line("G_FK");
+        rdk->_send_Array(&joints);
+        rdk->_send_Item(this);
+    }
+    for (int i=0; i<count; i++){
+        Mat pose = rdk->_recv_Pose();
+        if (tool != nullptr){
+            pose = pose*(*tool);
+        }
+        if (ref != nullptr){
+            pose = ref_inv * pose;
+        }
+        rdk->_check_status();
+        poses.append(pose);
+    }
+    return poses;
+}
 
-//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 /// <summary>
-/// Adds a function call in the program output. RoboDK will handle the syntax when the code is generated for a specific robot. If the program exists it will also run the program in simulate mode.
+/// Returns the kinematics of the robot (retrieved once and kept by the RoboDK link).
 /// </summary>
-/// <param name="function_w_params">Function name with parameters (if any)</param>
-/// <returns></returns>
-int RoboDK::RunProgram(const QString &function_w_params){
-    return RunCode(function_w_params, true);
+Kinematics Item::getKinematics(bool refresh){
+    tLinkScope rdk(this);
+    return rdk->_kinematics(*this, refresh);
 }
 
 /// <summary>
-/// Adds code to run in the program output. If the program exists it will also run the program in simulate mode.
+/// Returns the robot configuration state for a set of robot joints.
 /// </summary>
-/// <param name="code"></param>
-/// <param name="code_is_fcn_call"></param>
-/// <returns></returns>
-int RoboDK::RunCode(const QString &code, bool code_is_fcn_call){
-    _check_connection();
-    _send_Line("RunCode");
-    _send_Int(code_is_fcn_call ? 1 : 0);
-    _send_Line(code);
-    int prog_status = _recv_Int();
-    _check_status();
-    return prog_status;
+/// <param name="joints">array of joints</param>
+/// <returns>3-array -> configuration status as [REAR, LOWERARM, FLIP]</returns>
+void Item::JointsConfig(const tJoints &joints, tConfig config){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_Thetas_Config");
+    rdk->_send_Array(&joints);
+    rdk->_send_Item(this);
+    int sz = RDK_SIZE_MAX_CONFIG;
+    rdk->_recv_Array(config, &sz);
+    rdk->_check_status();
+    //return config;
 }
 
 /// <summary>
-/// Shows a message or a comment in the output robot program.
+/// Computes the inverse kinematics for the specified robot and pose. The joints returned are the closest to the current robot configuration (see SolveIK_All())
 /// </summary>
-/// <param name="message"></param>
-/// <param name="message_is_comment"></param>
-void RoboDK::RunMessage(const QString &message, bool message_is_comment){
-    _check_connection();
-    _send_Line("RunMessage");
-    _send_Int(message_is_comment ? 1 : 0);
-    _send_Line(message);
-    _check_status();
+/// <param name="pose">4x4 matrix -> pose of the robot flange with respect to the robot base frame</param>
+/// <param name="tool">4x4 matrix -> Optionally provide a tool, otherwise, the robot flange is used. Tip: use robot.PoseTool() to retrieve the active robot tool.</param>
+/// <param name="reference">4x4 matrix -> Optionally provide a reference, otherwise, the robot base is used. Tip: use robot.PoseFrame() to retrieve the active robot reference frame.</param>
+/// <returns>array of joints</returns>
+tJoints Item::SolveIK(const Mat &pose, const Mat *tool, const Mat *ref){
+    tLinkScope rdk(this);
+    Kinematics kin = rdk->_kinematics(*this, false);
+    if (kin.CanSolveIK()){
+        // the solution with the smallest maximum joint move from the current joints (see Kinematics::SolveIK)
+        return kin.SolveIK(pose, Joints(), tool, ref);
+    }
+    tJoints jnts;
+    Mat base2flange(pose);
+    if (tool != nullptr){
+        base2flange = pose*tool->inv();
+    }
+    if (ref != nullptr){
+        base2flange = (*ref) * base2flange;
+    }
+    rdk->_check_connection();
+    rdk->_send_Line("G_IK");
+    rdk->_send_Pose(base2flange);
+    rdk->_send_Item(this);
+    rdk->_recv_Array(&jnts);
+    rdk->_check_status();
+    return jnts;
 }
 
+
+
 /// <summary>
-/// Renders the scene. This function turns off rendering unless always_render is set to true.
+/// Computes the inverse kinematics for the specified robot and pose. The joints returned are the closest to the current robot configuration (see SolveIK_All())
 /// </summary>
-/// <param name="always_render"></param>
-void RoboDK::Render(bool always_render){
-    bool auto_render = !always_render;
-    _check_connection();
-    _send_Line("Render");
-    _send_Int(auto_render ? 1 : 0);
-    _check_status();
+/// <param name="pose">4x4 matrix -> pose of the robot flange with respect to the robot base frame</param>
+/// <param name="joints_approx">Aproximate solution. Leave empty to return the closest match to the current robot position.</param>
+/// <param name="tool">4x4 matrix -> Optionally provide a tool, otherwise, the robot flange is used. Tip: use robot.PoseTool() to retrieve the active robot tool.</param>
+/// <param name="reference">4x4 matrix -> Optionally provide a reference, otherwise, the robot base is used. Tip: use robot.PoseFrame() to retrieve the active robot reference frame.</param>
+/// <returns>array of joints</returns>
+tJoints Item::SolveIK(const Mat pose, tJoints joints_approx, const Mat *tool, const Mat *ref){
+    tLinkScope rdk(this);
+    Kinematics kin = rdk->_kinematics(*this, false);
+    if (kin.CanSolveIK()){
+        return kin.SolveIK(pose, joints_approx.Length() > 0 ? joints_approx : Joints(), tool, ref);
+    }
+    Mat base2flange(pose);
+    if (tool != nullptr){
+        base2flange = pose*tool->inv();
+    }
+    if (ref != nullptr){
+        base2flange = (*ref) * base2flange;
+    }
+    rdk->_check_connection();
+    rdk->_send_Line("G_IK_jnts");
+    rdk->_send_Pose(base2flange);
+    rdk->_send_Array(&joints_approx);
+    rdk->_send_Item(this);
+    tJoints jnts;
+    rdk->_recv_Array(&jnts);
+    rdk->_check_status();
+    return jnts;
 }
 
+
 /// <summary>
-/// Update the screen.
-/// This updates the position of all robots and internal links according to previously set values.
+/// Computes the inverse kinematics for the specified robot and pose. The function returns all available joint solutions as a 2D matrix.
 /// </summary>
-void RoboDK::Update()
-{
-    _check_connection();
-    _send_Line("Refresh");
-    _send_Int(0);
-    _check_status();
+/// <param name="pose">4x4 matrix -> pose of the robot tool with respect to the robot frame</param>
+/// <returns>double x n x m -> joint list (2D matrix)</returns>
+tMatrix2D* Item::SolveIK_All_Mat2D(const Mat &pose, const Mat *tool, const Mat *ref){
+    tLinkScope rdk(this);
+    Kinematics kin = rdk->_kinematics(*this, false);
+    if (kin.CanSolveIK()){
+        // same layout as G_IK_cmpl: one column per solution, the joints followed by 2 values (0 when computed locally)
+        QList<tJoints> solutions = kin.SolveIK_All(pose, tool, ref);
+        tMatrix2D *mat2d = Matrix2D_Create();
+        Matrix2D_Set_Size(mat2d, 6 + 2, solutions.length());
+        for (int i=0; i<solutions.length(); i++){
+            double *column = mat2d->data + i*(6 + 2);
+            memcpy(column, solutions[i].ValuesD(), 6 * sizeof(double));
+            column[6] = column[7] = 0.0;
+        }
+        return mat2d;
+    }
+    tMatrix2D *mat2d = nullptr;
+    Mat base2flange(pose);
+    if (tool != nullptr){
+        base2flange = pose*tool->inv();
+    }
+    if (ref != nullptr){
+        base2flange = (*ref) * base2flange;
+    }
+    rdk->_check_connection();
+    rdk->_send_Line("G_IK_cmpl");
+    rdk->_send_Pose(base2flange);
+    rdk->_send_Item(this);
+    rdk->_recv_Matrix2D(&mat2d);
+    rdk->_check_status();
+    return mat2d;
+}
+QList<tJoints> Item::SolveIK_All(const Mat &pose, const Mat *tool, const Mat *ref){
+    Kinematics kin = getKinematics();
+    if (kin.CanSolveIK()){
+        return kin.SolveIK_All(pose, tool, ref);
+    }
+    tMatrix2D *mat2d = SolveIK_All_Mat2D(pose, tool, ref);
+    QList<tJoints> jnts_list;
+    int ndofs = Matrix2D_Size(mat2d, 1) - 2;
+    int nsol = Matrix2D_Size(mat2d, 2);
+    for (int i=0; i<nsol; i++){
+        tJoints jnts = tJoints(mat2d, i);
+        jnts.setLength(jnts.Length() - 2);
+        jnts_list.append(jnts);
+    }
+    Matrix2D_Delete(&mat2d);
+    return jnts_list;
 }
 
 /// <summary>
-/// Returns (1/True) if object_inside is inside the object_parent
+/// Computes the inverse kinematics for an array of poses (locally if possible).
 /// </summary>
-/// <param name="object_inside"></param>
-/// <param name="object_parent"></param>
-/// <returns></returns>
-bool RoboDK::IsInside(Item object_inside, Item object_parent){
-    _check_connection();
-    _send_Line("IsInside");
-    _send_Item(object_inside);
-    _send_Item(object_parent);
-    int inside = _recv_Int();
-    _check_status();
-    return inside > 0;
+bool Item::SolveIK_All(const double *poses, int count, double *solutions, int *nsolutions, int *configs, const Mat *tool, const Mat *ref){
+    tLinkScope rdk(this);
+    Kinematics kin = rdk->_kinematics(*this, false);
+    if (kin.CanSolveIK()){
+        return kin.SolveIK(poses, count, solutions, nsolutions, configs, tool, ref);
+    }
+    if (count < 0 || (count > 0 && (poses == nullptr || solutions == nullptr || nsolutions == nullptr))){
+        return false;
+    }
+    Mat tool_inv = (tool != nullptr) ? tool->inv() : Mat();
+    Mat base = (ref != nullptr) ? *ref : Mat();
+    tMatrix2D *mat2d = Matrix2D_Create();
+    bool ok = true;
+    for (int first=0; first<count; first+=ROBODK_API_IK_REMOTE_GROUP){
+        int n = qMin(ROBODK_API_IK_REMOTE_GROUP, count - first);
+        // each group is one call: the requests are sent before reading the responses
+        for (int i=first; i<first+n; i++){
+            rdk->_batch_request(i - first);
+            rdk->_send_Line("G_IK_cmpl");
+            rdk->_send_Pose(base * Mat(poses + 16*i) * tool_inv);
+            rdk->_send_Item(this);
+        }
+        for (int i=first; i<first+n; i++){
+            // each column is a solution: joints followed by 2 extra values
+            ok = rdk->_recv_Matrix2D(mat2d) && ok;
+            ok = !rdk->_check_status() && ok;
+            int nrows = Matrix2D_Get_nrows(mat2d);
+            int ndofs = qMin(nrows - 2, 6);
+            int nsol = qMin(Matrix2D_Get_ncols(mat2d), 8);
+            if (ndofs <= 0){
+                nsol = 0;
+            }
+            double *sol = solutions + (qint64) i * 8 * 6;
+            for (int k=0; k<nsol; k++){
+                const double *column = mat2d->data + k*nrows;
+                for (int j=0; j<6; j++){
+                    sol[6*k+j] = (j < ndofs) ? column[j] : 0.0;
+                }
+                if (configs != nullptr){
+                    configs[(qint64) i * 8 + k] = -1;
+                }
+            }
+            nsolutions[i] = nsol;
+        }
+    }
+    Matrix2D_Delete(&mat2d);
+    return ok;
 }
 
 /// <summary>
-/// Set collision checking ON or OFF (COLLISION_OFF/COLLISION_OFF) according to the collision map. If collision check is activated it returns the number of pairs of objects that are currently in a collision state.
+/// Connect to a real robot using the robot driver.
 /// </summary>
-/// <param name="check_state"></param>
-/// <returns>Number of pairs of objects in a collision state</returns>
-int RoboDK::setCollisionActive(int check_state){
-    _check_connection();
-    _send_Line("Collision_SetState");
-    _send_Int(check_state);
-    int ncollisions = _recv_Int();
-    _check_status();
-    return ncollisions;
+/// <param name="robot_ip">IP of the robot to connect. Leave empty to use the one defined in RoboDK</param>
+/// <returns>status -> true if connected successfully, false if connection failed</returns>
+bool Item::Connect(const QString &robot_ip){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Connect");
+    rdk->_send_Item(this);
+    rdk->_send_Line(robot_ip);
+    int status = rdk->_recv_Int();
+    rdk->_check_status();
+    return status != 0;
 }
 
 /// <summary>
-/// Set collision checking ON or OFF (COLLISION_ON/COLLISION_OFF) for a specific pair of objects. This allows altering the collision map for Collision checking.
-/// Specify the link id for robots or moving mechanisms (id 0 is the base).
+/// Disconnect from a real robot (when the robot driver is used)
 /// </summary>
-/// <param name="check_state">Set to COLLISION_ON or COLLISION_OFF</param>
-/// <param name="item1">Item 1</param>
-/// <param name="item2">Item 2</param>
-/// <param name="id1">Joint id for Item 1 (if Item 1 is a robot or a mechanism)</param>
-/// <param name="id2">Joint id for Item 2 (if Item 2 is a robot or a mechanism)</param>
-/// <returns>Returns true if succeeded. Returns false if setting the pair failed (wrong id was provided)</returns>
-bool RoboDK::setCollisionActivePair(int check_state, Item item1, Item item2, int id1, int id2){
-    _check_connection();
-    _send_Line("Collision_SetPair");
-    _send_Item(item1);
-    _send_Item(item2);
-    _send_Int(id1);
-    _send_Int(id2);
-    _send_Int(check_state);
-    int success = _recv_Int();
-    _check_status();
-    return success > 0;
+/// <returns>status -> true if disconnected successfully, false if it failed. It can fail if it was previously disconnected manually for example.</returns>
+bool Item::Disconnect(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Disconnect");
+    rdk->_send_Item(this);
+    int status = rdk->_recv_Int();
+    rdk->_check_status();
+    return status != 0;
 }
 
 /// <summary>
-/// Returns the number of pairs of objects that are currently in a collision state.
+/// Moves a robot to a specific target ("Move Joint" mode). By default, this function blocks until the robot finishes its movements.
 /// </summary>
-/// <returns></returns>
-int RoboDK::Collisions(){
-    _check_connection();
-    _send_Line("Collisions");
-    int ncollisions = _recv_Int();
-    _check_status();
-    return ncollisions;
+/// <param name="target">target -> target to move to as a target item (RoboDK target item)</param>
+/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
+void Item::MoveJ(const Item &itemtarget, bool blocking){
+    tLinkScope rdk(this);
+    if (_TYPE == RoboDK::ITEM_TYPE_PROGRAM){
+        rdk->_check_connection();
+        rdk->_send_Line("Add_INSMOVE");
+        rdk->_send_Item(itemtarget);
+        rdk->_send_Item(this);
+        rdk->_send_Int(1);
+        rdk->_check_status();
+    } else {
+        rdk->_moveX(&itemtarget, nullptr, nullptr, this, 1, blocking);
+    }
 }
 
 /// <summary>
-/// Returns 1 if item1 and item2 collided. Otherwise returns 0.
+/// Moves a robot to a specific target ("Move Joint" mode). By default, this function blocks until the robot finishes its movements.
 /// </summary>
-/// <param name="item1"></param>
-/// <param name="item2"></param>
-/// <returns></returns>
-int RoboDK::Collision(Item item1, Item item2){
-    _check_connection();
-    _send_Line("Collided");
-    _send_Item(item1);
-    _send_Item(item2);
-    int ncollisions = _recv_Int();
-    _check_status();
-    return ncollisions;
+/// <param name="target">joints -> joint target to move to.</param>
+/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
+void Item::MoveJ(const tJoints &joints, bool blocking){
+    tLinkScope rdk(this);
+    rdk->_moveX(nullptr, &joints, nullptr, this, 1, blocking);
 }
 
-QList<Item> RoboDK::getCollisionItems(QList<int> link_id_list)
-{
-    _check_connection();
-    _send_Line("Collision Items");
-    int nitems = _recv_Int();
-    QList<Item> itemList = QList<Item>();
-    if (!link_id_list.isEmpty()){
-        link_id_list.clear();
-    }
-    for (int i = 0; i < nitems; i++){
-        itemList.append(_recv_Item());
-        int linkId = _recv_Int();
-        if (!link_id_list.isEmpty()){
-            link_id_list.append(linkId);
-        }
-        int collisionTimes = _recv_Int();
-    }
-    _check_status();
-    return itemList;
+/// <summary>
+/// Moves a robot to a specific target ("Move Joint" mode). By default, this function blocks until the robot finishes its movements.
+/// </summary>
+/// <param name="target">pose -> pose target to move to. It must be a 4x4 Homogeneous matrix</param>
+/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
+void Item::MoveJ(const Mat &target, bool blocking){
+    tLinkScope rdk(this);
+    rdk->_moveX(nullptr, nullptr, &target, this, 1, blocking);
 }
 
 /// <summary>
-/// Sets the current simulation speed. Set the speed to 1 for a real-time simulation. The slowest speed allowed is 0.001 times the real speed. Set to a high value (>100) for fast simulation results.
+/// Moves a robot to a specific target ("Move Linear" mode). By default, this function blocks until the robot finishes its movements.
 /// </summary>
-/// <param name="speed"></param>
-void RoboDK::setSimulationSpeed(double speed){
-    _check_connection();
-    _send_Line("SimulateSpeed");
-    _send_Int((int)(speed * 1000.0));
-    _check_status();
+/// <param name="itemtarget">target -> target to move to as a target item (RoboDK target item)</param>
+/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
+void Item::MoveL(const Item &itemtarget, bool blocking){
+    tLinkScope rdk(this);
+    if (_TYPE == RoboDK::ITEM_TYPE_PROGRAM){
+        rdk->_check_connection();
+        rdk->_send_Line("Add_INSMOVE");
+        rdk->_send_Item(itemtarget);
+        rdk->_send_Item(this);
+        rdk->_send_Int(2);
+        rdk->_check_status();
+    } else {
+        rdk->_moveX(&itemtarget, nullptr, nullptr, this, 2, blocking);
+    }
 }
 
 /// <summary>
-/// Gets the current simulation speed. Set the speed to 1 for a real-time simulation.
+/// Moves a robot to a specific target ("Move Linear" mode). By default, this function blocks until the robot finishes its movements.
 /// </summary>
-/// <returns></returns>
-double RoboDK::SimulationSpeed(){
-    _check_connection();
-    _send_Line("GetSimulateSpeed");
-    double speed = ((double)_recv_Int()) / 1000.0;
-    _check_status();
-    return speed;
+/// <param name="joints">joints -> joint target to move to.</param>
+/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
+void Item::MoveL(const tJoints &joints, bool blocking){
+    tLinkScope rdk(this);
+    rdk->_moveX(nullptr, &joints, nullptr, this, 2, blocking);
 }
+
 /// <summary>
-/// Sets the behavior of the RoboDK API. By default, robodk shows the path simulation for movement instructions (run_mode=1=RUNMODE_SIMULATE).
-/// Setting the run_mode to RUNMODE_QUICKVALIDATE allows performing a quick check to see if the path is feasible.
-/// if robot.Connect() is used, RUNMODE_RUN_FROM_PC is selected automatically.
+/// Moves a robot to a specific target ("Move Linear" mode). By default, this function blocks until the robot finishes its movements.
 /// </summary>
-/// <param name="run_mode">int = RUNMODE
-/// RUNMODE_SIMULATE=1        performs the simulation moving the robot (default)
-/// RUNMODE_QUICKVALIDATE=2   performs a quick check to validate the robot movements
-/// RUNMODE_MAKE_ROBOTPROG=3  makes the robot program
-/// RUNMODE_RUN_REAL=4        moves the real robot is it is connected</param>
-void RoboDK::setRunMode(int run_mode){
-    _check_connection();
-    _send_Line("S_RunMode");
-    _send_Int(run_mode);
-    _check_status();
+/// <param name="target">pose -> pose target to move to. It must be a 4x4 Homogeneous matrix</param>
+/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
+void Item::MoveL(const Mat &target, bool blocking){
+    tLinkScope rdk(this);
+    rdk->_moveX(nullptr, nullptr, &target, this, 2, blocking);
 }
 
 /// <summary>
-/// Returns the behavior of the RoboDK API. By default, robodk shows the path simulation for movement instructions (run_mode=1)
+/// Moves a robot to a specific target ("Move Circular" mode). By default, this function blocks until the robot finishes its movements.
 /// </summary>
-/// <returns>int = RUNMODE
-/// RUNMODE_SIMULATE=1        performs the simulation moving the robot (default)
-/// RUNMODE_QUICKVALIDATE=2   performs a quick check to validate the robot movements
-/// RUNMODE_MAKE_ROBOTPROG=3  makes the robot program
-/// RUNMODE_RUN_REAL=4        moves the real robot is it is connected</returns>
-int RoboDK::RunMode(){
-    _check_connection();
-    _send_Line("G_RunMode");
-    int runmode = _recv_Int();
-    _check_status();
-    return runmode;
+/// <param name="itemtarget1">target -> intermediate target to move to as a target item (RoboDK target item)</param>
+/// <param name="itemtarget2">target -> final target to move to as a target item (RoboDK target item)</param>
+/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
+void Item::MoveC(const Item &itemtarget1, const Item &itemtarget2, bool blocking){
+    tLinkScope rdk(this);
+    rdk->_moveC(&itemtarget1, nullptr, nullptr, &itemtarget2, nullptr, nullptr, this, blocking);
 }
+
 /// <summary>
-/// Gets all the user parameters from the open RoboDK station.
-/// The parameters can also be modified by right clicking the station and selecting "shared parameters"
-/// User parameters can be added or modified by the user
+/// Moves a robot to a specific target ("Move Circular" mode). By default, this function blocks until the robot finishes its movements.
 /// </summary>
-/// <returns>list of pairs of strings as parameter-value (list of a list)</returns>
-QList<QPair<QString,QString>> RoboDK::getParams(){
-    _check_connection();
-    _send_Line("G_Params");
-    QList<QPair<QString,QString>> paramlist;
-    int nparam = _recv_Int();
-    for (int i = 0; i < nparam; i++) {
-        QString param = _recv_Line();
-        QString value = _recv_Line();
-        paramlist.append(qMakePair(param, value));
-    }
-    _check_status();
-    return paramlist;
+/// <param name="joints1">joints -> intermediate joint target to move to.</param>
+/// <param name="joints2">joints -> final joint target to move to.</param>
+/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
+void Item::MoveC(const tJoints &joints1, const tJoints &joints2, bool blocking){
+    tLinkScope rdk(this);
+    rdk->_moveC(nullptr, &joints1, nullptr, nullptr, &joints2, nullptr, this, blocking);
 }
 
 /// <summary>
-/// Gets a global or a user parameter from the open RoboDK station.
-/// The parameters can also be modified by right clicking the station and selecting "shared parameters"
-/// Some available parameters:
-/// PATH_OPENSTATION = folder path of the current .stn file
-/// FILE_OPENSTATION = file path of the current .stn file
-/// PATH_DESKTOP = folder path of the user's folder
-/// Other parameters can be added or modified by the user
+/// Moves a robot to a specific target ("Move Circular" mode). By default, this function blocks until the robot finishes its movements.
 /// </summary>
-/// <param name="param">RoboDK parameter</param>
-/// <returns>value</returns>
-QString RoboDK::getParam(const QString &param){
-    _check_connection();
-    _send_Line("G_Param");
-    _send_Line(param);
-    QString value = _recv_Line();
-    if (value.startsWith("UNKNOWN ")) {
-        value = "";
-    }
-    _check_status();
-    return value;
+/// <param name="target1">pose -> intermediate pose target to move to. It must be a 4x4 Homogeneous matrix</param>
+/// <param name="target2">pose -> final pose target to move to. It must be a 4x4 Homogeneous matrix</param>
+/// <param name="blocking">blocking -> True if we want the instruction to block until the robot finished the movement (default=true)</param>
+void Item::MoveC(const Mat &target1, const Mat &target2, bool blocking){
+    tLinkScope rdk(this);
+    rdk->_moveC(nullptr, nullptr, &target1, nullptr, nullptr, &target2, this, blocking);
 }
 
 /// <summary>
-/// Sets a global parameter from the RoboDK station. If the parameters exists, it will be modified. If not, it will be added to the station.
-/// The parameters can also be modified by right clicking the station and selecting "shared parameters"
+/// Checks if a joint movement is free of collision.
 /// </summary>
-/// <param name="param">RoboDK parameter</param>
-/// <param name="value">value</param>
-/// <returns></returns>
-void RoboDK::setParam(const QString &param, const QString &value){
-    _check_connection();
-    _send_Line("S_Param");
-    _send_Line(param);
-    _send_Line(value);
-    _check_status();
+/// <param name="j1">joints -> start joints</param>
+/// <param name="j2">joints -> destination joints</param>
+/// <param name="minstep_deg">(optional): maximum joint step in degrees</param>
+/// <returns>collision : returns 0 if the movement is free of collision. Otherwise it returns the number of pairs of objects that collided if there was a collision.</returns>
+int Item::MoveJ_Test(const tJoints &j1, const tJoints &j2, double minstep_deg){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("CollisionMove");
+    rdk->_send_Item(this);
+    rdk->_send_Array(&j1);
+    rdk->_send_Array(&j2);
+    rdk->_send_Int((int)(minstep_deg * 1000.0));
+    rdk->_TIMEOUT = 3600 * 1000;
+    int collision = rdk->_recv_Int();
+    rdk->_TIMEOUT = rdk->_DEFAULT_TIMEOUT;
+    rdk->_check_status();
+    return collision;
 }
 
 /// <summary>
-/// Send a special command. These commands are meant to have a specific effect in RoboDK, such as changing a specific setting or provoke specific events.
+/// Checks if a linear movement is free of collision.
 /// </summary>
-/// <param name="cmd">Command Name, such as Trace, Threads or Window.</param>
-/// <param name="value">Comand value (optional, not all commands require a value)</param>
-/// <returns></returns>
-QString RoboDK::Command(const QString &cmd, const QString &value){
-    _check_connection();
-    _send_Line("SCMD");
-    _send_Line(cmd);
-    _send_Line(value);
-    QString answer = _recv_Line();
-    _check_status();
-    return answer;
+/// <param name="j1">joints -> start joints</param>
+/// <param name="pose2">joints -> destination pose (active tool with respect to the active reference frame)</param>
+/// <param name="minstep_mm">(optional): maximum joint step in degrees</param>
+/// <returns>collision : returns 0 if the movement is free of collision. Otherwise it returns the number of pairs of objects that collided if there was a collision.</returns>
+int Item::MoveL_Test(const tJoints &j1, const Mat &pose2, double minstep_deg){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("CollisionMoveL");
+    rdk->_send_Item(this);
+    rdk->_send_Array(&j1);
+    rdk->_send_Pose(pose2);
+    rdk->_send_Int((int)(minstep_deg * 1000.0));
+    rdk->_TIMEOUT = 3600 * 1000;
+    int collision = rdk->_recv_Int();
+    rdk->_TIMEOUT = rdk->_DEFAULT_TIMEOUT;
+    rdk->_check_status();
+    return collision;
 }
 
-bool RoboDK::LaserTrackerMeasure(tXYZ xyz, tXYZ estimate, bool search)
-{
-    _check_connection();
-    _send_Line("MeasLT");
-    _send_XYZ(estimate);
-    _send_Int(search ? 1 : 0);
-    _recv_XYZ(xyz);
-    _check_status();
-    if (xyz[0]*xyz[0] + xyz[1]*xyz[1] + xyz[2]*xyz[2] < 0.0001){
-        return false;
-    }
-
-    return true;
-}
 
-void RoboDK::ShowAsCollided(QList<Item> itemList, QList<bool> collidedList, QList<int> *robot_link_id)
-{
-    int nitems = qMin(itemList.length(),collidedList.length());
-    if (robot_link_id != nullptr){
-        nitems = qMin(nitems, robot_link_id->length());
-    }
-    _check_connection();
-    _send_Line("ShowAsCollidedList");
-    _send_Int(nitems);
-    for (int i = 0; i < nitems; i++){
-        _send_Item(itemList[i]);
-        _send_Int(collidedList[i] ? 1 : 0);
-        int link_id = 0;
-        if (robot_link_id != nullptr){
-            link_id = robot_link_id->at(i);
-        }
-        _send_Int(link_id);
-    }
-    _check_status();
+/// <summary>
+/// Sets the speed and/or the acceleration of a robot.
+/// </summary>
+/// <param name="speed_linear">linear speed in mm/s (-1 = no change)</param>
+/// <param name="accel_linear">linear acceleration in mm/s2 (-1 = no change)</param>
+/// <param name="speed_joints">joint speed in deg/s (-1 = no change)</param>
+/// <param name="accel_joints">joint acceleration in deg/s2 (-1 = no change)</param>
+void Item::setSpeed(double speed_linear, double accel_linear, double speed_joints, double accel_joints){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_Speed4");
+    rdk->_send_Item(this);
+    double speed_accel[4];
+    speed_accel[0] = speed_linear;
+    speed_accel[1] = accel_linear;
+    speed_accel[2] = speed_joints;
+    speed_accel[3] = accel_joints;
+    rdk->_send_Array(speed_accel, 4);
+    rdk->_check_status();
 }
 
-//---------------------------------------------- ADD MORE  (getParams, setParams, calibrate TCP, calibrate ref...)
+/// <summary>
+/// Sets the robot movement smoothing accuracy (also known as zone data value).
+/// </summary>
+/// <param name="zonedata">zonedata value (int) (robot dependent, set to -1 for fine movements)</param>
+void Item::setRounding(double zonedata){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_ZoneData");
+    rdk->_send_Int((int)(zonedata * 1000.0));
+    rdk->_send_Item(this);
+    rdk->_check_status();
+}
+
+/// <summary>
+/// Displays a sequence of joints
+/// </summary>
+/// <param name="sequence">joint sequence as a 6xN matrix or instruction sequence as a 7xN matrix</param>
+void Item::ShowSequence(tMatrix2D *sequence){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Show_Seq");
+    rdk->_send_Matrix2D(sequence);
+    rdk->_send_Item(this);
+    rdk->_check_status();
+}
 
 
 /// <summary>
-/// Calibrate a tool (TCP) given a number of points or calibration joints. Important: If the robot is calibrated, provide joint values to maximize accuracy.
+/// Checks if a robot or program is currently running (busy or moving)
 /// </summary>
-/// <param name="poses_joints">matrix of poses in a given format or a list of joints</param>
-/// <param name="error_stats">stats[mean, standard deviation, max] - Output error stats summary</param>
-/// <param name="format">Euler format. Optionally, use JOINT_FORMAT and provide the robot.</param>
-/// <param name="algorithm">type of algorithm (by point, plane, ...)</param>
-/// <param name="robot">Robot used for calibration (if using joint values)</param>
-/// <returns>TCP as [x, y, z] - calculated TCP</returns>
-///
-void RoboDK::CalibrateTool(tMatrix2D *poses_joints, tXYZ tcp_xyz, int format, int algorithm, Item *robot, double *error_stats){
-    _check_connection();
-    _send_Line("CalibTCP2");
-    _send_Matrix2D(poses_joints);
-    _send_Int(format);
-    _send_Int(algorithm);
-    _send_Item(robot);
-    int nxyz = 3;
-    _recv_Array(tcp_xyz, &nxyz);
-    if (error_stats != nullptr){
-        _recv_Array(error_stats);
-    } else {
-        double errors_ignored[20];
-        _recv_Array(errors_ignored);
-    }
-    tMatrix2D *error_graph = Matrix2D_Create();
-    _recv_Matrix2D(&error_graph);
-    Matrix2D_Delete(&error_graph);
-    _check_status();
+/// <returns>busy status (true=moving, false=stopped)</returns>
+bool Item::Busy(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("IsBusy");
+    rdk->_send_Item(this);
+    int busy = rdk->_recv_Int();
+    rdk->_check_status();
+    return (busy > 0);
 }
 
 /// <summary>
-/// Calibrate a Reference Frame given a list of points or joint values. Important: If the robot is calibrated, provide joint values to maximize accuracy.
+/// Stops a program or a robot
 /// </summary>
-/// <param name="joints">points as a 3xN matrix or nDOFsxN) - List of points or a list of robot joints</param>
-/// <param name="method">type of algorithm(by point, plane, ...) CALIBRATE_FRAME_...</param>
-/// <param name="use_joints">use points or joint values. The robot item must be provided if joint values is used.</param>
-/// <param name="robot"></param>
 /// <returns></returns>
-Mat RoboDK::CalibrateReference(tMatrix2D *poses_joints, int method, bool use_joints, Item *robot){
-    _check_connection();
-    _send_Line("CalibFrame");
-    _send_Matrix2D(poses_joints);
-    _send_Int(use_joints ? -1 : 0);
-    _send_Int(method);
-    _send_Item(robot);
-    Mat reference_pose = _recv_Pose();
-    double error_stats[20];
-    _recv_Array(error_stats);
-    _check_status();
-    return reference_pose;
+void Item::Stop(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Stop");
+    rdk->_send_Item(this);
+    rdk->_check_status();
+}
+
+/// <summary>
+/// Waits (blocks) until the robot finishes its movement.
+/// </summary>
+/// <param name="timeout_sec">timeout -> Max time to wait for robot to finish its movement (in seconds)</param>
+void Item::WaitMove(double timeout_sec) const{
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("WaitMove");
+    rdk->_send_Item(this);
+    rdk->_check_status();
+    rdk->_TIMEOUT = (int)(timeout_sec * 1000.0);
+    rdk->_check_status();//will wait here;
+    rdk->_TIMEOUT = rdk->_DEFAULT_TIMEOUT;
+    //int isbusy = rdk->Busy(this);
+    //while (isbusy)
+    //{
+    //    busy = rdk->Busy(item);
+    //}
 }
 
 
-int RoboDK::ProgramStart(const QString &progname, const QString &defaultfolder, const QString &postprocessor, Item *robot){
-    _check_connection();
-    _send_Line("ProgramStart");
-    _send_Line(progname);
-    _send_Line(defaultfolder);
-    _send_Line(postprocessor);
-    _send_Item(robot);
-    int errors = _recv_Int();
-    _check_status();
-    return errors;
+/// <summary>
+/// Sets the accuracy of the robot active or inactive. A robot must have been calibrated to properly use this option.
+/// </summary>
+/// <param name="accurate">set to 1 to use the accurate model or 0 to use the nominal model</param>
+void Item::setAccuracyActive(int accurate){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_AbsAccOn");
+    rdk->_send_Item(this);
+    rdk->_send_Int(accurate);
+    rdk->_check_status();
 }
 
+///////// ADD MORE METHODS
+
+
+// ---- Program item calls -----
+
 /// <summary>
-/// Set the pose of the wold reference frame with respect to the view (camera/screen)
+/// Saves a program to a file.
 /// </summary>
-/// <param name="pose"></param>
-void RoboDK::setViewPose(const Mat &pose){
-    _check_connection();
-    _send_Line("S_ViewPose");
-    _send_Pose(pose);
-    _check_status();
+/// <param name="filename">File path of the program</param>
+/// <returns>success</returns>
+bool Item::MakeProgram(const QString &filename){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("MakeProg");
+    rdk->_send_Item(this);
+    rdk->_send_Line(filename);
+    int prog_status = rdk->_recv_Int();
+    QString prog_log_str = rdk->_recv_Line();
+    rdk->_check_status();
+    bool success = false;
+    if (prog_status > 1) {
+        success = true;
+    }
+    return success; // prog_log_str
 }
 
 /// <summary>
-/// Get the pose of the wold reference frame with respect to the view (camera/screen)
+/// Sets if the program will be run in simulation mode or on the real robot.
+/// Use: "PROGRAM_RUN_ON_SIMULATOR" to set the program to run on the simulator only or "PROGRAM_RUN_ON_ROBOT" to force the program to run on the robot.
 /// </summary>
-/// <param name="pose"></param>
-Mat RoboDK::ViewPose(){
-    _check_connection();
-    _send_Line("G_ViewPose");
-    Mat pose = _recv_Pose();
-    _check_status();
-    return pose;
+/// <returns>number of instructions that can be executed</returns>
+void Item::setRunType(int program_run_type){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("S_ProgRunType");
+    rdk->_send_Item(this);
+    rdk->_send_Int(program_run_type);
+    rdk->_check_status();
 }
-//INCOMPLETE!!!!!!!
-/*bool RoboDK::SetRobotParams(Item *robot, tMatrix2D dhm, Mat poseBase, Mat poseTool)
-{
-    _check_connection();
-    _send_Line("S_AbsAccParam");
-    _send_Item(robot);
-    Mat r2b;
-    r2b.setToIdentity();
-    _send_Pose(r2b);
-    _send_Pose(poseBase);
-    _send_Pose(poseTool);
-    int *ndofs = dhm.size;
-    _send_Int(*ndofs);
-    for (int i = 0; i < *ndofs; i++){
-        _send_Array(dhm);
-    }
 
-    _send_Pose(poseBase);
-    _send_Pose(poseTool);
-    _send_Int(*ndofs);
-    for (int i = 0; i < *ndofs; i++){
-        _send_Array(dhm[i]);
+/// <summary>
+/// Runs a program. It returns the number of instructions that can be executed successfully (a quick program check is performed before the program starts)
+/// This is a non-blocking call. Use IsBusy() to check if the program execution finished.
+/// Notes:
+/// if setRunMode(RUNMODE_SIMULATE) is used  -> the program will be simulated (default run mode)
+/// if setRunMode(RUNMODE_RUN_ROBOT) is used -> the program will run on the robot (default when RUNMODE_RUN_ROBOT is used)
+/// if setRunMode(RUNMODE_RUN_ROBOT) is used together with program.setRunType(PROGRAM_RUN_ON_ROBOT) -> the program will run sequentially on the robot the same way as if we right clicked the program and selected "Run on robot" in the RoboDK GUI
+/// </summary>
+/// <returns>number of instructions that can be executed</returns>
+int Item::RunProgram(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("RunProg");
+    rdk->_send_Item(this);
+    int prog_status = rdk->_recv_Int();
+    rdk->_check_status();
+    return prog_status;
+}
+
+
+/// <summary>
+/// Runs a program. It returns the number of instructions that can be executed successfully (a quick program check is performed before the program starts)
+/// Program parameters can be provided for Python calls.
+/// This is a non-blocking call.Use IsBusy() to check if the program execution finished.
+/// Notes: if setRunMode(RUNMODE_SIMULATE) is used  -> the program will be simulated (default run mode)
+/// if setRunMode(RUNMODE_RUN_ROBOT) is used ->the program will run on the robot(default when RUNMODE_RUN_ROBOT is used)
+/// if setRunMode(RUNMODE_RUN_ROBOT) is used together with program.setRunType(PROGRAM_RUN_ON_ROBOT) -> the program will run sequentially on the robot the same way as if we right clicked the program and selected "Run on robot" in the RoboDK GUI
+/// </summary>
+/// <param name="parameters">Number of instructions that can be executed</param>
+int Item::RunCode(const QString &parameters){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    if (parameters.isEmpty()){
+        rdk->_send_Line("RunProg");
+        rdk->_send_Item(this);
+    } else {
+        rdk->_send_Line("RunProgParam");
+        rdk->_send_Item(this);
+        rdk->_send_Line(parameters);
     }
+    int progstatus = rdk->_recv_Int();
+    rdk->_check_status();
+    return progstatus;
+}
 
-    _send_Array(nullptr);
-    _send_Array(nullptr);
-    _check_status();
-    return true;
-}*/
+/// <summary>
+/// Adds a program call, code, message or comment inside a program.
+/// </summary>
+/// <param name="code"><string of the code or program to run/param>
+/// <param name="run_type">INSTRUCTION_* variable to specify if the code is a progra</param>
+int Item::RunInstruction(const QString &code, int run_type){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("RunCode2");
+    rdk->_send_Item(this);
+    rdk->_send_Line(QString(code).replace("\n\n", "<br>").replace("\n", "<br>"));
+    rdk->_send_Int(run_type);
+    int progstatus = rdk->_recv_Int();
+    rdk->_check_status();
+    return progstatus;
+}
 
-Item RoboDK::getCursorXYZ(int x, int y, tXYZ xyzStation)
-{
-    _check_connection();
-    _send_Line("Proj2d3d");
-    _send_Int(x);
-    _send_Int(y);
-    int selection = _recv_Int();
-    Item selectedItem = _recv_Item();
-    tXYZ xyz;
-    _recv_XYZ(xyz);
-    if (xyzStation != nullptr){
-        xyzStation[0] = xyz[0];
-        xyzStation[1] = xyz[1];
-        xyzStation[2] = xyz[2];
+/// <summary>
+/// Generates a pause instruction for a robot or a program when generating code. Set it to -1 (default) if you want the robot to stop and let the user resume the program anytime.
+/// </summary>
+/// <param name="time_ms">Time in milliseconds</param>
+void Item::Pause(double time_ms){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("RunPause");
+    rdk->_send_Item(this);
+    rdk->_send_Int((int)(time_ms * 1000.0));
+    rdk->_check_status();
+}
+
+
+/// <summary>
+/// Sets a variable (output) to a given value. This can also be used to set any variables to a desired value.
+/// </summary>
+/// <param name="io_var">io_var -> digital output (string or number)</param>
+/// <param name="io_value">io_value -> value (string or number)</param>
+void Item::setDO(const QString &io_var, const QString &io_value){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("setDO");
+    rdk->_send_Item(this);
+    rdk->_send_Line(io_var);
+    rdk->_send_Line(io_value);
+    rdk->_check_status();
+}
+/// <summary>
+/// Set an analog Output
+/// </summary>
+/// <param name="io_var">Analog Output</param>
+/// <param name="io_value">Value as a string</param>
+void Item::setAO(const QString &io_var, const QString &io_value){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("setAO");
+    rdk->_send_Item(this);
+    rdk->_send_Line(io_var);
+    rdk->_send_Line(io_value);
+    rdk->_check_status();
+}
+
+/// <summary>
+/// Get a Digital Input (DI). This function is only useful when connected to a real robot using the robot driver. It returns a string related to the state of the Digital Input (1=True, 0=False). This function returns an empty string if the script is not executed on the robot.
+/// </summary>
+/// <param name="io_var">io_var -> digital input (string or number as a string)</param>
+QString Item::getDI(const QString &io_var){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("getDI");
+    rdk->_send_Item(this);
+    rdk->_send_Line(io_var);
+    QString io_value(rdk->_recv_Line());
+    rdk->_check_status();
+    return io_value;
+}
+
+/// <summary>
+/// Get an Analog Input (AI). This function is only useful when connected to a real robot using the robot driver. It returns a string related to the state of the Digital Input (0-1 or other range depending on the robot driver). This function returns an empty string if the script is not executed on the robot.
+/// </summary>
+/// <param name="io_var">io_var -> analog input (string or number as a string)</param>
+QString Item::getAI(const QString &io_var){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("getAI");
+    rdk->_send_Item(this);
+    rdk->_send_Line(io_var);
+    QString di_value(rdk->_recv_Line());
+    rdk->_check_status();
+    return di_value;
+}
+
+/// <summary>
+/// Waits for an input io_id to attain a given value io_value. Optionally, a timeout can be provided.
+/// </summary>
+/// <param name="io_var">io_var -> digital output (string or number)</param>
+/// <param name="io_value">io_value -> value (string or number)</param>
+/// <param name="timeout_ms">int (optional) -> timeout in miliseconds</param>
+void Item::waitDI(const QString &io_var, const QString &io_value, double timeout_ms){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("waitDI");
+    rdk->_send_Item(this);
+    rdk->_send_Line(io_var);
+    rdk->_send_Line(io_value);
+    rdk->_send_Int((int)(timeout_ms * 1000.0));
+    rdk->_check_status();
+}
+
+
+/// <summary>
+/// Add a custom instruction. This instruction will execute a Python file or an executable file.
+/// </summary>
+/// <param name="name"></param>
+/// <param name="path_run">path to run(relative to RoboDK/bin folder or absolute path)</param>
+/// <param name="path_icon">icon path(relative to RoboDK/bin folder or absolute path)</param>
+/// <param name="blocking">True if blocking, 0 if it is a non blocking executable trigger</param>
+/// <param name="cmd_run_on_robot">Command to run through the driver when connected to the robot</param>
+/// :param name: digital input (string or number)
+void Item::customInstruction(const QString &name, const QString &path_run, const QString &path_icon, bool blocking, const QString &cmd_run_on_robot){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("InsCustom2");
+    rdk->_send_Item(this);
+    rdk->_send_Line(name);
+    rdk->_send_Line(path_run);
+    rdk->_send_Line(path_icon);
+    rdk->_send_Line(cmd_run_on_robot);
+    rdk->_send_Int(blocking ? 1 : 0);
+    rdk->_check_status();
+}
+
+/*
+/////// obsolete functions
+/// <summary>
+/// Adds a new robot move joint instruction to a program.
+/// </summary>
+/// <param name="itemtarget">target to move to</param>
+void Item::addMoveJ(const Item &itemtarget){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Add_INSMOVE");
+    rdk->_send_Item(itemtarget);
+    rdk->_send_Item(this);
+    rdk->_send_Int(1);
+    rdk->_check_status();
+}
+
+/// <summary>
+/// Adds a new robot move linear instruction to a program.
+/// </summary>
+/// <param name="itemtarget">target to move to</param>
+void Item::addMoveL(const Item &itemtarget){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Add_INSMOVE");
+    rdk->_send_Item(itemtarget);
+    rdk->_send_Item(this);
+    rdk->_send_Int(2);
+    rdk->_check_status();
+}
+*/
+
+/// <summary>
+/// Show or hide instruction items of a program in the RoboDK tree
+/// </summary>
+/// <param name="show"></param>
+void Item::ShowInstructions(bool visible){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Prog_ShowIns");
+    rdk->_send_Item(this);
+    rdk->_send_Int(visible ? 1 : 0);
+    rdk->_check_status();
+}
+
+/// <summary>
+/// Show or hide targets of a program in the RoboDK tree
+/// </summary>
+/// <param name="show"></param>
+void Item::ShowTargets(bool visible){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Prog_ShowTargets");
+    rdk->_send_Item(this);
+    rdk->_send_Int(visible ? 1 : 0);
+    rdk->_check_status();
+}
+
+
+////////// ADD MORE METHODS
+/// <summary>
+/// Returns the number of instructions of a program.
+/// </summary>
+/// <returns></returns>
+int Item::InstructionCount(){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Prog_Nins");
+    rdk->_send_Item(this);
+    int nins = rdk->_recv_Int();
+    rdk->_check_status();
+    return nins;
+}
+
+/// <summary>
+/// Returns the program instruction at position id
+/// </summary>
+/// <param name="ins_id"></param>
+/// <param name="name"></param>
+/// <param name="instype"></param>
+/// <param name="movetype"></param>
+/// <param name="isjointtarget"></param>
+/// <param name="target"></param>
+/// <param name="joints"></param>
+void Item::Instruction(int ins_id, QString &name, int &instype, int &movetype, bool &isjointtarget, Mat &target, tJoints &joints){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Prog_GIns");
+    rdk->_send_Item(this);
+    rdk->_send_Int(ins_id);
+    name = rdk->_recv_Line();
+    instype = rdk->_recv_Int();
+    movetype = 0;
+    isjointtarget = false;
+    //target = null;
+    //joints = null;
+    if (instype == RoboDK::INS_TYPE_MOVE) {
+        movetype = rdk->_recv_Int();
+        isjointtarget = rdk->_recv_Int() > 0 ? true : false;
+        target = rdk->_recv_Pose();
+        rdk->_recv_Array(&joints);
+    }
+    rdk->_check_status();
+}
+
+/// <summary>
+/// Sets the program instruction at position id
+/// </summary>
+/// <param name="ins_id"></param>
+/// <param name="name"></param>
+/// <param name="instype"></param>
+/// <param name="movetype"></param>
+/// <param name="isjointtarget"></param>
+/// <param name="target"></param>
+/// <param name="joints"></param>
+void Item::setInstruction(int ins_id, const QString &name, int instype, int movetype, bool isjointtarget, const Mat &target, const tJoints &joints){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Prog_SIns");
+    rdk->_send_Item(this);
+    rdk->_send_Int(ins_id);
+    rdk->_send_Line(name);
+    rdk->_send_Int(instype);
+    if (instype == RoboDK::INS_TYPE_MOVE)
+    {
+        rdk->_send_Int(movetype);
+        rdk->_send_Int(isjointtarget ? 1 : 0);
+        rdk->_send_Pose(target);
+        rdk->_send_Array(&joints);
+    }
+    rdk->_check_status();
+}
+
+/// <summary>
+/// Returns the instructions of a program, pipelining the Prog_GIns requests
+/// </summary>
+/// <param name="instructions"></param>
+/// <param name="first"></param>
+/// <param name="count"></param>
+/// <param name="max_pending"></param>
+int Item::Instructions(tProgramInstructions *instructions, int first, int count, int max_pending){
+    instructions->first = qMax(first, 0);
+    instructions->name_id.resize(0);
+    instructions->names.clear();
+    instructions->type.resize(0);
+    instructions->move_type.resize(0);
+    instructions->joint_target.resize(0);
+    instructions->poses.resize(0);
+    instructions->joints_start.resize(0);
+    instructions->joints.resize(0);
+    int nins = InstructionCount();
+    if (count < 0 || instructions->first + count > nins){
+        count = qMax(nins - instructions->first, 0);
+    }
+    instructions->name_id.reserve(count);
+    instructions->type.reserve(count);
+    instructions->move_type.reserve(count);
+    instructions->joint_target.reserve(count);
+    instructions->poses.reserve(count * 16);
+    instructions->joints_start.reserve(count);
+
+    tLinkScope rdk(this);
+    QHash<QString, int> name_ids;
+    max_pending = qMax(max_pending, 1);
+    int sent = 0;
+    int received = 0;
+    // the requests are sent and read by a single call
+    bool link_ok = true;
+    while (link_ok && received < count){
+        if (sent < count && sent - received < max_pending){
+            if (!rdk->_batch_request(sent)){
+                break;
+            }
+            rdk->_send_Line("Prog_GIns");
+            rdk->_send_Item(this);
+            rdk->_send_Int(instructions->first + sent);
+            sent++;
+            if (rdk->_SEND_BUFFER.size() < ROBODK_API_PIPELINE_FLUSH_SIZE && sent < count && sent - received < max_pending){
+                continue;
+            }
+        }
+        // reading the response writes the requests not sent yet
+        link_ok = _recv_Instruction(rdk, instructions, name_ids);
+        if (link_ok){
+            received++;
+        }
+    }
+    return received;
+}
+
+// Read the response of Prog_GIns (see Instruction) into the arrays of instructions. Names are looked up in name_ids to store them once.
+// Returns false if the response is incomplete (the connection was lost).
+bool Item::_recv_Instruction(RoboDK *rdk, tProgramInstructions *instructions, QHash<QString, int> &name_ids){
+    QString name = rdk->_recv_Line();
+    int name_id = name_ids.value(name, -1);
+    if (name_id < 0){
+        name_id = instructions->names.length();
+        name_ids.insert(name, name_id);
+        instructions->names.append(name);
+    }
+    qint32 instype = rdk->_recv_Int();
+    qint32 movetype = 0;
+    bool isjointtarget = false;
+    int pose_start = instructions->poses.size();
+    int joints_start = instructions->joints.size();
+    instructions->poses.resize(pose_start + 16);
+    double *pose = instructions->poses.data() + pose_start;
+    memset(pose, 0, 16 * sizeof(double));
+    bool ok = true;
+    if (instype == RoboDK::INS_TYPE_MOVE){
+        movetype = rdk->_recv_Int();
+        isjointtarget = rdk->_recv_Int() > 0;
+        ok = rdk->_recv_Doubles(pose, 16);
+        qint32 njoints = rdk->_recv_Int();
+        if (ok && njoints >= 0 && njoints <= 50){
+            instructions->joints.resize(joints_start + njoints);
+            ok = rdk->_recv_Doubles(instructions->joints.data() + joints_start, njoints);
+        } else {
+            ok = false;
+        }
+    }
+    QString message;
+    rdk->_recv_Status(message);
+    if (!ok || rdk->_ABORTED || rdk->_DESYNC || !rdk->_connected()){
+        // the response is incomplete: drop it
+        instructions->poses.resize(pose_start);
+        instructions->joints.resize(joints_start);
+        return false;
+    }
+    instructions->name_id.append(name_id);
+    instructions->type.append(instype);
+    instructions->move_type.append(movetype);
+    instructions->joint_target.append(isjointtarget ? 1 : 0);
+    instructions->joints_start.append(joints_start);
+    return true;
+}
+
+
+/// <summary>
+/// Returns the list of program instructions as an MxN matrix, where N is the number of instructions and M equals to 1 plus the number of robot axes.
+/// </summary>
+/// <param name="instructions">the matrix of instructions</param>
+/// <returns>Returns 0 if success</returns>
+int Item::InstructionList(tMatrix2D *instructions){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_ProgInsList");
+    rdk->_send_Item(this);
+    rdk->_recv_Matrix2D(instructions);
+    int errors = rdk->_recv_Int();
+    rdk->_check_status();
+    return errors;
+}
+
+
+
+/// <summary>
+/// Updates a program and returns the estimated time and the number of valid instructions.
+/// An update can also be applied to a robot machining project. The update is performed on the generated program.
+/// </summary>
+/// <param name="collision_check">check_collisions: Check collisions (COLLISION_ON -yes- or COLLISION_OFF -no-)</param>
+/// <param name="timeout_sec">Maximum time to wait for the update to complete (in seconds)</param>
+/// <param name="out_nins_time_dist">optional double array [3] = [valid_instructions, program_time, program_distance]</param>
+/// <param name="mm_step">Maximum step in millimeters for linear movements (millimeters). Set to -1 to use the default, as specified in Tools-Options-Motion.</param>
+/// <param name="deg_step">Maximum step for joint movements (degrees). Set to -1 to use the default, as specified in Tools-Options-Motion.</param>
+/// <returns>1.0 if there are no problems with the path or less than 1.0 if there is a problem in the path (ratio of problem)</returns>
+double Item::Update(int collision_check, int timeout_sec, double *out_nins_time_dist, double mm_step, double deg_step){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("Update2");
+    rdk->_send_Item(this);
+    double values[5];
+    values[0] = collision_check;
+    values[1] = mm_step;
+    values[2] = deg_step;
+    rdk->_send_Array(values, 3);
+    rdk->_TIMEOUT = timeout_sec * 1000;
+    double return_values[10];
+    int nvalues = 10;
+    rdk->_recv_Array(return_values, &nvalues);
+    rdk->_TIMEOUT = rdk->_DEFAULT_TIMEOUT;
+    QString readable_msg = rdk->_recv_Line();
+    rdk->_check_status();
+    double ratio_ok = return_values[3];
+    if (out_nins_time_dist != nullptr)
+    {
+        out_nins_time_dist[0] = return_values[0]; // number of correct instructions
+        out_nins_time_dist[1] = return_values[1]; // estimated time to complete the program (cycle time)
+        out_nins_time_dist[2] = return_values[2]; // estimated travel distance
+    }
+    return ratio_ok;
+}
+
+
+/// <summary>
+/// Returns a list of joints an MxN matrix, where M is the number of robot axes plus 4 columns. Linear moves are rounded according to the smoothing parameter set inside the program.
+/// </summary>
+/// <param name="error_msg">Returns a human readable error message (if any)</param>
+/// <param name="joint_list">Returns the list of joints as [J1, J2, ..., Jn, ERROR, MM_STEP, DEG_STEP, MOVE_ID] if a file name is not specified</param>
+/// <param name="mm_step">Maximum step in millimeters for linear movements (millimeters)</param>
+/// <param name="deg_step">Maximum step for joint movements (degrees)</param>
+/// <param name="save_to_file">Provide a file name to directly save the output to a file. If the file name is not provided it will return the matrix. If step values are very small, the returned matrix can be very large.</param>
+/// <param name="collision_check">Check for collisions</param>
+/// <param name="result_flag">set to 1 to include the timings between movements, set to 2 to also include the joint speeds (deg/s), set to 3 to also include the accelerations, set to 4 to include all previous information and make the splitting time-based.</param>
+/// <param name="time_step_s">(optional) set the time step in seconds for time based calculation. This value is only used when the result flag is set to 4 (time based).</param>
+/// <returns>Returns 0 if success, otherwise, it will return negative values</returns>
+int Item::InstructionListJoints(QString &error_msg, tMatrix2D **joint_list, double mm_step, double deg_step, const QString &save_to_file, bool collision_check, int result_flag, double time_step_s){
+    tMatrix2D *mat2d = nullptr;
+    if (save_to_file.isEmpty()) {
+        mat2d = Matrix2D_Create();
+    }
+    int error_code = InstructionListJointsInto(error_msg, mat2d, mm_step, deg_step, save_to_file, collision_check, result_flag, time_step_s);
+    if (joint_list != nullptr) {
+        *joint_list = mat2d;
+    } else if (mat2d != nullptr) {
+        Matrix2D_Delete(&mat2d);
+    }
+    return error_code;
+}
+
+int Item::InstructionListJointsInto(QString &error_msg, tMatrix2D *joint_list, double mm_step, double deg_step, const QString &save_to_file, bool collision_check, int result_flag, double time_step_s){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("G_ProgJointList");
+    rdk->_send_Item(this);
+    double step_mm_deg[5] = { mm_step, deg_step, collision_check ? 1.0 : 0.0, (double) result_flag, time_step_s };
+    rdk->_send_Array(step_mm_deg, 5);
+    rdk->_TIMEOUT = 3600 * 1000;
+    if (save_to_file.isEmpty()) {
+        rdk->_send_Line("");
+        if (joint_list != nullptr) {
+            rdk->_recv_Matrix2D(joint_list);
+        } else {
+            tMatrix2D *ignored = Matrix2D_Create();
+            rdk->_recv_Matrix2D(ignored);
+            Matrix2D_Delete(&ignored);
+        }
+    } else {
+        rdk->_send_Line(save_to_file);
+    }
+    int error_code = rdk->_recv_Int();
+    rdk->_TIMEOUT = rdk->_DEFAULT_TIMEOUT;
+    error_msg = rdk->_recv_Line();
+    rdk->_check_status();
+    return error_code;
+}
+
+/// <summary>
+/// Set a specific item parameter.
+/// Select **Tools-Run Script-Show Commands** to see all available commands for items and the station.
+/// Note: For parameters (commands) that require a JSON string value you can also provide a dict.
+/// </summary>
+/// <param name="param">item parameter</param>
+/// <param name="value">value</param>
+/// <returns></returns>
+QString Item::setParam(const QString &param, const QString &value){
+    tLinkScope rdk(this);
+    rdk->_check_connection();
+    rdk->_send_Line("ICMD");
+    rdk->_send_Item(this);
+    rdk->_send_Line(param);
+    rdk->_send_Line(value);
+    QString result =rdk->_recv_Line();
+    rdk->_check_status();
+    return result;
+}
+
+/// <summary>
+/// Disconnect from the RoboDK API. This flushes any pending program generation.
+/// </summary>
+/// <returns></returns>
+bool Item::Finish(){
+    tLinkScope rdk(this);
+    rdk->Finish();
+    return true;
+}
+
+quint64 Item::GetID(){
+    return _PTR;
+}
+
+//----------------------------------------  add more
+
+
+
+
+
+
+
+
+
+
+
+
+//---------------------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// LatencyHistogram CLASS //////////////////////////////////////////
+LatencyHistogram::LatencyHistogram(){
+    Reset();
+}
+
+// Values below SUB_BUCKETS have their own bucket. Larger values use SUB_BUCKETS buckets per power of two.
+int LatencyHistogram::_bucket(qint64 us){
+    if (us < SUB_BUCKETS){
+        return (int) qMax<qint64>(us, 0);
+    }
+    int shift = 0;
+    while ((us >> shift) >= 2*SUB_BUCKETS){
+        shift++;
+    }
+    int bucket = SUB_BUCKETS + shift*SUB_BUCKETS + (int) (us >> shift) - SUB_BUCKETS;
+    return qMin<int>(bucket, BUCKETS - 1);
+}
+
+qint64 LatencyHistogram::_upper(int bucket){
+    if (bucket < SUB_BUCKETS){
+        return bucket;
+    }
+    int shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+    qint64 sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(qint64 us){
+    us = qMax<qint64>(us, 0);
+    _COUNTS[_bucket(us)]++;
+    if (_COUNT == 0 || us < _MIN){
+        _MIN = us;
+    }
+    if (_COUNT == 0 || us > _MAX){
+        _MAX = us;
+    }
+    _COUNT++;
+    _SUM += us;
+}
+
+void LatencyHistogram::Add(const LatencyHistogram &other){
+    if (other._COUNT == 0){
+        return;
+    }
+    for (int i=0; i<BUCKETS; i++){
+        _COUNTS[i] += other._COUNTS[i];
+    }
+    _MIN = _COUNT == 0 ? other._MIN : qMin(_MIN, other._MIN);
+    _MAX = _COUNT == 0 ? other._MAX : qMax(_MAX, other._MAX);
+    _COUNT += other._COUNT;
+    _SUM += other._SUM;
+}
+
+void LatencyHistogram::Reset(){
+    memset(_COUNTS, 0, sizeof(_COUNTS));
+    _COUNT = 0;
+    _MIN = 0;
+    _MAX = 0;
+    _SUM = 0.0;
+}
+
+quint64 LatencyHistogram::Count() const {
+    return _COUNT;
+}
+
+qint64 LatencyHistogram::Min() const {
+    return _MIN;
+}
+
+qint64 LatencyHistogram::Max() const {
+    return _MAX;
+}
+
+double LatencyHistogram::Mean() const {
+    return _COUNT == 0 ? 0.0 : _SUM / _COUNT;
+}
+
+qint64 LatencyHistogram::Percentile(double percentile) const {
+    if (_COUNT == 0){
+        return 0;
+    }
+    quint64 rank = (quint64) ceil(qBound(0.0, percentile, 100.0) / 100.0 * _COUNT);
+    rank = qMax<quint64>(rank, 1);
+    quint64 seen = 0;
+    for (int i=0; i<BUCKETS; i++){
+        seen += _COUNTS[i];
+        if (seen >= rank){
+            return qBound(_MIN, _upper(i), _MAX);
+        }
+    }
+    return _MAX;
+}
+
+
+
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// RoboDK CLASS ////////////////////////////////////////////////////
+/// Names the blocking waits of a receive function in the trace (see RoboDKTracer).
+/// The outermost function gives the name, for example _check_status rather than _recv_Int.
+struct RoboDK::tTraceScope {
+    tTraceScope(RoboDK *rdk, const char *name) :
+        _RDK(rdk),
+        _OUTER(rdk->_TRACE_SCOPE == nullptr)
+    {
+        if (_OUTER){
+            _RDK->_TRACE_SCOPE = name;
+        }
+    }
+    ~tTraceScope(){
+        if (_OUTER){
+            _RDK->_TRACE_SCOPE = nullptr;
+        }
+    }
+    RoboDK *_RDK;
+    bool _OUTER;
+};
+
+RoboDK::RoboDK(const QString &robodk_ip, int com_port, const QString &args, const QString &path) {
+    _init(robodk_ip, com_port, args, path);
+}
+
+RoboDK::RoboDK(QSharedPointer<RoboDKTransport> transport, const QString &robodk_ip, int com_port, const QString &args, const QString &path) {
+    _TRANSPORT = transport;
+    _init(robodk_ip, com_port, args, path);
+}
+
+void RoboDK::_init(const QString &robodk_ip, int com_port, const QString &args, const QString &path){
+    _COM = nullptr;
+    if (_TRANSPORT.isNull()){
+        _TRANSPORT = QSharedPointer<RoboDKTransport>(new TcpTransport());
+    }
+    _IP = robodk_ip;
+    _DEFAULT_TIMEOUT = ROBODK_API_TIMEOUT;
+    _TIMEOUT = _DEFAULT_TIMEOUT;
+    _POOL = nullptr;
+    _PROCESS = 0;
+    _PORT = com_port;
+    _ROBODK_BIN = path;
+    if (_PORT < 0){
+        _PORT = ROBODK_DEFAULT_PORT;
+    }
+    if (_ROBODK_BIN.isEmpty()){
+        _ROBODK_BIN = ROBODK_DEFAULT_PATH_BIN;
+    }
+    _ARGUMENTS = args;
+    if (com_port > 0){
+        _ARGUMENTS.append(" /PORT=" + QString::number(com_port));
+    }
+    _SEND_BUFFER.reserve(ROBODK_API_SEND_BUFFER_SIZE);
+    _COMM_WRITES = 0;
+    _COMM_COMMANDS = 0;
+    _PIPELINE_ACTIVE = false;
+    _PIPELINE_DEPTH = 0;
+    _PIPELINE_COUNT = 0;
+    _INDEX_VALID = false;
+    _CLOCK.start();
+    _startup_reset();
+    _DEADLINE = -1;
+    _CANCEL_SET = false;
+    _ABORTED = false;
+    _ABORT_COUNT = 0;
+    _DESYNC = false;
+    _SYNC_COUNT = 0;
+    _STATS_ON = false;
+    _TRACE_SCOPE = nullptr;
+    _STAT_ACTIVE = false;
+    _STAT_REQUESTS = 0;
+    _COMMAND_NEXT = false;
+    _CAPTURE = nullptr;
+    _CAPTURE_SENT = 0;
+    _CAPTURE_TYPE = 0;
+    _connect_smart();
+}
+
+RoboDK::~RoboDK(){
+    StopCapture();
+    _disconnect();
+    qDeleteAll(_NEW_LINKS);
+    _NEW_LINKS.clear();
+}
+
+quint64 RoboDK::ProcessID(){
+    if (_PROCESS == 0) {
+        QString response = Command("MainProcess_ID");
+        _PROCESS = response.toInt();
+    }
+    return _PROCESS;
+}
+
+tStartupTiming RoboDK::StartupTiming() const {
+    return _STARTUP;
+}
+
+// Instances started by StartHeadless that did not accept a link yet (process ID by port).
+// Links to these ports wait for the instance instead of starting another one.
+static QMutex RoboDK_Headless_Mutex;
+static QHash<int, quint64> RoboDK_Headless_Ports;
+
+static bool Headless_Pending(int port){
+    QMutexLocker lock(&RoboDK_Headless_Mutex);
+    return RoboDK_Headless_Ports.contains(port);
+}
+
+static void Headless_Done(int port){
+    QMutexLocker lock(&RoboDK_Headless_Mutex);
+    RoboDK_Headless_Ports.remove(port);
+}
+
+quint64 RoboDK::StartHeadless(int com_port, const QString &args, const QString &path){
+    QString bin = path.isEmpty() ? QString(ROBODK_DEFAULT_PATH_BIN) : path;
+    QStringList arguments;
+    arguments << "/NOSPLASH" << "/NOSHOW" << "/HIDDEN";
+    if (com_port > 0){
+        arguments << "/PORT=" + QString::number(com_port);
+    }
+    arguments << args.split(" ", QString::SkipEmptyParts);
+    qint64 pid = 0;
+    if (!QProcess::startDetached(bin, arguments, QString(), &pid)){
+        qDebug() << "Could not start RoboDK: " << bin;
+        return 0;
+    }
+    QMutexLocker lock(&RoboDK_Headless_Mutex);
+    RoboDK_Headless_Ports.insert(com_port > 0 ? com_port : ROBODK_DEFAULT_PORT, pid);
+    return pid;
+}
+
+quint64 RoboDK::WindowID(){
+    qint64 window_id;
+    if (window_id == 0) {
+        QString response = Command("MainWindow_ID");
+        window_id = response.toInt();
+    }
+    return window_id;
+}
+
+bool RoboDK::Connected(){
+    return _connected();
+}
+
+bool RoboDK::Connect(){
+    _startup_reset();
+    return _connect();
+}
+
+bool RoboDK::ConnectWait(int timeout_ms){
+    _startup_reset();
+    return _connect_wait(timeout_ms < 0 ? ROBODK_API_START_TIMEOUT : timeout_ms);
+}
+/// <summary>
+/// Disconnect from the RoboDK API. This flushes any pending program generation.
+/// </summary>
+/// <returns></returns>
+void RoboDK::Disconnect(){
+    if (_PIPELINE_ACTIVE){
+        PipelineEnd();
+    }
+    _disconnect();
+}
+/// <summary>
+/// Disconnect from the RoboDK API. This flushes any pending program generation.
+/// </summary>
+/// <returns></returns>
+void RoboDK::Finish(){
+    Disconnect();
+}
+
+quint64 RoboDK::CommWrites() const {
+    return _COMM_WRITES;
+}
+
+quint64 RoboDK::CommCommands() const {
+    return _COMM_COMMANDS;
+}
+
+void RoboDK::ResetCommStats(){
+    _COMM_WRITES = 0;
+    _COMM_COMMANDS = 0;
+}
+
+void RoboDK::setStats(bool enable){
+    if (!enable && _STAT_ACTIVE){
+        _call_end();
+    }
+    _STATS_ON = enable;
+}
+
+bool RoboDK::StatsEnabled() const {
+    return _STATS_ON;
+}
+
+QList<tCommandStats> RoboDK::Stats(){
+    if (_STAT_ACTIVE){
+        _call_end(); // the last call is complete once its response was read
+    }
+    QStringList commands = _STATS.keys();
+    commands.sort();
+    QList<tCommandStats> stats;
+    for (int i=0; i<commands.length(); i++){
+        stats.append(_STATS.value(commands[i]));
+    }
+    return stats;
+}
+
+void RoboDK::ResetStats(){
+    _STAT_ACTIVE = false;
+    _STATS.clear();
+}
+
+void RoboDK::setTracer(QSharedPointer<RoboDKTracer> tracer){
+    if (_STAT_ACTIVE){
+        _call_end();
+    }
+    _TRACER = tracer;
+}
+
+QSharedPointer<RoboDKTracer> RoboDK::Tracer() const {
+    return _TRACER;
+}
+
+QString RoboDK::StatsText(){
+    QList<tCommandStats> stats = Stats();
+    QString text = QString("command").leftJustified(24) + QString(" %1 %2 %3 %4 %5 %6 %7 %8 %9\n").arg("calls", 8).arg("requests", 9).arg("bytes_out", 12).arg("bytes_in", 12)
+            .arg("send_p50", 10).arg("wait_p50", 10).arg("recv_p50", 10).arg("total_p50", 10).arg("total_p99", 10);
+    for (int i=0; i<stats.length(); i++){
+        // the command name is not given to arg: it could contain markers such as %1
+        const tCommandStats &cmd = stats[i];
+        text += cmd.command.leftJustified(24) + QString(" %1 %2 %3 %4 %5 %6 %7 %8 %9\n").arg(cmd.calls, 8).arg(cmd.requests, 9).arg(cmd.bytes_out, 12).arg(cmd.bytes_in, 12)
+                .arg(cmd.send.Percentile(50), 10).arg(cmd.wait.Percentile(50), 10).arg(cmd.recv.Percentile(50), 10)
+                .arg(cmd.total.Percentile(50), 10).arg(cmd.total.Percentile(99), 10);
+    }
+    return text;
+}
+
+static QString Stats_Json_Histogram(const LatencyHistogram &histogram){
+    return QString("{\"min\":%1,\"mean\":%2,\"p50\":%3,\"p90\":%4,\"p99\":%5,\"p999\":%6,\"max\":%7}")
+            .arg(histogram.Min()).arg(histogram.Mean(), 0, 'f', 1).arg(histogram.Percentile(50)).arg(histogram.Percentile(90))
+            .arg(histogram.Percentile(99)).arg(histogram.Percentile(99.9)).arg(histogram.Max());
+}
+
+QString RoboDK::StatsJson(){
+    QList<tCommandStats> stats = Stats();
+    QString json = "[";
+    for (int i=0; i<stats.length(); i++){
+        const tCommandStats &cmd = stats[i];
+        QString name = cmd.command;
+        name.replace("\\", "\\\\").replace("\"", "\\\"");
+        json += QString(i > 0 ? ",\n" : "\n") + "{\"command\":\"" + name + "\",";
+        json += QString("\"calls\":%1,\"requests\":%2,\"bytes_out\":%3,\"bytes_in\":%4,\"send\":%5,\"wait\":%6,\"recv\":%7,\"total\":%8}")
+                .arg(cmd.calls).arg(cmd.requests).arg(cmd.bytes_out).arg(cmd.bytes_in)
+                .arg(Stats_Json_Histogram(cmd.send)).arg(Stats_Json_Histogram(cmd.wait)).arg(Stats_Json_Histogram(cmd.recv)).arg(Stats_Json_Histogram(cmd.total));
+    }
+    json += "\n]\n";
+    return json;
+}
+
+bool RoboDK::StartCapture(const QString &trace_file){
+    StopCapture();
+    QFile *file = new QFile(trace_file);
+    if (!file->open(QFile::WriteOnly | QFile::Truncate)){
+        qDebug() << "Can not open file for writting " << trace_file;
+        delete file;
+        return false;
+    }
+    uchar version[sizeof(quint32)];
+    qToBigEndian<quint32>(ROBODK_TRACE_VERSION, version);
+    file->write(ROBODK_TRACE_MAGIC, sizeof(ROBODK_TRACE_MAGIC) - 1);
+    file->write((const char*) version, sizeof(quint32));
+    _CAPTURE = file;
+    _CAPTURE_SENT = _SEND_BUFFER.size(); // a request being built is not recorded
+    _CAPTURE_TYPE = 0;
+    _CAPTURE_DATA.clear();
+    return true;
+}
+
+void RoboDK::StopCapture(){
+    if (_CAPTURE == nullptr){
+        return;
+    }
+    _capture_end();
+    _CAPTURE->close();
+    delete _CAPTURE;
+    _CAPTURE = nullptr;
+    _CAPTURE_DATA.clear();
+}
+
+bool RoboDK::Capturing() const {
+    return _CAPTURE != nullptr;
+}
+
+void RoboDK::PipelineStart(int max_pending){
+    if (_PIPELINE_ACTIVE){
+        return;
+    }
+    _PIPELINE_ACTIVE = true;
+    _PIPELINE_DEPTH = qMax(max_pending, 1);
+    _PIPELINE_COUNT = 0;
+    _PIPELINE_ERRORS.clear();
+}
+
+int RoboDK::PipelineEnd(QList<tPipelineError> *errors){
+    if (!_PIPELINE_ACTIVE){
+        return 0;
+    }
+    _pipeline_drain();
+    _PIPELINE_ACTIVE = false;
+    int nerrors = _PIPELINE_ERRORS.length();
+    if (errors != nullptr){
+        *errors = _PIPELINE_ERRORS;
+    }
+    _PIPELINE_ERRORS.clear();
+    return nerrors;
+}
+
+bool RoboDK::PipelineActive() const {
+    return _PIPELINE_ACTIVE;
+}
+
+void RoboDK::setTimeout(int timeout_ms){
+    _DEFAULT_TIMEOUT = qMax(timeout_ms, 1);
+    _TIMEOUT = _DEFAULT_TIMEOUT;
+}
+
+int RoboDK::Timeout() const {
+    return _DEFAULT_TIMEOUT;
+}
+
+RoboDKPool *RoboDK::Pool() const {
+    return _POOL;
+}
+
+QSharedPointer<RoboDKTransport> RoboDK::Transport() const {
+    return _TRANSPORT;
+}
+
+void RoboDK::setDeadline(int timeout_ms, const CancelToken &token){
+    _DEADLINE = (timeout_ms < 0) ? -1 : _CLOCK.elapsed() + timeout_ms;
+    _CANCEL = token;
+    _CANCEL_SET = true;
+}
+
+void RoboDK::clearDeadline(){
+    _DEADLINE = -1;
+    _CANCEL = CancelToken();
+    _CANCEL_SET = false;
+}
+
+bool RoboDK::Aborted() const {
+    return _ABORTED;
+}
+
+// %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// public methods
+/// <summary>
+/// Returns an item by its name. If there is no exact match it will return the last closest match.
+/// </summary>
+/// <param name="name">Item name</param>
+/// <param name="type">Filter by item type RoboDK.ITEM_TYPE_...</param>
+/// <returns></returns>
+Item RoboDK::getItem(QString name, int itemtype){
+    _check_connection();
+    if (itemtype < 0){
+        _send_Line("G_Item");
+        _send_Line(name);
+    } else {
+        _send_Line("G_Item2");
+        _send_Line(name);
+        _send_Int(itemtype);
+    }
+    Item item = _recv_Item();
+    _check_status();
+    return item;
+}
+
+/// <summary>
+/// Returns a list of items (list of name or pointers) of all available items in the currently open station in robodk.
+/// Optionally, use a filter to return specific items (example: getItemListNames(filter = ITEM_CASE_ROBOT))
+/// </summary>
+/// <param name="filter">ITEM_TYPE</param>
+/// <returns></returns>
+QStringList RoboDK::getItemListNames(int filter){
+    _check_connection();
+    if (filter < 0) {
+        _send_Line("G_List_Items");
+    } else {
+        _send_Line("G_List_Items_Type");
+        _send_Int(filter);
+    }
+    qint32 numitems = _recv_Int();
+    QStringList listnames;
+    for (int i = 0; i < numitems; i++) {
+        listnames.append(_recv_Line());
+    }
+    _check_status();
+    return listnames;
+}
+
+/// <summary>
+/// Returns a list of items (list of name or pointers) of all available items in the currently open station in robodk.
+/// Optionally, use a filter to return specific items (example: getItemListNames(filter = ITEM_CASE_ROBOT))
+/// </summary>
+/// <param name="filter">ITEM_TYPE</param>
+/// <returns></returns>
+QList<Item> RoboDK::getItemList(int filter) {
+    _check_connection();
+    if (filter < 0) {
+        _send_Line("G_List_Items_ptr");
+    } else {
+        _send_Line("G_List_Items_Type_ptr");
+        _send_Int(filter);
+    }
+    int numitems = _recv_Int();
+    QList<Item> listitems;
+    for (int i = 0; i < numitems; i++) {
+        listitems.append(_recv_Item());
+    }
+    _check_status();
+    return listitems;
+}
+
+/// <summary>
+/// Builds a local index of the station tree (names, types and parents of all items) to look up items without contacting RoboDK.
+/// </summary>
+/// <returns>Number of items in the index</returns>
+int RoboDK::IndexRefresh(){
+    IndexInvalidate();
+    QList<Item> items = getItemList();
+    // send the name and parent requests of all items before reading any response (one round trip)
+    for (int i = 0; i < items.length(); i++){
+        _batch_request(2*i);
+        _send_Line("G_Name");
+        _send_Item(items[i]);
+        _batch_request(2*i + 1);
+        _send_Line("G_Parent");
+        _send_Item(items[i]);
+    }
+    _INDEX_ITEMS.reserve(items.length());
+    _INDEX_NAMES.reserve(items.length());
+    for (int i = 0; i < items.length(); i++){
+        QString name = _recv_Line();
+        _check_status();
+        Item parent = _recv_Item();
+        _check_status();
+        _index_add(items[i], name, parent);
+    }
+    _INDEX_VALID = _connected();
+    if (!_INDEX_VALID){
+        IndexInvalidate();
+    }
+    return _INDEX_ITEMS.size();
+}
+
+/// <summary>
+/// Discards the local index of the station tree.
+/// </summary>
+void RoboDK::IndexInvalidate(){
+    _INDEX_VALID = false;
+    _INDEX_ITEMS.clear();
+    _INDEX_NAMES.clear();
+}
+
+/// <summary>
+/// Checks if the local index of the station tree is available.
+/// </summary>
+/// <returns>True if the index is available</returns>
+bool RoboDK::IndexValid() const {
+    return _INDEX_VALID;
+}
+
+/// <summary>
+/// Returns an item by its exact name using the local index of the station tree.
+/// </summary>
+/// <param name="name">Item name</param>
+/// <param name="itemtype">Filter by item type RoboDK.ITEM_TYPE_...</param>
+/// <returns>First item with a match (invalid item if there is no match)</returns>
+Item RoboDK::IndexItem(const QString &name, int itemtype) const {
+    RoboDK *rdk = const_cast<RoboDK*>(this);
+    QHash<QString, QList<quint64> >::const_iterator it = _INDEX_NAMES.constFind(name);
+    if (it == _INDEX_NAMES.constEnd()){
+        return Item(rdk);
+    }
+    const QList<quint64> &ptrs = it.value();
+    for (int i = 0; i < ptrs.length(); i++){
+        qint32 type = _INDEX_ITEMS.value(ptrs[i]).type;
+        if (itemtype < 0 || type == itemtype){
+            return Item(rdk, ptrs[i], type);
+        }
+    }
+    return Item(rdk);
+}
+
+/// <summary>
+/// Returns the name of an item using the local index of the station tree.
+/// </summary>
+/// <param name="item">Item</param>
+/// <returns>Item name</returns>
+QString RoboDK::IndexName(const Item &item) const {
+    return _INDEX_ITEMS.value(item._PTR).name;
+}
+
+/// <summary>
+/// Returns the type of an item using the local index of the station tree.
+/// </summary>
+/// <param name="item">Item</param>
+/// <returns>Item type</returns>
+int RoboDK::IndexType(const Item &item) const {
+    QHash<quint64, tIndexEntry>::const_iterator it = _INDEX_ITEMS.constFind(item._PTR);
+    if (it == _INDEX_ITEMS.constEnd()){
+        return -1;
+    }
+    return it.value().type;
+}
+
+/// <summary>
+/// Returns the parent of an item using the local index of the station tree.
+/// </summary>
+/// <param name="item">Item</param>
+/// <returns>Parent item</returns>
+Item RoboDK::IndexParent(const Item &item) const {
+    RoboDK *rdk = const_cast<RoboDK*>(this);
+    QHash<quint64, tIndexEntry>::const_iterator it = _INDEX_ITEMS.constFind(item._PTR);
+    if (it == _INDEX_ITEMS.constEnd()){
+        return Item(rdk);
+    }
+    return Item(rdk, it.value().parent, it.value().parent_type);
+}
+
+void RoboDK::_index_add(const Item &item, const QString &name, const Item &parent){
+    if (item._PTR == 0){ return; }
+    tIndexEntry entry;
+    entry.name = name;
+    entry.type = item._TYPE;
+    entry.parent = parent._PTR;
+    entry.parent_type = parent._TYPE;
+    _INDEX_ITEMS.insert(item._PTR, entry);
+    _INDEX_NAMES[name].append(item._PTR);
+}
+
+// remove an item and all its childs from the index
+void RoboDK::_index_remove(quint64 ptr){
+    if (!_INDEX_ITEMS.contains(ptr)){ return; }
+    QList<quint64> childs;
+    for (QHash<quint64, tIndexEntry>::const_iterator it = _INDEX_ITEMS.constBegin(); it != _INDEX_ITEMS.constEnd(); ++it){
+        if (it.value().parent == ptr){
+            childs.append(it.key());
+        }
+    }
+    for (int i = 0; i < childs.length(); i++){
+        _index_remove(childs[i]);
+    }
+    QString name = _INDEX_ITEMS.value(ptr).name;
+    _INDEX_ITEMS.remove(ptr);
+    QList<quint64> &ptrs = _INDEX_NAMES[name];
+    ptrs.removeAll(ptr);
+    if (ptrs.isEmpty()){
+        _INDEX_NAMES.remove(name);
+    }
+}
+
+void RoboDK::_index_rename(quint64 ptr, const QString &name){
+    QHash<quint64, tIndexEntry>::iterator it = _INDEX_ITEMS.find(ptr);
+    if (it == _INDEX_ITEMS.end()){ return; }
+    QList<quint64> &ptrs = _INDEX_NAMES[it.value().name];
+    ptrs.removeAll(ptr);
+    if (ptrs.isEmpty()){
+        _INDEX_NAMES.remove(it.value().name);
+    }
+    it.value().name = name;
+    _INDEX_NAMES[name].append(ptr);
+}
+
+void RoboDK::_index_reparent(quint64 ptr, const Item &parent){
+    QHash<quint64, tIndexEntry>::iterator it = _INDEX_ITEMS.find(ptr);
+    if (it == _INDEX_ITEMS.end()){ return; }
+    it.value().parent = parent._PTR;
+    it.value().parent_type = parent._TYPE;
+}
+
+/////// add more methods
+
+/// <summary>
+/// Shows a RoboDK popup to select one object from the open station.
+/// An item type can be specified to filter desired items. If no type is specified, all items are selectable.
+/// </summary>
+/// <param name="message">Message to pop up</param>
+/// <param name="itemtype">optionally filter by RoboDK.ITEM_TYPE_*</param>
+/// <returns></returns>
+Item RoboDK::ItemUserPick(const QString &message, int itemtype) {
+    _check_connection();
+    _send_Line("PickItem");
+    _send_Line(message);
+    _send_Int(itemtype);
+    _TIMEOUT = 3600 * 1000;
+    Item item = _recv_Item();//item);
+    _TIMEOUT = _DEFAULT_TIMEOUT;
+    _check_status();
+    return item;
+}
+
+/// <summary>
+/// Shows or raises the RoboDK window
+/// </summary>
+void RoboDK::ShowRoboDK() {
+    _check_connection();
+    _send_Line("RAISE");
+    _check_status();
+}
+
+/// <summary>
+/// Hides the RoboDK window
+/// </summary>
+void RoboDK::HideRoboDK() {
+    _check_connection();
+    _send_Line("HIDE");
+    _check_status();
+}
+
+/// <summary>
+/// Closes RoboDK window and finishes RoboDK execution
+/// </summary>
+void RoboDK::CloseRoboDK() {
+    _check_connection();
+    _send_Line("QUIT");
+    _check_status();
+    _disconnect();
+    _PROCESS = 0;
+}
+
+QString RoboDK::Version()
+{
+    _check_connection();
+    _send_Line("Version");
+    QString appName = _recv_Line();
+    int bitArch = _recv_Int();
+    QString ver4 = _recv_Line();
+    QString dateBuild = _recv_Line();
+    _check_status();
+    return ver4;
+
+}
+
+
+/// <summary>
+/// Set the state of the RoboDK window
+/// </summary>
+/// <param name="windowstate"></param>
+void RoboDK::setWindowState(int windowstate){
+    _check_connection();
+    _send_Line("S_WindowState");
+    _send_Int(windowstate);
+    _check_status();
+}
+
+
+/// <summary>
+/// Update the RoboDK flags. RoboDK flags allow defining how much access the user has to RoboDK features. Use FLAG_ROBODK_* variables to set one or more flags.
+/// </summary>
+/// <param name="flags">state of the window(FLAG_ROBODK_*)</param>
+void RoboDK::setFlagsRoboDK(int flags){
+    _check_connection();
+    _send_Line("S_RoboDK_Rights");
+    _send_Int(flags);
+    _check_status();
+}
+
+/// <summary>
+/// Update item flags. Item flags allow defining how much access the user has to item-specific features. Use FLAG_ITEM_* flags to set one or more flags.
+/// </summary>
+/// <param name="item"></param>
+/// <param name="flags"></param>
+void RoboDK::setFlagsItem(Item item, int flags){
+    _check_connection();
+    _send_Line("S_Item_Rights");
+    _send_Item(item);
+    _send_Int(flags);
+    _check_status();
+}
+
+/// <summary>
+/// Retrieve current item flags. Item flags allow defining how much access the user has to item-specific features. Use FLAG_ITEM_* flags to set one or more flags.
+/// </summary>
+/// <param name="item"></param>
+/// <returns></returns>
+int RoboDK::getFlagsItem(Item item){
+    _check_connection();
+    _send_Line("S_Item_Rights");
+    _send_Item(item);
+    int flags = _recv_Int();
+    _check_status();
+    return flags;
+}
+
+/// <summary>
+/// Show a message in RoboDK (it can be blocking or non blocking in the status bar)
+/// </summary>
+/// <param name="message">Message to display</param>
+/// <param name="popup">Set to true to make the message blocking or set to false to make it non blocking</param>
+void RoboDK::ShowMessage(const QString &message, bool popup){
+    _check_connection();
+    if (popup)
+    {
+        _send_Line("ShowMessage");
+        _send_Line(message);
+        _TIMEOUT = 3600 * 1000;
+        _check_status();
+        _TIMEOUT = _DEFAULT_TIMEOUT;
+    }
+    else
+    {
+        _send_Line("ShowMessageStatus");
+        _send_Line(message);
+        _check_status();
+    }
+
+}
+
+/// <summary>
+/// Makes a copy of an item (same as Ctrl+C), which can be pasted (Ctrl+V) using Paste().
+/// </summary>
+/// <param name="tocopy">Item to copy</param>
+void RoboDK::Copy(const Item &tocopy){
+    _check_connection();
+    _send_Line("Copy");
+    _send_Item(tocopy);
+    _check_status();
+}
+
+/// <summary>
+/// Paste the copied item as a dependency of another item (same as Ctrl+V). Paste should be used after Copy(). It returns the newly created item.
+/// </summary>
+/// <param name="paste_to">Item to attach the copied item (optional)</param>
+/// <returns>New item created</returns>
+Item RoboDK::Paste(const Item *paste_to){
+    _check_connection();
+    _send_Line("Paste");
+    _send_Item(paste_to);
+    Item newitem = _recv_Item();
+    _check_status();
+    return newitem;
+}
+
+/// <summary>
+/// Loads a file and attaches it to parent. It can be any file supported by robodk.
+/// </summary>
+/// <param name="filename">absolute path of the file</param>
+/// <param name="parent">parent to attach. Leave empty for new stations or to load an object at the station root</param>
+/// <returns>Newly added object. Check with item.Valid() for a successful load</returns>
+Item RoboDK::AddFile(const QString &filename, const Item *parent){
+    _check_connection();
+    _send_Line("Add");
+    _send_Line(filename);
+    _send_Item(parent);
+    Item newitem = _recv_Item();
+    _check_status();
+    return newitem;
+}
+
+/// <summary>
+/// Save an item to a file. If no item is provided, the open station is saved.
+/// </summary>
+/// <param name="filename">absolute path to save the file</param>
+/// <param name="itemsave">object or station to save. Leave empty to automatically save the current station.</param>
+void RoboDK::Save(const QString &filename, const Item *itemsave){
+    _check_connection();
+    _send_Line("Save");
+    _send_Line(filename);
+    _send_Item(itemsave);
+    _check_status();
+}
+
+/// <summary>
+///     Adds a shape provided triangle coordinates. Triangles must be provided as a list of vertices. A vertex normal can
+///     be provided optionally.
+/// </summary>
+/// <param name="trianglePoints">
+///     List of vertices grouped by triangles (3xN or 6xN matrix, N must be multiple of 3 because
+///     vertices must be stacked by groups of 3)
+/// </param>
+/// <param name="addTo">item to attach the newly added geometry (optional). Leave empty to create a new object.</param>
+/// <param name="shapeOverride">Set to true to replace any other existing geometry</param>
+/// <param name="color">Color of the added shape</param>
+/// <returns>added object/shape (use item.Valid() to check if item is valid.)</returns>
+Item RoboDK::AddShape(tMatrix2D *trianglePoints, Item *addTo, bool shapeOverride, Color *color)
+{
+    double colorArray[4] = {0.6,0.6,0.8,1.0};
+    if (color != nullptr){
+        colorArray[0] = color->r;
+        colorArray[1] = color->g;
+        colorArray[2] = color->b;
+        colorArray[3] = color->a;
+    }
+    _check_connection();
+    _send_Line("AddShape3");
+    _send_Matrix2D(trianglePoints);
+    _send_Item(addTo);
+    _send_Int(shapeOverride? 1 : 0);
+    _send_Array(colorArray,4);
+    Item newitem = _recv_Item();
+    _check_status();
+    return newitem;
+}
+
+/// <summary>
+/// Adds a curve provided point coordinates.
+/// The provided points must be a list of vertices.
+/// A vertex normal can be provided optionally.
+/// </summary>
+/// <param name="curvePoints">matrix 3xN or 6xN -> N must be multiple of 3</param>
+/// <param name="referenceObject">object to add the curve and/or project the curve to the surface</param>
+/// <param name="addToRef">
+///     If True, the curve will be added as part of the object in the RoboDK item tree (a reference
+///     object must be provided)
+/// </param>
+/// <param name="projectionType">
+///     Type of projection. For example:  ProjectionType.AlongNormalRecalc will project along the
+///     point normal and recalculate the normal vector on the surface projected.
+/// </param>
+/// <returns>added object/curve (use item.Valid() to check if item is valid.)</returns>
+Item RoboDK::AddCurve(tMatrix2D *curvePoints, Item *referenceObject, bool addToRef, int ProjectionType)
+{
+    _check_connection();
+    _send_Line("AddWire");
+    _send_Matrix2D(curvePoints);
+    _send_Item(referenceObject);
+    _send_Int(addToRef ? 1:0);
+    _send_Int(ProjectionType);
+    Item newitem = _recv_Item();
+    _check_status();
+    return newitem;
+}
+
+/// <summary>
+/// Adds a list of points to an object. The provided points must be a list of vertices. A vertex normal can be provided optionally.
+/// </summary>
+/// <param name="points">list of points as a matrix (3xN matrix, or 6xN to provide point normals as ijk vectors)</param>
+/// <param name="referenceObject">item to attach the newly added geometry (optional)</param>
+/// <param name="addToRef">If True, the points will be added as part of the object in the RoboDK item tree (a reference object must be provided)</param>
+/// <param name="projectionType">Type of projection.Use the PROJECTION_* flags.</param>
+/// <returns>added object/shape (0 if failed)</returns>
+Item RoboDK::AddPoints(tMatrix2D *points, Item *referenceObject, bool addToRef, int ProjectionType)
+{
+    _check_connection();
+    _send_Line("AddPoints");
+    _send_Matrix2D(points);
+    _send_Item(referenceObject);
+    _send_Int(addToRef? 1 : 0);
+    _send_Int(ProjectionType);Item newitem = _recv_Item();
+    _check_status();
+    return newitem;
+}
+
+void RoboDK::ProjectPoints(tMatrix2D *points, tMatrix2D **projected, Item objectProject, int ProjectionType)
+{
+    _check_connection();
+    _send_Line("ProjectPoints");
+    _send_Matrix2D(points);
+    _send_Item(objectProject);
+    _send_Int(ProjectionType);
+    _recv_Matrix2D(projected);
+    _check_status();
+}
+
+void RoboDK::ProjectPointsInto(tMatrix2D *points, tMatrix2D *projected, Item objectProject, int ProjectionType)
+{
+    _check_connection();
+    _send_Line("ProjectPoints");
+    _send_Matrix2D(points);
+    _send_Item(objectProject);
+    _send_Int(ProjectionType);
+    _recv_Matrix2D(projected);
+    _check_status();
+}
+
+/// <summary>
+/// Add a new empty station.
+/// </summary>
+/// <param name="name">Name of the station</param>
+/// <returns>Newly created station IItem</returns>
+Item RoboDK::AddStation(QString name)
+{
+    _check_connection();
+    _send_Line("NewStation");
+    Item newitem = _recv_Item();
+    _check_status();
+    return newitem;
+}
+
+
+
+
+/// <summary>
+/// Closes the current station without suggesting to save
+/// </summary>
+void RoboDK::CloseStation(){
+    _check_connection();
+    _send_Line("RemoveStn");
+    _check_status();
+}
+
+/// <summary>
+/// Adds a new target that can be reached with a robot.
+/// </summary>
+/// <param name="name">name of the target</param>
+/// <param name="itemparent">parent to attach to (such as a frame)</param>
+/// <param name="itemrobot">main robot that will be used to go to self target</param>
+/// <returns>the new target created</returns>
+Item RoboDK::AddTarget(const QString &name, Item *itemparent, Item *itemrobot){
+    _check_connection();
+    _send_Line("Add_TARGET");
+    _send_Line(name);
+    _send_Item(itemparent);
+    _send_Item(itemrobot);
+    Item newitem = _recv_Item();
+    _check_status();
+    if (_INDEX_VALID){
+        _index_add(newitem, name, itemparent != nullptr ? *itemparent : newitem.Parent());
+    }
+    return newitem;
+}
+
+/// <summary>
+/// Adds a new Frame that can be referenced by a robot.
+/// </summary>
+/// <param name="name">name of the reference frame</param>
+/// <param name="itemparent">parent to attach to (such as the robot base frame)</param>
+/// <returns>the new reference frame created</returns>
+Item RoboDK::AddFrame(const QString &name, Item *itemparent){
+    _check_connection();
+    _send_Line("Add_FRAME");
+    _send_Line(name);
+    _send_Item(itemparent);
+    Item newitem = _recv_Item();
+    _check_status();
+    if (_INDEX_VALID){
+        _index_add(newitem, name, itemparent != nullptr ? *itemparent : newitem.Parent());
+    }
+    return newitem;
+}
+
+/// <summary>
+/// Adds a new Frame that can be referenced by a robot.
+/// </summary>
+/// <param name="name">name of the program</param>
+/// <param name="itemparent">robot that will be used</param>
+/// <returns>the new program created</returns>
+Item RoboDK::AddProgram(const QString &name, Item *itemrobot){
+    _check_connection();
+    _send_Line("Add_PROG");
+    _send_Line(name);
+    _send_Item(itemrobot);
+    Item newitem = _recv_Item();
+    _check_status();
+    return newitem;
+}
+
+/// <summary>
+/// Add a new robot machining project. Machining projects can also be used for 3D printing, following curves and following points.
+/// It returns the newly created :class:`.IItem` containing the project settings.
+/// Tip: Use the macro /RoboDK/Library/Macros/MoveRobotThroughLine.py to see an example that creates a new "curve follow project" given a list of points to follow(Option 4).
+/// </summary>
+/// <param name="name">Name of the project settings</param>
+/// <param name="itemrobot">Robot to use for the project settings(optional). It is not required to specify the robot if only one robot or mechanism is available in the RoboDK station.</param>
+/// <returns></returns>
+Item RoboDK::AddMachiningProject(QString name, Item *itemrobot)
+{
+    _check_connection();
+    _send_Line("Add_MACHINING");
+    _send_Line(name);
+    _send_Item(itemrobot);
+    Item newitem = _recv_Item();
+    _check_status();
+    return newitem;
+}
+
+
+
+QList<Item> RoboDK::getOpenStation()
+{
+    _check_connection();
+    _send_Line("G_AllStn");
+    int nstn = _recv_Int();
+    QList<Item> *listStn = new QList<Item>();
+    for (int i = 0;i < nstn;i++){
+        Item station = _recv_Item();
+        listStn->append(station);
+    }
+    _check_status();
+    return *listStn;
+}
+
+
+/// <summary>
+/// Returns the active station item (station currently visible)
+/// </summary>
+/// <returns></returns>
+Item RoboDK::getActiveStation() {
+    _check_connection();
+    _send_Line("G_ActiveStn");
+    Item station = _recv_Item();
+    _check_status();
+    return station;
+}
+
+/// <summary>
+/// Set the active station (project currently visible)
+/// </summary>
+/// <param name="station">station item, it can be previously loaded as an RDK file</param>
+void RoboDK::setActiveStation(Item station) {
+    _check_connection();
+    _send_Line("S_ActiveStn");
+    _send_Item(station);
+    _check_status();
+}
+
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/// <summary>
+/// Adds a function call in the program output. RoboDK will handle the syntax when the code is generated for a specific robot. If the program exists it will also run the program in simulate mode.
+/// </summary>
+/// <param name="function_w_params">Function name with parameters (if any)</param>
+/// <returns></returns>
+int RoboDK::RunProgram(const QString &function_w_params){
+    return RunCode(function_w_params, true);
+}
+
+/// <summary>
+/// Adds code to run in the program output. If the program exists it will also run the program in simulate mode.
+/// </summary>
+/// <param name="code"></param>
+/// <param name="code_is_fcn_call"></param>
+/// <returns></returns>
+int RoboDK::RunCode(const QString &code, bool code_is_fcn_call){
+    _check_connection();
+    _send_Line("RunCode");
+    _send_Int(code_is_fcn_call ? 1 : 0);
+    _send_Line(code);
+    int prog_status = _recv_Int();
+    _check_status();
+    return prog_status;
+}
+
+/// <summary>
+/// Shows a message or a comment in the output robot program.
+/// </summary>
+/// <param name="message"></param>
+/// <param name="message_is_comment"></param>
+void RoboDK::RunMessage(const QString &message, bool message_is_comment){
+    _check_connection();
+    _send_Line("RunMessage");
+    _send_Int(message_is_comment ? 1 : 0);
+    _send_Line(message);
+    _check_status();
+}
+
+/// <summary>
+/// Renders the scene. This function turns off rendering unless always_render is set to true.
+/// </summary>
+/// <param name="always_render"></param>
+void RoboDK::Render(bool always_render){
+    bool auto_render = !always_render;
+    _check_connection();
+    _send_Line("Render");
+    _send_Int(auto_render ? 1 : 0);
+    _check_status();
+}
+
+/// <summary>
+/// Update the screen.
+/// This updates the position of all robots and internal links according to previously set values.
+/// </summary>
+void RoboDK::Update()
+{
+    _check_connection();
+    _send_Line("Refresh");
+    _send_Int(0);
+    _check_status();
+}
+
+/// <summary>
+/// Returns (1/True) if object_inside is inside the object_parent
+/// </summary>
+/// <param name="object_inside"></param>
+/// <param name="object_parent"></param>
+/// <returns></returns>
+bool RoboDK::IsInside(Item object_inside, Item object_parent){
+    _check_connection();
+    _send_Line("IsInside");
+    _send_Item(object_inside);
+    _send_Item(object_parent);
+    int inside = _recv_Int();
+    _check_status();
+    return inside > 0;
+}
+
+/// <summary>
+/// Set collision checking ON or OFF (COLLISION_OFF/COLLISION_OFF) according to the collision map. If collision check is activated it returns the number of pairs of objects that are currently in a collision state.
+/// </summary>
+/// <param name="check_state"></param>
+/// <returns>Number of pairs of objects in a collision state</returns>
+int RoboDK::setCollisionActive(int check_state){
+    _check_connection();
+    _send_Line("Collision_SetState");
+    _send_Int(check_state);
+    int ncollisions = _recv_Int();
+    _check_status();
+    return ncollisions;
+}
+
+/// <summary>
+/// Set collision checking ON or OFF (COLLISION_ON/COLLISION_OFF) for a specific pair of objects. This allows altering the collision map for Collision checking.
+/// Specify the link id for robots or moving mechanisms (id 0 is the base).
+/// </summary>
+/// <param name="check_state">Set to COLLISION_ON or COLLISION_OFF</param>
+/// <param name="item1">Item 1</param>
+/// <param name="item2">Item 2</param>
+/// <param name="id1">Joint id for Item 1 (if Item 1 is a robot or a mechanism)</param>
+/// <param name="id2">Joint id for Item 2 (if Item 2 is a robot or a mechanism)</param>
+/// <returns>Returns true if succeeded. Returns false if setting the pair failed (wrong id was provided)</returns>
+bool RoboDK::setCollisionActivePair(int check_state, Item item1, Item item2, int id1, int id2){
+    _check_connection();
+    _send_Line("Collision_SetPair");
+    _send_Item(item1);
+    _send_Item(item2);
+    _send_Int(id1);
+    _send_Int(id2);
+    _send_Int(check_state);
+    int success = _recv_Int();
+    _check_status();
+    return success > 0;
+}
+
+/// <summary>
+/// Returns the number of pairs of objects that are currently in a collision state.
+/// </summary>
+/// <returns></returns>
+int RoboDK::Collisions(){
+    _check_connection();
+    _send_Line("Collisions");
+    int ncollisions = _recv_Int();
+    _check_status();
+    return ncollisions;
+}
+
+/// <summary>
+/// Returns 1 if item1 and item2 collided. Otherwise returns 0.
+/// </summary>
+/// <param name="item1"></param>
+/// <param name="item2"></param>
+/// <returns></returns>
+int RoboDK::Collision(Item item1, Item item2){
+    _check_connection();
+    _send_Line("Collided");
+    _send_Item(item1);
+    _send_Item(item2);
+    int ncollisions = _recv_Int();
+    _check_status();
+    return ncollisions;
+}
+
+QList<Item> RoboDK::getCollisionItems(QList<int> link_id_list)
+{
+    _check_connection();
+    _send_Line("Collision Items");
+    int nitems = _recv_Int();
+    QList<Item> itemList = QList<Item>();
+    if (!link_id_list.isEmpty()){
+        link_id_list.clear();
+    }
+    for (int i = 0; i < nitems; i++){
+        itemList.append(_recv_Item());
+        int linkId = _recv_Int();
+        if (!link_id_list.isEmpty()){
+            link_id_list.append(linkId);
+        }
+        int collisionTimes = _recv_Int();
+    }
+    _check_status();
+    return itemList;
+}
+
+/// <summary>
+/// Sets the current simulation speed. Set the speed to 1 for a real-time simulation. The slowest speed allowed is 0.001 times the real speed. Set to a high value (>100) for fast simulation results.
+/// </summary>
+/// <param name="speed"></param>
+void RoboDK::setSimulationSpeed(double speed){
+    _check_connection();
+    _send_Line("SimulateSpeed");
+    _send_Int((int)(speed * 1000.0));
+    _check_status();
+}
+
+/// <summary>
+/// Gets the current simulation speed. Set the speed to 1 for a real-time simulation.
+/// </summary>
+/// <returns></returns>
+double RoboDK::SimulationSpeed(){
+    _check_connection();
+    _send_Line("GetSimulateSpeed");
+    double speed = ((double)_recv_Int()) / 1000.0;
+    _check_status();
+    return speed;
+}
+/// <summary>
+/// Sets the behavior of the RoboDK API. By default, robodk shows the path simulation for movement instructions (run_mode=1=RUNMODE_SIMULATE).
+/// Setting the run_mode to RUNMODE_QUICKVALIDATE allows performing a quick check to see if the path is feasible.
+/// if robot.Connect() is used, RUNMODE_RUN_FROM_PC is selected automatically.
+/// </summary>
+/// <param name="run_mode">int = RUNMODE
+/// RUNMODE_SIMULATE=1        performs the simulation moving the robot (default)
+/// RUNMODE_QUICKVALIDATE=2   performs a quick check to validate the robot movements
+/// RUNMODE_MAKE_ROBOTPROG=3  makes the robot program
+/// RUNMODE_RUN_REAL=4        moves the real robot is it is connected</param>
+void RoboDK::setRunMode(int run_mode){
+    _check_connection();
+    _send_Line("S_RunMode");
+    _send_Int(run_mode);
+    _check_status();
+}
+
+/// <summary>
+/// Returns the behavior of the RoboDK API. By default, robodk shows the path simulation for movement instructions (run_mode=1)
+/// </summary>
+/// <returns>int = RUNMODE
+/// RUNMODE_SIMULATE=1        performs the simulation moving the robot (default)
+/// RUNMODE_QUICKVALIDATE=2   performs a quick check to validate the robot movements
+/// RUNMODE_MAKE_ROBOTPROG=3  makes the robot program
+/// RUNMODE_RUN_REAL=4        moves the real robot is it is connected</returns>
+int RoboDK::RunMode(){
+    _check_connection();
+    _send_Line("G_RunMode");
+    int runmode = _recv_Int();
+    _check_status();
+    return runmode;
+}
+/// <summary>
+/// Gets all the user parameters from the open RoboDK station.
+/// The parameters can also be modified by right clicking the station and selecting "shared parameters"
+/// User parameters can be added or modified by the user
+/// </summary>
+/// <returns>list of pairs of strings as parameter-value (list of a list)</returns>
+QList<QPair<QString,QString>> RoboDK::getParams(){
+    _check_connection();
+    _send_Line("G_Params");
+    QList<QPair<QString,QString>> paramlist;
+    int nparam = _recv_Int();
+    for (int i = 0; i < nparam; i++) {
+        QString param = _recv_Line();
+        QString value = _recv_Line();
+        paramlist.append(qMakePair(param, value));
+    }
+    _check_status();
+    return paramlist;
+}
+
+/// <summary>
+/// Gets a global or a user parameter from the open RoboDK station.
+/// The parameters can also be modified by right clicking the station and selecting "shared parameters"
+/// Some available parameters:
+/// PATH_OPENSTATION = folder path of the current .stn file
+/// FILE_OPENSTATION = file path of the current .stn file
+/// PATH_DESKTOP = folder path of the user's folder
+/// Other parameters can be added or modified by the user
+/// </summary>
+/// <param name="param">RoboDK parameter</param>
+/// <returns>value</returns>
+QString RoboDK::getParam(const QString &param){
+    _check_connection();
+    _send_Line("G_Param");
+    _send_Line(param);
+    QString value = _recv_Line();
+    if (value.startsWith("UNKNOWN ")) {
+        value = "";
+    }
+    _check_status();
+    return value;
+}
+
+/// <summary>
+/// Sets a global parameter from the RoboDK station. If the parameters exists, it will be modified. If not, it will be added to the station.
+/// The parameters can also be modified by right clicking the station and selecting "shared parameters"
+/// </summary>
+/// <param name="param">RoboDK parameter</param>
+/// <param name="value">value</param>
+/// <returns></returns>
+void RoboDK::setParam(const QString &param, const QString &value){
+    _check_connection();
+    _send_Line("S_Param");
+    _send_Line(param);
+    _send_Line(value);
+    _check_status();
+}
+
+/// <summary>
+/// Send a special command. These commands are meant to have a specific effect in RoboDK, such as changing a specific setting or provoke specific events.
+/// </summary>
+/// <param name="cmd">Command Name, such as Trace, Threads or Window.</param>
+/// <param name="value">Comand value (optional, not all commands require a value)</param>
+/// <returns></returns>
+QString RoboDK::Command(const QString &cmd, const QString &value){
+    _check_connection();
+    _send_Line("SCMD");
+    _send_Line(cmd);
+    _send_Line(value);
+    QString answer = _recv_Line();
+    _check_status();
+    return answer;
+}
+
+bool RoboDK::LaserTrackerMeasure(tXYZ xyz, tXYZ estimate, bool search)
+{
+    _check_connection();
+    _send_Line("MeasLT");
+    _send_XYZ(estimate);
+    _send_Int(search ? 1 : 0);
+    _recv_XYZ(xyz);
+    _check_status();
+    if (xyz[0]*xyz[0] + xyz[1]*xyz[1] + xyz[2]*xyz[2] < 0.0001){
+        return false;
+    }
+
+    return true;
+}
+
+void RoboDK::ShowAsCollided(QList<Item> itemList, QList<bool> collidedList, QList<int> *robot_link_id)
+{
+    int nitems = qMin(itemList.length(),collidedList.length());
+    if (robot_link_id != nullptr){
+        nitems = qMin(nitems, robot_link_id->length());
+    }
+    _check_connection();
+    _send_Line("ShowAsCollidedList");
+    _send_Int(nitems);
+    for (int i = 0; i < nitems; i++){
+        _send_Item(itemList[i]);
+        _send_Int(collidedList[i] ? 1 : 0);
+        int link_id = 0;
+        if (robot_link_id != nullptr){
+            link_id = robot_link_id->at(i);
+        }
+        _send_Int(link_id);
+    }
+    _check_status();
+}
+
+/// <summary>
+/// Set the relative positions (poses) of a list of items with respect to their parent (faster than calling Item::setPose for each item).
+/// </summary>
+/// <param name="items">List of items</param>
+/// <param name="poses">List of poses (same length as the list of items)</param>
+/// <returns>True if successful</returns>
+bool RoboDK::setPoses(const QList<Item> &items, const QList<Mat> &poses){
+    return _setPoses("S_Hlocals", items, poses);
+}
+
+/// <summary>
+/// Set the absolute positions (poses) of a list of items with respect to the station reference (faster than calling Item::setPoseAbs for each item).
+/// </summary>
+/// <param name="items">List of items</param>
+/// <param name="poses">List of absolute poses (same length as the list of items)</param>
+/// <returns>True if successful</returns>
+bool RoboDK::setPosesAbs(const QList<Item> &items, const QList<Mat> &poses){
+    return _setPoses("S_Hlocal_AbsS", items, poses);
+}
+
+/// <summary>
+/// Returns the relative positions (poses) of a list of items (see Item::Pose).
+/// </summary>
+/// <param name="items">List of items</param>
+/// <returns>List of poses</returns>
+QList<Mat> RoboDK::Poses(const QList<Item> &items){
+    return _getPoses("G_Hlocal", items);
+}
+
+/// <summary>
+/// Returns the absolute positions (poses) of a list of items with respect to the station reference (see Item::PoseAbs).
+/// </summary>
+/// <param name="items">List of items</param>
+/// <returns>List of absolute poses</returns>
+QList<Mat> RoboDK::PosesAbs(const QList<Item> &items){
+    return _getPoses("G_Hlocal_Abs", items);
+}
+
+/// <summary>
+/// Returns the current joints of a list of robots (faster than calling Item::Joints for each robot).
+/// </summary>
+/// <param name="robots">List of robot items</param>
+/// <returns>List of robot joints</returns>
+QList<tJoints> RoboDK::Joints(const QList<Item> &robots){
+    QList<tJoints> joints_list;
+    Joints(robots, joints_list);
+    return joints_list;
+}
+
+/// <summary>
+/// Retrieves the current joints of a list of robots in an existing list (faster than calling Item::Joints for each robot).
+/// </summary>
+/// <param name="robots">List of robot items</param>
+/// <param name="joints_list">Returns the list of robot joints</param>
+/// <returns>True if successful</returns>
+bool RoboDK::Joints(const QList<Item> &robots, QList<tJoints> &joints_list){
+    // reuse the existing list: only resize it if the number of robots changed
+    while (joints_list.length() > robots.length()){
+        joints_list.removeLast();
+    }
+    while (joints_list.length() < robots.length()){
+        joints_list.append(tJoints());
+    }
+    _check_connection();
+    _send_Line("G_ThetasList");
+    _send_Int(robots.length());
+    // RoboDK answers each robot in order: send all robots before reading the joints (one round trip)
+    for (int i = 0; i < robots.length(); i++){
+        _send_Item(robots[i]);
+    }
+    bool ok = true;
+    for (int i = 0; i < robots.length(); i++){
+        ok = _recv_Array(&joints_list[i]) && ok;
+    }
+    return !_check_status() && ok;
+}
+
+/// <summary>
+/// Set the current joints of a list of robots (faster than calling Item::setJoints for each robot).
+/// </summary>
+/// <param name="robots">List of robot items</param>
+/// <param name="joints_list">List of robot joints (same length as the list of robots)</param>
+/// <returns>True if successful</returns>
+bool RoboDK::setJoints(const QList<Item> &robots, const QList<tJoints> &joints_list){
+    if (robots.length() != joints_list.length()){
+        qDebug() << "RoboDK API ERROR: The number of robots must match the number of joints (S_ThetasList)";
+        return false;
+    }
+    _check_connection();
+    _send_Line("S_ThetasList");
+    _send_Int(robots.length());
+    for (int i = 0; i < robots.length(); i++){
+        _send_Item(robots[i]);
+        _send_Array(&joints_list[i]);
+    }
+    return !_check_status();
+}
+
+bool RoboDK::_setPoses(const QString &command, const QList<Item> &items, const QList<Mat> &poses){
+    if (items.length() != poses.length()){
+        qDebug() << "RoboDK API ERROR: The number of items must match the number of poses (" << command << ")";
+        return false;
+    }
+    _check_connection();
+    _send_Line(command);
+    _send_Int(items.length());
+    for (int i = 0; i < items.length(); i++){
+        _send_Item(items[i]);
+        _send_Pose(poses[i]);
+    }
+    return !_check_status();
+}
+
+// Send the requests for all items before reading any response. This is equivalent to calling the single item command for each item, with one round trip.
+QList<Mat> RoboDK::_getPoses(const QString &command, const QList<Item> &items){
+    QList<Mat> poses;
+    poses.reserve(items.length());
+    for (int i = 0; i < items.length(); i++){
+        _batch_request(i);
+        _send_Line(command);
+        _send_Item(items[i]);
+    }
+    for (int i = 0; i < items.length(); i++){
+        poses.append(_recv_Pose());
+        _check_status();
+    }
+    return poses;
+}
+
+/// <summary>
+/// Returns the kinematics of a robot. The first time, the joint axes are retrieved from the forward kinematics computed by RoboDK:
+/// the pose with all joints at 0 and the pose moving each joint on its own (all requests are sent at once).
+/// The result is verified with 2 more poses, the kinematics are not valid if the robot is not a serial chain (such as robots with coupled joints).
+/// The inverse kinematics are verified with one more round trip (see Kinematics::CanSolveIK).
+/// </summary>
+Kinematics RoboDK::_kinematics(const Item &robot, bool refresh){
+    if (!refresh && _KINEMATICS.contains(robot._PTR)){
+        return _KINEMATICS.value(robot._PTR);
+    }
+    Kinematics kin;
+    int ndofs = robot.Joints().Length();
+    _ROBOT_DOFS.insert(robot._PTR, ndofs);
+    QList<tJoints> samples;
+    samples.append(tJoints(ndofs));
+    for (int j=0; j<ndofs; j++){
+        tJoints joints(ndofs);
+        joints.Data()[j] = ROBODK_API_FK_STEP;
+        samples.append(joints);
+    }
+    tJoints check1(ndofs);
+    tJoints check2(ndofs);
+    for (int j=0; j<ndofs; j++){
+        check1.Data()[j] = 10.0 + 7.0*j;
+        check2.Data()[j] = (j % 2 == 0) ? -35.0 + 3.0*j : 25.0 - 4.0*j;
+    }
+    samples.append(check1);
+    samples.append(check2);
+    if (ndofs > 0){
+        _batch_request(0);
+        _send_Line("G_RobLimits");
+        _send_Item(robot);
+        for (int i=0; i<samples.length(); i++){
+            _batch_request(i + 1);
+            _send_Line("G_FK");
+            _send_Array(&samples[i]);
+            _send_Item(robot);
+        }
+    }
+    bool ok = ndofs > 0;
+    tJoints lower_limits;
+    tJoints upper_limits;
+    QList<Mat> poses;
+    if (ndofs > 0){
+        _recv_Array(&lower_limits);
+        _recv_Array(&upper_limits);
+        _recv_Int(); // joints type
+        _check_status();
+    }
+    for (int i=0; ndofs > 0 && i<samples.length(); i++){
+        poses.append(_recv_Pose());
+        if (_check_status()){
+            ok = false;
+        }
+    }
+
+    // exp(joint j * step) = FK(step on joint j) * FK(0)^-1
+    const double step_rad = ROBODK_API_FK_STEP * M_PI / 180.0;
+    const double s = sin(step_rad);
+    const double k = 1.0 - cos(step_rad);
+    for (int j=0; ok && j<ndofs; j++){
+        Mat motion = poses[j+1] * poses[0].inv();
+        double rot_error = 0;
+        for (int r=0; r<3; r++){
+            for (int c=0; c<3; c++){
+                rot_error = qMax(rot_error, fabs(motion(r,c) - (r == c ? 1.0 : 0.0)));
+            }
+        }
+        tXYZ t;
+        motion.Pos(t);
+        if (rot_error < ROBODK_API_FK_TOLERANCE){
+            // linear joint: pure translation
+            ok = kin.addJoint(t, nullptr, true);
+            continue;
+        }
+        // rotative joint: axis w from the skew-symmetric part of the rotation, point of the axis c from t = (I-R)*c
+        tXYZ w;
+        w[0] = (motion(2,1) - motion(1,2)) / (2.0*s);
+        w[1] = (motion(0,2) - motion(2,0)) / (2.0*s);
+        w[2] = (motion(1,0) - motion(0,1)) / (2.0*s);
+        double wnorm = sqrt(w[0]*w[0] + w[1]*w[1] + w[2]*w[2]);
+        if (wnorm < 1e-6){
+            ok = false;
+            break;
+        }
+        for (int i=0; i<3; i++){
+            w[i] /= wnorm;
+        }
+        double t_w = t[0]*w[0] + t[1]*w[1] + t[2]*w[2];
+        for (int i=0; i<3; i++){
+            t[i] -= t_w * w[i];
+        }
+        tXYZ w_t = { w[1]*t[2] - w[2]*t[1], w[2]*t[0] - w[0]*t[2], w[0]*t[1] - w[1]*t[0] };
+        tXYZ point;
+        for (int i=0; i<3; i++){
+            point[i] = (k*t[i] + s*w_t[i]) / (k*k + s*s);
+        }
+        ok = kin.addJoint(w, point, false);
+    }
+    if (ok){
+        kin.setHome(poses[0]);
+        for (int i=ndofs+1; ok && i<samples.length(); i++){
+            Mat pose = kin.SolveFK(samples[i]);
+            for (int v=0; v<16; v++){
+                double expected = poses[i].ValuesD()[v];
+                if (fabs(pose.ValuesD()[v] - expected) > ROBODK_API_FK_TOLERANCE * (1.0 + fabs(expected))){
+                    ok = false;
+                    break;
+                }
+            }
+        }
+    }
+    if (!ok){
+        if (ndofs > 0){
+            qDebug() << "The kinematics of this robot can't be computed locally, RoboDK is used instead";
+        }
+        kin.clear();
+        _KINEMATICS.insert(robot._PTR, kin);
+        return kin;
+    }
+    kin.setJointLimits(lower_limits, upper_limits);
+
+    // verify the inverse kinematics with RoboDK: the solution of RoboDK must be one of the local solutions
+    // and the configuration flags must match (the flags that are defined the other way around are inverted)
+    if (kin.CanSolveIK()){
+        const Mat &pose = poses[ndofs+1];
+        QList<tJoints> solutions = kin.SolveIK_All(pose);
+        _batch_request(0);
+        _send_Line("G_IK");
+        _send_Pose(pose);
+        _send_Item(robot);
+        for (int i=0; i<solutions.length(); i++){
+            _batch_request(i + 1);
+            _send_Line("G_Thetas_Config");
+            _send_Array(&solutions[i]);
+            _send_Item(robot);
+        }
+        tJoints joints_rdk;
+        _recv_Array(&joints_rdk);
+        bool ik_ok = !_check_status() && joints_rdk.Length() >= 6;
+        // joint error of the local solution closest to the solution of RoboDK
+        double ik_error = -1;
+        for (int i=0; ik_ok && i<solutions.length(); i++){
+            double error = 0;
+            for (int j=0; j<6; j++){
+                error = qMax(error, fabs(remainder(solutions[i].ValuesD()[j] - joints_rdk.ValuesD()[j], 360.0)));
+            }
+            if (ik_error < 0 || error < ik_error){
+                ik_error = error;
+            }
+        }
+        ik_ok = ik_ok && ik_error >= 0 && ik_error < ROBODK_API_IK_TOLERANCE;
+        int mask = -1;
+        for (int i=0; i<solutions.length(); i++){
+            tConfig config_rdk;
+            int sz = RDK_SIZE_MAX_CONFIG;
+            _recv_Array(config_rdk, &sz);
+            if (_check_status() || sz < 3){
+                ik_ok = false;
+                continue;
+            }
+            tConfig config;
+            kin.JointsConfig(solutions[i], config);
+            int mask_i = 0;
+            for (int k=0; k<3; k++){
+                if ((config[k] > 0.5) != (config_rdk[k] > 0.5)){
+                    mask_i |= (1 << k);
+                }
+            }
+            if (mask >= 0 && mask != mask_i){
+                ik_ok = false;
+            }
+            mask = mask_i;
+        }
+        if (ik_ok){
+            kin._CONFIG_MASK = qMax(mask, 0);
+        } else {
+            qDebug() << "The inverse kinematics of this robot can't be computed locally (joint error:" << ik_error << "deg)";
+            kin._IK_DISABLED = true;
+        }
+    }
+    _KINEMATICS.insert(robot._PTR, kin);
+    return kin;
+}
+
+//---------------------------------------------- ADD MORE  (getParams, setParams, calibrate TCP, calibrate ref...)
+
+
+/// <summary>
+/// Calibrate a tool (TCP) given a number of points or calibration joints. Important: If the robot is calibrated, provide joint values to maximize accuracy.
+/// </summary>
+/// <param name="poses_joints">matrix of poses in a given format or a list of joints</param>
+/// <param name="error_stats">stats[mean, standard deviation, max] - Output error stats summary</param>
+/// <param name="format">Euler format. Optionally, use JOINT_FORMAT and provide the robot.</param>
+/// <param name="algorithm">type of algorithm (by point, plane, ...)</param>
+/// <param name="robot">Robot used for calibration (if using joint values)</param>
+/// <returns>TCP as [x, y, z] - calculated TCP</returns>
+///
+void RoboDK::CalibrateTool(tMatrix2D *poses_joints, tXYZ tcp_xyz, int format, int algorithm, Item *robot, double *error_stats){
+    _check_connection();
+    _send_Line("CalibTCP2");
+    _send_Matrix2D(poses_joints);
+    _send_Int(format);
+    _send_Int(algorithm);
+    _send_Item(robot);
+    int nxyz = 3;
+    _recv_Array(tcp_xyz, &nxyz);
+    if (error_stats != nullptr){
+        _recv_Array(error_stats);
+    } else {
+        double errors_ignored[20];
+        _recv_Array(errors_ignored);
+    }
+    tMatrix2D *error_graph = Matrix2D_Create();
+    _recv_Matrix2D(error_graph);
+    Matrix2D_Delete(&error_graph);
+    _check_status();
+}
+
+/// <summary>
+/// Calibrate a Reference Frame given a list of points or joint values. Important: If the robot is calibrated, provide joint values to maximize accuracy.
+/// </summary>
+/// <param name="joints">points as a 3xN matrix or nDOFsxN) - List of points or a list of robot joints</param>
+/// <param name="method">type of algorithm(by point, plane, ...) CALIBRATE_FRAME_...</param>
+/// <param name="use_joints">use points or joint values. The robot item must be provided if joint values is used.</param>
+/// <param name="robot"></param>
+/// <returns></returns>
+Mat RoboDK::CalibrateReference(tMatrix2D *poses_joints, int method, bool use_joints, Item *robot){
+    _check_connection();
+    _send_Line("CalibFrame");
+    _send_Matrix2D(poses_joints);
+    _send_Int(use_joints ? -1 : 0);
+    _send_Int(method);
+    _send_Item(robot);
+    Mat reference_pose = _recv_Pose();
+    double error_stats[20];
+    _recv_Array(error_stats);
+    _check_status();
+    return reference_pose;
+}
+
+
+int RoboDK::ProgramStart(const QString &progname, const QString &defaultfolder, const QString &postprocessor, Item *robot){
+    _check_connection();
+    _send_Line("ProgramStart");
+    _send_Line(progname);
+    _send_Line(defaultfolder);
+    _send_Line(postprocessor);
+    _send_Item(robot);
+    int errors = _recv_Int();
+    _check_status();
+    return errors;
+}
+
+/// <summary>
+/// Set the pose of the wold reference frame with respect to the view (camera/screen)
+/// </summary>
+/// <param name="pose"></param>
+void RoboDK::setViewPose(const Mat &pose){
+    _check_connection();
+    _send_Line("S_ViewPose");
+    _send_Pose(pose);
+    _check_status();
+}
+
+/// <summary>
+/// Get the pose of the wold reference frame with respect to the view (camera/screen)
+/// </summary>
+/// <param name="pose"></param>
+Mat RoboDK::ViewPose(){
+    _check_connection();
+    _send_Line("G_ViewPose");
+    Mat pose = _recv_Pose();
+    _check_status();
+    return pose;
+}
+//INCOMPLETE!!!!!!!
+/*bool RoboDK::SetRobotParams(Item *robot, tMatrix2D dhm, Mat poseBase, Mat poseTool)
+{
+    _check_connection();
+    _send_Line("S_AbsAccParam");
+    _send_Item(robot);
+    Mat r2b;
+    r2b.setToIdentity();
+    _send_Pose(r2b);
+    _send_Pose(poseBase);
+    _send_Pose(poseTool);
+    int *ndofs = dhm.size;
+    _send_Int(*ndofs);
+    for (int i = 0; i < *ndofs; i++){
+        _send_Array(dhm);
+    }
+
+    _send_Pose(poseBase);
+    _send_Pose(poseTool);
+    _send_Int(*ndofs);
+    for (int i = 0; i < *ndofs; i++){
+        _send_Array(dhm[i]);
+    }
+
+    _send_Array(nullptr);
+    _send_Array(nullptr);
+    _check_status();
+    return true;
+}*/
+
+Item RoboDK::getCursorXYZ(int x, int y, tXYZ xyzStation)
+{
+    _check_connection();
+    _send_Line("Proj2d3d");
+    _send_Int(x);
+    _send_Int(y);
+    int selection = _recv_Int();
+    Item selectedItem = _recv_Item();
+    tXYZ xyz;
+    _recv_XYZ(xyz);
+    if (xyzStation != nullptr){
+        xyzStation[0] = xyz[0];
+        xyzStation[1] = xyz[1];
+        xyzStation[2] = xyz[2];
+    }
+    _check_status();
+    return selectedItem;
+}
+
+
+///---------------------------------- add get/set robot parameters
+
+
+/// <summary>
+/// Returns the license string (as shown in the RoboDK main window)
+/// </summary>
+/// <returns></returns>
+QString RoboDK::License(){
+    _check_connection();
+    _send_Line("G_License");
+    QString license = _recv_Line();
+    _check_status();
+    return license;
+}
+
+/// <summary>
+/// Returns the list of items selected (it can be one or more items)
+/// </summary>
+/// <returns></returns>
+QList<Item> RoboDK::Selection(){
+    _check_connection();
+    _send_Line("G_Selection");
+    int nitems = _recv_Int();
+    QList<Item> list_items;
+    for (int i = 0; i < nitems; i++)    {
+        list_items.append(_recv_Item());
+    }
+    _check_status();
+    return list_items;
+}
+
+/// <summary>
+/// Sets the selection in the tree (it can be one or more items).
+/// </summary>
+/// <returns>List of items to set as selected</returns>
+void RoboDK::setSelection(QList<Item> list_items){
+    _check_connection();
+    _send_Line("S_Selection");
+    _send_Int(list_items.length());
+    for (int i = 0; i < list_items.length(); i++)    {
+        _send_Item(list_items[i]);
+    }
+    _check_status();
+}
+
+
+/// <summary>
+/// Show the popup menu to create the ISO9283 path for path accuracy and performance testing
+/// </summary>
+/// <returns>IS9283 Program</returns>
+Item RoboDK::Popup_ISO9283_CubeProgram(Item *robot, tXYZ center, double side, bool blocking){
+    //_require_build(5177);
+    Item iso_program;
+    _check_connection();
+    if (center == nullptr){
+        _send_Line("Popup_ProgISO9283");
+        _send_Item(robot);
+        _TIMEOUT = 3600 * 1000;
+        iso_program = _recv_Item();
+        _TIMEOUT = _DEFAULT_TIMEOUT;
+        _check_status();
+    } else {
+        _send_Line("Popup_ProgISO9283_Param");
+        _send_Item(robot);
+        double values[5];
+        values[0] = center[0];
+        values[1] = center[1];
+        values[2] = center[2];
+        values[3] = side;
+        values[4] = blocking ? 1 : 0;
+        _send_Array(values, 4);
+        if (blocking){
+            _TIMEOUT = 3600 * 1000;
+            iso_program = _recv_Item();
+            _TIMEOUT = _DEFAULT_TIMEOUT;
+            _check_status();
+        }
+    }
+    return iso_program;
+}
+
+
+
+
+bool RoboDK::FileSet(const QString &path_file_local, const QString &file_remote, bool load_file, Item *attach_to){
+    if (!_check_connection()){ return false; }
+    if (!_send_Line("FileRecvBin")){ return false; }
+    QFile file(path_file_local);
+    if (!_send_Line(file_remote)){ return false; }
+    int nbytes = file.size();
+    if (!_send_Int(nbytes)){ return false; }
+    if (!_send_Item(attach_to)){ return false; }
+    if (!_send_Int(load_file ? 1 : 0)){ return false; }
+    // the contents are written after the header: the header must be sent and accepted first, also in pipelined mode
+    _recv_Begin();
+    QString message;
+    int status = _recv_Status(message);
+    if (status != 0 && status != 2){ return false; }
+    qint64 sz_sent = 0;
+    if (!file.open(QFile::ReadOnly)){
+        return false;
+    }
+    while (true){
+        QByteArray buffer(file.read(1024));
+        if (buffer.size() == 0){
+            break;
+        }
+        qint64 written = _COM->write(buffer);
+        _COMM_WRITES++;
+        _capture(ROBODK_TRACE_SEND, buffer.constData(), written);
+        if (_STAT_ACTIVE){
+            _STAT_OUT += qMax<qint64>(written, 0);
+        }
+        if (written != buffer.size()){
+            qDebug() << "Could not send file " << path_file_local;
+            file.close();
+            return false;
+        }
+        sz_sent += written;
+        //qDebug() << "Sending file " << path_file_local << 100*sz_sent/nbytes;
+    }
+    file.close();
+    _TRANSPORT->Flush(_COM);
+    return sz_sent == nbytes;
+}
+
+bool RoboDK::FileGet(const QString &path_file_local, Item *station, const QString path_file_remote){
+    if (!_check_connection()){ return false; }
+    if (!_send_Line("FileSendBin")){ return false; }
+    if (!_send_Item(station)){ return false; }
+    if (!_send_Line(path_file_remote)){ return false; }
+    int nbytes = _recv_Int();
+    int remaining = nbytes;
+    QFile file(path_file_local);
+    if (!file.open(QFile::WriteOnly)){
+        qDebug() << "Can not open file for writting " << path_file_local;
+        return false;
+    }
+    while (remaining > 0){
+        if (_COM->bytesAvailable() <= 0 && !_wait_data()){
+            qDebug() << "Could not receive file " << path_file_remote;
+            file.close();
+            return false;
+        }
+        QByteArray buffer(_COM->read(qMin(remaining, 1024)));
+        _received(buffer.constData(), buffer.size());
+        remaining -= buffer.size();
+        file.write(buffer);
+    }
+    file.close();
+    if (_check_status()){ return false; }
+    return true;
+}
+
+
+
+
+//-------------------------- private ---------------------------------------
+
+bool RoboDK::_connected(){
+    return _COM != nullptr && _TRANSPORT->Connected(_COM);
+}
+
+
+bool RoboDK::_check_connection(){
+    if (_STAT_ACTIVE){
+        _call_end();
+    }
+    if (_STATS_ON || !_TRACER.isNull()){
+        _STAT_ACTIVE = true;
+        _STAT_T0 = _CLOCK.nsecsElapsed();
+        _STAT_FLUSH = -1;
+        _STAT_FIRST = -1;
+        _STAT_LAST = -1;
+        _STAT_OUT = 0;
+        _STAT_IN = 0;
+        _STAT_REQUESTS = 1;
+    }
+    _COMM_COMMANDS++;
+    _COMMAND.clear();
+    _COMMAND_NEXT = false;
+    _ABORTED = false;
+    _TIMEOUT = _DEFAULT_TIMEOUT; // long operations raise the timeout of their own call only
+    if (_connected()){
+        if (_DESYNC && !_resync()){
+            return _ABORTED ? false : _connect_smart();
+        }
+        return true;
+    }
+    bool connection_ok = _connect_smart();
+    //if (!connection_ok){
+    //    throw -1;
+    //}
+    return connection_ok;
+}
+
+// Start another request of the current call (calls that send several requests before reading the responses).
+// The request is framed as a command of its own in the capture and counted in the statistics of the call. Unlike _check_connection,
+// the call goes on: the responses of the requests already sent are still expected.
+void RoboDK::_command_next(){
+    _COMM_COMMANDS++;
+    _COMMAND_NEXT = true;
+    if (_STAT_ACTIVE){
+        _STAT_REQUESTS++;
+    }
+}
+
+// Start the request number index (from 0) of a call that sends several requests before reading the responses:
+// the first request starts the call (_check_connection), the following ones continue it (_command_next).
+// Returns false if the first request could not connect.
+bool RoboDK::_batch_request(int index){
+    if (index > 0){
+        _command_next();
+        return true;
+    }
+    return _check_connection();
+}
+
+bool RoboDK::_check_status(){
+    tTraceScope scope(this, "_check_status");
+    if (_PIPELINE_ACTIVE){
+        // collect the status later (see _pipeline_drain)
+        tPipelinePending pending;
+        pending.index = _PIPELINE_COUNT++;
+        pending.command = _COMMAND;
+        pending.timeout = (_TIMEOUT != _DEFAULT_TIMEOUT) ? _TIMEOUT : 0;
+        pending.robot = 0;
+        _PIPELINE_PENDING.append(pending);
+        if (_PIPELINE_PENDING.length() >= _PIPELINE_DEPTH){
+            _pipeline_drain();
+        } else if (_SEND_BUFFER.size() >= ROBODK_API_PIPELINE_FLUSH_SIZE){
+            _send_Flush();
+        }
+        return 0;
+    }
+    QString message;
+    int status = _recv_Status(message);
+    if (status == 2){
+        return 0;
+    }
+    return status;
+}
+
+int RoboDK::_recv_Status(QString &strproblems){
+    qint32 status = _recv_Int();
+    if (status == 0) {
+        // everything is OK
+        //status = status
+    } else if (status > 0 && status < 10) {
+        strproblems = "Unknown error";
+        if (status == 1) {
+            strproblems = "Invalid item provided: The item identifier provided is not valid or it does not exist.";
+        } else if (status == 2) { //output warning only
+            strproblems = _recv_Line();
+            qDebug() << "RoboDK API WARNING: " << strproblems;
+        } else if (status == 3){ // output error
+            strproblems = _recv_Line();
+            qDebug() << "RoboDK API ERROR: " << strproblems;
+        } else if (status == 9) {
+            strproblems = "Invalid RoboDK License";
+            qDebug() << "Invalid RoboDK License";
+        }
+        //print(strproblems);
+        //throw new RDKException(strproblems); //raise Exception(strproblems)
+    } else if (status < 100){
+        strproblems = _recv_Line();
+        qDebug() << "RoboDK API ERROR: " << strproblems;
+    } else  {
+        //throw new RDKException("Communication problems with the RoboDK API"); //raise Exception('Problems running function');
+        strproblems = "Communication problems with the RoboDK API";
+        qDebug() << "Communication problems with the RoboDK API";
+    }
+    return status;
+}
+
+// collect the status of all the commands sent in pipelined mode, in the same order they were sent
+// Read the status of the first count pending commands (all of them if count is negative)
+void RoboDK::_pipeline_drain(int count){
+    tTraceScope scope(this, "_pipeline_drain");
+    QList<tPipelinePending> pending;
+    pending.swap(_PIPELINE_PENDING);
+    if (count < 0 || count > pending.length()){
+        count = pending.length();
+    }
+    for (int i=0; i<count; i++){
+        if (pending[i].timeout > 0){
+            _TIMEOUT = pending[i].timeout;
+        }
+        QString message;
+        int status = _recv_Status(message);
+        if (status == 0 && pending[i].robot != 0){
+            // queued movement: the first status means the movement was accepted, the second one arrives when the movement finishes
+            _TIMEOUT = pending[i].timeout;
+            status = _recv_Status(message);
+        }
+        _TIMEOUT = _DEFAULT_TIMEOUT;
+        if (status != 0){
+            tPipelineError error;
+            error.index = pending[i].index;
+            error.command = pending[i].command;
+            error.status = status;
+            error.message = message;
+            if (pending[i].robot != 0){
+                tMotionError motion_error;
+                motion_error.robot = pending[i].robot;
+                motion_error.error = error;
+                _MOTION_ERRORS.append(motion_error);
+            } else {
+                _PIPELINE_ERRORS.append(error);
+            }
+        }
+    }
+    // reading statuses does not queue new commands: keep the remaining ones
+    if (count < pending.length()){
+        _PIPELINE_PENDING = pending.mid(count);
+    }
+}
+
+
+
+void RoboDK::_disconnect(){
+    _SEND_BUFFER.resize(0);
+    _PIPELINE_PENDING.clear();
+    _DESYNC = false;
+    _SYNC_MARKER.clear();
+    _MOTION_ERRORS.clear();
+    IndexInvalidate(); // item pointers are not valid for another RoboDK instance
+    _KINEMATICS.clear();
+    _ROBOT_DOFS.clear();
+    if (_COM != nullptr){
+        _COM->deleteLater();
+        _COM = nullptr;
+    }
+}
+
+// Move the socket to the calling thread (a pool leased this link to the thread)
+void RoboDK::_attach_thread(){
+    if (_COM != nullptr && _COM->thread() != QThread::currentThread()){
+        _COM->moveToThread(QThread::currentThread());
+    }
+}
+
+// Collect pending statuses and detach the socket from the calling thread so that another thread can attach it
+void RoboDK::_detach_thread(){
+    if (_PIPELINE_ACTIVE){
+        PipelineEnd();
+    }
+    _recv_Begin();
+    _TIMEOUT = _DEFAULT_TIMEOUT;
+    if (_COM != nullptr && _COM->thread() == QThread::currentThread()){
+        _COM->moveToThread(nullptr);
+    }
+}
+
+// attempt a simple connection to RoboDK and start RoboDK if it is not running
+// While RoboDK starts, the port is probed with an exponential backoff (the output of RoboDK only shortens the wait between probes)
+bool RoboDK::_connect_smart(){
+    _startup_reset();
+    //Establishes a connection with robodk. robodk must be running, otherwise, it will attempt to start it
+    bool is_local = _IP.isEmpty() || _IP == "127.0.0.1" || _IP == "localhost";
+    bool is_connected = _connect(is_local ? qMin(_TIMEOUT, ROBODK_API_PROBE_TIMEOUT) : _TIMEOUT);
+    _STARTUP.probe = _CLOCK.elapsed() - _STARTUP_T0;
+    if (is_connected){
+        Headless_Done(_PORT);
+        qDebug() << "The RoboDK API is connected";
+        return true;
+    }
+    if (is_local && Headless_Pending(_PORT)){
+        // the instance was started by StartHeadless and is still loading
+        return _connect_wait(ROBODK_API_START_TIMEOUT);
+    }
+
+    qDebug() << "...Trying to start RoboDK: " << _ROBODK_BIN << " " << _ARGUMENTS;
+    // Start RoboDK
+    QProcess *p = new QProcess();
+    //_ARGUMENTS = "/DEBUG";
+    p->setReadChannel(QProcess::StandardOutput);
+    p->start(_ROBODK_BIN, _ARGUMENTS.split(" ", QString::SkipEmptyParts));
+    if (!p->waitForStarted(ROBODK_API_START_TIMEOUT)){
+        qDebug() << "Could not start RoboDK!";
+        delete p;
+        return false;
+    }
+    _PROCESS = p->processId();
+    _STARTUP.spawn = _CLOCK.elapsed() - _STARTUP_T0;
+    _STARTUP.started = true;
+
+    int delay = ROBODK_API_PROBE_DELAY_MIN;
+    QElapsedTimer starting;
+    starting.start();
+    while (starting.elapsed() < ROBODK_API_START_TIMEOUT){
+        bool exited = (p->state() == QProcess::NotRunning);
+        bool running = false;
+        if (!exited){
+            p->waitForReadyRead(delay);
+        }
+        while (p->canReadLine()){
+            QString line = QString::fromUtf8(p->readLine().trimmed());
+            //qDebug() << "RoboDK process: " << line;
+            running = running || line.contains("Running", Qt::CaseInsensitive);
+        }
+        if (_connect(ROBODK_API_PROBE_TIMEOUT)){
+            qDebug() << "The RoboDK API is connected";
+            return true;
+        }
+        if (exited){
+            break;
+        }
+        // probe again right away once RoboDK says it is running
+        delay = running ? ROBODK_API_PROBE_DELAY_MIN : qMin(delay * 2, ROBODK_API_PROBE_DELAY_MAX);
+    }
+    qDebug() << "The RoboDK API is NOT connected!";
+    return false;
+}
+
+// Probe the port with an exponential backoff until RoboDK accepts the link or timeout_ms expires. RoboDK is never started.
+bool RoboDK::_connect_wait(int timeout_ms){
+    int delay = ROBODK_API_PROBE_DELAY_MIN;
+    QElapsedTimer waiting;
+    waiting.start();
+    forever {
+        if (_connect(ROBODK_API_PROBE_TIMEOUT)){
+            Headless_Done(_PORT);
+            qDebug() << "The RoboDK API is connected";
+            return true;
+        }
+        qint64 left = timeout_ms - waiting.elapsed();
+        if (left <= 0){
+            break;
+        }
+        QThread::msleep((unsigned long) qMin<qint64>(delay, left));
+        delay = qMin(delay * 2, ROBODK_API_PROBE_DELAY_MAX);
+    }
+    qDebug() << "The RoboDK API is NOT connected!";
+    return false;
+}
+
+void RoboDK::_startup_reset(){
+    _STARTUP_T0 = _CLOCK.elapsed();
+    _STARTUP.probe = -1;
+    _STARTUP.spawn = -1;
+    _STARTUP.first_byte = -1;
+    _STARTUP.ready = -1;
+    _STARTUP.attempts = 0;
+    _STARTUP.started = false;
+}
+
+// attempt a simple connection to RoboDK (timeout_ms to connect, _TIMEOUT by default, and _TIMEOUT for the READY answer)
+bool RoboDK::_connect(int timeout_ms){
+    _disconnect();
+    if (timeout_ms < 0){
+        timeout_ms = _TIMEOUT;
+    }
+    _STARTUP.attempts++;
+    // usually, 5 msec should be enough for localhost
+    _COM = _TRANSPORT->Open(_IP, _PORT, timeout_ms);
+    if (_COM == nullptr){
+        return false;
+    }
+
+    // RoboDK protocol to check that we are connected to the right port
+    _COM->write(ROBODK_API_START_STRING ROBODK_API_LF "1 0" ROBODK_API_LF);
+    _TRANSPORT->Flush(_COM);
+
+    // 10 msec should be enough for localhost
+    QElapsedTimer waiting;
+    waiting.start();
+    while (!_COM->canReadLine()){
+        qint64 wait = _TIMEOUT - waiting.elapsed();
+        if (wait <= 0 || !_COM->waitForReadyRead((int) wait)){
+            _COM->deleteLater();
+            _COM = nullptr;
+            return false;
+        }
+        if (_STARTUP.first_byte < 0){
+            _STARTUP.first_byte = _CLOCK.elapsed() - _STARTUP_T0;
+        }
+    }
+    if (_STARTUP.first_byte < 0){
+        _STARTUP.first_byte = _CLOCK.elapsed() - _STARTUP_T0;
+    }
+    QString read(_COM->readLine());
+    // make sure we receive the OK from RoboDK
+    if (!read.startsWith(ROBODK_API_READY_STRING)){
+        _COM->deleteLater();
+        _COM = nullptr;
+        return false;
+    }
+    _STARTUP.ready = _CLOCK.elapsed() - _STARTUP_T0;
+    return true;
+}
+
+
+/////////////////////////////////////////////
+// Conversion of double arrays between the host byte order and the byte order of the RoboDK protocol (big endian).
+// The conversion is the same in both directions and src and dst may point to the same memory (conversion in place).
+// The fastest kernel supported by the CPU is selected the first time it is needed.
+typedef void (*tDoublesSwap)(double *dst, const double *src, qint64 n);
+
+static void Doubles_Swap_Scalar(double *dst, const double *src, qint64 n){
+    for (qint64 i=0; i<n; i++){
+        quint64 bits;
+        memcpy(&bits, src + i, sizeof(double));
+        bits = qbswap<quint64>(bits);
+        memcpy(dst + i, &bits, sizeof(double));
+    }
+}
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+static void Doubles_Copy(double *dst, const double *src, qint64 n){
+    if (dst != src){
+        memmove(dst, src, n*sizeof(double));
+    }
+}
+#endif
+
+#ifdef ROBODK_API_SIMD_SSE2
+static void Doubles_Swap_SSE2(double *dst, const double *src, qint64 n){
+    qint64 i = 0;
+    for (; i + 2 <= n; i += 2){
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        // reverse the 16 bit words of each 64 bit value, then the bytes of each word
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*)(dst + i), v);
+    }
+    Doubles_Swap_Scalar(dst + i, src + i, n - i);
+}
+#endif
+
+#ifdef ROBODK_API_SIMD_AVX2
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+static void Doubles_Swap_AVX2(double *dst, const double *src, qint64 n){
+    const __m256i mask = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                          7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    qint64 i = 0;
+    for (; i + 8 <= n; i += 8){
+        __m256i v0 = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i*)(src + i + 4));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_shuffle_epi8(v0, mask));
+        _mm256_storeu_si256((__m256i*)(dst + i + 4), _mm256_shuffle_epi8(v1, mask));
+    }
+    for (; i + 4 <= n; i += 4){
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_shuffle_epi8(v, mask));
+    }
+    Doubles_Swap_Scalar(dst + i, src + i, n - i);
+}
+
+static bool Cpu_Has_AVX2(){
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7){ return false; }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6){ return false; }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#ifdef ROBODK_API_SIMD_NEON
+static void Doubles_Swap_NEON(double *dst, const double *src, qint64 n){
+    qint64 i = 0;
+    for (; i + 2 <= n; i += 2){
+        uint8x16_t v = vld1q_u8((const uint8_t*)(src + i));
+        vst1q_u8((uint8_t*)(dst + i), vrev64q_u8(v));
+    }
+    Doubles_Swap_Scalar(dst + i, src + i, n - i);
+}
+#endif
+
+static tDoublesSwap Doubles_Swap_Select(){
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    return Doubles_Copy;
+#else
+#if defined(ROBODK_API_SIMD_AVX2)
+    if (Cpu_Has_AVX2()){
+        return Doubles_Swap_AVX2;
+    }
+#endif
+#if defined(ROBODK_API_SIMD_SSE2)
+    return Doubles_Swap_SSE2;
+#elif defined(ROBODK_API_SIMD_NEON)
+    return Doubles_Swap_NEON;
+#else
+    return Doubles_Swap_Scalar;
+#endif
+#endif
+}
+
+// Convert n doubles from host byte order to big endian or vice versa
+static inline void Doubles_BigEndian(double *dst, const double *src, qint64 n){
+    static const tDoublesSwap kernel = Doubles_Swap_Select();
+    kernel(dst, src, n);
+}
+
+/////////////////////////////////////////////
+// Append values to the send buffer using the byte order of the RoboDK protocol (big endian, same as QDataStream)
+static inline void Buffer_Append_Int(QByteArray &buffer, qint32 value){
+    uchar bytes[sizeof(qint32)];
+    qToBigEndian<qint32>(value, bytes);
+    buffer.append((const char*) bytes, sizeof(qint32));
+}
+static inline void Buffer_Append_UInt64(QByteArray &buffer, quint64 value){
+    uchar bytes[sizeof(quint64)];
+    qToBigEndian<quint64>(value, bytes);
+    buffer.append((const char*) bytes, sizeof(quint64));
+}
+static inline void Buffer_Append_Doubles(QByteArray &buffer, const double *values, qint64 n){
+    int pos = buffer.size();
+    buffer.resize(pos + n*sizeof(double));
+    Doubles_BigEndian((double*)(buffer.data() + pos), values, n);
+}
+// Append a string as UTF-8. ASCII characters are copied one by one, so the usual case does not need a temporary QByteArray.
+static inline void Buffer_Append_Utf8(QByteArray &buffer, const QString &string){
+    const QChar *chars = string.constData();
+    int n = string.size();
+    int pos = buffer.size();
+    buffer.resize(pos + n);
+    char *dst = buffer.data() + pos;
+    for (int i=0; i<n; i++){
+        ushort c = chars[i].unicode();
+        if (c >= 0x80){
+            buffer.resize(pos + i);
+            buffer.append(string.mid(i).toUtf8());
+            return;
+        }
+        dst[i] = (char) c;
+    }
+}
+
+// Write the pending request with a single socket write. This is called before reading any response.
+bool RoboDK::_send_Flush(){
+    if (_SEND_BUFFER.isEmpty()){ return true; }
+    if (_COM == nullptr || !_COM->isOpen() || _ABORTED){
+        _SEND_BUFFER.resize(0);
+        _CAPTURE_SENT = 0;
+        return false;
+    }
+    qint64 written = _COM->write(_SEND_BUFFER);
+    _COMM_WRITES++;
+    if (_CAPTURE != nullptr){
+        _CAPTURE_SENT = qMin(_CAPTURE_SENT, _SEND_BUFFER.size());
+        _capture(ROBODK_TRACE_SEND, _SEND_BUFFER.constData() + _CAPTURE_SENT, _SEND_BUFFER.size() - _CAPTURE_SENT);
+    }
+    if (_STAT_ACTIVE){
+        _STAT_OUT += _SEND_BUFFER.size();
+    }
+    _CAPTURE_SENT = 0;
+    _SEND_BUFFER.resize(0);
+    _TRANSPORT->Flush(_COM);
+    if (_STAT_ACTIVE && _STAT_FLUSH < 0){
+        _STAT_FLUSH = _CLOCK.nsecsElapsed();
+    }
+    return written >= 0;
+}
+
+// Add the current call to the statistics of its command and to the trace. The call ends with the last byte received (or once the request is written if there is no response).
+void RoboDK::_call_end(){
+    _STAT_ACTIVE = false;
+    if (_COMMAND.isEmpty()){
+        return;
+    }
+    qint64 sent = _STAT_FLUSH >= 0 ? _STAT_FLUSH : _STAT_T0;
+    qint64 first = _STAT_FIRST >= 0 ? qMax(_STAT_FIRST, sent) : sent;
+    qint64 last = qMax(_STAT_LAST, first);
+    if (!_TRACER.isNull()){
+        qint64 offset = _TRACER->Now() - _CLOCK.nsecsElapsed();
+        _TRACER->Complete(_COMMAND, "call", _STAT_T0 + offset, last + offset,
+                          QString("\"requests\":%1,\"bytes_out\":%2,\"bytes_in\":%3").arg(_STAT_REQUESTS).arg(_STAT_OUT).arg(_STAT_IN));
+    }
+    if (!_STATS_ON){
+        return;
+    }
+    QHash<QString, tCommandStats>::iterator stats = _STATS.find(_COMMAND);
+    if (stats == _STATS.end()){
+        tCommandStats empty;
+        empty.command = _COMMAND;
+        empty.calls = 0;
+        empty.requests = 0;
+        empty.bytes_out = 0;
+        empty.bytes_in = 0;
+        stats = _STATS.insert(_COMMAND, empty);
+    }
+    stats->calls++;
+    stats->requests += _STAT_REQUESTS;
+    stats->bytes_out += _STAT_OUT;
+    stats->bytes_in += _STAT_IN;
+    stats->send.Record((sent - _STAT_T0) / 1000);
+    stats->wait.Record((first - sent) / 1000);
+    stats->recv.Record((last - first) / 1000);
+    stats->total.Record((last - _STAT_T0) / 1000);
+}
+
+// Account bytes received from RoboDK (statistics and trace)
+void RoboDK::_received(const char *data, qint64 size){
+    if (_STAT_ACTIVE){
+        _STAT_LAST = _CLOCK.nsecsElapsed();
+        if (_STAT_FIRST < 0){
+            _STAT_FIRST = _STAT_LAST;
+        }
+        _STAT_IN += size;
+    }
+    _capture(ROBODK_TRACE_RECV, data, size);
+}
+
+// Record bytes in the trace (see StartCapture). Consecutive bytes of the same type are written as one record.
+void RoboDK::_capture(char type, const char *data, qint64 size){
+    if (_CAPTURE == nullptr || size <= 0){
+        return;
+    }
+    if (type != _CAPTURE_TYPE || type == ROBODK_TRACE_COMMAND){
+        _capture_end();
+        _CAPTURE_TYPE = type;
+    }
+    _CAPTURE_DATA.append(data, size);
+}
+
+// Write the record being collected to the trace file
+void RoboDK::_capture_end(){
+    if (_CAPTURE_TYPE == 0){
+        return;
+    }
+    uchar size[sizeof(quint32)];
+    qToBigEndian<quint32>(_CAPTURE_DATA.size(), size);
+    _CAPTURE->write(&_CAPTURE_TYPE, 1);
+    _CAPTURE->write((const char*) size, sizeof(quint32));
+    _CAPTURE->write(_CAPTURE_DATA);
+    _CAPTURE_TYPE = 0;
+    _CAPTURE_DATA.resize(0);
+}
+
+// Prepare to read the response of the current command: send the request and collect the status of previous pipelined commands
+void RoboDK::_recv_Begin(){
+    _send_Flush();
+    if (!_PIPELINE_PENDING.isEmpty()){
+        _pipeline_drain();
+    }
+}
+
+// Wait for more data from RoboDK (timeout_ms without data, _TIMEOUT by default).
+// The call is aborted if the deadline expires or the cancellation token is cancelled, and the response is discarded at the beginning of the next call.
+bool RoboDK::_wait_data(int timeout_ms){
+    if (_TRACER.isNull()){
+        return _wait_ready(timeout_ms);
+    }
+    qint64 start = _TRACER->Now();
+    bool ready = _wait_ready(timeout_ms);
+    if (!ready && _STAT_ACTIVE){
+        // no response: the call lasts until the wait gave up
+        _STAT_LAST = _CLOCK.nsecsElapsed();
+    }
+    _TRACER->Complete(_TRACE_SCOPE != nullptr ? _TRACE_SCOPE : "_wait_data", "wait", start, _TRACER->Now(),
+                      ready ? "" : "\"timeout\":true");
+    return ready;
+}
+
+bool RoboDK::_wait_ready(int timeout_ms){
+    if (_COM == nullptr || _ABORTED){ return false; }
+    if (timeout_ms < 0){
+        timeout_ms = _TIMEOUT;
+    }
+    if (_DEADLINE < 0 && !_CANCEL_SET){
+        if (_COM->waitForReadyRead(timeout_ms)){
+            return true;
+        }
+        // the response may still arrive: it must be skipped before the next command
+        _DESYNC = _connected();
+        return false;
+    }
+    QElapsedTimer waiting;
+    waiting.start();
+    forever {
+        if ((_CANCEL_SET && _CANCEL.Cancelled()) || (_DEADLINE >= 0 && _CLOCK.elapsed() >= _DEADLINE)){
+            _abort();
+            return false;
+        }
+        qint64 wait = timeout_ms - waiting.elapsed();
+        if (wait <= 0){
+            _DESYNC = _connected();
+            return false;
+        }
+        if (_CANCEL_SET){
+            wait = qMin<qint64>(wait, ROBODK_API_CANCEL_POLL);
+        }
+        if (_DEADLINE >= 0){
+            wait = qMin<qint64>(wait, qMax<qint64>(_DEADLINE - _CLOCK.elapsed(), 1));
+        }
+        if (_COM->waitForReadyRead((int) wait)){
+            return true;
+        }
+        if (!_connected()){
+            return false;
+        }
+    }
+}
+
+// Abort the current call: nothing else is sent or read until the next call
+void RoboDK::_abort(){
+    _ABORTED = true;
+    _ABORT_COUNT++;
+    _DESYNC = _connected();
+    _SEND_BUFFER.resize(0);
+    _CAPTURE_SENT = 0;
+}
+
+// Realign the stream after a response was not read completely.
+// An unknown station parameter with a unique name is requested and everything received before RoboDK answers it is discarded (RoboDK answers commands in order).
+// The wait is bounded by the timeout and the deadline of the current call: if the deadline expires again the same request is awaited by the next call,
+// if the timeout expires the link is disconnected so that the call reconnects.
+bool RoboDK::_resync(){
+    tTraceScope scope(this, "_resync");
+    // statuses of pipelined commands are discarded with the rest of the stream
+    _PIPELINE_PENDING.clear();
+    if (_SYNC_MARKER.isEmpty()){
+        _SYNC_MARKER = QByteArray("RDK_API_SYNC_") + QByteArray::number(_CLOCK.msecsSinceReference()) + "_" + QByteArray::number(++_SYNC_COUNT);
+        _SEND_BUFFER.append("G_Param" ROBODK_API_LF);
+        _SEND_BUFFER.append(_SYNC_MARKER);
+        _SEND_BUFFER.append(ROBODK_API_LF, 1);
+        _send_Flush();
+    }
+    bool found = false;
+    while (!found){
+        while (!found && _COM->canReadLine()){
+            QByteArray line = _COM->readLine();
+            _received(line.constData(), line.size());
+            found = line.trimmed().endsWith(_SYNC_MARKER);
+        }
+        if (!found && !_wait_data()){
+            if (!_ABORTED){
+                qDebug() << "RoboDK API: Could not resynchronize the communication";
+                _disconnect();
+            }
+            return false;
+        }
+    }
+    _SYNC_MARKER.clear();
+    _DESYNC = false;
+    QString message;
+    return _recv_Status(message) == 0;
+}
+
+bool RoboDK::_waitline(){
+    tTraceScope scope(this, "_waitline");
+    if (_COM == nullptr){ return false; }
+    _recv_Begin();
+    while (!_COM->canReadLine()){
+        if (!_wait_data()){
+            return false;
+        }
+    }
+    return true;
+}
+QString RoboDK::_recv_Line(){//QString &string){
+    QString string;
+    if (!_waitline()){
+        if (_COM != nullptr){
+            //if this happens it means that there are problems: delete buffer
+            QByteArray discarded = _COM->readAll();
+            _received(discarded.constData(), discarded.size());
+        }
+        return string;
+    }
+    QByteArray line = _COM->readLine();
+    _received(line.constData(), line.size());
+    string.append(QString::fromUtf8(line.trimmed()));//remove last character \n //.trimmed();
+    return string;
+}
+bool RoboDK::_send_Line(const QString& string){
+    if (_COM == nullptr || !_COM->isOpen()){ return false; }
+    if (_COMMAND.isEmpty() || _COMMAND_NEXT){
+        _send_Command(string);
+    }
+    Buffer_Append_Utf8(_SEND_BUFFER, string);
+    _SEND_BUFFER.append(ROBODK_API_LF, 1);
+    return true;
+}
+bool RoboDK::_send_Line(const char *line){
+    if (_COM == nullptr || !_COM->isOpen()){ return false; }
+    if (_COMMAND.isEmpty() || _COMMAND_NEXT){
+        _send_Command(QString::fromUtf8(line));
+    }
+    // command names and other literals are appended as they are, without converting them to a QString
+    _SEND_BUFFER.append(line);
+    _SEND_BUFFER.append(ROBODK_API_LF, 1);
+    return true;
+}
+// Record the first line of a request as the name of the command (stats, traces and capture)
+void RoboDK::_send_Command(const QString &name){
+    if (_COMMAND.isEmpty()){
+        _COMMAND = name;
+    }
+    _COMMAND_NEXT = false;
+    if (_CAPTURE != nullptr){
+        // the request of the previous command may still be in the buffer (pipelined mode)
+        _CAPTURE_SENT = qMin(_CAPTURE_SENT, _SEND_BUFFER.size());
+        _capture(ROBODK_TRACE_SEND, _SEND_BUFFER.constData() + _CAPTURE_SENT, _SEND_BUFFER.size() - _CAPTURE_SENT);
+        _CAPTURE_SENT = _SEND_BUFFER.size();
+        QByteArray utf8 = name.toUtf8();
+        _capture(ROBODK_TRACE_COMMAND, utf8.constData(), utf8.size());
+    }
+}
+
+int RoboDK::_recv_Int(){//qint32 &value){
+    tTraceScope scope(this, "_recv_Int");
+    if (_COM == nullptr){ return false; }
+    _recv_Begin();
+    while (_COM->bytesAvailable() < sizeof(qint32)){
+        if (!_wait_data()){
+            return -1;
+        }
+    }
+    uchar bytes[sizeof(qint32)];
+    _COM->read((char*) bytes, sizeof(qint32));
+    _received((const char*) bytes, sizeof(qint32));
+    return qFromBigEndian<qint32>(bytes); // do not change type
+}
+bool RoboDK::_send_Int(qint32 value){
+    if (_COM == nullptr || !_COM->isOpen()){ return false; }
+    Buffer_Append_Int(_SEND_BUFFER, value);
+    return true;
+}
+
+Item RoboDK::_recv_Item(){//Item *item){
+    tTraceScope scope(this, "_recv_Item");
+    Item item(this);
+    if (_COM == nullptr){ return item; }
+    _recv_Begin();
+    item._PTR = 0;
+    item._TYPE = -1;
+    while (_COM->bytesAvailable() < sizeof(quint64) + sizeof(qint32)){
+        if (!_wait_data()){
+            return item;
+        }
+    }
+    uchar bytes[sizeof(quint64) + sizeof(qint32)];
+    _COM->read((char*) bytes, sizeof(bytes));
+    _received((const char*) bytes, sizeof(bytes));
+    item._PTR = qFromBigEndian<quint64>(bytes);
+    item._TYPE = qFromBigEndian<qint32>(bytes + sizeof(quint64));
+    return item;
+}
+bool RoboDK::_send_Item(const Item *item){
+    if (_COM == nullptr || !_COM->isOpen()){ return false; }
+    quint64 ptr = 0;
+    if (item != nullptr){
+        ptr = item->_PTR;
+    }
+    Buffer_Append_UInt64(_SEND_BUFFER, ptr);
+    return true;
+}
+bool RoboDK::_send_Item(const Item &item){
+    return _send_Item(&item);
+}
+
+Mat RoboDK::_recv_Pose(){//Mat &pose){
+    Mat pose;
+    if (_COM == nullptr){ return pose; }
+    _recv_Begin();
+    // values are sent column by column, as stored by Mat
+    double m44[16];
+    if (!_recv_Doubles(m44, 16)){
+        return pose;
+    }
+    return Mat(m44);
+}
+bool RoboDK::_send_Pose(const Mat &pose){
+    if (_COM == nullptr || !_COM->isOpen()){ return false; }
+    Buffer_Append_Doubles(_SEND_BUFFER, pose.ValuesD(), 16);
+    return true;
+}
+bool RoboDK::_recv_XYZ(tXYZ pos){
+    if (_COM == nullptr){ return false; }
+    _recv_Begin();
+    return _recv_Doubles(pos, 3);
+}
+bool RoboDK::_send_XYZ(const tXYZ pos){
+    if (_COM == nullptr || !_COM->isOpen()){ return false; }
+    Buffer_Append_Doubles(_SEND_BUFFER, pos, 3);
+    return true;
+}
+bool RoboDK::_recv_Array(tJoints *jnts){
+    return _recv_Array(jnts->_Values, &(jnts->_nDOFs));
+}
+bool RoboDK::_send_Array(const tJoints *jnts){
+    if (jnts == nullptr){
+        return _send_Int(0);
+    }
+    return _send_Array(jnts->_Values, jnts->_nDOFs);
+}
+bool RoboDK::_send_Array(const Mat *mat){
+    if (mat == nullptr){
+        return _send_Int(0);
+    }
+    return _send_Array(mat->ValuesD(), 16);
+}
+bool RoboDK::_recv_Array(double *values, int *psize){
+    int nvalues = _recv_Int();
+    if (_COM == nullptr || nvalues < 0) {return false;}
+    if (psize != nullptr){
+        *psize = nvalues;
+    }
+    if (nvalues < 0 || nvalues > 50){return false;} //check if the value is not too big
+    return _recv_Doubles(values, nvalues);
+}
+bool RoboDK::_send_Array(const double *values, int nvalues){
+    if (_COM == nullptr || !_COM->isOpen()){ return false; }
+    if (!_send_Int((qint32)nvalues)){ return false; }
+    Buffer_Append_Doubles(_SEND_BUFFER, values, nvalues);
+    return true;
+}
+bool RoboDK::_recv_Matrix2D(tMatrix2D **mat){ // needs to delete after!
+    *mat = Matrix2D_Create();
+    if (!_recv_Matrix2D(*mat)){
+        Matrix2D_Delete(mat);
+        return false;
+    }
+    return true;
+}
+// Read a matrix into an existing tMatrix2D. The memory of the matrix is reused if it is large enough (this allows using a preallocated buffer)
+bool RoboDK::_recv_Matrix2D(tMatrix2D *mat){
+    tTraceScope scope(this, "_recv_Matrix2D");
+    qint32 dim1 = _recv_Int();
+    qint32 dim2 = _recv_Int();
+    if (_COM == nullptr || dim1 < 0 || dim2 < 0){ return false; }
+    Matrix2D_Set_Size(mat, dim1, dim2);
+    return _recv_Doubles(mat->data, (qint64) dim1 * dim2);
+}
+// Read doubles straight into values and convert them in place (big endian to host byte order) as they arrive
+bool RoboDK::_recv_Doubles(double *values, qint64 nvalues){
+    tTraceScope scope(this, "_recv_Doubles");
+    if (_COM == nullptr){ return false; }
+    char *bytes = (char*) values;
+    qint64 nbytes = nvalues * sizeof(double);
+    qint64 received = 0;
+    qint64 converted = 0;
+    while (received < nbytes){
+        if (_COM->bytesAvailable() <= 0 && !_wait_data()){
+            return false;
+        }
+        qint64 nread = _COM->read(bytes + received, nbytes - received);
+        if (nread < 0){
+            return false;
+        }
+        _received(bytes + received, nread);
+        received += nread;
+        qint64 complete = received / sizeof(double);
+        Doubles_BigEndian(values + converted, values + converted, complete - converted);
+        converted = complete;
+    }
+    return true;
+}
+bool RoboDK::_send_Matrix2D(tMatrix2D *mat){
+    if (_COM == nullptr || !_COM->isOpen()){ return false; }
+    qint32 dim1 = Matrix2D_Size(mat, 1);
+    qint32 dim2 = Matrix2D_Size(mat, 2);
+    bool ok1 = _send_Int(dim1);
+    bool ok2 = _send_Int(dim2);
+    if (!ok1 || !ok2) {return false; }
+    // the matrix data is stored column by column, as expected by RoboDK
+    Buffer_Append_Doubles(_SEND_BUFFER, mat->data, (qint64) dim1 * dim2);
+    return true;
+}
+// private move type, to be used by public methods (MoveJ  and MoveL)
+void RoboDK::_moveX(const Item *target, const tJoints *joints, const Mat *mat_target, const Item *itemrobot, int movetype, bool blocking){
+    itemrobot->WaitMove();
+    _check_connection();
+    _send_MoveX(target, joints, mat_target, itemrobot, movetype, blocking);
+    _check_status();
+    if (blocking){
+        // MoveXb: RoboDK sends a second status once the robot finished the movement
+        _TIMEOUT = 3600 * 1000;
+        _check_status();//will wait here;
+        _TIMEOUT = _DEFAULT_TIMEOUT;
+    }
+}
+// private move type, to be used by public methods (MoveC)
+void RoboDK::_moveC(const Item *target1, const tJoints *joints1, const Mat *mat_target1, const Item *target2, const tJoints *joints2, const Mat *mat_target2, const Item *itemrobot, bool blocking){
+    itemrobot->WaitMove();
+    _check_connection();
+    _send_MoveC(target1, joints1, mat_target1, target2, joints2, mat_target2, itemrobot, blocking);
+    _check_status();
+    if (blocking){
+        // MoveCb: RoboDK sends a second status once the robot finished the movement
+        _TIMEOUT = 3600 * 1000;
+        _check_status();//will wait here;
+        _TIMEOUT = _DEFAULT_TIMEOUT;
+    }
+}
+// send a MoveX request (MoveXb if the status must be sent when the movement finishes)
+void RoboDK::_send_MoveX(const Item *target, const tJoints *joints, const Mat *mat_target, const Item *itemrobot, int movetype, bool blocking){
+    _send_Line(blocking ? "MoveXb" : "MoveX");
+    _send_Int(movetype);
+    _send_Target(target, joints, mat_target);
+    _send_Item(itemrobot);
+}
+// send a MoveC request (MoveCb if the status must be sent when the movement finishes)
+void RoboDK::_send_MoveC(const Item *target1, const tJoints *joints1, const Mat *mat_target1, const Item *target2, const tJoints *joints2, const Mat *mat_target2, const Item *itemrobot, bool blocking){
+    _send_Line(blocking ? "MoveCb" : "MoveC");
+    _send_Int(3);
+    _send_Target(target1, joints1, mat_target1);
+    _send_Target(target2, joints2, mat_target2);
+    _send_Item(itemrobot);
+}
+// send a movement target given as an item, joints or a pose
+void RoboDK::_send_Target(const Item *target, const tJoints *joints, const Mat *mat_target){
+    if (target != nullptr){
+        _send_Int(3);
+        _send_Array((tJoints*)nullptr);
+        _send_Item(target);
+    } else if (joints != nullptr){
+        _send_Int(1);
+        _send_Array(joints);
+        _send_Item(nullptr);
+    } else if (mat_target != nullptr){// && mat_target.IsHomogeneous()) {
+        _send_Int(2);
+        _send_Array(mat_target); // keep it as array!
+        _send_Item(nullptr);
+    } else {
+        //throw new RDKException("Invalid target type"); //raise Exception('Problems running function');
+        throw 0;
+    }
+}
+
+// Register a movement sent with MoveXb/MoveCb: both statuses are read later (see _pipeline_drain). The request is sent right away so the robot can start moving.
+void RoboDK::_motion_push(const Item *itemrobot, int index, int timeout){
+    tPipelinePending pending;
+    pending.index = index;
+    pending.command = _COMMAND;
+    pending.timeout = timeout;
+    pending.robot = itemrobot->_PTR;
+    _PIPELINE_PENDING.append(pending);
+    _send_Flush();
+}
+// Number of queued movements of a robot that did not finish
+int RoboDK::_motion_in_flight(const Item *itemrobot) const {
+    quint64 robot = itemrobot->_PTR;
+    int in_flight = 0;
+    for (int i=0; i<_PIPELINE_PENDING.length(); i++){
+        if (_PIPELINE_PENDING[i].robot == robot){
+            in_flight++;
+        }
+    }
+    return in_flight;
+}
+// Wait until at most max_in_flight movements of a robot are queued
+void RoboDK::_motion_wait(const Item *itemrobot, int max_in_flight){
+    quint64 robot = itemrobot->_PTR;
+    while (_motion_in_flight(itemrobot) > max_in_flight){
+        int oldest = 0;
+        while (_PIPELINE_PENDING[oldest].robot != robot){
+            oldest++;
+        }
+        _pipeline_drain(oldest + 1);
+    }
+}
+// Retrieve and clear the errors of the queued movements of a robot
+int RoboDK::_motion_errors(const Item *itemrobot, QList<tPipelineError> *errors){
+    quint64 robot = itemrobot->_PTR;
+    int nerrors = 0;
+    for (int i=0; i<_MOTION_ERRORS.length(); ){
+        if (_MOTION_ERRORS[i].robot == robot){
+            if (errors != nullptr){
+                errors->append(_MOTION_ERRORS[i].error);
+            }
+            _MOTION_ERRORS.removeAt(i);
+            nerrors++;
+        } else {
+            i++;
+        }
+    }
+    return nerrors;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// RoboDKAsync CLASS //////////////////////////////////////////////
+// Fields of a response read by RoboDKAsync, in the order they are sent by RoboDK
+enum {
+    ASYNC_STATUS = 0, // status (and the message for errors and warnings)
+    ASYNC_INT,        // 32 bit integer
+    ASYNC_ITEM,       // item pointer and type
+    ASYNC_POSE,       // 16 doubles
+    ASYNC_ARRAY       // number of values followed by the values
+};
+
+/// Values received for a call of RoboDKAsync
+struct tAsyncValues {
+    qint32 status;     // first status that is not 0 (0 if all succeeded)
+    QString message;
+    qint32 value;      // last ASYNC_INT
+    quint64 item_ptr;  // last ASYNC_ITEM
+    qint32 item_type;
+    double doubles[16]; // last ASYNC_POSE or ASYNC_ARRAY
+    int ndoubles;
+};
+
+/// Call of RoboDKAsync waiting for its response
+struct tAsyncRequest {
+    QString command;
+    QVector<int> fields;
+    int field;           // next field to read
+    tAsyncValues values;
+
+    tAsyncRequest() : field(0) {
+        values.status = 0;
+        values.value = 0;
+        values.item_ptr = 0;
+        values.item_type = -1;
+        values.ndoubles = 0;
+    }
+    virtual ~tAsyncRequest(){}
+
+    /// Complete the future (ok is false if the response was not received)
+    virtual void Finish(RoboDK *rdk, bool ok) = 0;
+
+    /// Parse the next field from buffer (starting at pos). Returns false if the field is not complete yet.
+    bool Parse(const QByteArray &buffer, int &pos){
+        const char *data = buffer.constData();
+        int available = buffer.size() - pos;
+        switch (fields[field]){
+        case ASYNC_STATUS: {
+            if (available < 4){ return false; }
+            qint32 status = qFromBigEndian<qint32>((const uchar*) data + pos);
+            int next = pos + 4;
+            QString message;
+            if (status == 2 || status == 3 || (status >= 10 && status < 100)){
+                int end = buffer.indexOf('\n', next);
+                if (end < 0){ return false; }
+                message = QString::fromUtf8(data + next, end - next).trimmed();
+                next = end + 1;
+            }
+            pos = next;
+            if (status == 2){
+                qDebug() << "RoboDK API WARNING: " << message;
+            } else if (status != 0){
+                qDebug() << "RoboDK API ERROR: " << command << message;
+                if (values.status == 0){
+                    values.status = status;
+                    values.message = message;
+                }
+            }
+            break;
+        }
+        case ASYNC_INT:
+            if (available < 4){ return false; }
+            values.value = qFromBigEndian<qint32>((const uchar*) data + pos);
+            pos += 4;
+            break;
+        case ASYNC_ITEM:
+            if (available < 12){ return false; }
+            values.item_ptr = qFromBigEndian<quint64>((const uchar*) data + pos);
+            values.item_type = qFromBigEndian<qint32>((const uchar*) data + pos + 8);
+            pos += 12;
+            break;
+        case ASYNC_POSE:
+            if (available < 16*8){ return false; }
+            memcpy(values.doubles, data + pos, 16*8);
+            Doubles_BigEndian(values.doubles, values.doubles, 16);
+            values.ndoubles = 16;
+            pos += 16*8;
+            break;
+        case ASYNC_ARRAY: {
+            if (available < 4){ return false; }
+            qint32 n = qMax(qFromBigEndian<qint32>((const uchar*) data + pos), 0);
+            if (available < 4 + (qint64) n*8){ return false; }
+            // values beyond the first 16 are skipped so that the next field starts at the right place
+            int nkeep = qMin(n, 16);
+            memcpy(values.doubles, data + pos + 4, nkeep*8);
+            Doubles_BigEndian(values.doubles, values.doubles, nkeep);
+            values.ndoubles = nkeep;
+            pos += 4 + n*8;
+            break;
+        }
+        }
+        field++;
+        return true;
+    }
+};
+
+/// Call of RoboDKAsync with a future of type T (convert builds the result from the values received)
+template<class T>
+struct tAsyncRequestT : public tAsyncRequest {
+    QFutureInterface<T> future;
+    T (*convert)(RoboDK *rdk, const tAsyncValues &values, bool ok);
+
+    void Finish(RoboDK *rdk, bool ok) override {
+        future.reportResult(convert(rdk, values, ok && values.status == 0));
+        future.reportFinished();
     }
-    _check_status();
-    return selectedItem;
+};
+
+template<class T>
+static tAsyncRequestT<T> *Async_Request(T (*convert)(RoboDK*, const tAsyncValues&, bool), const QVector<int> &fields){
+    tAsyncRequestT<T> *request = new tAsyncRequestT<T>();
+    request->convert = convert;
+    request->fields = fields;
+    request->future.reportStarted();
+    return request;
 }
 
+static int Async_Status(RoboDK *, const tAsyncValues &values, bool ok){
+    return ok ? 0 : (values.status != 0 ? values.status : -1);
+}
+static int Async_Int(RoboDK *, const tAsyncValues &values, bool ok){
+    return ok ? values.value : -1;
+}
+static Item Async_Item(RoboDK *rdk, const tAsyncValues &values, bool ok){
+    return ok ? Item(rdk, values.item_ptr, values.item_type) : Item(rdk);
+}
+static Mat Async_Pose(RoboDK *, const tAsyncValues &values, bool ok){
+    return ok ? Mat(values.doubles) : Mat(false);
+}
+static tJoints Async_Joints(RoboDK *, const tAsyncValues &values, bool ok){
+    return ok ? tJoints(values.doubles, values.ndoubles) : tJoints();
+}
 
-///---------------------------------- add get/set robot parameters
 
+RoboDKAsync::RoboDKAsync(RoboDK *rdk, QObject *parent) :
+    QObject(parent),
+    _RDK(rdk),
+    _SOCKET(nullptr),
+    _RECV_POS(0),
+    _FLUSH_QUEUED(false)
+{
+    _LINK = new RoboDK(rdk->_TRANSPORT, rdk->_IP, rdk->_PORT);
+    _begin();
+}
 
-/// <summary>
-/// Returns the license string (as shown in the RoboDK main window)
-/// </summary>
-/// <returns></returns>
-QString RoboDK::License(){
-    _check_connection();
-    _send_Line("G_License");
-    QString license = _recv_Line();
-    _check_status();
-    return license;
+RoboDKAsync::~RoboDKAsync(){
+    _fail_all();
+    delete _LINK;
 }
 
-/// <summary>
-/// Returns the list of items selected (it can be one or more items)
-/// </summary>
-/// <returns></returns>
-QList<Item> RoboDK::Selection(){
-    _check_connection();
-    _send_Line("G_Selection");
-    int nitems = _recv_Int();
-    QList<Item> list_items;
-    for (int i = 0; i < nitems; i++)    {
-        list_items.append(_recv_Item());
+bool RoboDKAsync::Connected() const {
+    return _LINK->_connected();
+}
+
+int RoboDKAsync::Pending() const {
+    return _QUEUE.length();
+}
+
+void RoboDKAsync::Flush(){
+    _LINK->_send_Flush();
+}
+
+// Start a call: connect the socket if needed (and its signals to this object)
+bool RoboDKAsync::_begin(){
+    if (!_LINK->_connected()){
+        if (_SOCKET != nullptr){
+            _closed();
+        }
+        if (!_LINK->_connect()){
+            return false;
+        }
     }
-    _check_status();
-    return list_items;
+    if (_SOCKET != _LINK->_COM){
+        _SOCKET = _LINK->_COM;
+        _RECV.clear();
+        _RECV_POS = 0;
+        connect(_SOCKET, &QIODevice::readyRead, this, &RoboDKAsync::_read);
+        connect(_SOCKET, SIGNAL(disconnected()), this, SLOT(_closed())); // QTcpSocket and QLocalSocket
+    }
+    _LINK->_COMMAND.clear();
+    return true;
 }
 
-/// <summary>
-/// Sets the selection in the tree (it can be one or more items).
-/// </summary>
-/// <returns>List of items to set as selected</returns>
-void RoboDK::setSelection(QList<Item> list_items){
-    _check_connection();
-    _send_Line("S_Selection");
-    _send_Int(list_items.length());
-    for (int i = 0; i < list_items.length(); i++)    {
-        _send_Item(list_items[i]);
+// Queue a call after its request was added to the send buffer. The buffer is written once the event loop runs so that calls made together are sent together.
+void RoboDKAsync::_push(tAsyncRequest *request){
+    request->command = _LINK->_COMMAND;
+    if (_SOCKET == nullptr || !_LINK->_connected()){
+        _LINK->_SEND_BUFFER.resize(0);
+        request->Finish(_RDK, false);
+        delete request;
+        return;
+    }
+    _LINK->_COMM_COMMANDS++;
+    _QUEUE.append(request);
+    if (!_FLUSH_QUEUED){
+        _FLUSH_QUEUED = true;
+        QMetaObject::invokeMethod(this, "_flush_queued", Qt::QueuedConnection);
     }
-    _check_status();
 }
 
+void RoboDKAsync::_flush_queued(){
+    _FLUSH_QUEUED = false;
+    _LINK->_send_Flush();
+}
 
-/// <summary>
-/// Show the popup menu to create the ISO9283 path for path accuracy and performance testing
-/// </summary>
-/// <returns>IS9283 Program</returns>
-Item RoboDK::Popup_ISO9283_CubeProgram(Item *robot, tXYZ center, double side, bool blocking){
-    //_require_build(5177);
-    Item iso_program;
-    _check_connection();
-    if (center == nullptr){
-        _send_Line("Popup_ProgISO9283");
-        _send_Item(robot);
-        _TIMEOUT = 3600 * 1000;
-        iso_program = _recv_Item();
-        _TIMEOUT = ROBODK_API_TIMEOUT;
-        _check_status();
-    } else {
-        _send_Line("Popup_ProgISO9283_Param");
-        _send_Item(robot);
-        double values[5];
-        values[0] = center[0];
-        values[1] = center[1];
-        values[2] = center[2];
-        values[3] = side;
-        values[4] = blocking ? 1 : 0;
-        _send_Array(values, 4);
-        if (blocking){
-            _TIMEOUT = 3600 * 1000;
-            iso_program = _recv_Item();
-            _TIMEOUT = ROBODK_API_TIMEOUT;
-            _check_status();
+// Parse the responses received so far and complete the calls in the order they were sent
+void RoboDKAsync::_read(){
+    if (_SOCKET == nullptr){ return; }
+    QByteArray received = _SOCKET->readAll();
+    _LINK->_capture(ROBODK_TRACE_RECV, received.constData(), received.size());
+    _RECV.append(received);
+    while (!_QUEUE.isEmpty()){
+        tAsyncRequest *request = _QUEUE.first();
+        while (request->field < request->fields.size() && request->Parse(_RECV, _RECV_POS)){}
+        if (request->field < request->fields.size()){
+            break;
+        }
+        _QUEUE.removeFirst();
+        request->Finish(_RDK, true);
+        delete request;
+        if (_QUEUE.isEmpty()){
+            emit idle();
         }
     }
-    return iso_program;
+    if (_QUEUE.isEmpty() || _RECV_POS > ROBODK_API_SEND_BUFFER_SIZE){
+        _RECV.remove(0, _RECV_POS);
+        _RECV_POS = 0;
+    }
 }
 
+void RoboDKAsync::_closed(){
+    if (_SOCKET != nullptr){
+        disconnect(_SOCKET, nullptr, this, nullptr);
+        _SOCKET = nullptr;
+    }
+    _fail_all();
+}
 
+// Complete all the pending calls as failed
+void RoboDKAsync::_fail_all(){
+    QList<tAsyncRequest*> queue;
+    queue.swap(_QUEUE);
+    _RECV.clear();
+    _RECV_POS = 0;
+    for (int i=0; i<queue.length(); i++){
+        queue[i]->Finish(_RDK, false);
+        delete queue[i];
+    }
+    if (!queue.isEmpty()){
+        emit idle();
+    }
+}
 
+QFuture<Item> RoboDKAsync::getItem(const QString &name, int itemtype){
+    tAsyncRequestT<Item> *request = Async_Request<Item>(Async_Item, QVector<int>() << ASYNC_ITEM << ASYNC_STATUS);
+    QFuture<Item> future = request->future.future();
+    if (_begin()){
+        if (itemtype < 0){
+            _LINK->_send_Line("G_Item");
+            _LINK->_send_Line(name);
+        } else {
+            _LINK->_send_Line("G_Item2");
+            _LINK->_send_Line(name);
+            _LINK->_send_Int(itemtype);
+        }
+    }
+    _push(request);
+    return future;
+}
 
-bool RoboDK::FileSet(const QString &path_file_local, const QString &file_remote, bool load_file, Item *attach_to){
-    if (!_check_connection()){ return false; }
-    if (!_send_Line("FileRecvBin")){ return false; }
-    QFile file(path_file_local);
-    if (!_send_Line(file_remote)){ return false; }
-    int nbytes = file.size();
-    if (!_send_Int(nbytes)){ return false; }
-    if (!_send_Item(attach_to)){ return false; }
-    if (!_send_Int(load_file ? 1 : 0)){ return false; }
-    if (!_check_status()){ return false; }
-    int sz_sent = 0;
-    if (!file.open(QFile::ReadOnly)){
-        return false;
+QFuture<int> RoboDKAsync::RunProgram(const QString &function_w_params){
+    tAsyncRequestT<int> *request = Async_Request<int>(Async_Int, QVector<int>() << ASYNC_INT << ASYNC_STATUS);
+    QFuture<int> future = request->future.future();
+    if (_begin()){
+        _LINK->_send_Line("RunCode");
+        _LINK->_send_Int(1);
+        _LINK->_send_Line(function_w_params);
     }
-    while (true){
-        QByteArray buffer(file.read(1024));
-        if (buffer.size() == 0){
-            break;
-        }
-        // warning! Nothing guarantees that all bytes are sent
-        sz_sent += _COM->write(buffer);
-        qDebug() << "Sending file " << path_file_local << 100*sz_sent/nbytes;
+    _push(request);
+    return future;
+}
+
+QFuture<int> RoboDKAsync::RunProgram(const Item &program){
+    tAsyncRequestT<int> *request = Async_Request<int>(Async_Int, QVector<int>() << ASYNC_INT << ASYNC_STATUS);
+    QFuture<int> future = request->future.future();
+    if (_begin()){
+        _LINK->_send_Line("RunProg");
+        _LINK->_send_Item(program);
     }
-    file.close();
-    return true;
+    _push(request);
+    return future;
 }
 
-bool RoboDK::FileGet(const QString &path_file_local, Item *station, const QString path_file_remote){
-    if (!_check_connection()){ return false; }
-    if (!_send_Line("FileSendBin")){ return false; }
-    if (!_send_Item(station)){ return false; }
-    if (!_send_Line(path_file_remote)){ return false; }
-    int nbytes = _recv_Int();
-    int remaining = nbytes;
-    QFile file(path_file_local);
-    if (!file.open(QFile::WriteOnly)){
-        qDebug() << "Can not open file for writting " << path_file_local;
-        return false;
+QFuture<tJoints> RoboDKAsync::Joints(const Item &robot){
+    tAsyncRequestT<tJoints> *request = Async_Request<tJoints>(Async_Joints, QVector<int>() << ASYNC_ARRAY << ASYNC_STATUS);
+    QFuture<tJoints> future = request->future.future();
+    if (_begin()){
+        _LINK->_send_Line("G_Thetas");
+        _LINK->_send_Item(robot);
     }
-    while (remaining > 0){
-        QByteArray buffer(_COM->read(qMin(remaining, 1024)));
-        remaining -= buffer.size();
-        file.write(buffer);
+    _push(request);
+    return future;
+}
+
+QFuture<Mat> RoboDKAsync::Pose(const Item &item){
+    tAsyncRequestT<Mat> *request = Async_Request<Mat>(Async_Pose, QVector<int>() << ASYNC_POSE << ASYNC_STATUS);
+    QFuture<Mat> future = request->future.future();
+    if (_begin()){
+        _LINK->_send_Line("G_Hlocal");
+        _LINK->_send_Item(item);
     }
-    file.close();
-    if (!_check_status()){ return false;}
-    return true;
+    _push(request);
+    return future;
+}
+
+QFuture<int> RoboDKAsync::setJoints(const Item &robot, const tJoints &joints){
+    tAsyncRequestT<int> *request = Async_Request<int>(Async_Status, QVector<int>() << ASYNC_STATUS);
+    QFuture<int> future = request->future.future();
+    if (_begin()){
+        _LINK->_send_Line("S_Thetas");
+        _LINK->_send_Array(&joints);
+        _LINK->_send_Item(robot);
+    }
+    _push(request);
+    return future;
+}
+
+QFuture<int> RoboDKAsync::setPose(const Item &item, const Mat &pose){
+    tAsyncRequestT<int> *request = Async_Request<int>(Async_Status, QVector<int>() << ASYNC_STATUS);
+    QFuture<int> future = request->future.future();
+    if (_begin()){
+        _LINK->_send_Line("S_Hlocal");
+        _LINK->_send_Item(item);
+        _LINK->_send_Pose(pose);
+    }
+    _push(request);
+    return future;
 }
 
+QFuture<int> RoboDKAsync::MoveJ(const Item &robot, const Item &target, bool blocking){
+    return _move(robot, &target, nullptr, nullptr, 1, blocking);
+}
+QFuture<int> RoboDKAsync::MoveJ(const Item &robot, const tJoints &joints, bool blocking){
+    return _move(robot, nullptr, &joints, nullptr, 1, blocking);
+}
+QFuture<int> RoboDKAsync::MoveJ(const Item &robot, const Mat &target, bool blocking){
+    return _move(robot, nullptr, nullptr, &target, 1, blocking);
+}
+QFuture<int> RoboDKAsync::MoveL(const Item &robot, const Item &target, bool blocking){
+    return _move(robot, &target, nullptr, nullptr, 2, blocking);
+}
+QFuture<int> RoboDKAsync::MoveL(const Item &robot, const tJoints &joints, bool blocking){
+    return _move(robot, nullptr, &joints, nullptr, 2, blocking);
+}
+QFuture<int> RoboDKAsync::MoveL(const Item &robot, const Mat &target, bool blocking){
+    return _move(robot, nullptr, nullptr, &target, 2, blocking);
+}
 
+// MoveXb sends a second status when the movement finished (see RoboDK::_moveX)
+QFuture<int> RoboDKAsync::_move(const Item &robot, const Item *target, const tJoints *joints, const Mat *mat_target, int movetype, bool blocking){
+    QVector<int> fields;
+    fields << ASYNC_STATUS;
+    if (blocking){
+        fields << ASYNC_STATUS;
+    }
+    tAsyncRequestT<int> *request = Async_Request<int>(Async_Status, fields);
+    QFuture<int> future = request->future.future();
+    if (_begin()){
+        _LINK->_send_MoveX(target, joints, mat_target, &robot, movetype, blocking);
+    }
+    _push(request);
+    return future;
+}
 
 
-//-------------------------- private ---------------------------------------
 
-bool RoboDK::_connected(){
-    return _COM != nullptr && _COM->state() == QTcpSocket::ConnectedState;
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// RoboDKTransport CLASSES /////////////////////////////////////////
+RoboDKTransport::~RoboDKTransport(){
 }
 
+void RoboDKTransport::Flush(QIODevice *stream){
+    Q_UNUSED(stream);
+}
 
-bool RoboDK::_check_connection(){
-    if (_connected()){
-        return true;
+static QString Transport_Local_Name(const QString &server_name, int com_port){
+    if (!server_name.isEmpty()){
+        return server_name;
     }
-    bool connection_ok = _connect_smart();
-    //if (!connection_ok){
-    //    throw -1;
-    //}
-    return connection_ok;
+    return ROBODK_API_LOCAL_NAME + QString::number(com_port);
 }
 
-bool RoboDK::_check_status(){
-    qint32 status = _recv_Int();
-    if (status == 0) {
-        // everything is OK
-        //status = status
-    } else if (status > 0 && status < 10) {
-        QString strproblems("Unknown error");
-        if (status == 1) {
-            strproblems = "Invalid item provided: The item identifier provided is not valid or it does not exist.";
-        } else if (status == 2) { //output warning only
-            strproblems = _recv_Line();
-            qDebug() << "RoboDK API WARNING: " << strproblems;
-            return 0;
-        } else if (status == 3){ // output error
-            strproblems = _recv_Line();
-            qDebug() << "RoboDK API ERROR: " << strproblems;
-        } else if (status == 9) {
-            qDebug() << "Invalid RoboDK License";
-        }
-        //print(strproblems);
-        //throw new RDKException(strproblems); //raise Exception(strproblems)
-    } else if (status < 100){
-        QString strproblems = _recv_Line();
-        qDebug() << "RoboDK API ERROR: " << strproblems;
-    } else  {
-        //throw new RDKException("Communication problems with the RoboDK API"); //raise Exception('Problems running function');
-        qDebug() << "Communication problems with the RoboDK API";
+QIODevice *TcpTransport::Open(const QString &robodk_ip, int com_port, int timeout_ms){
+    QTcpSocket *socket = new QTcpSocket();
+    socket->connectToHost(robodk_ip.isEmpty() ? QString("127.0.0.1") : robodk_ip, com_port);
+    if (!socket->waitForConnected(timeout_ms)){
+        socket->deleteLater();
+        return nullptr;
     }
-    return status;
+    // requests are written in one go (see _send_Flush), avoid Nagle delays
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    return socket;
+}
+
+bool TcpTransport::Connected(const QIODevice *stream) const {
+    return static_cast<const QTcpSocket*>(stream)->state() == QTcpSocket::ConnectedState;
 }
 
+void TcpTransport::Flush(QIODevice *stream){
+    static_cast<QTcpSocket*>(stream)->flush();
+}
 
 
-void RoboDK::_disconnect(){
-    if (_COM != nullptr){
-        _COM->deleteLater();
-        _COM = nullptr;
+LocalTransport::LocalTransport(const QString &server_name) :
+    _SERVER_NAME(server_name)
+{
+}
+
+QIODevice *LocalTransport::Open(const QString &robodk_ip, int com_port, int timeout_ms){
+    Q_UNUSED(robodk_ip);
+    QLocalSocket *socket = new QLocalSocket();
+    socket->connectToServer(Transport_Local_Name(_SERVER_NAME, com_port));
+    if (!socket->waitForConnected(timeout_ms)){
+        socket->deleteLater();
+        return nullptr;
+    }
+    return socket;
+}
+
+bool LocalTransport::Connected(const QIODevice *stream) const {
+    return static_cast<const QLocalSocket*>(stream)->state() == QLocalSocket::ConnectedState;
+}
+
+void LocalTransport::Flush(QIODevice *stream){
+    static_cast<QLocalSocket*>(stream)->flush();
+}
+
+
+/// Ring buffer in shared memory. head and tail count the bytes written and read (they wrap around), the data follows the ring.
+struct tShmRing {
+    QAtomicInteger<quint32> head;
+    QAtomicInteger<quint32> tail;
+    quint32 size; // power of 2
+    quint32 reserved;
+};
+
+/// Shared memory of a SharedMemoryTransport stream: header, ring from the client to the relay, ring from the relay to the client
+struct tShmHeader {
+    char magic[8];                  // "RDKSHM2"
+    quint32 ring_size;
+    QAtomicInteger<quint32> closed; // bit 0: closed by the client, bit 1: closed by the relay
+    QAtomicInteger<quint32> waiting; // bit 0: the client sleeps until the relay writes, bit 1: the relay sleeps until the client writes
+};
+
+static tShmRing *Shm_Ring(void *memory, int index){
+    tShmHeader *header = (tShmHeader*) memory;
+    char *rings = (char*) memory + sizeof(tShmHeader);
+    return (tShmRing*)(rings + index * (sizeof(tShmRing) + header->ring_size));
+}
+static inline char *Shm_Ring_Data(tShmRing *ring){
+    return (char*)(ring + 1);
+}
+static inline quint32 Shm_Ring_Available(tShmRing *ring){
+    return ring->head.loadAcquire() - ring->tail.load();
+}
+// Copy up to n bytes to the ring without blocking. Returns the number of bytes copied.
+static quint32 Shm_Ring_Write(tShmRing *ring, const char *src, quint32 n){
+    quint32 head = ring->head.load();
+    quint32 space = ring->size - (head - ring->tail.loadAcquire());
+    n = qMin(n, space);
+    quint32 pos = head & (ring->size - 1);
+    quint32 first = qMin(n, ring->size - pos);
+    memcpy(Shm_Ring_Data(ring) + pos, src, first);
+    memcpy(Shm_Ring_Data(ring), src + first, n - first);
+    ring->head.storeRelease(head + n);
+    return n;
+}
+// Copy up to n bytes from the ring without blocking. Returns the number of bytes copied.
+static quint32 Shm_Ring_Read(tShmRing *ring, char *dst, quint32 n){
+    quint32 tail = ring->tail.load();
+    n = qMin(n, ring->head.loadAcquire() - tail);
+    quint32 pos = tail & (ring->size - 1);
+    quint32 first = qMin(n, ring->size - pos);
+    memcpy(dst, Shm_Ring_Data(ring) + pos, first);
+    memcpy(dst + first, Shm_Ring_Data(ring), n - first);
+    ring->tail.storeRelease(tail + n);
+    return n;
+}
+// Position of the first byte c in the ring (-1 if not found)
+static qint64 Shm_Ring_IndexOf(tShmRing *ring, char c){
+    quint32 tail = ring->tail.load();
+    quint32 available = ring->head.loadAcquire() - tail;
+    const char *data = Shm_Ring_Data(ring);
+    for (quint32 i=0; i<available; i++){
+        if (data[(tail + i) & (ring->size - 1)] == c){
+            return i;
+        }
+    }
+    return -1;
+}
+// Wake the peer after writing to its ring if it sleeps (bit of tShmHeader::waiting): one byte on the control socket ends its wait.
+// The peer sets its bit before checking the ring a last time, so either it sees the data or the bit is seen here.
+static inline void Shm_Notify(tShmHeader *header, quint32 bit, QLocalSocket *control){
+    if (header->waiting.fetchAndAndOrdered(~bit) & bit){
+        control->write(ROBODK_API_LF, 1);
+        control->flush();
+    }
+}
+// Wait a little between polls of a full ring buffer: spin first (lowest latency), then sleep
+static inline void Shm_Backoff(int &polls){
+    if (++polls < ROBODK_API_SHM_SPIN){
+        QThread::yieldCurrentThread();
+    } else {
+        QThread::usleep(ROBODK_API_SHM_SLEEP_US);
     }
 }
 
-// attempt a simple connection to RoboDK and start RoboDK if it is not running
-bool RoboDK::_connect_smart(){
-    //Establishes a connection with robodk. robodk must be running, otherwise, it will attempt to start it
-    if (_connect()){
-        qDebug() << "The RoboDK API is connected";
+/// Stream of a SharedMemoryTransport (client side). The local socket to the relay stays open to detect when the relay is gone.
+class SharedMemoryStream : public QIODevice {
+public:
+    SharedMemoryStream(QSharedMemory *memory, QLocalSocket *control) :
+        _MEMORY(memory),
+        _CONTROL(control)
+    {
+        _HEADER = (tShmHeader*) _MEMORY->data();
+        _SEND = Shm_Ring(_HEADER, 0);
+        _RECV = Shm_Ring(_HEADER, 1);
+        _CONTROL->setParent(this);
+        open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+    }
+    ~SharedMemoryStream(){
+        _HEADER->closed.fetchAndOrRelease(1);
+        delete _MEMORY;
+    }
+
+    bool isSequential() const override {
+        return true;
+    }
+    qint64 bytesAvailable() const override {
+        return Shm_Ring_Available(_RECV) + QIODevice::bytesAvailable();
+    }
+    bool canReadLine() const override {
+        return Shm_Ring_IndexOf(_RECV, '\n') >= 0 || QIODevice::canReadLine();
+    }
+    // spin for the lowest latency, then sleep until the relay rings the control socket (see Shm_Notify)
+    bool waitForReadyRead(int msecs) override {
+        QElapsedTimer timer;
+        timer.start();
+        int polls = 0;
+        while (Shm_Ring_Available(_RECV) == 0){
+            qint64 wait = (msecs < 0) ? -1 : msecs - timer.elapsed();
+            if (!PeerConnected() || (msecs >= 0 && wait <= 0)){
+                return false;
+            }
+            if (++polls < ROBODK_API_SHM_SPIN){
+                QThread::yieldCurrentThread();
+                continue;
+            }
+            _HEADER->waiting.fetchAndOrOrdered(1);
+            if (Shm_Ring_Available(_RECV) == 0){
+                _CONTROL->waitForReadyRead((int) wait);
+            }
+            _HEADER->waiting.fetchAndAndOrdered(~1u);
+            _CONTROL->readAll();
+        }
+        return true;
+    }
+    bool waitForBytesWritten(int) override {
         return true;
     }
 
-    qDebug() << "...Trying to start RoboDK: " << _ROBODK_BIN << " " << _ARGUMENTS;
-    // Start RoboDK
-    QProcess *p = new QProcess();
-    //_ARGUMENTS = "/DEBUG";
-    p->start(_ROBODK_BIN, _ARGUMENTS.split(" ", QString::SkipEmptyParts));
-    p->setReadChannel(QProcess::StandardOutput);
-    //p->waitForReadyRead(10000);
-    _PROCESS = p->processId();
-    while (p->canReadLine() || p->waitForReadyRead(5000)){
-        QString line = QString::fromUtf8(p->readLine().trimmed());
-        //qDebug() << "RoboDK process: " << line;
-        if (line.contains("Running", Qt::CaseInsensitive)){
-            qDebug() << "RoboDK is Running... Connecting API";
-            bool is_connected = _connect();
-            if (is_connected){
-                qDebug() << "The RoboDK API is connected";
+    bool PeerConnected() const {
+        return (_HEADER->closed.loadAcquire() & 2) == 0 && _CONTROL->state() == QLocalSocket::ConnectedState;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override {
+        return Shm_Ring_Read(_RECV, data, (quint32) qMin<qint64>(maxlen, UINT_MAX));
+    }
+    qint64 readLineData(char *data, qint64 maxlen) override {
+        qint64 end = Shm_Ring_IndexOf(_RECV, '\n');
+        qint64 n = (end < 0) ? Shm_Ring_Available(_RECV) : end + 1;
+        return Shm_Ring_Read(_RECV, data, (quint32) qMin(n, maxlen));
+    }
+    // blocks until everything is in the ring: the relay always reads what it receives
+    qint64 writeData(const char *data, qint64 len) override {
+        qint64 written = 0;
+        int polls = 0;
+        while (written < len){
+            quint32 n = Shm_Ring_Write(_SEND, data + written, (quint32) qMin<qint64>(len - written, UINT_MAX));
+            written += n;
+            if (n > 0){
+                Shm_Notify(_HEADER, 2, _CONTROL);
+            }
+            if (n == 0){
+                if (!PeerConnected()){
+                    return written > 0 ? written : -1;
+                }
+                Shm_Backoff(polls);
+            } else {
+                polls = 0;
+            }
+        }
+        return written;
+    }
+
+private:
+    QSharedMemory *_MEMORY;
+    QLocalSocket *_CONTROL;
+    tShmHeader *_HEADER;
+    tShmRing *_SEND;
+    tShmRing *_RECV;
+};
+
+
+SharedMemoryTransport::SharedMemoryTransport(int ring_size, const QString &server_name) :
+    _SERVER_NAME(server_name)
+{
+    _RING_SIZE = 4096;
+    while (_RING_SIZE < ring_size && _RING_SIZE < (1 << 30)){
+        _RING_SIZE *= 2;
+    }
+}
+
+QIODevice *SharedMemoryTransport::Open(const QString &robodk_ip, int com_port, int timeout_ms){
+    Q_UNUSED(robodk_ip);
+    static QAtomicInt counter;
+    QString key = QString("RoboDK_API_SHM_%1_%2").arg(QCoreApplication::applicationPid()).arg(counter.fetchAndAddRelaxed(1));
+    QSharedMemory *memory = new QSharedMemory(key);
+    if (!memory->create(sizeof(tShmHeader) + 2 * (sizeof(tShmRing) + _RING_SIZE))){
+        qDebug() << "RoboDK API: Could not create the shared memory:" << memory->errorString();
+        delete memory;
+        return nullptr;
+    }
+    tShmHeader *header = new (memory->data()) tShmHeader;
+    memcpy(header->magic, "RDKSHM2", 8);
+    header->ring_size = _RING_SIZE;
+    header->closed.store(0);
+    header->waiting.store(0);
+    for (int i=0; i<2; i++){
+        tShmRing *ring = new (Shm_Ring(header, i)) tShmRing;
+        ring->head.store(0);
+        ring->tail.store(0);
+        ring->size = _RING_SIZE;
+        ring->reserved = 0;
+    }
+
+    // give the key to the relay and wait until it is attached to the shared memory
+    QLocalSocket *control = new QLocalSocket();
+    control->connectToServer(Transport_Local_Name(_SERVER_NAME, com_port));
+    bool ready = control->waitForConnected(timeout_ms);
+    if (ready){
+        control->write(ROBODK_API_SHM_STRING " " + key.toUtf8() + ROBODK_API_LF);
+        control->flush();
+        ready = (control->canReadLine() || control->waitForReadyRead(timeout_ms)) && control->readLine().startsWith(ROBODK_API_READY_STRING);
+    }
+    if (!ready){
+        delete control;
+        delete memory;
+        return nullptr;
+    }
+    return new SharedMemoryStream(memory, control);
+}
+
+bool SharedMemoryTransport::Connected(const QIODevice *stream) const {
+    return static_cast<const SharedMemoryStream*>(stream)->PeerConnected();
+}
+
+
+/// Forwarding between a shared memory stream and RoboDK, running in its own thread (relay side).
+/// The thread owns the control socket of the client: it answers READY once RoboDK is connected and wakes the client when it sleeps.
+class RelaySharedMemory : public QThread {
+public:
+    RelaySharedMemory(QSharedMemory *memory, QLocalSocket *control, const QString &robodk_ip, int com_port) :
+        _MEMORY(memory),
+        _CONTROL(control),
+        _IP(robodk_ip),
+        _PORT(com_port)
+    {
+        _STOP.store(0);
+    }
+    ~RelaySharedMemory(){
+        _STOP.storeRelease(1);
+        wait();
+        delete _MEMORY;
+    }
+
+protected:
+    void run() override {
+        tShmHeader *header = (tShmHeader*) _MEMORY->data();
+        tShmRing *from_client = Shm_Ring(header, 0);
+        tShmRing *to_client = Shm_Ring(header, 1);
+        TcpTransport tcp;
+        QTcpSocket *robodk = static_cast<QTcpSocket*>(tcp.Open(_IP, _PORT, ROBODK_API_TIMEOUT));
+        if (robodk != nullptr){
+            _CONTROL->write(ROBODK_API_READY_STRING ROBODK_API_LF);
+            _CONTROL->flush();
+        }
+        QByteArray buffer(256*1024, 0);
+        QByteArray to_send; // data from RoboDK that did not fit in the ring yet
+        int polls = 0;
+        while (robodk != nullptr && _STOP.loadAcquire() == 0 && (header->closed.loadAcquire() & 1) == 0
+               && robodk->state() == QTcpSocket::ConnectedState && _CONTROL->state() == QLocalSocket::ConnectedState){
+            bool moved = false;
+            quint32 n = Shm_Ring_Read(from_client, buffer.data(), buffer.size());
+            if (n > 0){
+                robodk->write(buffer.constData(), n);
+                robodk->flush();
+                moved = true;
+            }
+            if (robodk->bytesAvailable() > 0 || robodk->waitForReadyRead(0)){
+                to_send.append(robodk->readAll());
+            }
+            if (!to_send.isEmpty()){
+                quint32 written = Shm_Ring_Write(to_client, to_send.constData(), to_send.size());
+                to_send.remove(0, written);
+                if (written > 0){
+                    Shm_Notify(header, 1, _CONTROL);
+                    moved = true;
+                }
+            }
+            if (moved){
+                polls = 0;
+            } else if (!to_send.isEmpty() || ++polls < ROBODK_API_SHM_SPIN){
+                // the ring of the client is full (it reads it) or the relay just went idle
+                Shm_Backoff(polls);
             } else {
-                qDebug() << "The RoboDK API is NOT connected!";
+                _sleep(header, from_client, robodk);
+            }
+        }
+        header->closed.fetchAndOrRelease(2);
+        delete robodk;
+        delete _CONTROL; // the client sees the relay is gone
+    }
+
+private:
+    // Sleep until RoboDK sends data or the client rings the control socket after writing to its ring (see Shm_Notify)
+    void _sleep(tShmHeader *header, tShmRing *from_client, QTcpSocket *robodk){
+        header->waiting.fetchAndOrOrdered(2);
+        if (Shm_Ring_Available(from_client) == 0 && robodk->bytesAvailable() == 0){
+            QEventLoop loop;
+            QObject::connect(robodk, &QTcpSocket::readyRead, &loop, &QEventLoop::quit);
+            QObject::connect(robodk, &QTcpSocket::disconnected, &loop, &QEventLoop::quit);
+            QObject::connect(_CONTROL, &QLocalSocket::readyRead, &loop, &QEventLoop::quit);
+            QObject::connect(_CONTROL, &QLocalSocket::disconnected, &loop, &QEventLoop::quit);
+            QTimer::singleShot(ROBODK_API_SHM_STOP_POLL, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+        header->waiting.fetchAndAndOrdered(~2u);
+        _CONTROL->readAll();
+    }
+
+    QSharedMemory *_MEMORY;
+    QLocalSocket *_CONTROL;
+    QString _IP;
+    int _PORT;
+    QAtomicInt _STOP;
+};
+
+/// Client of a RoboDKRelay: forwards a local socket to RoboDK, or attaches to the shared memory of a SharedMemoryTransport
+class RelayClient : public QObject {
+public:
+    RelayClient(QLocalSocket *local, const QString &robodk_ip, int com_port, QObject *parent) :
+        QObject(parent),
+        _LOCAL(local),
+        _ROBODK(nullptr),
+        _SHARED(nullptr),
+        _IP(robodk_ip),
+        _PORT(com_port)
+    {
+        _LOCAL->setParent(this);
+        connect(_LOCAL, &QLocalSocket::readyRead, this, [this](){ _read(); });
+        connect(_LOCAL, &QLocalSocket::disconnected, this, [this](){ deleteLater(); });
+    }
+    ~RelayClient(){
+        delete _SHARED;
+    }
+
+private:
+    void _read(){
+        if (_ROBODK != nullptr){
+            _ROBODK->write(_LOCAL->readAll());
+            return;
+        }
+        if (_SHARED != nullptr || !_LOCAL->canReadLine()){
+            return;
+        }
+        if (_LOCAL->peek(sizeof(ROBODK_API_SHM_STRING)).startsWith(ROBODK_API_SHM_STRING " ")){
+            QString key = QString::fromUtf8(_LOCAL->readLine().mid(sizeof(ROBODK_API_SHM_STRING))).trimmed();
+            QSharedMemory *memory = new QSharedMemory(key);
+            if (!memory->attach() || memcmp(memory->data(), "RDKSHM2", 8) != 0){
+                qDebug() << "RoboDKRelay: Could not attach to the shared memory" << key;
+                delete memory;
+                _LOCAL->disconnectFromServer();
+                return;
             }
-            return is_connected;
+            // the local socket becomes the control socket of the relay thread (READY and wake-ups).
+            // It is handed over from the event loop, not from its own readyRead signal.
+            disconnect(_LOCAL, nullptr, this, nullptr);
+            _SHARED = new RelaySharedMemory(memory, _LOCAL, _IP, _PORT);
+            connect(_SHARED, &QThread::finished, this, [this](){ deleteLater(); });
+            QTimer::singleShot(0, this, [this](){
+                _LOCAL->setParent(nullptr);
+                _LOCAL->moveToThread(_SHARED);
+                _LOCAL = nullptr;
+                _SHARED->start();
+            });
+            return;
+        }
+        // plain local socket: forward everything in both directions
+        TcpTransport tcp;
+        _ROBODK = static_cast<QTcpSocket*>(tcp.Open(_IP, _PORT, ROBODK_API_TIMEOUT));
+        if (_ROBODK == nullptr){
+            _LOCAL->disconnectFromServer();
+            return;
         }
+        _ROBODK->setParent(this);
+        connect(_ROBODK, &QTcpSocket::readyRead, this, [this](){ _LOCAL->write(_ROBODK->readAll()); });
+        connect(_ROBODK, &QTcpSocket::disconnected, this, [this](){ _LOCAL->disconnectFromServer(); });
+        _ROBODK->write(_LOCAL->readAll());
     }
-    qDebug() << "Could not start RoboDK!";
-    return false;
-}
 
-// attempt a simple connection to RoboDK
-bool RoboDK::_connect(){
-    _disconnect();
-    _COM = new QTcpSocket();
-    if (_IP.isEmpty()){
-        _COM->connectToHost("127.0.0.1", _PORT); //QHostAddress::LocalHost, _PORT);
-    } else {
-        _COM->connectToHost(_IP, _PORT);
-    }
-    // usually, 5 msec should be enough for localhost
-    if (!_COM->waitForConnected(_TIMEOUT)){
-        _COM->deleteLater();
-        _COM = nullptr;
-        return false;
-    }
+    QLocalSocket *_LOCAL;
+    QTcpSocket *_ROBODK;
+    RelaySharedMemory *_SHARED;
+    QString _IP;
+    int _PORT;
+};
 
-    // RoboDK protocol to check that we are connected to the right port
-    _COM->write(ROBODK_API_START_STRING); _COM->write(ROBODK_API_LF, 1);
-    _COM->write("1 0"); _COM->write(ROBODK_API_LF, 1);
 
-    // 5 msec should be enough for localhost
-    /*if (!_COM->waitForBytesWritten(_TIMEOUT)){
-        _COM->deleteLater();
-        _COM = nullptr;
-        return false;
-    }*/
-    // 10 msec should be enough for localhost
-    if (!_COM->canReadLine() && !_COM->waitForReadyRead(_TIMEOUT)){
-        _COM->deleteLater();
-        _COM = nullptr;
-        return false;
-    }
-    QString read(_COM->readAll());
-    // make sure we receive the OK from RoboDK
-    if (!read.startsWith(ROBODK_API_READY_STRING)){
-        _COM->deleteLater();
-        _COM = nullptr;
-        return false;
-    }
-    return true;
+RoboDKRelay::RoboDKRelay(const QString &robodk_ip, int com_port, QObject *parent) :
+    QObject(parent),
+    _IP(robodk_ip),
+    _PORT(com_port < 0 ? ROBODK_DEFAULT_PORT : com_port),
+    _SERVER(nullptr)
+{
 }
 
+RoboDKRelay::~RoboDKRelay(){
+    Close();
+}
 
-/////////////////////////////////////////////
-bool RoboDK::_waitline(){
-    if (_COM == nullptr){ return false; }
-    while (!_COM->canReadLine()){
-        if (!_COM->waitForReadyRead(_TIMEOUT)){
-            return false;
-        }
+bool RoboDKRelay::Listen(const QString &server_name){
+    Close();
+    QString name = Transport_Local_Name(server_name, _PORT);
+    _SERVER = new QLocalServer(this);
+    QLocalServer::removeServer(name); // remove a stale server of a previous process
+    if (!_SERVER->listen(name)){
+        qDebug() << "RoboDKRelay: Could not listen on" << name << _SERVER->errorString();
+        delete _SERVER;
+        _SERVER = nullptr;
+        return false;
     }
+    connect(_SERVER, &QLocalServer::newConnection, this, &RoboDKRelay::_accept);
     return true;
 }
-QString RoboDK::_recv_Line(){//QString &string){
-    QString string;
-    if (!_waitline()){
-        if (_COM != nullptr){
-            //if this happens it means that there are problems: delete buffer
-            _COM->readAll();
-        }
-        return string;
-    }
-    QByteArray line = _COM->readLine().trimmed();//remove last character \n //.trimmed();
-    string.append(QString::fromUtf8(line));
-    return string;
+
+void RoboDKRelay::Close(){
+    QList<QObject*> clients;
+    clients.swap(_CLIENTS);
+    qDeleteAll(clients);
+    delete _SERVER;
+    _SERVER = nullptr;
 }
-bool RoboDK::_send_Line(const QString& string){
-    if (_COM == nullptr || !_COM->isOpen()){ return false; }
-    _COM->write(string.toUtf8());
-    _COM->write(ROBODK_API_LF, 1);
-    return true;
+
+int RoboDKRelay::Clients() const {
+    return _CLIENTS.length();
 }
 
-int RoboDK::_recv_Int(){//qint32 &value){
-    qint32 value; // do not change type
-    if (_COM == nullptr){ return false; }
-    if (_COM->bytesAvailable() < sizeof(qint32)){
-        _COM->waitForReadyRead(_TIMEOUT);
-        if (_COM->bytesAvailable() < sizeof(qint32)){
-            return -1;
-        }
+void RoboDKRelay::_accept(){
+    while (_SERVER != nullptr && _SERVER->hasPendingConnections()){
+        RelayClient *client = new RelayClient(_SERVER->nextPendingConnection(), _IP, _PORT, this);
+        _CLIENTS.append(client);
+        connect(client, &QObject::destroyed, this, [this, client](){ _CLIENTS.removeOne(client); });
     }
-    QDataStream ds(_COM);
-    ds >> value;
-    return value;
-}
-bool RoboDK::_send_Int(qint32 value){
-    if (_COM == nullptr || !_COM->isOpen()){ return false; }
-    QDataStream ds(_COM);
-    ds << value;
-    return true;
 }
 
-Item RoboDK::_recv_Item(){//Item *item){
-    Item item(this);
-    if (_COM == nullptr){ return item; }
-    item._PTR = 0;
-    item._TYPE = -1;
-    if (_COM->bytesAvailable() < sizeof(quint64)){
-        _COM->waitForReadyRead(_TIMEOUT);
-        if (_COM->bytesAvailable() < sizeof(quint64)){
-            return item;
+
+
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// RoboDKReplay CLASS ////////////////////////////////////////////////
+
+/// Server of a RoboDKReplay running in its own thread. Clients are served one after the other.
+class ReplayServer : public QThread {
+public:
+    ReplayServer(const QList<QPair<char, QByteArray> > &records, int port, bool local) :
+        Listening(false),
+        Port(port),
+        _RECORDS(records),
+        _LOCAL(local)
+    {
+        Served.store(0);
+        Mismatches.store(0);
+        _STOP.store(0);
+    }
+    ~ReplayServer(){
+        _STOP.storeRelease(1);
+        wait();
+    }
+
+    /// Released once the server is listening (or failed to listen)
+    QSemaphore Started;
+    bool Listening;
+    int Port;
+
+    QAtomicInt Served;
+    QAtomicInt Mismatches;
+
+protected:
+    void run() override {
+        QTcpServer *tcp = nullptr;
+        QLocalServer *local = nullptr;
+        QSharedPointer<RoboDKTransport> transport;
+        if (_LOCAL){
+            QString name = Transport_Local_Name("", Port);
+            QLocalServer::removeServer(name);
+            local = new QLocalServer();
+            Listening = local->listen(name);
+            transport = QSharedPointer<RoboDKTransport>(new LocalTransport());
+        } else {
+            tcp = new QTcpServer();
+            Listening = tcp->listen(QHostAddress::LocalHost, Port);
+            Port = tcp->serverPort();
+            transport = QSharedPointer<RoboDKTransport>(new TcpTransport());
         }
+        Started.release();
+        while (Listening && !_STOP.loadAcquire()){
+            QIODevice *client = nullptr;
+            if (tcp != nullptr && tcp->waitForNewConnection(ROBODK_API_CANCEL_POLL)){
+                client = tcp->nextPendingConnection();
+            } else if (local != nullptr && local->waitForNewConnection(ROBODK_API_CANCEL_POLL)){
+                client = local->nextPendingConnection();
+            }
+            if (client != nullptr){
+                _serve(client, transport.data());
+                delete client;
+            }
+        }
+        delete tcp;
+        delete local;
     }
-    QDataStream ds(_COM);
-    ds >> item._PTR;
-    ds >> item._TYPE;
-    return item;
-}
-bool RoboDK::_send_Item(const Item *item){
-    if (_COM == nullptr || !_COM->isOpen()){ return false; }
-    QDataStream ds(_COM);
-    quint64 ptr = 0;
-    if (item != nullptr){
-        ptr = item->_PTR;
-    }
-    ds << ptr;
-    return true;
-}
-bool RoboDK::_send_Item(const Item &item){
-    return _send_Item(&item);
-}
 
-Mat RoboDK::_recv_Pose(){//Mat &pose){
-    Mat pose;
-    if (_COM == nullptr){ return pose; }
-    int size = 16*sizeof(double);
-    if (_COM->bytesAvailable() < size){
-        _COM->waitForReadyRead(_TIMEOUT);
-        if (_COM->bytesAvailable() < size){
-            return pose;
+private:
+    /// Replay the trace to a client until it disconnects (the trace starts again once it ends)
+    void _serve(QIODevice *client, RoboDKTransport *transport){
+        if (!_wait(client, transport, -1) || !client->readLine().startsWith(ROBODK_API_START_STRING)){
+            return;
         }
-    }
-    QDataStream ds(_COM);
-    ds.setFloatingPointPrecision(QDataStream::DoublePrecision);
-    //ds.setByteOrder(QDataStream::LittleEndian);
-    double valuei;
-    for (int j=0; j<4; j++){
-        for (int i=0; i<4; i++){
-            ds >> valuei;
-            pose.Set(i,j,valuei);
-            //pose.data()[i][j] = valuei;
+        if (!_wait(client, transport, -1)){
+            return;
         }
-    }
-    return pose;
-}
-bool RoboDK::_send_Pose(const Mat &pose){
-    if (_COM == nullptr || !_COM->isOpen()){ return false; }
-    QDataStream ds(_COM);
-    ds.setFloatingPointPrecision(QDataStream::DoublePrecision);
-    //ds.setByteOrder(QDataStream::LittleEndian);
-    double valuei;
-    for (int j=0; j<4; j++){
-        for (int i=0; i<4; i++){
-            valuei = pose.Get(i,j);
-            ds << valuei;
+        client->readLine();
+        client->write(ROBODK_API_READY_STRING ROBODK_API_LF);
+        transport->Flush(client);
+        for (int r=0; ; r = (r + 1) % _RECORDS.length()){
+            const QByteArray &data = _RECORDS[r].second;
+            switch (_RECORDS[r].first){
+            case ROBODK_TRACE_COMMAND:
+                Served.fetchAndAddRelaxed(1);
+                break;
+            case ROBODK_TRACE_SEND:
+                if (!_wait(client, transport, data.size())){
+                    return;
+                }
+                if (client->read(data.size()) != data){
+                    Mismatches.fetchAndAddRelaxed(1);
+                }
+                break;
+            case ROBODK_TRACE_RECV:
+                client->write(data);
+                transport->Flush(client);
+                break;
+            }
         }
     }
-    return true;
-}
-bool RoboDK::_recv_XYZ(tXYZ pos){
-    if (_COM == nullptr){ return false; }
-    int size = 3*sizeof(double);
-    if (_COM->bytesAvailable() < size){
-        _COM->waitForReadyRead(_TIMEOUT);
-        if (_COM->bytesAvailable() < size){
-            return false;
+
+    /// Wait until size bytes (or a line if size < 0) can be read. Returns false if the client disconnected or the server is stopping.
+    bool _wait(QIODevice *client, RoboDKTransport *transport, qint64 size){
+        while (size < 0 ? !client->canReadLine() : client->bytesAvailable() < size){
+            if (_STOP.loadAcquire() || !transport->Connected(client)){
+                return false;
+            }
+            client->waitForReadyRead(ROBODK_API_CANCEL_POLL);
         }
+        return true;
     }
-    QDataStream ds(_COM);
-    ds.setFloatingPointPrecision(QDataStream::DoublePrecision);
-    //ds.setByteOrder(QDataStream::LittleEndian);
-    double valuei;
-    for (int i=0; i<3; i++){
-        ds >> valuei;
-        pos[i] = valuei;
-    }
-    return true;
-}
-bool RoboDK::_send_XYZ(const tXYZ pos){
-    if (_COM == nullptr || !_COM->isOpen()){ return false; }
-    QDataStream ds(_COM);
-    ds.setFloatingPointPrecision(QDataStream::DoublePrecision);
-    //ds.setByteOrder(QDataStream::LittleEndian);
-    double valuei;
-    for (int i=0; i<3; i++){
-        valuei = pos[i];
-        ds << valuei;
+
+    QList<QPair<char, QByteArray> > _RECORDS;
+    bool _LOCAL;
+    QAtomicInt _STOP;
+};
+
+RoboDKReplay::RoboDKReplay(const QString &trace_file) :
+    _SERVER(nullptr)
+{
+    if (!trace_file.isEmpty()){
+        Load(trace_file);
     }
-    return true;
 }
-bool RoboDK::_recv_Array(tJoints *jnts){
-    return _recv_Array(jnts->_Values, &(jnts->_nDOFs));
-}
-bool RoboDK::_send_Array(const tJoints *jnts){
-    if (jnts == nullptr){
-        return _send_Int(0);
-    }
-    return _send_Array(jnts->_Values, jnts->_nDOFs);
+
+RoboDKReplay::~RoboDKReplay(){
+    Close();
 }
-bool RoboDK::_send_Array(const Mat *mat){
-    if (mat == nullptr){
-        return _send_Int(0);
+
+bool RoboDKReplay::Load(const QString &trace_file){
+    if (_SERVER != nullptr){
+        qDebug() << "RoboDKReplay: the trace can not be loaded while listening";
+        return false;
     }
-    double m44[16];
-    for (int c=0; c<4; c++){
-        for (int r=0; r<4; r++){
-            m44[c*4+r] = mat->Get(r,c);
-        }
+    QFile file(trace_file);
+    if (!file.open(QFile::ReadOnly)){
+        qDebug() << "RoboDKReplay: Can not open file " << trace_file;
+        return false;
     }
-    return _send_Array(m44, 16);
-}
-bool RoboDK::_recv_Array(double *values, int *psize){
-    int nvalues = _recv_Int();
-    if (_COM == nullptr || nvalues < 0) {return false;}
-    if (psize != nullptr){
-        *psize = nvalues;
+    QByteArray trace = file.readAll();
+    file.close();
+    const int header_size = sizeof(ROBODK_TRACE_MAGIC) - 1 + sizeof(quint32);
+    if (trace.size() < header_size || !trace.startsWith(ROBODK_TRACE_MAGIC)
+            || qFromBigEndian<quint32>((const uchar*) trace.constData() + header_size - sizeof(quint32)) != ROBODK_TRACE_VERSION){
+        qDebug() << "RoboDKReplay: Invalid trace file " << trace_file;
+        return false;
     }
-    if (nvalues < 0 || nvalues > 50){return false;} //check if the value is not too big
-    int size = nvalues*sizeof(double);
-    if (_COM->bytesAvailable() < size){
-        _COM->waitForReadyRead(_TIMEOUT);
-        if (_COM->bytesAvailable() < size){
-            return false;
+    QList<QPair<char, QByteArray> > records;
+    bool sends = false;
+    int pos = header_size;
+    while (pos < trace.size()){
+        if (trace.size() - pos < 1 + (int) sizeof(quint32)){
+            break;
+        }
+        char type = trace.at(pos);
+        quint32 size = qFromBigEndian<quint32>((const uchar*) trace.constData() + pos + 1);
+        pos += 1 + sizeof(quint32);
+        if (size > (quint32) (trace.size() - pos)){
+            break;
         }
+        records.append(qMakePair(type, trace.mid(pos, size)));
+        sends = sends || type == ROBODK_TRACE_SEND;
+        pos += size;
     }
-    QDataStream ds(_COM);
-    ds.setFloatingPointPrecision(QDataStream::DoublePrecision);
-    //ds.setByteOrder(QDataStream::LittleEndian);
-    double valuei;
-    for (int i=0; i<nvalues; i++){
-        ds >> valuei;
-        values[i] = valuei;
+    if (pos != trace.size() || !sends){
+        qDebug() << "RoboDKReplay: Invalid trace file " << trace_file;
+        return false;
     }
+    _RECORDS = records;
     return true;
 }
-bool RoboDK::_send_Array(const double *values, int nvalues){
-    if (_COM == nullptr || !_COM->isOpen()){ return false; }
-    if (!_send_Int((qint32)nvalues)){ return false; }
-    QDataStream ds(_COM);
-    ds.setFloatingPointPrecision(QDataStream::DoublePrecision);
-    //ds.setByteOrder(QDataStream::LittleEndian);
-    double valuei;
-    for (int i=0; i<nvalues; i++){
-        valuei = values[i];
-        ds << valuei;
+
+bool RoboDKReplay::Listen(int port, bool local){
+    Close();
+    if (_RECORDS.isEmpty()){
+        qDebug() << "RoboDKReplay: No trace loaded";
+        return false;
+    }
+    if (local && port <= 0){
+        port = ROBODK_DEFAULT_PORT;
     }
+    ReplayServer *server = new ReplayServer(_RECORDS, port, local);
+    server->start();
+    server->Started.acquire();
+    if (!server->Listening){
+        qDebug() << "RoboDKReplay: Could not listen on port " << port;
+        delete server;
+        return false;
+    }
+    _SERVER = server;
     return true;
 }
-bool RoboDK::_recv_Matrix2D(tMatrix2D **mat){ // needs to delete after!
-    qint32 dim1 = _recv_Int();
-    qint32 dim2 = _recv_Int();
-    *mat = Matrix2D_Create();
-    //emxInit_real_T(mat, 2);
-    if (dim1 < 0 || dim2 < 0){ return false; }
-    Matrix2D_Set_Size(*mat, dim1, dim2);
-    if (dim1*dim2 <= 0){
-        return true;
-    }
-    QByteArray buffer;
-    int count = 0;
-    double value;
-    while (true){
-        int remaining = dim1*dim2 - count;
-        if (remaining <= 0){ return true; }
-        if (_COM->bytesAvailable() <= 0 && !_COM->waitForReadyRead(_TIMEOUT)){
-            Matrix2D_Delete(mat);
-            return false;
-        }
-        buffer.append(_COM->read(remaining * sizeof(double) - buffer.size()));
-        int np = buffer.size() / sizeof(double);
-        QDataStream indata(buffer);
-        indata.setFloatingPointPrecision(QDataStream::DoublePrecision);
-        for (int i=0; i<np; i++){
-            indata >> value;
-            (*mat)->data[count] = value;
-            count = count + 1;
-        }
-        buffer = buffer.mid(np * sizeof(double));
+
+void RoboDKReplay::Close(){
+    delete _SERVER;
+    _SERVER = nullptr;
+}
+
+int RoboDKReplay::Port() const {
+    if (_SERVER == nullptr){
+        return -1;
     }
-    return false;// we should never arrive here...
+    return static_cast<ReplayServer*>(_SERVER)->Port;
 }
-bool RoboDK::_send_Matrix2D(tMatrix2D *mat){
-    if (_COM == nullptr || !_COM->isOpen()){ return false; }
-    QDataStream ds(_COM);
-    ds.setFloatingPointPrecision(QDataStream::DoublePrecision);
-    //ds.setByteOrder(QDataStream::LittleEndian);
-    qint32 dim1 = Matrix2D_Size(mat, 1);
-    qint32 dim2 = Matrix2D_Size(mat, 2);
-    bool ok1 = _send_Int(dim1);
-    bool ok2 = _send_Int(dim2);
-    if (!ok1 || !ok2) {return false; }
-    double valuei;
-    for (int j=0; j<dim2; j++){
-        for (int i=0; i<dim1; i++){
-            valuei = Matrix2D_Get_ij(mat, i, j);
-            ds << valuei;
+
+QStringList RoboDKReplay::Commands() const {
+    QStringList commands;
+    for (int i=0; i<_RECORDS.length(); i++){
+        if (_RECORDS[i].first == ROBODK_TRACE_COMMAND){
+            commands.append(QString::fromUtf8(_RECORDS[i].second));
         }
     }
-    return true;
+    return commands;
 }
-// private move type, to be used by public methods (MoveJ  and MoveL)
-void RoboDK::_moveX(const Item *target, const tJoints *joints, const Mat *mat_target, const Item *itemrobot, int movetype, bool blocking){
-    itemrobot->WaitMove();
-    _send_Line("MoveX");
-    _send_Int(movetype);
-    if (target != nullptr){
-        _send_Int(3);
-        _send_Array((tJoints*)nullptr);
-        _send_Item(target);
-    } else if (joints != nullptr){
-        _send_Int(1);
-        _send_Array(joints);
-        _send_Item(nullptr);
-    } else if (mat_target != nullptr){// && mat_target.IsHomogeneous()) {
-        _send_Int(2);
-        _send_Array(mat_target); // keep it as array!
-        _send_Item(nullptr);
-    } else {
-        //throw new RDKException("Invalid target type"); //raise Exception('Problems running function');
-        throw 0;
-    }
-    _send_Item(itemrobot);
-    _check_status();
-    if (blocking){
-        itemrobot->WaitMove();
+
+int RoboDKReplay::Served() const {
+    if (_SERVER == nullptr){
+        return 0;
     }
+    return static_cast<ReplayServer*>(_SERVER)->Served.load();
 }
-// private move type, to be used by public methods (MoveJ  and MoveL)
-void RoboDK::_moveC(const Item *target1, const tJoints *joints1, const Mat *mat_target1, const Item *target2, const tJoints *joints2, const Mat *mat_target2, const Item *itemrobot, bool blocking){
-    itemrobot->WaitMove();
-    _send_Line("MoveC");
-    _send_Int(3);
-    if (target1 != nullptr){
-        _send_Int(3);
-        _send_Array((tJoints*)nullptr);
-        _send_Item(target1);
-    } else if (joints1 != nullptr) {
-        _send_Int(1);
-        _send_Array(joints1);
-        _send_Item(nullptr);
-    } else if (mat_target1 != nullptr){// && mat_target1.IsHomogeneous()) {
-        _send_Int(2);
-        _send_Array(mat_target1);
-        _send_Item(nullptr);
-    } else {
-        throw 0;
-        //throw new RDKException("Invalid type of target 1");
-    }
-    /////////////////////////////////////
-    if (target2 != nullptr) {
-        _send_Int(3);
-        _send_Array((tJoints*)nullptr);
-        _send_Item(target2);
-    } else if (joints2 != nullptr) {
-        _send_Int(1);
-        _send_Array(joints2);
-        _send_Item(nullptr);
-    } else if (mat_target2 != nullptr){// && mat_target2.IsHomogeneous()) {
-        _send_Int(2);
-        _send_Array(mat_target2);
-        _send_Item(nullptr);
-    } else {
-        throw 0;
-        //throw new RDKException("Invalid type of target 2");
-    }
-    /////////////////////////////////////
-    _send_Item(itemrobot);
-    _check_status();
-    if (blocking){
-        itemrobot->WaitMove();
+
+int RoboDKReplay::Mismatches() const {
+    if (_SERVER == nullptr){
+        return 0;
     }
+    return static_cast<ReplayServer*>(_SERVER)->Mismatches.load();
 }
 
 
 
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// RoboDKTracer CLASS ////////////////////////////////////////////////
+
+// Quote a string for the trace file (JSON)
+static QString Tracer_Quote(const QString &str){
+    QString quoted("\"");
+    for (int i=0; i<str.length(); i++){
+        QChar c = str.at(i);
+        if (c == '"' || c == '\\'){
+            quoted.append('\\');
+            quoted.append(c);
+        } else if (c.unicode() < 0x20){
+            quoted.append(QString("\\u%1").arg((int) c.unicode(), 4, 16, QChar('0')));
+        } else {
+            quoted.append(c);
+        }
+    }
+    quoted.append('"');
+    return quoted;
+}
 
+RoboDKTracer::RoboDKTracer(const QString &trace_file) :
+    _FILE(new QFile(trace_file)),
+    _PID(QCoreApplication::applicationPid())
+{
+    if (!_FILE->open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        qDebug() << "Unable to create trace file" << trace_file;
+        delete _FILE;
+        _FILE = nullptr;
+        return;
+    }
+    _FILE->write("[");
+    _CLOCK.start();
+}
 
+RoboDKTracer::~RoboDKTracer(){
+    Close();
+}
 
+bool RoboDKTracer::IsOpen() const {
+    QMutexLocker lock(&_MUTEX);
+    return _FILE != nullptr;
+}
 
+void RoboDKTracer::Close(){
+    QMutexLocker lock(&_MUTEX);
+    if (_FILE == nullptr){
+        return;
+    }
+    _FILE->write("\n]\n");
+    _FILE->close();
+    delete _FILE;
+    _FILE = nullptr;
+}
 
+qint64 RoboDKTracer::Now() const {
+    return _CLOCK.nsecsElapsed();
+}
 
-
-
+void RoboDKTracer::Complete(const QString &name, const QString &category, qint64 start_ns, qint64 end_ns, const QString &args){
+    QMutexLocker lock(&_MUTEX);
+    if (_FILE == nullptr){
+        return;
+    }
+    int tid = _thread_id();
+    // timestamps are given in microseconds
+    QString event = QString("%1\n{\"name\":%2,\"cat\":%3,\"ph\":\"X\",\"pid\":%4,\"tid\":%5,\"ts\":%6,\"dur\":%7")
+            .arg(_FILE->pos() > 1 ? "," : "")
+            .arg(Tracer_Quote(name)).arg(Tracer_Quote(category)).arg(_PID).arg(tid)
+            .arg(start_ns / 1000.0, 0, 'f', 3).arg(qMax(end_ns - start_ns, (qint64) 0) / 1000.0, 0, 'f', 3);
+    if (!args.isEmpty()){
+        event.append(",\"args\":{" + args + "}");
+    }
+    event.append("}");
+    _FILE->write(event.toUtf8());
+}
+
+// Trace id of the calling thread. The first event of each thread is preceded by its name. Called with the mutex locked.
+int RoboDKTracer::_thread_id(){
+    Qt::HANDLE handle = QThread::currentThreadId();
+    QHash<Qt::HANDLE, int>::const_iterator it = _THREADS.constFind(handle);
+    if (it != _THREADS.constEnd()){
+        return it.value();
+    }
+    int tid = _THREADS.size() + 1;
+    _THREADS.insert(handle, tid);
+    QString name = QThread::currentThread()->objectName();
+    if (name.isEmpty()){
+        name = QString("Thread %1").arg(tid);
+    }
+    QString meta = QString("%1\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%2,\"tid\":%3,\"args\":{\"name\":%4}}")
+            .arg(_FILE->pos() > 1 ? "," : "").arg(_PID).arg(tid).arg(Tracer_Quote(name));
+    _FILE->write(meta.toUtf8());
+    return tid;
+}
 
 
 //---------------------------------------------------------------------------------------------------
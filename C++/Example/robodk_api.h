@@ -38,6 +38,8 @@
 //     to avoid using the RoboDK_API namespace
 //  2- Add #define RDK_WITH_EXPORTS  (and RDK_EXPORTS)
 //     to generate/import as a DLL
+//  3- Add #define RDK_SKIP_QTGUI
+//     to build without QtGui (Mat can't be converted to/from QMatrix4x4)
 //---------------------------------------------
 
 
@@ -259,11 +261,27 @@
 
 
 #include <QtCore/QString>
-#include <QtGui/QMatrix4x4> // this should not be part of the QtGui! it is just a matrix
+#include <QtCore/QStringList>
+#include <QtCore/QList>
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QObject>
+#include <QtCore/QFuture>
 #include <QDebug>
+#include <functional>
 
 
 class QTcpSocket;
+class QIODevice;
+class QLocalServer;
+class QFile;
+class QThread;
+class QMatrix4x4;
 
 
 #ifndef RDK_SKIP_NAMESPACE
@@ -275,6 +293,18 @@ namespace RoboDK_API {
 
 class Item;
 class RoboDK;
+class RoboDKPool;
+class RoboDKLease;
+class DeadlineScope;
+class RoboDKAsync;
+class RoboDKTransport;
+class RoboDKRelay;
+class RoboDKReplay;
+class RoboDKTracer;
+class RoboDKInstancePool;
+class MotionQueue;
+class ProgramBuilder;
+struct tAsyncRequest;
 
 
 /// maximum size of robot joints (maximum allowed degrees of freedom for a robot)
@@ -378,6 +408,170 @@ struct tMatrix2D {
 
 
 
+/// \brief The tPipelineError struct holds the status of a command that failed while the pipelined mode was active (see RoboDK::PipelineStart) or of a movement that failed in a \ref MotionQueue.
+struct tPipelineError {
+    /// Index of the command since the pipeline was started (0 for the first command). For a MotionQueue, index of the movement in the queue. For a ProgramBuilder, index of the instruction.
+    int index;
+
+    /// Command name (first line sent to RoboDK, such as S_Hlocal)
+    QString command;
+
+    /// Status returned by RoboDK (2 is a warning, other values are errors)
+    int status;
+
+    /// Message returned by RoboDK
+    QString message;
+};
+
+
+/// \brief The tInstanceJobResult struct holds the result of a job run by a RoboDKInstancePool.
+struct tInstanceJobResult {
+    /// Job index
+    int job;
+
+    /// Index of the instance that ran the job (-1 if the job did not run)
+    int instance;
+
+    /// Value returned by the job (false if the job threw an exception)
+    bool ok;
+
+    /// Time spent running the job, in ms
+    qint64 elapsed;
+};
+
+
+/// \brief The tStartupTiming struct holds the phases of the last connection of a RoboDK link (see RoboDK::StartupTiming).
+/// Times are in ms since the connection started, -1 if the phase did not happen.
+struct tStartupTiming {
+    /// The first connection attempt finished (RoboDK was already running if started is false)
+    qint64 probe;
+
+    /// The RoboDK process was started
+    qint64 spawn;
+
+    /// First byte received from RoboDK (answer to the start string)
+    qint64 first_byte;
+
+    /// READY handshake completed: the link is connected
+    qint64 ready;
+
+    /// Number of connection attempts
+    int attempts;
+
+    /// True if RoboDK was started by this link
+    bool started;
+};
+
+
+/// \brief The LatencyHistogram class counts durations (in us) in logarithmic buckets split in 16 linear sub-buckets, like an HDR histogram.
+/// Values are kept with a resolution of about 6% from 1 us to more than one hour, using a fixed amount of memory.
+class ROBODK LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    /// Add a duration (us)
+    void Record(qint64 us);
+
+    /// Add the values of another histogram
+    void Add(const LatencyHistogram &other);
+
+    void Reset();
+
+    /// Number of values
+    quint64 Count() const;
+
+    /// Smallest value (us), 0 if empty
+    qint64 Min() const;
+
+    /// Largest value (us), 0 if empty
+    qint64 Max() const;
+
+    /// Average value (us), 0 if empty
+    double Mean() const;
+
+    /// <summary>
+    /// Returns the value below which the given percentage of the values fall (upper bound of its bucket).
+    /// </summary>
+    /// <param name="percentile">Percentile from 0 to 100</param>
+    /// <returns>Value in us, 0 if empty</returns>
+    qint64 Percentile(double percentile) const;
+
+private:
+    enum {
+        SUB_BUCKETS = 16,
+        BUCKETS = 30 * SUB_BUCKETS
+    };
+    static int _bucket(qint64 us);
+    static qint64 _upper(int bucket);
+
+    quint64 _COUNTS[BUCKETS];
+    quint64 _COUNT;
+    qint64 _MIN;
+    qint64 _MAX;
+    double _SUM;
+};
+
+
+/// \brief The tCommandStats struct holds the statistics of an API command (see RoboDK::setStats).
+/// A call is split in three phases: send (the request is built and written), wait (until the first byte of the response) and recv (until the last byte).
+struct tCommandStats {
+    /// Command name (first line sent by the call)
+    QString command;
+
+    /// Number of calls
+    quint64 calls;
+
+    /// Number of requests sent by the calls (more than calls if some calls send several requests at once)
+    quint64 requests;
+
+    /// Bytes sent
+    quint64 bytes_out;
+
+    /// Bytes received
+    quint64 bytes_in;
+
+    LatencyHistogram send;
+    LatencyHistogram wait;
+    LatencyHistogram recv;
+
+    /// Duration of the whole call
+    LatencyHistogram total;
+};
+
+
+/// \brief The tProgramInstructions struct holds instructions of a program as a structure of arrays (see Item::Instructions).
+/// Instruction i of the program is first + i. Each name is stored once in names, instructions refer to it with name_id.
+struct tProgramInstructions {
+    /// Index of the first instruction in the program
+    int first;
+
+    /// Index of the name of each instruction in names
+    QVector<qint32> name_id;
+
+    /// Distinct instruction names
+    QStringList names;
+
+    /// Instruction type (RoboDK::INS_TYPE_*)
+    QVector<qint32> type;
+
+    /// Movement type (RoboDK::MOVE_TYPE_*, 0 if the instruction is not a movement)
+    QVector<qint32> move_type;
+
+    /// 1 if the movement has a joint target, 0 for a pose target or if the instruction is not a movement
+    QVector<quint8> joint_target;
+
+    /// Pose of the target of each instruction: 16 doubles per instruction in column-major order (same as Mat::ValuesD), zeros if the instruction is not a movement
+    QVector<double> poses;
+
+    /// First value of the joints of each instruction in joints (the joints end where the next instruction starts, no joints if the instruction is not a movement)
+    QVector<qint32> joints_start;
+
+    /// Joints of the targets of all the instructions
+    QVector<double> joints;
+};
+
+
+
 //--------------------- Joints class -----------------------
 
 /// The tJoints class represents a joint position of a robot (robot axes).
@@ -402,6 +596,10 @@ public:
     /// \param jnts
     tJoints(const tJoints &jnts);
 
+    /// \brief Copy the joint values of another object
+    /// \param jnts
+    tJoints &operator=(const tJoints &jnts);
+
     /// \brief Create joint values given a 2D matrix and the column selecting the desired values
     /// \param mat2d
     /// \param column
@@ -503,7 +701,10 @@ public:
 /// n_y & o_y & a_y & y \\
 /// n_z & o_z & a_z & z \\
 /// 0 & 0 & 0 & 1 \end{bmatrix} \f$
-class ROBODK Mat : public QMatrix4x4 {
+/// <br>
+/// Values are stored as doubles in column-major order (same order as the RoboDK protocol and the Values() array).
+/// A Mat can be converted to and from a QMatrix4x4 (single precision) unless RDK_SKIP_QTGUI is defined.
+class ROBODK Mat {
 
 public:
 
@@ -513,13 +714,25 @@ public:
     /// Create a valid or an invalid matrix
     Mat(bool valid);
 
+#ifndef RDK_SKIP_QTGUI
     /// Create a copy of the matrix
     Mat(const QMatrix4x4 &matrix);
 
+    /// Convert to a QMatrix4x4 (single precision)
+    QMatrix4x4 toQMatrix4x4() const;
+
+    /// Convert to a QMatrix4x4 (single precision)
+    explicit operator QMatrix4x4() const;
+#endif
+
     /// \brief Create a copy of the matrix
     /// \param matrix
     Mat(const Mat &matrix);
 
+    /// \brief Copy the values of another matrix
+    /// \param matrix
+    Mat &operator=(const Mat &matrix);
+
     /// <summary>
     /// Matrix class constructor for a 4x4 homogeneous matrix given N, O, A & T vectors
     /// </summary>
@@ -614,9 +827,49 @@ public:
     /// \return value
     double Get(int r, int c) const;
 
-    /// Invert the pose (homogeneous matrix assumed)
+    /// Invert the pose (homogeneous matrix assumed): the rotation is transposed and the translation becomes -R^T*t.
     Mat inv() const;
 
+    /// \brief Invert a general 4x4 matrix (same as QMatrix4x4::inverted). Use inv() for poses, it is faster and more accurate.
+    /// \param invertible Optionally returns false if the matrix can't be inverted (the identity matrix is returned)
+    Mat inverted(bool *invertible = nullptr) const;
+
+    /// Set the identity matrix
+    void setToIdentity();
+
+    /// Multiply this matrix by a translation (same as QMatrix4x4::translate)
+    void translate(double x, double y, double z);
+
+    /// Multiply this matrix by a rotation of angle degrees around the vector (x,y,z) (same as QMatrix4x4::rotate)
+    void rotate(double angle, double x, double y, double z);
+
+    /// Multiply 2 matrices (pose composition)
+    Mat operator*(const Mat &mat) const;
+
+    /// Multiply this matrix by another matrix (pose composition)
+    Mat &operator*=(const Mat &mat);
+
+    /// Returns true if all values are equal
+    bool operator==(const Mat &mat) const;
+
+    /// Returns true if any value is different
+    bool operator!=(const Mat &mat) const;
+
+    /// Access a matrix value given the row and the column
+    double &operator()(int r, int c);
+
+    /// Get a matrix value given the row and the column
+    double operator()(int r, int c) const;
+
+    /// Pointer to the 16 values (column-major order)
+    double *data();
+
+    /// Pointer to the 16 values (column-major order)
+    const double *data() const;
+
+    /// Pointer to the 16 values (column-major order)
+    const double *constData() const;
+
     /// Returns true if the matrix is homogeneous, otherwise it returns false
     bool isHomogeneous() const;
 
@@ -668,21 +921,19 @@ public:
     /// Get a pointer to the 16-digit double array.
     const double* ValuesD() const;
 
-    /// Get a pointer to the 16-digit array as an array of floats.
-    const float* ValuesF() const;
+    /// Copy the 16-digit array to an array of floats (the matrix is stored as doubles, see ValuesD).
+    void ValuesF(float values[16]) const;
 
-#ifdef ROBODK_API_FLOATS
-    /// Get a pointer to the 16-digit array (doubles or floats if ROBODK_API_FLOATS is defined).
-    const float* Values() const;
-#else
-    /// Get a pointer to the 16-digit array (doubles or floats if ROBODK_API_FLOATS is defined).
+#ifndef ROBODK_API_FLOATS
+    /// Get a pointer to the 16-digit double array (same as ValuesD).
+    /// It is not available if ROBODK_API_FLOATS is defined: the matrix is stored as doubles, use ValuesF to get a copy as floats.
     const double* Values() const;
 #endif
 
     /// Copy the 16-values of the 4x4 matrix to a double array.
     void Values(double values[16]) const;
 
-    /// Copy the 16-values of the 4x4 matrix to a double array.
+    /// Copy the 16-values of the 4x4 matrix to a float array.
     void Values(float values[16]) const;
 
     /// Check if the matrix is valid
@@ -743,14 +994,293 @@ public:
     static Mat rotz(double rz);
 
 private:
+    /// Matrix values (column-major order)
+    double _data[16];
+
     /// Flags if a matrix is not valid.
-    double _valid;
+    bool _valid;
+
+};
+
+/// \brief The Kinematics class computes the forward kinematics of a serial robot locally, without a round trip to RoboDK.
+/// The kinematic chain is stored as the axis of each joint and the pose of the robot flange with all joints at 0 (product of exponentials).
+/// This is equivalent to the DH/DHM table of the robot. Use Item::getKinematics to retrieve the kinematics of a robot in the station:
+/// they are retrieved once per robot and kept by the RoboDK link.
+/// Large batches of joints are evaluated in blocks (vectorized) and split among the threads of the global QThreadPool.
+/// The inverse kinematics are solved in closed form for 6 axis robots with joints 2 and 3 parallel and a spherical wrist (see CanSolveIK).
+/// \code
+/// Kinematics kin = robot.getKinematics();
+/// QList<Mat> poses = kin.SolveFK(joint_list); // one joint vector per column
+/// QList<tJoints> solutions = kin.SolveIK_All(poses[0]);
+/// \endcode
+class ROBODK Kinematics {
+    friend class RoboDK_API::RoboDK;
+
+public:
+    Kinematics();
+
+    /// <summary>
+    /// Returns true if the kinematics can be used to compute the forward kinematics (at least one joint and a valid flange pose).
+    /// </summary>
+    bool Valid() const;
+
+    /// <summary>
+    /// Number of joints (degrees of freedom).
+    /// </summary>
+    int DOFs() const;
+
+    /// <summary>
+    /// Remove all the joints.
+    /// </summary>
+    void clear();
+
+    /// <summary>
+    /// Add a joint at the end of the kinematic chain. The axis and the point are given with respect to the robot base with all joints at 0.
+    /// </summary>
+    /// <param name="axis">Joint axis (unit vector). Positive joint values rotate counterclockwise around this axis (right hand rule) or translate along this axis</param>
+    /// <param name="point">Point of the joint axis (mm), ignored for prismatic joints</param>
+    /// <param name="prismatic">Set to true for a linear joint (mm), false for a rotative joint (deg)</param>
+    /// <returns>True if successful, false if the maximum number of joints was reached or the axis is not valid</returns>
+    bool addJoint(const tXYZ axis, const tXYZ point, bool prismatic = false);
+
+    /// <summary>
+    /// Set the pose of the robot flange with respect to the robot base with all joints at 0.
+    /// </summary>
+    void setHome(const Mat &flange);
+
+    /// <summary>
+    /// Set the kinematics from a DHM table (modified Denavit Hartenberg). All joints are rotative.
+    /// </summary>
+    /// <param name="dhm">DHM table as a 4xn matrix: one column [alpha(deg), a(mm), theta(deg), d(mm)] per joint</param>
+    /// <param name="base">Pose of the first joint frame with respect to the robot base</param>
+    /// <param name="tool">Pose of the robot flange with respect to the last joint frame</param>
+    /// <returns>True if successful</returns>
+    bool setDHM(const tMatrix2D *dhm, const Mat &base = Mat(), const Mat &tool = Mat());
+
+    /// <summary>
+    /// Retrieve the axis of a joint (see addJoint).
+    /// </summary>
+    /// <param name="joint">Joint index (0 for the first joint)</param>
+    /// <param name="axis">Joint axis (unit vector)</param>
+    /// <param name="point">Point of the joint axis (mm)</param>
+    /// <returns>True if the joint is prismatic, false if it is rotative</returns>
+    bool JointAxis(int joint, tXYZ axis, tXYZ point = nullptr) const;
+
+    /// <summary>
+    /// Returns the pose of the robot flange with respect to the robot base with all joints at 0.
+    /// </summary>
+    Mat Home() const;
+
+    /// <summary>
+    /// Computes the forward kinematics for the provided joints (same result as Item::SolveFK).
+    /// </summary>
+    /// <param name="joints">Robot joints</param>
+    /// <param name="tool">Optionally provide a tool pose, otherwise, the robot flange is used</param>
+    /// <param name="ref">Optionally provide a reference pose, otherwise, the robot base is used</param>
+    /// <returns>4x4 homogeneous matrix: pose of the robot flange (or tool) with respect to the robot base (or reference)</returns>
+    Mat SolveFK(const tJoints &joints, const Mat *tool = nullptr, const Mat *ref = nullptr) const;
+
+    /// <summary>
+    /// Computes the forward kinematics for a list of joints.
+    /// </summary>
+    /// <param name="joint_list">Joint list: one joint vector per column (extra rows are ignored)</param>
+    /// <param name="tool">Optionally provide a tool pose, otherwise, the robot flange is used</param>
+    /// <param name="ref">Optionally provide a reference pose, otherwise, the robot base is used</param>
+    /// <param name="threads">Maximum number of threads (0 to use QThread::idealThreadCount)</param>
+    /// <returns>List of poses, one for each column</returns>
+    QList<Mat> SolveFK(const tMatrix2D *joint_list, const Mat *tool = nullptr, const Mat *ref = nullptr, int threads = 0) const;
+
+    /// <summary>
+    /// Computes the forward kinematics for an array of joint vectors. This is the fastest form for large batches.
+    /// </summary>
+    /// <param name="joints">Joint vectors (deg or mm), the first DOFs() values of each vector are used</param>
+    /// <param name="stride">Distance between consecutive joint vectors (number of doubles, at least DOFs())</param>
+    /// <param name="count">Number of joint vectors</param>
+    /// <param name="poses">Resulting poses: 16 x count doubles, each pose in column-major order (same as Mat::ValuesD)</param>
+    /// <param name="tool">Optionally provide a tool pose, otherwise, the robot flange is used</param>
+    /// <param name="ref">Optionally provide a reference pose, otherwise, the robot base is used</param>
+    /// <param name="threads">Maximum number of threads (0 to use QThread::idealThreadCount)</param>
+    /// <returns>True if successful</returns>
+    bool SolveFK(const double *joints, int stride, int count, double *poses, const Mat *tool = nullptr, const Mat *ref = nullptr, int threads = 0) const;
+
+    /// <summary>
+    /// Set the joint limits used by the inverse kinematics: solutions outside the limits are discarded. Provide empty joints to remove the limits.
+    /// </summary>
+    void setJointLimits(const tJoints &lower_limits, const tJoints &upper_limits);
+
+    /// <summary>
+    /// Retrieve the joint limits used by the inverse kinematics (empty joints if no limits are set).
+    /// </summary>
+    void JointLimits(tJoints *lower_limits, tJoints *upper_limits) const;
+
+    /// <summary>
+    /// Returns true if the inverse kinematics can be solved in closed form: 6 rotative joints, joints 2 and 3 parallel and joints 4, 5 and 6 intersecting in one point (spherical wrist).
+    /// </summary>
+    bool CanSolveIK() const;
+
+    /// <summary>
+    /// Returns the robot configuration state for a set of robot joints (same as Item::JointsConfig).
+    /// </summary>
+    /// <param name="joints">Robot joints</param>
+    /// <param name="config">Configuration status as [REAR, LOWERARM, FLIP]</param>
+    void JointsConfig(const tJoints &joints, tConfig config) const;
+
+    /// <summary>
+    /// Computes the inverse kinematics: all solutions within the joint limits (up to 8). Use JointsConfig to retrieve the configuration of each solution.
+    /// </summary>
+    /// <param name="pose">Pose of the robot flange (or tool) with respect to the robot base (or reference)</param>
+    /// <param name="tool">Optionally provide a tool pose, otherwise, the robot flange is used</param>
+    /// <param name="ref">Optionally provide a reference pose, otherwise, the robot base is used</param>
+    /// <returns>List of joint solutions (empty if the pose can't be reached)</returns>
+    QList<tJoints> SolveIK_All(const Mat &pose, const Mat *tool = nullptr, const Mat *ref = nullptr) const;
+
+    /// <summary>
+    /// Computes the inverse kinematics: returns the solution closest to the provided joints,
+    /// that is the solution with the smallest maximum joint move (deg). The first solution is kept if several solutions are as close.
+    /// </summary>
+    /// <param name="pose">Pose of the robot flange (or tool) with respect to the robot base (or reference)</param>
+    /// <param name="joints_approx">Approximate solution</param>
+    /// <param name="tool">Optionally provide a tool pose, otherwise, the robot flange is used</param>
+    /// <param name="ref">Optionally provide a reference pose, otherwise, the robot base is used</param>
+    /// <returns>Robot joints (not valid if the pose can't be reached)</returns>
+    tJoints SolveIK(const Mat &pose, const tJoints &joints_approx, const Mat *tool = nullptr, const Mat *ref = nullptr) const;
+
+    /// <summary>
+    /// Computes the inverse kinematics for an array of poses (all solutions). This is the fastest form for large batches.
+    /// </summary>
+    /// <param name="poses">Poses: 16 x count doubles, each pose in column-major order (same as Mat::ValuesD)</param>
+    /// <param name="count">Number of poses</param>
+    /// <param name="solutions">Resulting joints: 8 x 6 x count doubles. Up to 8 solutions of 6 joints for each pose, the valid solutions come first</param>
+    /// <param name="nsolutions">Number of solutions of each pose (count values)</param>
+    /// <param name="configs">Optionally retrieve the configuration of each solution (8 x count values): bit 0 is REAR, bit 1 is LOWERARM and bit 2 is FLIP</param>
+    /// <param name="tool">Optionally provide a tool pose, otherwise, the robot flange is used</param>
+    /// <param name="ref">Optionally provide a reference pose, otherwise, the robot base is used</param>
+    /// <param name="threads">Maximum number of threads (0 to use QThread::idealThreadCount)</param>
+    /// <returns>True if successful</returns>
+    bool SolveIK(const double *poses, int count, double *solutions, int *nsolutions, int *configs = nullptr, const Mat *tool = nullptr, const Mat *ref = nullptr, int threads = 0) const;
+
+private:
+    void _solveFK(const double *joints, int stride, int count, double *poses, const Mat &flange, const Mat &ref_inv) const;
+    void _solveIK(const double *poses, int count, double *solutions, int *nsolutions, int *configs, const Mat &tool_inv, const Mat &ref) const;
+
+    /// Number of joints
+    int _nDOFs;
+
+    /// Joint axes and points with all joints at 0 (with respect to the robot base)
+    double _AXIS[RDK_SIZE_JOINTS_MAX][3];
+    double _POINT[RDK_SIZE_JOINTS_MAX][3];
+    bool _PRISMATIC[RDK_SIZE_JOINTS_MAX];
+
+    /// Flange pose with all joints at 0
+    Mat _HOME;
+
+    /// Joint limits used by the inverse kinematics
+    tJoints _LOWER_LIMITS;
+    tJoints _UPPER_LIMITS;
+
+    /// Configuration flags to invert to match RoboDK (bit 0 is REAR, bit 1 is LOWERARM and bit 2 is FLIP)
+    int _CONFIG_MASK;
+
+    /// Set if the inverse kinematics did not match RoboDK
+    bool _IK_DISABLED;
+};
+
+/// \brief The CancelToken class cancels the calls of a RoboDK link from any thread (see RoboDK::setDeadline).
+/// Copies of a token share the same state: keep a copy in the supervisor thread and call Cancel() to abort the calls that use it.
+class ROBODK CancelToken {
+public:
+    CancelToken();
+
+    /// <summary>
+    /// Cancel the calls that use this token. Waiting calls return within a few milliseconds. This function is thread safe.
+    /// </summary>
+    void Cancel();
+
+    /// <summary>
+    /// Clear the cancelled state so that the token can be used again.
+    /// </summary>
+    void Reset();
+
+    /// <summary>
+    /// Check if Cancel() was called.
+    /// </summary>
+    bool Cancelled() const;
+
+private:
+    QSharedPointer<QAtomicInt> _STATE;
+};
+
+/// \brief The RoboDKTransport class opens the byte stream used by a RoboDK link to talk to the RoboDK API server.
+/// The default transport is TCP (TcpTransport). A transport can be shared by several links (see the RoboDK constructor).
+class ROBODK RoboDKTransport {
+public:
+    virtual ~RoboDKTransport();
+
+    /// <summary>
+    /// Open a stream to the RoboDK API server. The link sends the RoboDK start string once the stream is open and deletes the stream when it disconnects.
+    /// </summary>
+    /// <param name="robodk_ip">IP of the RoboDK API server (empty for localhost)</param>
+    /// <param name="com_port">Port of the RoboDK API server</param>
+    /// <param name="timeout_ms">Connection timeout</param>
+    /// <returns>Open stream or nullptr if the connection failed</returns>
+    virtual QIODevice *Open(const QString &robodk_ip, int com_port, int timeout_ms) = 0;
+
+    /// <summary>
+    /// Check if a stream returned by Open is still connected.
+    /// </summary>
+    virtual bool Connected(const QIODevice *stream) const = 0;
+
+    /// <summary>
+    /// Send the data written to a stream returned by Open without waiting for the event loop.
+    /// </summary>
+    virtual void Flush(QIODevice *stream);
+};
+
+/// \brief The TcpTransport class connects to the RoboDK API server with a TCP socket (default transport).
+class ROBODK TcpTransport : public RoboDKTransport {
+public:
+    QIODevice *Open(const QString &robodk_ip, int com_port, int timeout_ms) override;
+    bool Connected(const QIODevice *stream) const override;
+    void Flush(QIODevice *stream) override;
+};
+
+/// \brief The LocalTransport class connects to a RoboDK API server on the same computer with a local socket (QLocalSocket: Unix domain socket or named pipe).
+/// This avoids the TCP stack for every call. The server is usually a RoboDKRelay running next to RoboDK.
+class ROBODK LocalTransport : public RoboDKTransport {
+public:
+    /// <summary>
+    /// Connect to the local server server_name. Leave empty to use RoboDK_API_PORT (for example, RoboDK_API_20500).
+    /// </summary>
+    LocalTransport(const QString &server_name = "");
+
+    QIODevice *Open(const QString &robodk_ip, int com_port, int timeout_ms) override;
+    bool Connected(const QIODevice *stream) const override;
+    void Flush(QIODevice *stream) override;
 
-// this is a dummy variable to easily obtain a pointer to a 16-double-array for matrix multiplications
 private:
-    /// Copy of the data as a double array.
-    double _ddata16[16];
+    QString _SERVER_NAME;
+};
+
+/// \brief The SharedMemoryTransport class exchanges the RoboDK protocol through two ring buffers in shared memory (one per direction).
+/// Large requests and responses (files, 2D matrices, program joints) are copied without system calls. A reader spins on the ring buffer for a short time,
+/// then sleeps until the other side wakes it through the local socket of the relay.
+/// The link creates the shared memory and gives its key to a RoboDKRelay through the local server of the relay. The relay forwards the data to RoboDK.
+/// Note: the relay talks to RoboDK over a localhost TCP connection, so the round trip of a call still includes the TCP stack on the relay side.
+/// This transport saves copies and system calls of the client, the latency of small calls only drops if the relay runs inside the RoboDK process (plugin).
+/// Streams of this transport do not emit readyRead: they can not be used by RoboDKAsync.
+class ROBODK SharedMemoryTransport : public RoboDKTransport {
+public:
+    /// <summary>
+    /// Use ring buffers of ring_size bytes (rounded up to a power of 2) and the relay listening on server_name (empty for RoboDK_API_PORT).
+    /// </summary>
+    SharedMemoryTransport(int ring_size = 4*1024*1024, const QString &server_name = "");
+
+    QIODevice *Open(const QString &robodk_ip, int com_port, int timeout_ms) override;
+    bool Connected(const QIODevice *stream) const override;
 
+private:
+    int _RING_SIZE;
+    QString _SERVER_NAME;
 };
 
 /// <summary>
@@ -760,21 +1290,200 @@ private:
 /// </summary>
 class ROBODK RoboDK {
     friend class RoboDK_API::Item;
+    friend class RoboDK_API::MotionQueue;
+    friend class RoboDK_API::ProgramBuilder;
+    friend class RoboDK_API::RoboDKPool;
+    friend class RoboDK_API::DeadlineScope;
+    friend class RoboDK_API::RoboDKAsync;
+    friend class RoboDK_API::RoboDKInstancePool;
 
 
 public:
     RoboDK(const QString &robodk_ip="", int com_port=-1, const QString &args="", const QString &path="");
+
+    /// <summary>
+    /// Connect to RoboDK with a given transport (for example, LocalTransport or SharedMemoryTransport). Links created from this link (Item::NewLink, RoboDKAsync) use the same transport.
+    /// </summary>
+    RoboDK(QSharedPointer<RoboDKTransport> transport, const QString &robodk_ip="", int com_port=-1, const QString &args="", const QString &path="");
     ~RoboDK();
 
+    /// <summary>
+    /// Returns the transport used by this link.
+    /// </summary>
+    QSharedPointer<RoboDKTransport> Transport() const;
+
     quint64 ProcessID();
     quint64 WindowID();
 
+    /// <summary>
+    /// Returns the timing of the last connection to RoboDK (probing, process start, first byte and READY handshake).
+    /// </summary>
+    tStartupTiming StartupTiming() const;
+
+    /// <summary>
+    /// Start a hidden RoboDK instance without waiting for it to be ready, for example to prepare the instance of the next test while the current test runs.
+    /// Connect to it later with a RoboDK link on the same port: until the instance accepted a link, links created by this process on that port
+    /// probe the port with a backoff (up to 2 minutes) instead of starting another instance (see ConnectWait).
+    /// The instance is not closed when this process ends.
+    /// </summary>
+    /// <param name="com_port">Port of the RoboDK API server of the new instance (-1 for the default port)</param>
+    /// <param name="args">Additional command line arguments</param>
+    /// <param name="path">RoboDK executable (leave empty for the default path)</param>
+    /// <returns>Process ID of the new instance, 0 if it could not be started</returns>
+    static quint64 StartHeadless(int com_port = -1, const QString &args = "", const QString &path = "");
+
     bool Connected();
     bool Connect();
 
+    /// <summary>
+    /// Connect to a RoboDK instance that is starting: the port is probed with an exponential backoff until RoboDK accepts the link. RoboDK is never started.
+    /// </summary>
+    /// <param name="timeout_ms">Maximum time to wait (-1 for 2 minutes)</param>
+    /// <returns>True if the link is connected</returns>
+    bool ConnectWait(int timeout_ms = -1);
+
     void Disconnect();
     void Finish();
 
+    /// <summary>
+    /// Returns the number of socket writes issued since this object was created (or since ResetCommStats() was called).
+    /// Each API command builds its request in a single buffer so this value should match CommCommands().
+    /// </summary>
+    /// <returns>Number of socket writes</returns>
+    quint64 CommWrites() const;
+
+    /// <summary>
+    /// Returns the number of API commands sent since this object was created (or since ResetCommStats() was called).
+    /// </summary>
+    /// <returns>Number of API commands</returns>
+    quint64 CommCommands() const;
+
+    /// <summary>
+    /// Reset the write and command counters (see CommWrites() and CommCommands()).
+    /// </summary>
+    void ResetCommStats();
+
+    /// <summary>
+    /// Collect statistics of the API calls by command: number of calls, bytes sent and received and latency histograms (see tCommandStats).
+    /// The statistics are disabled by default and cost a single test per call when disabled.
+    /// In pipelined mode the statuses of previous commands are counted in the call that reads them.
+    /// </summary>
+    void setStats(bool enable);
+
+    /// <summary>
+    /// Returns true if the statistics are being collected (see setStats).
+    /// </summary>
+    bool StatsEnabled() const;
+
+    /// <summary>
+    /// Returns a snapshot of the statistics of each command, sorted by command name.
+    /// </summary>
+    QList<tCommandStats> Stats();
+
+    /// <summary>
+    /// Clear the statistics.
+    /// </summary>
+    void ResetStats();
+
+    /// <summary>
+    /// Returns the statistics as a text table (one line per command, times in us).
+    /// </summary>
+    QString StatsText();
+
+    /// <summary>
+    /// Returns the statistics as a JSON array (one object per command, times in us).
+    /// </summary>
+    QString StatsJson();
+
+    /// <summary>
+    /// Write the calls of this link to a RoboDKTracer: each call is an event named after its command and the blocking waits for RoboDK are nested inside it.
+    /// Several links may share the same tracer. Set a null pointer to stop tracing.
+    /// </summary>
+    void setTracer(QSharedPointer<RoboDKTracer> tracer);
+
+    /// <summary>
+    /// Returns the tracer of this link (see setTracer).
+    /// </summary>
+    QSharedPointer<RoboDKTracer> Tracer() const;
+
+    /// <summary>
+    /// Record every byte sent to and received from RoboDK in a binary trace file, framed by API command (the first line sent by each call).
+    /// RoboDKReplay serves the trace back so that the same calls can be run again without RoboDK.
+    /// The connection handshake is not recorded.
+    /// </summary>
+    /// <param name="trace_file">Trace file (an existing file is overwritten)</param>
+    /// <returns>True if the trace file could be created</returns>
+    bool StartCapture(const QString &trace_file);
+
+    /// <summary>
+    /// Stop recording and close the trace file (see StartCapture).
+    /// </summary>
+    void StopCapture();
+
+    /// <summary>
+    /// Returns true if the communication is being recorded (see StartCapture).
+    /// </summary>
+    bool Capturing() const;
+
+    /// <summary>
+    /// Set the communication timeout of this link. Long operations (such as WaitMove) use a longer timeout for the call and restore this value afterwards.
+    /// Each link of a RoboDKPool has its own timeout.
+    /// </summary>
+    /// <param name="timeout_ms">Timeout in milliseconds</param>
+    void setTimeout(int timeout_ms);
+
+    /// <summary>
+    /// Returns the communication timeout of this link in milliseconds (see setTimeout).
+    /// </summary>
+    int Timeout() const;
+
+    /// <summary>
+    /// Returns the pool this link belongs to (nullptr if the link was not created by a RoboDKPool).
+    /// </summary>
+    RoboDKPool *Pool() const;
+
+    /// <summary>
+    /// Start the pipelined mode. Commands that only return a status (setters such as Item::setPose, Item::setJoints, Item::setVisible or Item::setName) are sent back to back without waiting for RoboDK to answer.
+    /// Pending status values are collected when a command needs a response, when max_pending statuses are pending or when PipelineEnd() is called.
+    /// Tip: use the PipelineScope class to start and end the pipelined mode automatically.
+    /// </summary>
+    /// <param name="max_pending">Maximum number of pending status values before they are collected</param>
+    void PipelineStart(int max_pending = 256);
+
+    /// <summary>
+    /// End the pipelined mode and collect any pending status values.
+    /// </summary>
+    /// <param name="errors">Optional list to retrieve the commands that failed, including the command index and the RoboDK message</param>
+    /// <returns>Number of commands that failed since PipelineStart() was called</returns>
+    int PipelineEnd(QList<tPipelineError> *errors = nullptr);
+
+    /// <summary>
+    /// Check if the pipelined mode is active.
+    /// </summary>
+    /// <returns>True if PipelineStart() was called and PipelineEnd() was not called yet</returns>
+    bool PipelineActive() const;
+
+    /// <summary>
+    /// Set a deadline for all the following calls of this link, including long operations such as Item::WaitMove, Item::MoveJ_Test, Item::InstructionListJoints or Update.
+    /// A call that is still waiting for RoboDK when the deadline expires or when the token is cancelled returns immediately with an empty or invalid result (no more commands are sent).
+    /// The link stays connected: the remaining response is discarded at the beginning of the next call (within the timeout and deadline of that call, otherwise the link reconnects).
+    /// The deadline is a setting of the link rather than an argument of each call, so that every call (including long operations) honours it without new overloads.
+    /// Tip: use the DeadlineScope class to apply a deadline to the calls of a scope only.
+    /// </summary>
+    /// <param name="timeout_ms">Time from now until the deadline, in ms (negative for no deadline)</param>
+    /// <param name="token">Optional token to cancel the calls from another thread</param>
+    void setDeadline(int timeout_ms, const CancelToken &token = CancelToken());
+
+    /// <summary>
+    /// Remove the deadline and the cancellation token set with setDeadline.
+    /// </summary>
+    void clearDeadline();
+
+    /// <summary>
+    /// Check if the last call was aborted because the deadline expired or the token was cancelled.
+    /// </summary>
+    bool Aborted() const;
+
 
     /// <summary>
     /// Returns an item by its name. If there is no exact match it will return the last closest match.
@@ -800,6 +1509,57 @@ public:
     /// <returns>List of items with a match</returns>
     QList<Item> getItemList(int filter = -1);
 
+    /// <summary>
+    /// Builds a local index of the station tree (names, types and parents of all items) to look up items without contacting RoboDK.
+    /// All the information is retrieved with one round trip for the list of items and another one for the names and parents.
+    /// The index is updated when items are added, renamed, moved or deleted through this link with AddFrame, AddTarget, setName, setParent, setParentStatic and Delete.
+    /// The items of a RoboDKPool update the index of the link they belong to, even if the call runs on another link of the pool: look up items with the link that returned them
+    /// and don't change items of a link while another thread uses its index.
+    /// Call IndexRefresh again after other changes to the station (such as loading files or changes made by the user or other clients).
+    /// </summary>
+    /// <returns>Number of items in the index</returns>
+    int IndexRefresh();
+
+    /// <summary>
+    /// Discards the local index of the station tree (see IndexRefresh).
+    /// </summary>
+    void IndexInvalidate();
+
+    /// <summary>
+    /// Checks if the local index of the station tree is available (see IndexRefresh).
+    /// </summary>
+    /// <returns>True if the index was built and not invalidated</returns>
+    bool IndexValid() const;
+
+    /// <summary>
+    /// Returns an item by its exact name using the local index of the station tree (see IndexRefresh). RoboDK is not contacted.
+    /// </summary>
+    /// <param name="name">Item name</param>
+    /// <param name="itemtype">Filter by item type RoboDK.ITEM_TYPE_...</param>
+    /// <returns>First item of the station with a match. The item is invalid if there is no match or if the index is not available.</returns>
+    Item IndexItem(const QString &name, int itemtype = -1) const;
+
+    /// <summary>
+    /// Returns the name of an item using the local index of the station tree (see IndexRefresh). RoboDK is not contacted.
+    /// </summary>
+    /// <param name="item">Item</param>
+    /// <returns>Item name (empty if the item is not in the index)</returns>
+    QString IndexName(const Item &item) const;
+
+    /// <summary>
+    /// Returns the type of an item using the local index of the station tree (see IndexRefresh). RoboDK is not contacted.
+    /// </summary>
+    /// <param name="item">Item</param>
+    /// <returns>Item type ITEM_TYPE_... (-1 if the item is not in the index)</returns>
+    int IndexType(const Item &item) const;
+
+    /// <summary>
+    /// Returns the parent of an item using the local index of the station tree (see IndexRefresh). RoboDK is not contacted.
+    /// </summary>
+    /// <param name="item">Item</param>
+    /// <returns>Parent item (invalid if the item is not in the index)</returns>
+    Item IndexParent(const Item &item) const;
+
     /// <summary>
     /// Shows a RoboDK popup to select one object from the open RoboDK station.
     /// An item type can be specified to filter desired items. If no type is specified, all items are selectable.
@@ -929,6 +1689,16 @@ public:
     /// <param name="projection_type">Type of projection. For example: PROJECTION_ALONG_NORMAL_RECALC will project along the point normal and recalculate the normal vector on the surface projected.</param>
     void ProjectPoints(tMatrix2D *points, tMatrix2D **projected, Item objectProject, int ProjectionType = PROJECTION_ALONG_NORMAL_RECALC);
 
+    /// <summary>
+    /// Projects a point given its coordinates (see ProjectPoints). The result is stored in an existing matrix: its memory is reused if it is large enough.
+    /// It has its own name so that calls to ProjectPoints with a null pointer remain unambiguous.
+    /// </summary>
+    /// <param name="points">Matrix 3xN or 6xN: list of points to project.</param>
+    /// <param name="projected">Existing matrix to store the projected points (created with Matrix2D_Create or preallocated by the caller).</param>
+    /// <param name="object_project">Object to project.</param>
+    /// <param name="projection_type">Type of projection.</param>
+    void ProjectPointsInto(tMatrix2D *points, tMatrix2D *projected, Item objectProject, int ProjectionType = PROJECTION_ALONG_NORMAL_RECALC);
+
     /// <summary>
     /// Close the current station without asking to save.
     /// </summary>
@@ -1168,12 +1938,70 @@ public:
     /// <returns>True if collision found.</returns>
     bool CollisionLine(tXYZ p1, tXYZ p2);
 
-    /// \brief Set a list of items visibile (faster than the default setVisible())
-    void setVisible(QList<Item> itemList, QList<bool> visibleList, QList<int> visibleFrames);
+    /// \brief Set a list of items visibile (faster than the default setVisible())
+    void setVisible(QList<Item> itemList, QList<bool> visibleList, QList<int> visibleFrames);
+
+    ///
+    /// \brief Show a list of items as collided.
+    void ShowAsCollided(QList<Item> itemList, QList<bool> collidedList, QList<int> *robot_link_id = nullptr);
+
+    /// <summary>
+    /// Set the relative positions (poses) of a list of items with respect to their parent (faster than calling Item::setPose for each item).
+    /// All poses are sent with one command (one round trip).
+    /// </summary>
+    /// <param name="items">List of items</param>
+    /// <param name="poses">List of poses (same length as the list of items)</param>
+    /// <returns>True if successful</returns>
+    bool setPoses(const QList<Item> &items, const QList<Mat> &poses);
+
+    /// <summary>
+    /// Set the absolute positions (poses) of a list of items with respect to the station reference (faster than calling Item::setPoseAbs for each item).
+    /// All poses are sent with one command (one round trip).
+    /// </summary>
+    /// <param name="items">List of items</param>
+    /// <param name="poses">List of absolute poses (same length as the list of items)</param>
+    /// <returns>True if successful</returns>
+    bool setPosesAbs(const QList<Item> &items, const QList<Mat> &poses);
+
+    /// <summary>
+    /// Returns the relative positions (poses) of a list of items (see Item::Pose).
+    /// The requests for all items are sent together and the responses are read afterwards (one round trip).
+    /// </summary>
+    /// <param name="items">List of items</param>
+    /// <returns>List of poses (same order as the list of items)</returns>
+    QList<Mat> Poses(const QList<Item> &items);
+
+    /// <summary>
+    /// Returns the absolute positions (poses) of a list of items with respect to the station reference (see Item::PoseAbs).
+    /// The requests for all items are sent together and the responses are read afterwards (one round trip).
+    /// </summary>
+    /// <param name="items">List of items</param>
+    /// <returns>List of absolute poses (same order as the list of items)</returns>
+    QList<Mat> PosesAbs(const QList<Item> &items);
+
+    /// <summary>
+    /// Returns the current joints of a list of robots (faster than calling Item::Joints for each robot).
+    /// </summary>
+    /// <param name="robots">List of robot items</param>
+    /// <returns>List of robot joints (same order as the list of robots)</returns>
+    QList<tJoints> Joints(const QList<Item> &robots);
 
-    ///
-    /// \brief Show a list of items as collided.
-    void ShowAsCollided(QList<Item> itemList, QList<bool> collidedList, QList<int> *robot_link_id = nullptr);
+    /// <summary>
+    /// Retrieves the current joints of a list of robots in an existing list (faster than calling Item::Joints for each robot).
+    /// The list is only resized if the number of robots changed, which allows reusing the same list without allocating memory.
+    /// </summary>
+    /// <param name="robots">List of robot items</param>
+    /// <param name="joints_list">Returns the list of robot joints (same order as the list of robots)</param>
+    /// <returns>True if successful</returns>
+    bool Joints(const QList<Item> &robots, QList<tJoints> &joints_list);
+
+    /// <summary>
+    /// Set the current joints of a list of robots (faster than calling Item::setJoints for each robot).
+    /// </summary>
+    /// <param name="robots">List of robot items</param>
+    /// <param name="joints_list">List of robot joints (same length as the list of robots)</param>
+    /// <returns>True if successful</returns>
+    bool setJoints(const QList<Item> &robots, const QList<tJoints> &joints_list);
 
     /// <summary>
     /// Calibrate a tool (TCP) given a number of points or calibration joints. Important: If the robot is calibrated, provide joint values to maximize accuracy.
@@ -1639,49 +2467,678 @@ public:
 
 
 private:
-    QTcpSocket *_COM;
+    QIODevice *_COM;
+    QSharedPointer<RoboDKTransport> _TRANSPORT;
     QString _IP;
     int _PORT;
     int _TIMEOUT;
+    int _DEFAULT_TIMEOUT;     // timeout restored after long operations (see setTimeout)
     qint64 _PROCESS;
 
+    RoboDKPool *_POOL;        // pool that owns this link (nullptr if none)
+    QList<RoboDK*> _NEW_LINKS; // links created by Item::NewLink, deleted with this link
+
     QString _ROBODK_BIN; // file path to the robodk program (executable), typically C:/RoboDK/bin/RoboDK.exe. Leave empty to use the registry key: HKEY_LOCAL_MACHINE\SOFTWARE\RoboDK
     QString _ARGUMENTS;       // arguments to provide to RoboDK on startup
 
+    QByteArray _SEND_BUFFER;  // request of the current command, written to the socket by _send_Flush()
+    quint64 _COMM_WRITES;     // number of socket writes
+    quint64 _COMM_COMMANDS;   // number of API commands
+    QString _COMMAND;         // command being processed (first line sent after _check_connection)
+    bool _COMMAND_NEXT;       // the next line sent starts another request of the same call (see _command_next)
+
+    QElapsedTimer _CLOCK;     // monotonic clock for deadlines and the startup timing
+    tStartupTiming _STARTUP;  // timing of the last connection (see _connect_smart)
+    qint64 _STARTUP_T0;       // start of the last connection in ms of _CLOCK
+    qint64 _DEADLINE;         // deadline of the calls in ms of _CLOCK (-1 if none)
+    CancelToken _CANCEL;      // token that cancels the calls
+    bool _CANCEL_SET;         // a token was given to setDeadline
+    bool _ABORTED;            // the current call was aborted: no more data is sent or read
+    quint64 _ABORT_COUNT;     // number of aborted calls
+    bool _DESYNC;             // a response was not read completely (see _resync)
+    QByteArray _SYNC_MARKER;  // parameter name requested to resynchronize the stream (empty if not sent)
+    quint32 _SYNC_COUNT;
+    bool _STATS_ON;           // statistics are collected (see setStats)
+    QSharedPointer<RoboDKTracer> _TRACER;
+    const char *_TRACE_SCOPE; // function that names the blocking waits in the trace (see tTraceScope)
+    bool _STAT_ACTIVE;        // the current call is being timed (statistics or tracer)
+    qint64 _STAT_T0;          // times of the current call in ns of _CLOCK: start, request written, first and last byte received (-1 if not yet)
+    qint64 _STAT_FLUSH;
+    qint64 _STAT_FIRST;
+    qint64 _STAT_LAST;
+    quint64 _STAT_OUT;        // bytes sent and received by the current call
+    quint64 _STAT_IN;
+    quint64 _STAT_REQUESTS;   // requests sent by the current call
+    QHash<QString, tCommandStats> _STATS;
+    QFile *_CAPTURE;          // trace file being recorded (nullptr if not capturing)
+    int _CAPTURE_SENT;        // bytes of _SEND_BUFFER already recorded
+    char _CAPTURE_TYPE;       // type of the record being collected
+    QByteArray _CAPTURE_DATA; // data of the record being collected (consecutive bytes in the same direction form one record)
+
+    /// Status expected for a command sent in pipelined mode or for a movement sent by a MotionQueue
+    struct tPipelinePending {
+        int index;
+        QString command;
+        int timeout;   // timeout to read the status (ms), 0 to use the default timeout
+        quint64 robot; // robot pointer if this is a queued movement (MoveXb/MoveCb), 0 otherwise
+    };
+    /// Movement of a MotionQueue that failed
+    struct tMotionError {
+        quint64 robot;
+        tPipelineError error;
+    };
+    bool _PIPELINE_ACTIVE;
+    int _PIPELINE_DEPTH;
+    int _PIPELINE_COUNT;
+    QList<tPipelinePending> _PIPELINE_PENDING;
+    QList<tPipelineError> _PIPELINE_ERRORS;
+    QList<tMotionError> _MOTION_ERRORS;
+
+    /// Item of the station tree index (see IndexRefresh)
+    struct tIndexEntry {
+        QString name;
+        qint32 type;
+        quint64 parent;
+        qint32 parent_type;
+    };
+    bool _INDEX_VALID;
+    QHash<quint64, tIndexEntry> _INDEX_ITEMS;        // index entries by item pointer
+    QHash<QString, QList<quint64> > _INDEX_NAMES;    // item pointers by name (in station order)
+
+    QHash<quint64, Kinematics> _KINEMATICS;          // kinematics of robots by item pointer (see Item::getKinematics)
+    QHash<quint64, int> _ROBOT_DOFS;                 // number of joints of the robots in _KINEMATICS (also if they can't be computed locally)
+
+    void _init(const QString &robodk_ip, int com_port, const QString &args, const QString &path);
     bool _connected();
-    bool _connect();
+    bool _connect(int timeout_ms = -1);
+    void _startup_reset();
     bool _connect_smart(); // will attempt to start RoboDK
+    bool _connect_wait(int timeout_ms); // will wait for RoboDK without starting it
     void _disconnect();
+    void _attach_thread();
+    void _detach_thread();
+
+    bool _check_connection();
+    void _command_next();
+    bool _batch_request(int index);
+    bool _check_status();
+    int _recv_Status(QString &message);
+    void _pipeline_drain(int count = -1);
+
+    bool _send_Flush();
+    struct tTraceScope;
+    void _call_end();
+    void _received(const char *data, qint64 size);
+    void _capture(char type, const char *data, qint64 size);
+    void _capture_end();
+    void _recv_Begin();
+    bool _wait_data(int timeout_ms = -1);
+    bool _wait_ready(int timeout_ms);
+    void _abort();
+    bool _resync();
+
+    bool _waitline();
+    QString _recv_Line();//QString &string);
+    bool _send_Line(const QString &string);
+    bool _send_Line(const char *line);
+    void _send_Command(const QString &name);
+    int _recv_Int();//qint32 &value);
+    bool _send_Int(const qint32 value);
+    Item _recv_Item();//Item *item);
+    bool _send_Item(const Item *item);
+    bool _send_Item(const Item &item);
+    Mat _recv_Pose();//Mat &pose);
+    bool _send_Pose(const Mat &pose);
+    bool _recv_XYZ(tXYZ pos);
+    bool _send_XYZ(const tXYZ pos);
+    bool _recv_Array(double *values, int *psize=nullptr);
+    bool _send_Array(const double *values, int nvalues);
+    bool _recv_Array(tJoints *jnts);
+    bool _send_Array(const tJoints *jnts);
+    bool _send_Array(const Mat *mat);
+    bool _recv_Matrix2D(tMatrix2D **mat);
+    bool _recv_Matrix2D(tMatrix2D *mat);
+    bool _recv_Doubles(double *values, qint64 nvalues);
+    bool _send_Matrix2D(tMatrix2D *mat);
+
+
+    bool _setPoses(const QString &command, const QList<Item> &items, const QList<Mat> &poses);
+    QList<Mat> _getPoses(const QString &command, const QList<Item> &items);
+
+    void _moveX(const Item *target, const tJoints *joints, const Mat *mat_target, const Item *itemrobot, int movetype, bool blocking);
+    void _moveC(const Item *target1, const tJoints *joints1, const Mat *mat_target1, const Item *target2, const tJoints *joints2, const Mat *mat_target2, const Item *itemrobot, bool blocking);
+    void _send_MoveX(const Item *target, const tJoints *joints, const Mat *mat_target, const Item *itemrobot, int movetype, bool blocking);
+    void _send_MoveC(const Item *target1, const tJoints *joints1, const Mat *mat_target1, const Item *target2, const tJoints *joints2, const Mat *mat_target2, const Item *itemrobot, bool blocking);
+    void _send_Target(const Item *target, const tJoints *joints, const Mat *mat_target);
+
+    void _motion_push(const Item *itemrobot, int index, int timeout);
+    int _motion_in_flight(const Item *itemrobot) const;
+    void _motion_wait(const Item *itemrobot, int max_in_flight);
+    int _motion_errors(const Item *itemrobot, QList<tPipelineError> *errors);
+
+    void _index_add(const Item &item, const QString &name, const Item &parent);
+    void _index_remove(quint64 ptr);
+    void _index_rename(quint64 ptr, const QString &name);
+    void _index_reparent(quint64 ptr, const Item &parent);
+
+    Kinematics _kinematics(const Item &robot, bool refresh);
+};
+
+
+/// \brief The PipelineScope class starts the pipelined mode of a RoboDK link and ends it when it goes out of scope (see RoboDK::PipelineStart).
+/// \code
+/// {
+///     PipelineScope pipeline(RDK);
+///     for (int i=0; i<items.length(); i++){
+///         items[i].setVisible(false);
+///     }
+///     QList<tPipelineError> errors;
+///     pipeline.End(&errors);
+/// }
+/// \endcode
+class ROBODK PipelineScope {
+public:
+    PipelineScope(RoboDK *rdk, int max_pending = 256);
+    ~PipelineScope();
+
+    /// <summary>
+    /// End the pipelined mode before the scope ends (see RoboDK::PipelineEnd).
+    /// </summary>
+    /// <param name="errors">Optional list to retrieve the commands that failed</param>
+    /// <returns>Number of commands that failed</returns>
+    int End(QList<tPipelineError> *errors = nullptr);
+
+private:
+    RoboDK *_RDK;
+    bool _ACTIVE;
+};
+
+
+/// \brief The DeadlineScope class sets a deadline and an optional cancellation token for the calls of a RoboDK link and clears it when it goes out of scope (see RoboDK::setDeadline).
+/// \code
+/// CancelToken token; // token.Cancel() can be called from a supervisor thread
+/// {
+///     DeadlineScope deadline(RDK, 5000, token);
+///     int collisions = robot.MoveJ_Test(joints1, joints2);
+///     if (deadline.Aborted()){
+///         // the test did not finish in 5 s or it was cancelled
+///     }
+/// }
+/// \endcode
+class ROBODK DeadlineScope {
+public:
+    DeadlineScope(RoboDK *rdk, int timeout_ms, const CancelToken &token = CancelToken());
+    ~DeadlineScope();
+
+    /// <summary>
+    /// Check if a call was aborted since the scope started.
+    /// </summary>
+    bool Aborted() const;
+
+private:
+    Q_DISABLE_COPY(DeadlineScope)
+
+    RoboDK *_RDK;
+    quint64 _ABORT_COUNT;
+    qint64 _PREV_DEADLINE;
+    CancelToken _PREV_CANCEL;
+    bool _PREV_CANCEL_SET;
+};
+
+
+
+/// \brief The RoboDKPool class holds several links to the same RoboDK instance so that several threads can use the RoboDK API at the same time.
+/// A thread leases its own link (own socket) with RoboDKLease (released at the end of the scope) or Link() (released by Release()).
+/// Items retrieved from any link of the pool are valid in any thread: each call uses the link of the calling thread.
+/// A thread that calls items without holding a link leases one for that call only, so worker threads of a QThreadPool
+/// and finished threads do not keep links (use RoboDKLease around a sequence of calls to keep the same link).
+/// Released links are kept open and given to the next thread that needs one.
+/// \code
+/// RoboDKPool pool;
+/// // in each worker thread:
+/// RoboDKLease rdk(pool);
+/// Item robot = rdk->getItem("", RoboDK::ITEM_TYPE_ROBOT);
+/// robot.MoveJ(joints);
+/// \endcode
+class ROBODK RoboDKPool {
+public:
+    /// <summary>
+    /// Create a pool of links to a RoboDK instance. Links are created when needed.
+    /// </summary>
+    /// <param name="robodk_ip">IP of the RoboDK API server (leave empty for localhost)</param>
+    /// <param name="com_port">Port of the RoboDK API server (-1 for the default port)</param>
+    /// <param name="max_links">Maximum number of links (0 for no limit). Threads wait for a released link once the limit is reached</param>
+    /// <param name="transport">Transport used by the links (TCP if null)</param>
+    RoboDKPool(const QString &robodk_ip = "", int com_port = -1, int max_links = 0, QSharedPointer<RoboDKTransport> transport = QSharedPointer<RoboDKTransport>());
+
+    /// Deletes all the links. Links should be released before the pool is deleted.
+    ~RoboDKPool();
+
+    /// <summary>
+    /// Returns the link of the calling thread. A link is leased to the thread the first time (a released link or a new link).
+    /// The link stays leased until the thread calls Release(), RoboDKLease releases it automatically.
+    /// </summary>
+    RoboDK *Link();
+
+    /// <summary>
+    /// Return the link of the calling thread to the pool. Pending statuses are collected and the pipelined mode is ended.
+    /// </summary>
+    void Release();
+
+    /// <summary>
+    /// Number of links created by the pool.
+    /// </summary>
+    int Count() const;
+
+    /// <summary>
+    /// Number of links leased to threads.
+    /// </summary>
+    int Leased() const;
+
+private:
+    Q_DISABLE_COPY(RoboDKPool)
+
+    friend class RoboDK_API::RoboDKLease;
+    friend class RoboDK_API::Item;
+    RoboDK *_lease(bool *leased_now);
+
+    QString _IP;
+    int _PORT;
+    int _MAX_LINKS;
+    QSharedPointer<RoboDKTransport> _TRANSPORT;
+    int _CREATING;                        // links being created (outside the lock)
+    mutable QMutex _MUTEX;
+    QWaitCondition _RELEASED;
+    QList<RoboDK*> _LINKS;                // all links of the pool
+    QList<RoboDK*> _IDLE;                 // released links
+    QHash<Qt::HANDLE, RoboDK*> _LEASES;   // leased links by thread
+};
+
+/// \brief The RoboDKLease class leases the link of the calling thread from a RoboDKPool and releases it when it goes out of scope
+/// (only if the thread did not have a link already).
+class ROBODK RoboDKLease {
+public:
+    RoboDKLease(RoboDKPool &pool);
+    ~RoboDKLease();
+
+    /// Returns the leased link.
+    RoboDK *Link() const;
+
+    RoboDK *operator->() const;
+
+private:
+    Q_DISABLE_COPY(RoboDKLease)
+
+    RoboDKPool *_POOL;
+    RoboDK *_LINK;
+    bool _RELEASE;
+};
+
+
+
+/// \brief The RoboDKAsync class sends RoboDK API calls without blocking the calling thread.
+/// Each call writes its request and returns a QFuture. The future is completed from the Qt event loop when RoboDK answers (readyRead signal of the socket).
+/// RoboDK answers requests in order, so responses are matched to the calls with a FIFO and any number of calls can be outstanding.
+/// The requests of all the calls made in the same event loop iteration are written together.
+/// RoboDKAsync uses its own link to the same RoboDK instance: blocking calls of the original link can still be used at the same time.
+/// Items returned by this class belong to the original link.
+/// \code
+/// RoboDKAsync *async = new RoboDKAsync(RDK, this);
+/// QFutureWatcher<int> *watcher = new QFutureWatcher<int>(this);
+/// connect(watcher, &QFutureWatcher<int>::finished, [=](){ statusBar()->showMessage("Movement done"); });
+/// watcher->setFuture(async->MoveJ(robot, joints));
+/// \endcode
+class ROBODK RoboDKAsync : public QObject {
+    Q_OBJECT
+
+public:
+    /// <summary>
+    /// Open a link to the same RoboDK instance as rdk. The object must be used from the thread that creates it.
+    /// </summary>
+    explicit RoboDKAsync(RoboDK *rdk, QObject *parent = nullptr);
+
+    /// Cancels the futures of the calls that did not finish.
+    ~RoboDKAsync();
+
+    /// <summary>
+    /// Check if the link is connected.
+    /// </summary>
+    bool Connected() const;
+
+    /// <summary>
+    /// Number of calls waiting for a response.
+    /// </summary>
+    int Pending() const;
+
+    /// <summary>
+    /// Write the requests that were not written yet (this is done automatically when the event loop runs).
+    /// </summary>
+    void Flush();
+
+    /// <summary>
+    /// Returns an item by its name (see RoboDK::getItem).
+    /// </summary>
+    QFuture<Item> getItem(const QString &name, int itemtype = -1);
+
+    /// <summary>
+    /// Run a program or a function call (see RoboDK::RunProgram). The future holds the program status.
+    /// </summary>
+    QFuture<int> RunProgram(const QString &function_w_params);
+
+    /// <summary>
+    /// Run a program item (see Item::RunProgram). The future holds the program status.
+    /// </summary>
+    QFuture<int> RunProgram(const Item &program);
+
+    /// <summary>
+    /// Returns the current joints of a robot (see Item::Joints). The joints are not valid if the call failed.
+    /// </summary>
+    QFuture<tJoints> Joints(const Item &robot);
+
+    /// <summary>
+    /// Returns the pose of an item with respect to its parent (see Item::Pose). The pose is not valid if the call failed.
+    /// </summary>
+    QFuture<Mat> Pose(const Item &item);
+
+    /// <summary>
+    /// Set the current joints of a robot (see Item::setJoints). The future holds the status (0 if the call succeeded).
+    /// </summary>
+    QFuture<int> setJoints(const Item &robot, const tJoints &joints);
+
+    /// <summary>
+    /// Set the pose of an item with respect to its parent (see Item::setPose). The future holds the status (0 if the call succeeded).
+    /// </summary>
+    QFuture<int> setPose(const Item &item, const Mat &pose);
+
+    /// <summary>
+    /// Joint movement (see Item::MoveJ). If blocking is true the future finishes when the robot finished the movement, otherwise it finishes when the movement is accepted.
+    /// The future holds the status (0 if the call succeeded). Calls made after a blocking movement finish after the movement.
+    /// </summary>
+    QFuture<int> MoveJ(const Item &robot, const Item &target, bool blocking = true);
+    QFuture<int> MoveJ(const Item &robot, const tJoints &joints, bool blocking = true);
+    QFuture<int> MoveJ(const Item &robot, const Mat &target, bool blocking = true);
+
+    /// <summary>
+    /// Linear movement (see Item::MoveL and MoveJ).
+    /// </summary>
+    QFuture<int> MoveL(const Item &robot, const Item &target, bool blocking = true);
+    QFuture<int> MoveL(const Item &robot, const tJoints &joints, bool blocking = true);
+    QFuture<int> MoveL(const Item &robot, const Mat &target, bool blocking = true);
+
+signals:
+    /// <summary>
+    /// Emitted when the last pending call finished.
+    /// </summary>
+    void idle();
+
+private slots:
+    void _read();
+    void _closed();
+    void _flush_queued();
+
+private:
+    Q_DISABLE_COPY(RoboDKAsync)
+
+    bool _begin();
+    void _push(tAsyncRequest *request);
+    void _fail_all();
+    QFuture<int> _move(const Item &robot, const Item *target, const tJoints *joints, const Mat *mat_target, int movetype, bool blocking);
+
+    RoboDK *_RDK;                     // link given by the user (items returned belong to this link)
+    RoboDK *_LINK;                    // own link used to send requests
+    QIODevice *_SOCKET;               // stream connected to the signals of this object
+    QByteArray _RECV;                 // received data not parsed yet
+    int _RECV_POS;                    // first byte of _RECV not parsed yet
+    QList<tAsyncRequest*> _QUEUE;     // calls waiting for a response, in the order they were sent
+    bool _FLUSH_QUEUED;
+};
+
+
+
+/// \brief The RoboDKRelay class forwards the RoboDK protocol from a local server to the TCP port of RoboDK.
+/// Clients connect with LocalTransport or SharedMemoryTransport, each client gets its own TCP connection to RoboDK.
+/// The relay can run in any process of the computer that runs RoboDK (for example, a helper process or a RoboDK plugin) and needs a Qt event loop.
+/// The relay reaches RoboDK through its TCP port: running it in a separate process adds a hop to every call, run it inside a RoboDK plugin to reduce the latency.
+class ROBODK RoboDKRelay : public QObject {
+    Q_OBJECT
+
+public:
+    /// <summary>
+    /// Forward clients to the RoboDK API server at robodk_ip:com_port (localhost and the default port by default).
+    /// </summary>
+    explicit RoboDKRelay(const QString &robodk_ip = "", int com_port = -1, QObject *parent = nullptr);
+    ~RoboDKRelay();
+
+    /// <summary>
+    /// Start listening for clients. Leave server_name empty to use RoboDK_API_PORT (the default name of LocalTransport and SharedMemoryTransport).
+    /// </summary>
+    /// <returns>True if the local server is listening</returns>
+    bool Listen(const QString &server_name = "");
+
+    /// <summary>
+    /// Stop listening and close all the clients.
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Number of connected clients.
+    /// </summary>
+    int Clients() const;
+
+private slots:
+    void _accept();
+
+private:
+    Q_DISABLE_COPY(RoboDKRelay)
+
+    QString _IP;
+    int _PORT;
+    QLocalServer *_SERVER;
+    QList<QObject*> _CLIENTS;     // forwarding of each client (deleted when the client disconnects)
+};
+
+
+
+/// \brief The RoboDKTracer class writes the API calls of RoboDK links to a Chrome trace file (Trace Event JSON format), to open with chrome://tracing or Perfetto (see RoboDK::setTracer).
+/// Each call is shown as an event named after its command (such as WaitMove or G_ProgJointList) on the thread that made it.
+/// Every blocking wait for RoboDK is nested inside its call and named after the function that waited (such as _check_status, _recv_Matrix2D or _waitline).
+/// Events are written as they happen and the tracer can be shared by links running in different threads.
+class ROBODK RoboDKTracer {
+public:
+    /// <summary>
+    /// Create the trace file (an existing file is overwritten).
+    /// </summary>
+    explicit RoboDKTracer(const QString &trace_file);
+
+    /// Closes the trace file
+    ~RoboDKTracer();
+
+    /// <summary>
+    /// Returns true if the trace file is open.
+    /// </summary>
+    bool IsOpen() const;
+
+    /// <summary>
+    /// Complete the trace file and close it. Events added later are ignored.
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Time of the tracer clock (ns). Events are given in this clock.
+    /// </summary>
+    qint64 Now() const;
+
+    /// <summary>
+    /// Add an event of the calling thread.
+    /// </summary>
+    /// <param name="name">Event name</param>
+    /// <param name="category">Event category</param>
+    /// <param name="start_ns">Start time (see Now)</param>
+    /// <param name="end_ns">End time (see Now)</param>
+    /// <param name="args">Optional event arguments given as JSON object members, such as "bytes":12</param>
+    void Complete(const QString &name, const QString &category, qint64 start_ns, qint64 end_ns, const QString &args = "");
+
+private:
+    Q_DISABLE_COPY(RoboDKTracer)
+
+    int _thread_id();
+
+    mutable QMutex _MUTEX;
+    QFile *_FILE;
+    QElapsedTimer _CLOCK;
+    qint64 _PID;
+    QHash<Qt::HANDLE, int> _THREADS;  // trace id of each thread
+};
+
+
+
+/// \brief The RoboDKReplay class serves a trace recorded with RoboDK::StartCapture as if it was RoboDK, to repeat the recorded calls without RoboDK (for example to benchmark the client or to reproduce a performance regression).
+/// The server runs in its own thread, so the client may run in the thread that created it.
+/// Each connection replays the trace from the beginning. The bytes sent by the client are compared with the recorded requests and the recorded responses are sent back in the same order.
+/// Once the trace ends it starts again, so that the recorded calls can be repeated in a loop.
+/// \code
+/// RoboDKReplay replay("calls.rdktrace");
+/// replay.Listen();
+/// RoboDK rdk("127.0.0.1", replay.Port());
+/// \endcode
+class ROBODK RoboDKReplay {
+public:
+    explicit RoboDKReplay(const QString &trace_file = "");
+    ~RoboDKReplay();
+
+    /// <summary>
+    /// Load a trace file recorded with RoboDK::StartCapture (the server must not be listening).
+    /// </summary>
+    /// <returns>True if the trace is valid</returns>
+    bool Load(const QString &trace_file);
+
+    /// <summary>
+    /// Start serving the trace on localhost.
+    /// </summary>
+    /// <param name="port">TCP port (0 to use any free port, see Port())</param>
+    /// <param name="local">Serve on a local socket instead of TCP, with the name used by LocalTransport for this port (RoboDK_API_PORT)</param>
+    /// <returns>True if the server is listening</returns>
+    bool Listen(int port = 0, bool local = false);
+
+    /// <summary>
+    /// Stop the server and close the connection being served.
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Port the server is listening on (see Listen).
+    /// </summary>
+    int Port() const;
+
+    /// <summary>
+    /// Names of the commands of the trace, in order.
+    /// </summary>
+    QStringList Commands() const;
+
+    /// <summary>
+    /// Number of commands served since Listen was called.
+    /// </summary>
+    int Served() const;
+
+    /// <summary>
+    /// Number of requests that did not match the recorded requests since Listen was called (the recorded response is sent anyway).
+    /// </summary>
+    int Mismatches() const;
+
+private:
+    Q_DISABLE_COPY(RoboDKReplay)
+
+    QList<QPair<char, QByteArray> > _RECORDS; // records of the trace: type and data
+    QThread *_SERVER;                          // thread serving the trace (nullptr if not listening)
+};
+
+
+
+/// \brief The RoboDKInstancePool class runs jobs on several RoboDK instances in parallel, for example to generate many programs at the same time.
+/// Each instance listens on its own port (first_port, first_port+1, ...) and is started with /PORT= if it is not running (see the RoboDK constructor).
+/// Jobs are spread across the instances and an instance that runs out of jobs takes the remaining jobs of another instance (work stealing).
+/// Any RoboDK API server can be used as an instance, such as a local stand-in server for tests.
+/// \code
+/// RoboDKInstancePool instances(8);
+/// instances.Start("C:/stations/cell.rdk");
+/// QList<tInstanceJobResult> results;
+/// instances.Run(parts.length(), [&](RoboDK *rdk, int job){
+///     Item prog = rdk->getItem("Part program", RoboDK::ITEM_TYPE_PROGRAM);
+///     ...
+///     return prog.MakeProgram(folders[job]);
+/// }, &results);
+/// instances.Close();
+/// \endcode
+class ROBODK RoboDKInstancePool {
+public:
+    /// Job run with the link of the instance that runs it (job is the job index). Returns false if the job failed.
+    typedef std::function<bool(RoboDK *rdk, int job)> tJob;
+
+    /// <summary>
+    /// Create a pool of instances. Instances are started by Start().
+    /// </summary>
+    /// <param name="instances">Number of instances</param>
+    /// <param name="first_port">Port of the first instance, the following instances use the next ports</param>
+    /// <param name="robodk_ip">IP of the computer running the instances (leave empty for localhost)</param>
+    /// <param name="args">Command line arguments of the instances started by the pool</param>
+    /// <param name="path">RoboDK executable (leave empty for the default path)</param>
+    RoboDKInstancePool(int instances, int first_port = 20501, const QString &robodk_ip = "", const QString &args = "/NOSPLASH /NOSHOW /HIDDEN", const QString &path = "");
+
+    /// Deletes the links. Instances keep running unless Close() is called.
+    ~RoboDKInstancePool();
+
+    /// <summary>
+    /// Connect to all the instances at the same time (starting them if needed) and optionally load a station file in each instance.
+    /// </summary>
+    /// <param name="station">Station (or any file) to load in each instance (empty to load nothing)</param>
+    /// <returns>Number of instances ready</returns>
+    int Start(const QString &station = "");
+
+    /// <summary>
+    /// Load a file in every instance at the same time. Files are loaded with AddFile for local instances and sent with FileSet for remote instances.
+    /// </summary>
+    /// <returns>Number of instances that loaded the file</returns>
+    int LoadStation(const QString &station);
+
+    /// <summary>
+    /// Run njobs jobs on the instances and wait until all the jobs finished.
+    /// </summary>
+    /// <param name="njobs">Number of jobs</param>
+    /// <param name="job">Function called for each job index</param>
+    /// <param name="results">Optional list to retrieve the result of each job (ordered by job index)</param>
+    /// <returns>Number of jobs that failed</returns>
+    int Run(int njobs, const tJob &job, QList<tInstanceJobResult> *results = nullptr);
+
+    /// <summary>
+    /// Number of instances connected by Start().
+    /// </summary>
+    int Count() const;
+
+    /// <summary>
+    /// Link to an instance (only use it from the calling thread while Run is not running).
+    /// </summary>
+    RoboDK *Link(int index) const;
 
-    bool _check_connection();
-    bool _check_status();
+    /// <summary>
+    /// Close all the instances (RoboDK::CloseRoboDK) and delete the links.
+    /// </summary>
+    void Close();
 
-    bool _waitline();
-    QString _recv_Line();//QString &string);
-    bool _send_Line(const QString &string);
-    int _recv_Int();//qint32 &value);
-    bool _send_Int(const qint32 value);
-    Item _recv_Item();//Item *item);
-    bool _send_Item(const Item *item);
-    bool _send_Item(const Item &item);
-    Mat _recv_Pose();//Mat &pose);
-    bool _send_Pose(const Mat &pose);
-    bool _recv_XYZ(tXYZ pos);
-    bool _send_XYZ(const tXYZ pos);
-    bool _recv_Array(double *values, int *psize=nullptr);
-    bool _send_Array(const double *values, int nvalues);
-    bool _recv_Array(tJoints *jnts);
-    bool _send_Array(const tJoints *jnts);
-    bool _send_Array(const Mat *mat);
-    bool _recv_Matrix2D(tMatrix2D **mat);
-    bool _send_Matrix2D(tMatrix2D *mat);
+private:
+    Q_DISABLE_COPY(RoboDKInstancePool)
 
+    void _each(const std::function<void(int)> &task);
 
-    void _moveX(const Item *target, const tJoints *joints, const Mat *mat_target, const Item *itemrobot, int movetype, bool blocking);
-    void _moveC(const Item *target1, const tJoints *joints1, const Mat *mat_target1, const Item *target2, const tJoints *joints2, const Mat *mat_target2, const Item *itemrobot, bool blocking);
+    int _COUNT;
+    int _FIRST_PORT;
+    QString _IP;
+    QString _ARGS;
+    QString _PATH;
+    QList<RoboDK*> _LINKS;  // link of each instance (nullptr if the instance is not connected)
 };
 
 
+
 /// \brief The Item class represents an item in RoboDK station. An item can be a robot, a frame, a tool, an object, a target, ... any item visible in the <strong>station tree</strong>.
 /// An item can also be seen as a node where other items can be attached to (child items).
 /// Every item has one parent item/node and can have one or more child items/nodes
@@ -1689,17 +3146,26 @@ private:
 /// \image html station-tree.png
 class ROBODK Item {
     friend class RoboDK_API::RoboDK;
+    friend class RoboDK_API::ProgramBuilder;
 
 public:
     Item(RoboDK *rdk=nullptr, quint64 ptr=0, qint32 type=-1);
     Item(const Item &other);
+    Item &operator=(const Item &other);
 
     ~Item();
 
     QString ToString() const;
 
+    /// <summary>
+    /// Returns the RoboDK link used by this item. If the item belongs to a RoboDKPool, this is the link of the calling thread (leased until RoboDKPool::Release is called).
+    /// </summary>
     RoboDK* RDK();
 
+    /// <summary>
+    /// Use a new communication link for this item (one socket per thread). The link is deleted with the original link.
+    /// Items of a RoboDKPool already use the link of the calling thread.
+    /// </summary>
     void NewLink();
 
     /// Item type (object, robot, tool, reference, robot machining project, ...)
@@ -2032,6 +3498,24 @@ public:
     /// <returns>4x4 homogeneous matrix: pose of the robot flange with respect to the robot base</returns>
     Mat SolveFK(const tJoints &joints, const Mat *tool = nullptr, const Mat *ref = nullptr);
 
+    /// <summary>
+    /// Computes the forward kinematics of the robot for a list of joints. The poses are computed locally (see getKinematics), RoboDK is only used if the kinematics of the robot can't be computed locally.
+    /// </summary>
+    /// <param name="joint_list">Joint list: one joint vector per column (extra rows are ignored)</param>
+    /// <param name="tool">Optionally provide a tool pose, otherwise, the robot flange is used</param>
+    /// <param name="ref">Optionally provide a reference pose, otherwise, the robot base is used</param>
+    /// <returns>List of poses of the robot flange (or tool) with respect to the robot base (or reference), one for each column</returns>
+    QList<Mat> SolveFK(const tMatrix2D *joint_list, const Mat *tool = nullptr, const Mat *ref = nullptr);
+
+    /// <summary>
+    /// Returns the kinematics of the robot to compute the forward and inverse kinematics locally (see Kinematics).
+    /// The kinematics and the joint limits are retrieved from RoboDK the first time and kept by the RoboDK link for the next calls.
+    /// The result is not valid if the robot can't be represented as a serial chain (such as robots with coupled joints).
+    /// </summary>
+    /// <param name="refresh">Set to true to retrieve the kinematics again (for example, after modifying the robot)</param>
+    /// <returns>Robot kinematics</returns>
+    Kinematics getKinematics(bool refresh = false);
+
     /// <summary>
     /// Returns the robot configuration state for a set of robot joints.
     /// </summary>
@@ -2041,6 +3525,7 @@ public:
 
     /// <summary>
     /// Computes the inverse kinematics for the specified robot and pose. The joints returned are the closest to the current robot configuration (see SolveIK_All())
+    /// The inverse kinematics is computed locally if possible (see getKinematics): the current joints are retrieved and the solution with the smallest maximum joint move is returned (see Kinematics::SolveIK).
     /// </summary>
     /// <param name="pose">4x4 matrix -> pose of the robot flange with respect to the robot base frame</param>
     /// <param name="joints_close">Aproximate joints solution to choose among the possible solutions. Leave this value empty to return the closest match to the current robot position.</param>
@@ -2051,6 +3536,7 @@ public:
 
     /// <summary>
     /// Computes the inverse kinematics for the specified robot and pose. The joints returned are the closest to the current robot configuration (see SolveIK_All())
+    /// The inverse kinematics is computed locally if possible (see getKinematics), with the same rule as Kinematics::SolveIK.
     /// </summary>
     /// <param name="pose">4x4 matrix -> pose of the robot flange with respect to the robot base frame</param>
     /// <param name="joints_approx">Aproximate solution. Leave empty to return the closest match to the current robot position.</param>
@@ -2061,6 +3547,7 @@ public:
 
     /// <summary>
     /// Computes the inverse kinematics for the specified robot and pose. The function returns all available joint solutions as a 2D matrix.
+    /// Each column is a solution: the joints followed by 2 values given by RoboDK (0 if the inverse kinematics is computed locally, see getKinematics).
     /// </summary>
     /// <param name="pose">4x4 matrix -> pose of the robot tool with respect to the robot frame</param>
     /// <param name="tool_pose">Optionally provide a tool pose, otherwise, the robot flange is used. Tip: use robot.PoseTool() to retrieve the active robot tool.</param>
@@ -2069,7 +3556,7 @@ public:
     tMatrix2D *SolveIK_All_Mat2D(const Mat &pose, const Mat *tool=nullptr, const Mat *ref=nullptr);
 
     /// <summary>
-    /// Computes the inverse kinematics for the specified robot and pose. The function returns all available joint solutions as a 2D matrix.
+    /// Computes the inverse kinematics for the specified robot and pose. The function returns all available joint solutions (locally if possible, see getKinematics).
     /// </summary>
     /// <param name="pose">4x4 matrix -> pose of the robot tool with respect to the robot frame</param>
     /// <param name="tool_pose">Optionally provide a tool pose, otherwise, the robot flange is used. Tip: use robot.PoseTool() to retrieve the active robot tool.</param>
@@ -2077,6 +3564,20 @@ public:
     /// <returns>double x n x m -> joint list (2D matrix)</returns>
     QList<tJoints> SolveIK_All(const Mat &pose, const Mat *tool=nullptr, const Mat *ref=nullptr);
 
+    /// <summary>
+    /// Computes the inverse kinematics for an array of poses (all solutions). The local kinematics are used if possible (see Kinematics::CanSolveIK),
+    /// otherwise, the requests are sent to RoboDK in groups without waiting for each result.
+    /// </summary>
+    /// <param name="poses">Poses: 16 x count doubles, each pose in column-major order (same as Mat::ValuesD)</param>
+    /// <param name="count">Number of poses</param>
+    /// <param name="solutions">Resulting joints: 8 x 6 x count doubles. Up to 8 solutions of 6 joints for each pose, the valid solutions come first</param>
+    /// <param name="nsolutions">Number of solutions of each pose (count values)</param>
+    /// <param name="configs">Optionally retrieve the configuration of each solution (8 x count values, see Kinematics::SolveIK). The configuration is -1 for solutions computed by RoboDK</param>
+    /// <param name="tool">Optionally provide a tool pose, otherwise, the robot flange is used</param>
+    /// <param name="ref">Optionally provide a reference pose, otherwise, the robot base is used</param>
+    /// <returns>True if successful</returns>
+    bool SolveIK_All(const double *poses, int count, double *solutions, int *nsolutions, int *configs = nullptr, const Mat *tool = nullptr, const Mat *ref = nullptr);
+
     /// <summary>
     /// Connect to a real robot using the corresponding robot driver.
     /// </summary>
@@ -2353,6 +3854,17 @@ public:
     /// <param name="joints"></param>
     void setInstruction(int ins_id, const QString &name, int instype, int movetype, bool isjointtarget, const Mat &target, const tJoints &joints);
 
+    /// <summary>
+    /// Returns the instructions of a program (all of them by default), same as Instruction for each instruction.
+    /// All the requests are sent back to back after the number of instructions is known, which avoids one round trip per instruction.
+    /// </summary>
+    /// <param name="instructions">Instructions retrieved (the previous content is replaced)</param>
+    /// <param name="first">Index of the first instruction to retrieve</param>
+    /// <param name="count">Number of instructions to retrieve (-1 to retrieve until the end of the program)</param>
+    /// <param name="max_pending">Maximum number of requests sent before their response is read</param>
+    /// <returns>Number of instructions retrieved (less than requested if the program is shorter or if the connection was lost)</returns>
+    int Instructions(tProgramInstructions *instructions, int first = 0, int count = -1, int max_pending = 256);
+
     /// <summary>
     /// Returns the list of program instructions as an MxN matrix, where N is the number of instructions and M equals to 1 plus the number of robot axes.
     /// </summary>
@@ -2388,6 +3900,16 @@ public:
     /// <returns>Returns 0 if success, otherwise, it will return negative values</returns>
     int InstructionListJoints(QString &error_msg, tMatrix2D **joint_list, double mm_step = 10.0, double deg_step = 5.0, const QString &save_to_file = "", bool collision_check=false, int flags=0, double time_step_s=0.1);
 
+    /// <summary>
+    /// Returns a list of joints as an MxN matrix (see InstructionListJoints). The result is stored in an existing matrix: its memory is reused if it is large enough.
+    /// This avoids allocating a new matrix every time when the joint list is retrieved repeatedly.
+    /// It has its own name so that calls to InstructionListJoints with a null pointer remain unambiguous.
+    /// </summary>
+    /// <param name="error_msg">Returns a human readable error message (if any)</param>
+    /// <param name="joint_list">Existing matrix to store the list of joints (created with Matrix2D_Create or preallocated by the caller). It is not modified if save_to_file is provided.</param>
+    /// <returns>Returns 0 if success, otherwise, it will return negative values</returns>
+    int InstructionListJointsInto(QString &error_msg, tMatrix2D *joint_list, double mm_step = 10.0, double deg_step = 5.0, const QString &save_to_file = "", bool collision_check=false, int flags=0, double time_step_s=0.1);
+
 
     /// <summary>
     /// Set a specific item parameter.
@@ -2411,6 +3933,22 @@ public:
 
 
 private:
+    /// Resolves the link of an item once per call and releases it when the call returns if it was leased for the call
+    /// (threads that use items of a pool without RoboDKLease do not keep a link).
+    struct tLinkScope {
+        tLinkScope(const Item *item){ _LINK = item->_link(&_RELEASE); }
+        ~tLinkScope(){ if (_RELEASE != nullptr){ _RELEASE->Release(); } }
+        RoboDK *operator->() const { return _LINK; }
+        operator RoboDK*() const { return _LINK; }
+
+        RoboDK *_LINK;
+        RoboDKPool *_RELEASE;
+    };
+
+    RoboDK *_link() const;
+    RoboDK *_link(RoboDKPool **release) const;
+    bool _recv_Instruction(RoboDK *rdk, tProgramInstructions *instructions, QHash<QString, int> &name_ids);
+
     /// Pointer to RoboDK link object
     RoboDK *_RDK;
 
@@ -2422,6 +3960,392 @@ private:
 };
 
 
+/// \brief The MotionQueue class streams movements of a robot to RoboDK without waiting for each movement to finish.
+/// Movements are sent as MoveXb/MoveCb commands: RoboDK executes them in order and reports the end of each movement.
+/// Up to max_in_flight movements can be queued, adding a movement to a full queue waits until the oldest movement finishes.
+/// Any other command sent to the same RoboDK link waits until the queued movements finish, use WaitDone to wait explicitly.
+/// \code
+/// MotionQueue queue(robot, 32);
+/// for (int i=0; i<targets.length(); i++){
+///     queue.MoveL(targets[i]);
+/// }
+/// QList<tPipelineError> errors;
+/// queue.WaitDone(&errors);
+/// \endcode
+class ROBODK MotionQueue {
+public:
+    /// <summary>
+    /// Create a motion queue for a robot.
+    /// </summary>
+    /// <param name="robot">Robot item</param>
+    /// <param name="max_in_flight">Maximum number of movements sent to RoboDK that did not finish</param>
+    /// <param name="timeout_sec">Maximum time to wait for a queued movement to finish (in seconds)</param>
+    MotionQueue(const Item &robot, int max_in_flight = 16, double timeout_sec = 300);
+
+    /// Waits until all queued movements finish
+    ~MotionQueue();
+
+    /// <summary>
+    /// Queue a joint movement ("Move Joint" mode).
+    /// </summary>
+    /// <param name="itemtarget">Target to move to as a target item (RoboDK target item)</param>
+    void MoveJ(const Item &itemtarget);
+
+    /// <summary>
+    /// Queue a joint movement ("Move Joint" mode).
+    /// </summary>
+    /// <param name="joints">Robot joints to move to</param>
+    void MoveJ(const tJoints &joints);
+
+    /// <summary>
+    /// Queue a joint movement ("Move Joint" mode).
+    /// </summary>
+    /// <param name="target">Pose target to move to. It must be a 4x4 Homogeneous matrix</param>
+    void MoveJ(const Mat &target);
+
+    /// <summary>
+    /// Queue a linear movement ("Move Linear" mode).
+    /// </summary>
+    /// <param name="itemtarget">Target to move to as a target item (RoboDK target item)</param>
+    void MoveL(const Item &itemtarget);
+
+    /// <summary>
+    /// Queue a linear movement ("Move Linear" mode).
+    /// </summary>
+    /// <param name="joints">Robot joints to move to</param>
+    void MoveL(const tJoints &joints);
+
+    /// <summary>
+    /// Queue a linear movement ("Move Linear" mode).
+    /// </summary>
+    /// <param name="target">Pose target to move to. It must be a 4x4 Homogeneous matrix</param>
+    void MoveL(const Mat &target);
+
+    /// <summary>
+    /// Queue a circular movement ("Move Circular" mode).
+    /// </summary>
+    /// <param name="itemtarget1">Intermediate target to move to as a target item (RoboDK target item)</param>
+    /// <param name="itemtarget2">Final target to move to as a target item (RoboDK target item)</param>
+    void MoveC(const Item &itemtarget1, const Item &itemtarget2);
+
+    /// <summary>
+    /// Queue a circular movement ("Move Circular" mode).
+    /// </summary>
+    /// <param name="joints1">Intermediate joint target to move to.</param>
+    /// <param name="joints2">Final joint target to move to.</param>
+    void MoveC(const tJoints &joints1, const tJoints &joints2);
+
+    /// <summary>
+    /// Queue a circular movement ("Move Circular" mode).
+    /// </summary>
+    /// <param name="target1">Intermediate pose target to move to. It must be a 4x4 Homogeneous matrix</param>
+    /// <param name="target2">Final pose target to move to. It must be a 4x4 Homogeneous matrix</param>
+    void MoveC(const Mat &target1, const Mat &target2);
+
+    /// <summary>
+    /// Returns the number of movements sent to RoboDK that did not finish yet (as far as this client knows).
+    /// </summary>
+    int InFlight() const;
+
+    /// <summary>
+    /// Returns the number of movements queued since the queue was created.
+    /// </summary>
+    int Count() const;
+
+    /// <summary>
+    /// Waits until all queued movements finish.
+    /// </summary>
+    /// <param name="errors">Optional list to retrieve the movements that failed</param>
+    /// <returns>Number of movements that failed</returns>
+    int WaitDone(QList<tPipelineError> *errors = nullptr);
+
+private:
+    void _queued();
+
+    RoboDK *_RDK;
+    Item _ROBOT;
+    int _MAX_IN_FLIGHT;
+    int _TIMEOUT;
+    int _COUNT;
+};
+
+
+
+/// \brief The ProgramBuilder class accumulates the instructions of a program on the client side and adds them to a program item at once (see Commit).
+/// Adding instructions one by one with Item::MoveJ, Item::MoveL or Item::RunInstruction costs at least one round trip each.
+/// Commit sends the requests back to back and reads the statuses while more requests are sent, so long programs (such as paths with thousands of points) are created in a few round trips.
+/// Instructions are stored as a structure of arrays: the type of each instruction, and its numeric values and texts in shared arrays.
+/// \code
+/// ProgramBuilder builder(points.length() + 2);
+/// builder.setSpeed(100);
+/// builder.setRounding(1);
+/// for (int i=0; i<points.length(); i++){
+///     builder.MoveL(points[i]);
+/// }
+/// QList<tPipelineError> errors;
+/// builder.Commit(program, &errors);
+/// \endcode
+class ROBODK ProgramBuilder {
+public:
+    /// <summary>
+    /// Create an empty program builder.
+    /// </summary>
+    /// <param name="reserve">Number of instructions to allocate memory for</param>
+    ProgramBuilder(int reserve = 0);
+
+    /// <summary>
+    /// Allocate memory for a number of instructions (movements of 6 axis robots).
+    /// </summary>
+    void Reserve(int instructions);
+
+    /// <summary>
+    /// Add a joint movement ("Move Joint" mode) to a joint target.
+    /// </summary>
+    /// <param name="joints">Robot joints to move to</param>
+    void MoveJ(const tJoints &joints);
+
+    /// <summary>
+    /// Add a joint movement ("Move Joint" mode) to a pose target.
+    /// </summary>
+    /// <param name="target">Pose target to move to. It must be a 4x4 Homogeneous matrix</param>
+    void MoveJ(const Mat &target);
+
+    /// <summary>
+    /// Add a linear movement ("Move Linear" mode) to a joint target.
+    /// </summary>
+    /// <param name="joints">Robot joints to move to</param>
+    void MoveL(const tJoints &joints);
+
+    /// <summary>
+    /// Add a linear movement ("Move Linear" mode) to a pose target.
+    /// </summary>
+    /// <param name="target">Pose target to move to. It must be a 4x4 Homogeneous matrix</param>
+    void MoveL(const Mat &target);
+
+    /// <summary>
+    /// Add a speed and/or acceleration change (see Item::setSpeed).
+    /// </summary>
+    /// <param name="speed_linear">linear speed in mm/s (-1 = no change)</param>
+    /// <param name="accel_linear">linear acceleration in mm/s2 (-1 = no change)</param>
+    /// <param name="speed_joints">joint speed in deg/s (-1 = no change)</param>
+    /// <param name="accel_joints">joint acceleration in deg/s2 (-1 = no change)</param>
+    void setSpeed(double speed_linear, double accel_linear = -1, double speed_joints = -1, double accel_joints = -1);
+
+    /// <summary>
+    /// Add a rounding change (see Item::setRounding).
+    /// </summary>
+    /// <param name="zonedata">zonedata value (robot dependent, set to -1 for fine movements)</param>
+    void setRounding(double zonedata);
+
+    /// <summary>
+    /// Add an instruction to set a digital output (see Item::setDO).
+    /// </summary>
+    /// <param name="io_var">Digital output (string or number)</param>
+    /// <param name="io_value">Value (string or number)</param>
+    void setDO(const QString &io_var, const QString &io_value);
+
+    /// <summary>
+    /// Add an instruction to set an analog output (see Item::setAO).
+    /// </summary>
+    /// <param name="io_var">Analog output (string or number)</param>
+    /// <param name="io_value">Value (string or number)</param>
+    void setAO(const QString &io_var, const QString &io_value);
+
+    /// <summary>
+    /// Add an instruction to wait for a digital input (see Item::waitDI).
+    /// </summary>
+    /// <param name="io_var">Digital input (string or number)</param>
+    /// <param name="io_value">Value (string or number)</param>
+    /// <param name="timeout_ms">Timeout in milliseconds</param>
+    void waitDI(const QString &io_var, const QString &io_value, double timeout_ms = -1);
+
+    /// <summary>
+    /// Add a pause (see Item::Pause).
+    /// </summary>
+    /// <param name="time_ms">Time in milliseconds (-1 to stop until the user resumes the program)</param>
+    void Pause(double time_ms = -1);
+
+    /// <summary>
+    /// Add a program call, code, message or comment (see Item::RunInstruction).
+    /// </summary>
+    /// <param name="code">Code or program to run</param>
+    /// <param name="run_type">RoboDK::INSTRUCTION_* type</param>
+    void RunInstruction(const QString &code, int run_type = RoboDK::INSTRUCTION_CALL_PROGRAM);
+
+    /// <summary>
+    /// Add a comment (same as RunInstruction with RoboDK::INSTRUCTION_COMMENT).
+    /// </summary>
+    void Comment(const QString &comment);
+
+    /// <summary>
+    /// Returns the number of instructions added.
+    /// </summary>
+    int Count() const;
+
+    /// <summary>
+    /// Remove all the instructions.
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Add all the instructions to a program, in order. The instructions are kept, so the same instructions can be added to another program.
+    /// Up to max_pending requests are sent before the oldest status is read. If the connection is lost, the remaining instructions are reported as failed.
+    /// </summary>
+    /// <param name="program">Program item</param>
+    /// <param name="errors">Optional list to retrieve the instructions that failed or raised a warning (index of the instruction, command, status and message)</param>
+    /// <param name="max_pending">Maximum number of requests sent before their status is read</param>
+    /// <returns>Number of instructions that failed or raised a warning</returns>
+    int Commit(const Item &program, QList<tPipelineError> *errors = nullptr, int max_pending = 256);
+
+private:
+    enum {
+        INS_MOVEJ_JOINTS, INS_MOVEJ_POSE, INS_MOVEL_JOINTS, INS_MOVEL_POSE,
+        INS_SPEED, INS_ROUNDING, INS_SET_DO, INS_SET_AO, INS_WAIT_DI, INS_PAUSE, INS_RUN_INSTRUCTION
+    };
+
+    void _add(int type, const double *values, int nvalues);
+    void _send(RoboDK *rdk, const Item &program, int ins) const;
+    bool _read(RoboDK *rdk, int ins, QList<tPipelineError> *errors) const;
+
+    QVector<quint8> _TYPE;          // type of each instruction (INS_*)
+    QVector<qint32> _VALUE_START;   // first value of each instruction in _VALUES (values end where the next instruction starts)
+    QVector<qint32> _TEXT_START;    // first text of each instruction in _TEXTS
+    QVector<double> _VALUES;        // joints, poses (column-major), speeds and other numeric values
+    QVector<QString> _TEXTS;        // IO names and values, code and comments
+};
+
+
+
+/// \brief The ReachabilityMap class stores the orientations a robot can reach in each voxel of a grid (reachability map).
+/// Each voxel holds a bitset of the reachable orientations (up to 64) and the number of inverse kinematics solutions found (sum for all orientations).
+/// Build the map once with the inverse kinematics of a robot (see Item::SolveIK_All), save it to a file and open it later: the file is memory-mapped, opening a map is immediate.
+/// \code
+/// ReachabilityMap map;
+/// tXYZ origin = { -1500, -1500, 0 };
+/// map.setGrid(origin, 25.0, 121, 121, 81);
+/// map.setOrientations(orientations); // list of rotations
+/// map.Build(robot, &tool);
+/// map.Save("robot.rmap");
+/// ...
+/// map.Open("robot.rmap");
+/// tXYZ point = { 800, 200, 500 };
+/// bool reachable = map.Reachable(point);
+/// \endcode
+class ROBODK ReachabilityMap {
+public:
+    ReachabilityMap();
+    ~ReachabilityMap();
+
+    /// <summary>
+    /// Set the voxel grid. This removes the data of the map.
+    /// </summary>
+    /// <param name="origin">Center of the first voxel (mm), with respect to the robot base (or the reference used to build the map)</param>
+    /// <param name="voxel_size">Size of the voxels (mm)</param>
+    /// <param name="nx">Number of voxels along X</param>
+    /// <param name="ny">Number of voxels along Y</param>
+    /// <param name="nz">Number of voxels along Z</param>
+    /// <returns>True if successful</returns>
+    bool setGrid(const tXYZ origin, double voxel_size, int nx, int ny, int nz);
+
+    /// <summary>
+    /// Set the orientations tested in each voxel (only the rotation of each pose is used). This removes the data of the map.
+    /// </summary>
+    /// <param name="orientations">List of orientations (up to 64)</param>
+    /// <returns>True if successful</returns>
+    bool setOrientations(const QList<Mat> &orientations);
+
+    /// <summary>
+    /// Build the map: solves the inverse kinematics for each voxel center and orientation.
+    /// </summary>
+    /// <param name="robot">Robot item</param>
+    /// <param name="tool">Optionally provide a tool pose, otherwise, the robot flange is used</param>
+    /// <param name="ref">Optionally provide a reference pose for the grid, otherwise, the robot base is used</param>
+    /// <returns>Number of voxels where at least one orientation is reachable, -1 if it failed</returns>
+    int Build(Item &robot, const Mat *tool = nullptr, const Mat *ref = nullptr);
+
+    /// <summary>
+    /// Save the map to a file.
+    /// </summary>
+    /// <returns>True if successful</returns>
+    bool Save(const QString &filename) const;
+
+    /// <summary>
+    /// Open a map saved with Save. The file is memory-mapped (read only) until the map is closed or modified.
+    /// </summary>
+    /// <returns>True if successful</returns>
+    bool Open(const QString &filename);
+
+    /// <summary>
+    /// Remove the data of the map and close the file (if any).
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Returns true if the map holds data (built or opened).
+    /// </summary>
+    bool Valid() const;
+
+    /// <summary>
+    /// Number of voxels along X (dim=0), Y (dim=1) or Z (dim=2). Use dim=-1 to retrieve the total number of voxels.
+    /// </summary>
+    int Size(int dim = -1) const;
+
+    /// <summary>
+    /// Returns the list of orientations.
+    /// </summary>
+    QList<Mat> Orientations() const;
+
+    /// <summary>
+    /// Returns the index of the voxel containing a point (-1 if the point is outside the grid).
+    /// </summary>
+    int VoxelIndex(const tXYZ xyz) const;
+
+    /// <summary>
+    /// Retrieve the center of a voxel.
+    /// </summary>
+    void VoxelCenter(int index, tXYZ xyz) const;
+
+    /// <summary>
+    /// Returns the bitset of the reachable orientations of a voxel (bit i is set if orientation i is reachable).
+    /// </summary>
+    quint64 ReachableBits(int index) const;
+
+    /// <summary>
+    /// Returns the number of inverse kinematics solutions found in a voxel (sum for all orientations).
+    /// </summary>
+    int Solutions(int index) const;
+
+    /// <summary>
+    /// Returns true if a point is reachable.
+    /// </summary>
+    /// <param name="xyz">Point (mm)</param>
+    /// <param name="orientation">Index of the orientation, or -1 to accept any orientation</param>
+    bool Reachable(const tXYZ xyz, int orientation = -1) const;
+
+private:
+    Q_DISABLE_COPY(ReachabilityMap)
+
+    void _clearData();
+
+    double _ORIGIN[3];
+    double _VOXEL;
+    int _SIZE[3];
+    QList<Mat> _ORIENTATIONS;
+
+    /// Data of a map built in memory
+    QVector<quint64> _BITS_DATA;
+    QVector<quint16> _COUNT_DATA;
+
+    /// Memory-mapped file of a map opened from a file
+    QFile *_FILE;
+    uchar *_MAP;
+
+    /// Data of the map (built in memory or memory-mapped)
+    const quint64 *_BITS;
+    const quint16 *_COUNT;
+};
+
+
 
 /// Translation matrix class: Mat::transl.
 ROBODK Mat transl(double x, double y, double z);
@@ -2451,6 +4375,17 @@ ROBODK void Matrix2D_Delete(tMatrix2D **mat);
 /// @param[in] cols: The number of columns.
 ROBODK void Matrix2D_Set_Size(tMatrix2D *mat, int rows, int cols);
 
+/// @brief Appends a column to a \ref tMatrix2D (the matrix grows by one column).
+/// @param[in/out] mat: Pointer to the matrix
+/// @param[in] array: Values of the column
+/// @param[in] numel: Number of values (values beyond the number of rows are ignored)
+ROBODK void Matrix2D_Add(tMatrix2D *mat, const double *array, int numel);
+
+/// @brief Appends the columns of a \ref tMatrix2D to another one with the same number of rows.
+/// @param[in/out] mat: Pointer to the matrix
+/// @param[in] matadd: Matrix to append
+ROBODK void Matrix2D_Add(tMatrix2D *mat, const tMatrix2D *matadd);
+
 /// @brief Sets the size of a \ref tMatrix2D.
 /// @param[in/out] mat: Pointer to the matrix
 /// @param[in] dim: Dimension (1 or 2)
@@ -0,0 +1,1308 @@
+#include "robodk_mock.h"
+#include "robodk_api.h"
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QtCore/QThread>
+#include <QtCore/QSemaphore>
+#include <QtCore/QFileInfo>
+#include <QtCore/QtEndian>
+#include <cmath>
+#include <cstring>
+
+
+#ifndef RDK_SKIP_NAMESPACE
+namespace RoboDK_API {
+#endif
+
+
+#define ROBODK_MOCK_POLL 20 // period to check if the server is closing (ms)
+#define ROBODK_MOCK_CHUNK 16384 // maximum bytes written at once when the bandwidth is limited (10 ms of transfer otherwise)
+#define ROBODK_MOCK_FIRST_PTR 0x1000 // pointer of the first item
+
+
+static void Mock_Pose_Identity(double pose[16]){
+    memset(pose, 0, 16*sizeof(double));
+    pose[0] = pose[5] = pose[10] = pose[15] = 1.0;
+}
+
+// Append doubles in the byte order of the RoboDK protocol (big endian)
+static void Mock_Append_Doubles(QByteArray &buffer, const double *values, qint64 n){
+    int pos = buffer.size();
+    buffer.resize(pos + n*sizeof(double));
+    uchar *dst = (uchar*) buffer.data() + pos;
+    for (qint64 i=0; i<n; i++){
+        quint64 bits;
+        memcpy(&bits, values + i, sizeof(double));
+        qToBigEndian<quint64>(bits, dst + i*sizeof(double));
+    }
+}
+
+// Convert doubles from the byte order of the RoboDK protocol
+static void Mock_Read_Doubles(double *values, const QByteArray &bytes, qint64 n){
+    for (qint64 i=0; i<n; i++){
+        quint64 bits = qFromBigEndian<quint64>((const uchar*) bytes.constData() + i*sizeof(double));
+        memcpy(values + i, &bits, sizeof(double));
+    }
+}
+
+// out = a * b (column-major 4x4 matrices)
+static void Mock_Pose_Multiply(const double a[16], const double b[16], double out[16]){
+    double result[16];
+    for (int c=0; c<4; c++){
+        for (int r=0; r<4; r++){
+            double value = 0;
+            for (int k=0; k<4; k++){
+                value += a[k*4 + r] * b[c*4 + k];
+            }
+            result[c*4 + r] = value;
+        }
+    }
+    memcpy(out, result, sizeof(result));
+}
+
+// Pose of the first count links of a DHM table: product of rotx(alpha)*transl(a,0,0)*rotz(theta+q)*transl(0,0,d) for each joint
+static void Mock_DHM_Pose(const QVector<double> &dhm, const QVector<double> &joints, int count, double pose[16]){
+    Mock_Pose_Identity(pose);
+    for (int j=0; j<count; j++){
+        const double *dhm_j = dhm.constData() + 4*j;
+        double alpha = dhm_j[0] * M_PI / 180.0;
+        double theta = (dhm_j[2] + (j < joints.size() ? joints[j] : 0.0)) * M_PI / 180.0;
+        double ca = cos(alpha);
+        double sa = sin(alpha);
+        double ct = cos(theta);
+        double st = sin(theta);
+        double link[16] = {
+            ct, st*ca, st*sa, 0,
+            -st, ct*ca, ct*sa, 0,
+            0, -sa, ca, 0,
+            dhm_j[1], -sa*dhm_j[3], ca*dhm_j[3], 1
+        };
+        Mock_Pose_Multiply(pose, link, pose);
+    }
+}
+
+// Angle in degrees within [-180, 180]
+static double Mock_Angle(double angle_rad){
+    return remainder(angle_rad * 180.0 / M_PI, 360.0);
+}
+
+// True if the DHM table is a 6 axis robot with a spherical wrist that Mock_DHM_IK can solve:
+// alpha = [0, -90, 0, -90, 90, -90] (deg) and d2 = d3 = d5 = a5 = a6 = 0
+static bool Mock_DHM_Spherical(const QVector<double> &dhm){
+    static const double alpha[6] = { 0, -90, 0, -90, 90, -90 };
+    if (dhm.size() != 24){
+        return false;
+    }
+    for (int j=0; j<6; j++){
+        if (fabs(dhm[4*j] - alpha[j]) > 1e-9){
+            return false;
+        }
+    }
+    return dhm[7] == 0 && dhm[11] == 0 && dhm[19] == 0 && dhm[17] == 0 && dhm[21] == 0 && dhm[9] != 0;
+}
+
+// Inverse kinematics of a robot with a spherical wrist (see Mock_DHM_Spherical), derived by hand from the DHM model (independent of Kinematics).
+// The wrist center only depends on joints 1 to 3:
+//   W = (a1,0,0) + rotz(t1)*(a2 + u, 0, d1 - v)  with  (u,v) = rotz(t2)*((a3,0) + rotz(t3)*(a4,d4))
+// where tj = thetaj + qj. Joints 4 to 6 follow from the orientation of the wrist: rotx(90)*R03'*R = rotz(t4)*roty(-t5)*rotz(t6).
+// Up to 8 solutions: joint 1 to the front or to the rear, elbow up or down and wrist flipped or not.
+static QList<QVector<double> > Mock_DHM_IK(const QVector<double> &dhm, const double pose[16]){
+    QList<QVector<double> > solutions;
+    if (!Mock_DHM_Spherical(dhm)){
+        return solutions;
+    }
+    const double a1 = dhm[1], d1 = dhm[3], a2 = dhm[5], a3 = dhm[9], a4 = dhm[13], d4 = dhm[15], d6 = dhm[23];
+    double theta[6];
+    for (int j=0; j<6; j++){
+        theta[j] = dhm[4*j + 2] * M_PI / 180.0;
+    }
+    // wrist center: the flange is d6 along its Z axis
+    double wx = pose[12] - d6*pose[8] - a1;
+    double wy = pose[13] - d6*pose[9];
+    double wz = pose[14] - d6*pose[10];
+    double rho = sqrt(wx*wx + wy*wy);
+    double forearm = sqrt(a4*a4 + d4*d4);
+    double beta = atan2(d4, a4);
+    for (int rear=0; rear<2; rear++){
+        double t1 = atan2(wy, wx) + (rear ? M_PI : 0.0);
+        double u = (rear ? -rho : rho) - a2;
+        double v = d1 - wz;
+        double c = (u*u + v*v - a3*a3 - forearm*forearm) / (2*a3*forearm);
+        if (fabs(c) > 1.0 + 1e-12){
+            continue; // out of reach
+        }
+        c = qBound(-1.0, c, 1.0);
+        for (int lower=0; lower<2; lower++){
+            double elbow = lower ? -acos(c) : acos(c); // t3 + beta
+            double t3 = elbow - beta;
+            double t2 = atan2(v, u) - atan2(forearm*sin(elbow), a3 + forearm*cos(elbow));
+            QVector<double> joints(6, 0.0);
+            joints[0] = Mock_Angle(t1 - theta[0]);
+            joints[1] = Mock_Angle(t2 - theta[1]);
+            joints[2] = Mock_Angle(t3 - theta[2]);
+            // A = rotx(90) * R03' * R (3x3, A[r][c])
+            double pose3[16];
+            Mock_DHM_Pose(dhm, joints, 3, pose3);
+            double r36[3][3];
+            for (int r=0; r<3; r++){
+                for (int k=0; k<3; k++){
+                    r36[r][k] = pose3[r*4 + 0]*pose[k*4 + 0] + pose3[r*4 + 1]*pose[k*4 + 1] + pose3[r*4 + 2]*pose[k*4 + 2];
+                }
+            }
+            double A[3][3];
+            for (int k=0; k<3; k++){
+                A[0][k] = r36[0][k];
+                A[1][k] = -r36[2][k];
+                A[2][k] = r36[1][k];
+            }
+            // rotz(a)*roty(b)*rotz(c): A[2][2] = cos(b), A[0][2] = cos(a)*sin(b), A[1][2] = sin(a)*sin(b), A[2][0] = -sin(b)*cos(c), A[2][1] = sin(b)*sin(c)
+            double cb = qBound(-1.0, A[2][2], 1.0);
+            for (int flip=0; flip<2; flip++){
+                double sb = sqrt(1.0 - cb*cb) * (flip ? -1.0 : 1.0);
+                double a, b, cc;
+                if (fabs(sb) < 1e-12){
+                    if (flip){
+                        break; // singular wrist: one solution with joint 4 at 0
+                    }
+                    a = 0;
+                    b = (cb > 0) ? 0.0 : M_PI;
+                    cc = (cb > 0) ? atan2(A[1][0], A[0][0]) : atan2(A[1][0], -A[0][0]);
+                } else {
+                    a = atan2(A[1][2] / sb, A[0][2] / sb);
+                    b = atan2(sb, cb);
+                    cc = atan2(A[2][1] / sb, -A[2][0] / sb);
+                }
+                QVector<double> solution = joints;
+                solution[3] = Mock_Angle(a - theta[3]);
+                solution[4] = Mock_Angle(-b - theta[4]);
+                solution[5] = Mock_Angle(cc - theta[5]);
+                solutions.append(solution);
+            }
+        }
+    }
+    return solutions;
+}
+
+// Index of the solution closest to the joints (-1 if there are no solutions)
+static int Mock_Closest(const QList<QVector<double> > &solutions, const QVector<double> &joints){
+    int closest = -1;
+    double closest_dist = 0;
+    for (int i=0; i<solutions.length(); i++){
+        double dist = 0;
+        for (int j=0; j<solutions[i].size(); j++){
+            double delta = remainder(solutions[i][j] - (j < joints.size() ? joints[j] : 0.0), 360.0);
+            dist += delta*delta;
+        }
+        if (closest < 0 || dist < closest_dist){
+            closest = i;
+            closest_dist = dist;
+        }
+    }
+    return closest;
+}
+
+
+
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// RoboDKMockSession CLASS //////////////////////////////////////////
+RoboDKMockSession::RoboDKMockSession(RoboDKMock *mock, QTcpSocket *socket) :
+    _MOCK(mock),
+    _SOCKET(socket),
+    _THROTTLE_US(0),
+    _OK(true),
+    _CLOSE(false)
+{
+}
+
+RoboDKMock *RoboDKMockSession::Mock() const {
+    return _MOCK;
+}
+
+// Wait until size bytes (or a line) can be read. Returns false if the client disconnected or the server is closing.
+bool RoboDKMockSession::_wait(qint64 size, bool line){
+    while (line ? !_SOCKET->canReadLine() : _SOCKET->bytesAvailable() < size){
+        if (!_OK || _MOCK->_STOP.loadAcquire() || _SOCKET->state() != QAbstractSocket::ConnectedState){
+            _OK = false;
+            return false;
+        }
+        _SOCKET->waitForReadyRead(ROBODK_MOCK_POLL);
+    }
+    return true;
+}
+
+// Account the time needed to transfer bytes at the configured bandwidth
+void RoboDKMockSession::_throttle(qint64 bytes){
+    qint64 bandwidth = _MOCK->Bandwidth();
+    if (bandwidth <= 0){
+        return;
+    }
+    _THROTTLE_US += bytes * 1000000 / bandwidth;
+    if (_THROTTLE_US >= 1000){
+        QThread::usleep((unsigned long) _THROTTLE_US);
+        _THROTTLE_US = 0;
+    }
+}
+
+QString RoboDKMockSession::ReadLine(){
+    if (!_wait(0, true)){
+        return QString();
+    }
+    QByteArray line = _SOCKET->readLine();
+    _throttle(line.size());
+    line.chop(1);
+    return QString::fromUtf8(line);
+}
+
+qint32 RoboDKMockSession::ReadInt(){
+    QByteArray bytes = ReadBytes(sizeof(qint32));
+    if (bytes.size() != sizeof(qint32)){
+        return -1;
+    }
+    return qFromBigEndian<qint32>((const uchar*) bytes.constData());
+}
+
+quint64 RoboDKMockSession::ReadItem(){
+    QByteArray bytes = ReadBytes(sizeof(quint64));
+    if (bytes.size() != sizeof(quint64)){
+        return 0;
+    }
+    return qFromBigEndian<quint64>((const uchar*) bytes.constData());
+}
+
+bool RoboDKMockSession::ReadPose(double pose[16]){
+    QByteArray bytes = ReadBytes(16*sizeof(double));
+    if (bytes.size() != 16*sizeof(double)){
+        Mock_Pose_Identity(pose);
+        return false;
+    }
+    Mock_Read_Doubles(pose, bytes, 16);
+    return true;
+}
+
+QVector<double> RoboDKMockSession::ReadArray(){
+    qint32 nvalues = ReadInt();
+    QVector<double> values;
+    if (nvalues <= 0){
+        return values;
+    }
+    QByteArray bytes = ReadBytes((qint64) nvalues * sizeof(double));
+    if (bytes.size() != nvalues * (int) sizeof(double)){
+        return values;
+    }
+    values.resize(nvalues);
+    Mock_Read_Doubles(values.data(), bytes, nvalues);
+    return values;
+}
+
+QVector<double> RoboDKMockSession::ReadMatrix2D(int *rows, int *cols){
+    qint32 dim1 = ReadInt();
+    qint32 dim2 = ReadInt();
+    if (rows != nullptr){
+        *rows = qMax(dim1, 0);
+    }
+    if (cols != nullptr){
+        *cols = qMax(dim2, 0);
+    }
+    QVector<double> values;
+    if (dim1 <= 0 || dim2 <= 0){
+        return values;
+    }
+    qint64 nvalues = (qint64) dim1 * dim2;
+    QByteArray bytes = ReadBytes(nvalues * sizeof(double));
+    if (bytes.size() != nvalues * (qint64) sizeof(double)){
+        return values;
+    }
+    values.resize(nvalues);
+    Mock_Read_Doubles(values.data(), bytes, nvalues);
+    return values;
+}
+
+QByteArray RoboDKMockSession::ReadBytes(qint64 size){
+    if (size <= 0 || !_wait(size, false)){
+        return QByteArray();
+    }
+    QByteArray bytes = _SOCKET->read(size);
+    _throttle(bytes.size());
+    return bytes;
+}
+
+void RoboDKMockSession::WriteLine(const QString &line){
+    _RESPONSE.append(line.toUtf8());
+    _RESPONSE.append('\n');
+}
+
+void RoboDKMockSession::WriteInt(qint32 value){
+    uchar bytes[sizeof(qint32)];
+    qToBigEndian<qint32>(value, bytes);
+    _RESPONSE.append((const char*) bytes, sizeof(qint32));
+}
+
+void RoboDKMockSession::WriteItem(quint64 ptr, qint32 type){
+    uchar bytes[sizeof(quint64)];
+    qToBigEndian<quint64>(ptr, bytes);
+    _RESPONSE.append((const char*) bytes, sizeof(quint64));
+    WriteInt(type);
+}
+
+void RoboDKMockSession::WritePose(const double pose[16]){
+    Mock_Append_Doubles(_RESPONSE, pose, 16);
+}
+
+void RoboDKMockSession::WriteArray(const QVector<double> &values){
+    WriteInt(values.size());
+    Mock_Append_Doubles(_RESPONSE, values.constData(), values.size());
+}
+
+void RoboDKMockSession::WriteMatrix2D(int rows, int cols, const double *values){
+    WriteInt(rows);
+    WriteInt(cols);
+    Mock_Append_Doubles(_RESPONSE, values, (qint64) rows * cols);
+}
+
+void RoboDKMockSession::WriteBytes(const QByteArray &bytes){
+    _RESPONSE.append(bytes);
+}
+
+void RoboDKMockSession::WriteStatus(int status, const QString &message){
+    WriteInt(status);
+    if (status == 2 || status == 3 || (status >= 10 && status < 100)){
+        WriteLine(message);
+    }
+}
+
+void RoboDKMockSession::Flush(){
+    if (_RESPONSE.isEmpty() || !_OK){
+        _RESPONSE.resize(0);
+        return;
+    }
+    int latency = _MOCK->Latency();
+    if (latency > 0){
+        QThread::msleep(latency);
+    }
+    qint64 bandwidth = _MOCK->Bandwidth();
+    qint64 chunk = (bandwidth > 0) ? qBound<qint64>(1, bandwidth / 100, ROBODK_MOCK_CHUNK) : _RESPONSE.size();
+    qint64 pos = 0;
+    while (pos < _RESPONSE.size()){
+        qint64 size = qMin<qint64>(chunk, _RESPONSE.size() - pos);
+        _SOCKET->write(_RESPONSE.constData() + pos, size);
+        pos += size;
+        _throttle(size);
+        while (_SOCKET->bytesToWrite() > 0){
+            if (_MOCK->_STOP.loadAcquire() || _SOCKET->state() != QAbstractSocket::ConnectedState){
+                _OK = false;
+                _RESPONSE.resize(0);
+                return;
+            }
+            _SOCKET->waitForBytesWritten(ROBODK_MOCK_POLL);
+        }
+    }
+    _RESPONSE.resize(0);
+}
+
+void RoboDKMockSession::Close(){
+    _CLOSE = true;
+}
+
+bool RoboDKMockSession::Ok() const {
+    return _OK;
+}
+
+
+
+//---------------------------------------------------------------------------------------------------
+/////////////////////////////////// RoboDKMock CLASS /////////////////////////////////////////////////
+
+/// Thread serving one connection of a RoboDKMock
+class MockConnection : public QThread {
+public:
+    MockConnection(RoboDKMock *mock, qintptr descriptor) :
+        _MOCK(mock),
+        _DESCRIPTOR(descriptor)
+    {
+    }
+
+protected:
+    void run() override {
+        QTcpSocket socket;
+        if (!socket.setSocketDescriptor(_DESCRIPTOR)){
+            return;
+        }
+        socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        _MOCK->_serve(&socket);
+        socket.close();
+    }
+
+private:
+    RoboDKMock *_MOCK;
+    qintptr _DESCRIPTOR;
+};
+
+/// TCP server that keeps the descriptors of new connections: each connection is served by its own thread
+class MockTcpServer : public QTcpServer {
+public:
+    QList<qintptr> Pending;
+
+protected:
+    void incomingConnection(qintptr descriptor) override {
+        Pending.append(descriptor);
+    }
+};
+
+/// Thread accepting the connections of a RoboDKMock
+class MockListener : public QThread {
+public:
+    MockListener(RoboDKMock *mock, int port) :
+        Listening(false),
+        Port(port),
+        _MOCK(mock)
+    {
+    }
+    ~MockListener(){
+        wait();
+    }
+
+    /// Released once the server is listening (or failed to listen)
+    QSemaphore Started;
+    bool Listening;
+    int Port;
+
+protected:
+    void run() override {
+        MockTcpServer server;
+        Listening = server.listen(QHostAddress::LocalHost, Port);
+        Port = server.serverPort();
+        Started.release();
+        QList<MockConnection*> connections;
+        while (Listening && !_MOCK->_STOP.loadAcquire()){
+            server.waitForNewConnection(ROBODK_MOCK_POLL);
+            while (!server.Pending.isEmpty()){
+                MockConnection *connection = new MockConnection(_MOCK, server.Pending.takeFirst());
+                connections.append(connection);
+                connection->start();
+            }
+            for (int i=connections.length()-1; i>=0; i--){
+                if (connections[i]->isFinished()){
+                    delete connections.takeAt(i);
+                }
+            }
+        }
+        server.close();
+        for (int i=0; i<connections.length(); i++){
+            connections[i]->wait();
+        }
+        qDeleteAll(connections);
+    }
+
+private:
+    RoboDKMock *_MOCK;
+};
+
+
+RoboDKMock::RoboDKMock() :
+    _NEXT_PTR(ROBODK_MOCK_FIRST_PTR),
+    _LATENCY(0),
+    _BANDWIDTH(0),
+    _JOINTLIST_ROWS(10),
+    _JOINTLIST_COLS(100),
+    _LISTENER(nullptr)
+{
+    _STOP.store(0);
+    _COMMANDS.store(0);
+    _default_handlers();
+}
+
+RoboDKMock::~RoboDKMock(){
+    Close();
+}
+
+bool RoboDKMock::Listen(int port){
+    Close();
+    _STOP.store(0);
+    _COMMANDS.store(0);
+    MockListener *listener = new MockListener(this, port);
+    listener->start();
+    listener->Started.acquire();
+    if (!listener->Listening){
+        qDebug() << "RoboDKMock: Could not listen on port " << port;
+        delete listener;
+        return false;
+    }
+    _LISTENER = listener;
+    return true;
+}
+
+void RoboDKMock::Close(){
+    if (_LISTENER == nullptr){
+        return;
+    }
+    _STOP.storeRelease(1);
+    delete _LISTENER;
+    _LISTENER = nullptr;
+}
+
+int RoboDKMock::Port() const {
+    if (_LISTENER == nullptr){
+        return -1;
+    }
+    return static_cast<MockListener*>(_LISTENER)->Port;
+}
+
+void RoboDKMock::setLatency(int latency_ms){
+    QMutexLocker lock(&_MUTEX);
+    _LATENCY = qMax(latency_ms, 0);
+}
+
+int RoboDKMock::Latency() const {
+    QMutexLocker lock(&_MUTEX);
+    return _LATENCY;
+}
+
+void RoboDKMock::setBandwidth(qint64 bytes_per_second){
+    QMutexLocker lock(&_MUTEX);
+    _BANDWIDTH = qMax<qint64>(bytes_per_second, 0);
+}
+
+qint64 RoboDKMock::Bandwidth() const {
+    QMutexLocker lock(&_MUTEX);
+    return _BANDWIDTH;
+}
+
+void RoboDKMock::setHandler(const QString &command, const tHandler &handler){
+    QMutexLocker lock(&_MUTEX);
+    _HANDLERS.insert(command, handler);
+}
+
+quint64 RoboDKMock::AddItem(const QString &name, int type, const QVector<double> &joints, quint64 parent){
+    QMutexLocker lock(&_MUTEX);
+    tMockItem item;
+    item.ptr = _NEXT_PTR++;
+    item.name = name;
+    item.type = type;
+    item.parent = parent;
+    Mock_Pose_Identity(item.pose);
+    item.joints = joints;
+    _ITEMS.append(item);
+    return item.ptr;
+}
+
+tMockItem RoboDKMock::getItem(quint64 ptr) const {
+    QMutexLocker lock(&_MUTEX);
+    for (int i=0; i<_ITEMS.length(); i++){
+        if (_ITEMS[i].ptr == ptr){
+            return _ITEMS[i];
+        }
+    }
+    tMockItem none;
+    none.ptr = 0;
+    none.type = -1;
+    none.parent = 0;
+    Mock_Pose_Identity(none.pose);
+    return none;
+}
+
+quint64 RoboDKMock::AddRobot(const QString &name, const QVector<double> &dhm, const QVector<double> &joints){
+    if (dhm.size() != 24){
+        return 0;
+    }
+    quint64 ptr = AddItem(name, RoboDK::ITEM_TYPE_ROBOT, joints.isEmpty() ? QVector<double>(6, 0.0) : joints);
+    QMutexLocker lock(&_MUTEX);
+    _item(ptr)->dhm = dhm;
+    return ptr;
+}
+
+void RoboDKMock::ForwardKinematics(quint64 ptr, const QVector<double> &joints, double pose[16]) const {
+    _fk(getItem(ptr), joints, pose);
+}
+
+QList<QVector<double> > RoboDKMock::InverseKinematics(quint64 ptr, const double pose[16]) const {
+    return _ik(getItem(ptr), pose);
+}
+
+void RoboDKMock::JointsConfig(quint64 ptr, const QVector<double> &joints, double config[3]) const {
+    _config(getItem(ptr), joints, config);
+}
+
+QList<tMockItem> RoboDKMock::Items() const {
+    QMutexLocker lock(&_MUTEX);
+    return _ITEMS;
+}
+
+void RoboDKMock::setJointListSize(int rows, int cols){
+    QMutexLocker lock(&_MUTEX);
+    _JOINTLIST_ROWS = qMax(rows, 0);
+    _JOINTLIST_COLS = qMax(cols, 0);
+}
+
+QHash<QString, QByteArray> RoboDKMock::Files() const {
+    QMutexLocker lock(&_MUTEX);
+    return _FILES;
+}
+
+int RoboDKMock::Commands() const {
+    return _COMMANDS.load();
+}
+
+QStringList RoboDKMock::Unsupported() const {
+    QMutexLocker lock(&_MUTEX);
+    return _UNSUPPORTED;
+}
+
+// Serve a client until it disconnects (runs in the thread of the connection)
+void RoboDKMock::_serve(QTcpSocket *socket){
+    RoboDKMockSession session(this, socket);
+    if (!session.ReadLine().startsWith("CMD_START")){
+        return;
+    }
+    session.ReadLine(); // API version
+    session.WriteLine("READY");
+    session.Flush();
+    while (session.Ok() && !session._CLOSE){
+        QString command = session.ReadLine();
+        if (!session.Ok()){
+            break;
+        }
+        _COMMANDS.fetchAndAddRelaxed(1);
+        tHandler handler;
+        {
+            QMutexLocker lock(&_MUTEX);
+            handler = _HANDLERS.value(command);
+            if (!handler && !_UNSUPPORTED.contains(command)){
+                _UNSUPPORTED.append(command);
+            }
+        }
+        bool keep = true;
+        if (handler){
+            keep = handler(session);
+        } else {
+            // the arguments are unknown, so the next command can't be found in the stream: close the connection
+            session.WriteStatus(3, "Unsupported command: " + command);
+            session.Close();
+        }
+        session.Flush();
+        if (!keep){
+            break;
+        }
+    }
+}
+
+// Item of the station (the mutex must be locked). Returns nullptr if the item does not exist.
+tMockItem *RoboDKMock::_item(quint64 ptr){
+    for (int i=0; i<_ITEMS.length(); i++){
+        if (_ITEMS[i].ptr == ptr){
+            return &_ITEMS[i];
+        }
+    }
+    return nullptr;
+}
+
+// Remove an item and all its childs (the mutex must be locked)
+void RoboDKMock::_remove(quint64 ptr){
+    QList<quint64> childs;
+    for (int i=0; i<_ITEMS.length(); i++){
+        if (_ITEMS[i].parent == ptr){
+            childs.append(_ITEMS[i].ptr);
+        }
+    }
+    for (int i=0; i<childs.length(); i++){
+        _remove(childs[i]);
+    }
+    for (int i=0; i<_ITEMS.length(); i++){
+        if (_ITEMS[i].ptr == ptr){
+            _ITEMS.removeAt(i);
+            return;
+        }
+    }
+}
+
+// Forward kinematics of the mock robots.
+// DHM robots: product of rotx(alpha)*transl(a,0,0)*rotz(theta+q)*transl(0,0,d) for each joint (written out, independent of Kinematics).
+// Other robots: rotation of joint 1 around Z (deg) and translation of joints 2 to 4 (mm).
+void RoboDKMock::_fk(const tMockItem &robot, const QVector<double> &joints, double pose[16]) const {
+    if (!robot.dhm.isEmpty()){
+        Mock_DHM_Pose(robot.dhm, joints, robot.dhm.size() / 4, pose);
+        return;
+    }
+    Mock_Pose_Identity(pose);
+    double angle = joints.size() > 0 ? joints[0] * M_PI / 180.0 : 0.0;
+    pose[0] = cos(angle);
+    pose[1] = sin(angle);
+    pose[4] = -sin(angle);
+    pose[5] = cos(angle);
+    for (int i=0; i<3; i++){
+        pose[12 + i] = joints.size() > i + 1 ? joints[i + 1] : 0.0;
+    }
+}
+
+// All the inverse kinematics solutions of a robot (the remaining joints of the simple model are taken from the robot)
+QList<QVector<double> > RoboDKMock::_ik(const tMockItem &robot, const double pose[16]) const {
+    QList<QVector<double> > solutions;
+    if (!robot.dhm.isEmpty()){
+        return Mock_DHM_IK(robot.dhm, pose);
+    }
+    QVector<double> joints = robot.joints;
+    if (joints.size() < 4){
+        joints.resize(4);
+    }
+    joints[0] = atan2(pose[1], pose[0]) * 180.0 / M_PI;
+    joints[1] = pose[12];
+    joints[2] = pose[13];
+    joints[3] = pose[14];
+    solutions.append(joints);
+    return solutions;
+}
+
+// Configuration [REAR, LOWERARM, FLIP] of a robot (always 0 for the simple model), the branches of Mock_DHM_IK:
+// REAR if the wrist center is behind the axis of joint 1, LOWERARM if the elbow is bent the other way than at the home position
+// and FLIP if joint 5 is negative
+void RoboDKMock::_config(const tMockItem &robot, const QVector<double> &joints, double config[3]) const {
+    config[0] = config[1] = config[2] = 0.0;
+    if (!Mock_DHM_Spherical(robot.dhm) || joints.size() < 6){
+        return;
+    }
+    const QVector<double> &dhm = robot.dhm;
+    double pose[16];
+    Mock_DHM_Pose(dhm, joints, 6, pose);
+    double wx = pose[12] - dhm[23]*pose[8] - dhm[1];
+    double wy = pose[13] - dhm[23]*pose[9];
+    double t1 = (dhm[2] + joints[0]) * M_PI / 180.0;
+    double t3 = (dhm[10] + joints[2]) * M_PI / 180.0;
+    double beta = atan2(dhm[15], dhm[13]);
+    config[0] = (cos(t1)*wx + sin(t1)*wy < 0) ? 1.0 : 0.0;
+    config[1] = (sin(t3 + beta) * sin(dhm[10] * M_PI / 180.0 + beta) < 0) ? 1.0 : 0.0;
+    config[2] = (remainder(joints[4], 360.0) < 0) ? 1.0 : 0.0;
+}
+
+// Add an instruction to a program. Instructions sent to other items (such as robots) are ignored. Returns false if the item does not exist.
+bool RoboDKMock::_add_instruction(quint64 ptr, const tMockInstruction &instruction){
+    QMutexLocker lock(&_MUTEX);
+    tMockItem *item = _item(ptr);
+    if (item == nullptr){
+        return false;
+    }
+    if (item->type == RoboDK::ITEM_TYPE_PROGRAM){
+        item->instructions.append(instruction);
+    }
+    return true;
+}
+
+void RoboDKMock::_default_handlers(){
+    _HANDLERS.insert("G_Item", [this](RoboDKMockSession &session){
+        QString name = session.ReadLine();
+        QMutexLocker lock(&_MUTEX);
+        for (int i=0; i<_ITEMS.length(); i++){
+            if (_ITEMS[i].name.compare(name, Qt::CaseInsensitive) == 0){
+                session.WriteItem(_ITEMS[i].ptr, _ITEMS[i].type);
+                session.WriteStatus();
+                return true;
+            }
+        }
+        session.WriteItem(0, -1);
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("G_Item2", [this](RoboDKMockSession &session){
+        QString name = session.ReadLine();
+        int type = session.ReadInt();
+        QMutexLocker lock(&_MUTEX);
+        for (int i=0; i<_ITEMS.length(); i++){
+            if (_ITEMS[i].type == type && _ITEMS[i].name.compare(name, Qt::CaseInsensitive) == 0){
+                session.WriteItem(_ITEMS[i].ptr, _ITEMS[i].type);
+                session.WriteStatus();
+                return true;
+            }
+        }
+        session.WriteItem(0, -1);
+        session.WriteStatus();
+        return true;
+    });
+    auto list_items = [this](RoboDKMockSession &session, int filter){
+        QMutexLocker lock(&_MUTEX);
+        QList<tMockItem> items;
+        for (int i=0; i<_ITEMS.length(); i++){
+            if (filter < 0 || _ITEMS[i].type == filter){
+                items.append(_ITEMS[i]);
+            }
+        }
+        session.WriteInt(items.length());
+        for (int i=0; i<items.length(); i++){
+            session.WriteItem(items[i].ptr, items[i].type);
+        }
+        session.WriteStatus();
+        return true;
+    };
+    _HANDLERS.insert("G_List_Items_ptr", [list_items](RoboDKMockSession &session){
+        return list_items(session, -1);
+    });
+    _HANDLERS.insert("G_List_Items_Type_ptr", [list_items](RoboDKMockSession &session){
+        return list_items(session, session.ReadInt());
+    });
+    _HANDLERS.insert("G_Name", [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        QMutexLocker lock(&_MUTEX);
+        tMockItem *item = _item(ptr);
+        session.WriteLine(item == nullptr ? QString() : item->name);
+        session.WriteStatus(item == nullptr ? 1 : 0);
+        return true;
+    });
+    _HANDLERS.insert("S_Name", [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        QString name = session.ReadLine();
+        QMutexLocker lock(&_MUTEX);
+        tMockItem *item = _item(ptr);
+        if (item == nullptr){
+            session.WriteStatus(1);
+            return true;
+        }
+        item->name = name;
+        session.WriteStatus();
+        return true;
+    });
+    // the parent of the items attached to the station is an invalid item
+    _HANDLERS.insert("G_Parent", [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        QMutexLocker lock(&_MUTEX);
+        tMockItem *item = _item(ptr);
+        tMockItem *parent = (item == nullptr) ? nullptr : _item(item->parent);
+        if (parent == nullptr){
+            session.WriteItem(0, -1);
+        } else {
+            session.WriteItem(parent->ptr, parent->type);
+        }
+        session.WriteStatus(item == nullptr ? 1 : 0);
+        return true;
+    });
+    // poses are not composed with the parents: S_Parent and S_Parent_Static only change the station tree
+    tHandler set_parent = [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        quint64 parent = session.ReadItem();
+        QMutexLocker lock(&_MUTEX);
+        tMockItem *item = _item(ptr);
+        if (item == nullptr || (parent != 0 && _item(parent) == nullptr)){
+            session.WriteStatus(1);
+            return true;
+        }
+        item->parent = parent;
+        session.WriteStatus();
+        return true;
+    };
+    _HANDLERS.insert("S_Parent", set_parent);
+    _HANDLERS.insert("S_Parent_Static", set_parent);
+    _HANDLERS.insert("Add_FRAME", [this](RoboDKMockSession &session){
+        QString name = session.ReadLine();
+        quint64 parent = session.ReadItem();
+        quint64 ptr = AddItem(name, RoboDK::ITEM_TYPE_FRAME, QVector<double>(), parent);
+        session.WriteItem(ptr, RoboDK::ITEM_TYPE_FRAME);
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("Add_TARGET", [this](RoboDKMockSession &session){
+        QString name = session.ReadLine();
+        quint64 parent = session.ReadItem();
+        session.ReadItem(); // robot
+        quint64 ptr = AddItem(name, RoboDK::ITEM_TYPE_TARGET, QVector<double>(), parent);
+        session.WriteItem(ptr, RoboDK::ITEM_TYPE_TARGET);
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("Remove", [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        QMutexLocker lock(&_MUTEX);
+        if (_item(ptr) == nullptr){
+            session.WriteStatus(1);
+            return true;
+        }
+        _remove(ptr);
+        session.WriteStatus();
+        return true;
+    });
+    // poses are not composed with the parents: the absolute pose is the local pose
+    tHandler get_pose = [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        QMutexLocker lock(&_MUTEX);
+        tMockItem *item = _item(ptr);
+        if (item == nullptr){
+            double zeros[16] = {0};
+            session.WritePose(zeros);
+            session.WriteStatus(1);
+            return true;
+        }
+        session.WritePose(item->pose);
+        session.WriteStatus();
+        return true;
+    };
+    _HANDLERS.insert("G_Hlocal", get_pose);
+    _HANDLERS.insert("G_Hlocal_Abs", get_pose);
+    tHandler set_pose = [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        double pose[16];
+        session.ReadPose(pose);
+        QMutexLocker lock(&_MUTEX);
+        tMockItem *item = _item(ptr);
+        if (item == nullptr){
+            session.WriteStatus(1);
+            return true;
+        }
+        memcpy(item->pose, pose, sizeof(pose));
+        session.WriteStatus();
+        return true;
+    };
+    _HANDLERS.insert("S_Hlocal", set_pose);
+    _HANDLERS.insert("S_Hlocal_Abs", set_pose);
+    tHandler set_poses = [this](RoboDKMockSession &session){
+        qint32 nitems = session.ReadInt();
+        bool found = true;
+        for (int i=0; i<nitems && session.Ok(); i++){
+            quint64 ptr = session.ReadItem();
+            double pose[16];
+            session.ReadPose(pose);
+            QMutexLocker lock(&_MUTEX);
+            tMockItem *item = _item(ptr);
+            if (item == nullptr){
+                found = false;
+                continue;
+            }
+            memcpy(item->pose, pose, sizeof(pose));
+        }
+        session.WriteStatus(found ? 0 : 1);
+        return true;
+    };
+    _HANDLERS.insert("S_Hlocals", set_poses);
+    _HANDLERS.insert("S_Hlocal_AbsS", set_poses);
+    _HANDLERS.insert("G_Thetas", [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        QMutexLocker lock(&_MUTEX);
+        tMockItem *item = _item(ptr);
+        if (item == nullptr){
+            session.WriteArray(QVector<double>());
+            session.WriteStatus(1);
+            return true;
+        }
+        session.WriteArray(item->joints);
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("S_Thetas", [this](RoboDKMockSession &session){
+        QVector<double> joints = session.ReadArray();
+        quint64 ptr = session.ReadItem();
+        QMutexLocker lock(&_MUTEX);
+        tMockItem *item = _item(ptr);
+        if (item == nullptr){
+            session.WriteStatus(1);
+            return true;
+        }
+        item->joints = joints;
+        session.WriteStatus();
+        return true;
+    });
+    // the client sends all robots before reading the joints of each robot in order
+    _HANDLERS.insert("G_ThetasList", [this](RoboDKMockSession &session){
+        qint32 nitems = session.ReadInt();
+        QList<quint64> ptrs;
+        for (int i=0; i<nitems && session.Ok(); i++){
+            ptrs.append(session.ReadItem());
+        }
+        bool found = true;
+        QMutexLocker lock(&_MUTEX);
+        for (int i=0; i<ptrs.length(); i++){
+            tMockItem *item = _item(ptrs[i]);
+            found = found && item != nullptr;
+            session.WriteArray(item == nullptr ? QVector<double>() : item->joints);
+        }
+        session.WriteStatus(found ? 0 : 1);
+        return true;
+    });
+    _HANDLERS.insert("S_ThetasList", [this](RoboDKMockSession &session){
+        qint32 nitems = session.ReadInt();
+        bool found = true;
+        for (int i=0; i<nitems && session.Ok(); i++){
+            quint64 ptr = session.ReadItem();
+            QVector<double> joints = session.ReadArray();
+            QMutexLocker lock(&_MUTEX);
+            tMockItem *item = _item(ptr);
+            if (item == nullptr){
+                found = false;
+                continue;
+            }
+            item->joints = joints;
+        }
+        session.WriteStatus(found ? 0 : 1);
+        return true;
+    });
+    _HANDLERS.insert("G_FK", [this](RoboDKMockSession &session){
+        QVector<double> joints = session.ReadArray();
+        tMockItem robot = getItem(session.ReadItem());
+        double pose[16];
+        _fk(robot, joints, pose);
+        session.WritePose(pose);
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("G_IK", [this](RoboDKMockSession &session){
+        double pose[16];
+        session.ReadPose(pose);
+        tMockItem robot = getItem(session.ReadItem());
+        // the solution closest to the current joints
+        QList<QVector<double> > solutions = _ik(robot, pose);
+        int closest = Mock_Closest(solutions, robot.joints);
+        session.WriteArray(closest >= 0 ? solutions[closest] : QVector<double>());
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("G_IK_cmpl", [this](RoboDKMockSession &session){
+        double pose[16];
+        session.ReadPose(pose);
+        tMockItem robot = getItem(session.ReadItem());
+        // one column per solution: the joints followed by 2 values that are not used by the mock
+        QList<QVector<double> > solutions = _ik(robot, pose);
+        int ndofs = solutions.isEmpty() ? robot.joints.size() : solutions[0].size();
+        QVector<double> values;
+        for (int i=0; i<solutions.length(); i++){
+            values += solutions[i];
+            values += QVector<double>(2, 0.0);
+        }
+        session.WriteMatrix2D(ndofs + 2, solutions.length(), values.constData());
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("G_Thetas_Config", [this](RoboDKMockSession &session){
+        QVector<double> joints = session.ReadArray();
+        tMockItem robot = getItem(session.ReadItem());
+        double config[3];
+        _config(robot, joints, config);
+        session.WriteArray(QVector<double>() << config[0] << config[1] << config[2]);
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("G_RobLimits", [this](RoboDKMockSession &session){
+        tMockItem robot = getItem(session.ReadItem());
+        session.WriteArray(QVector<double>(robot.joints.size(), -180.0));
+        session.WriteArray(QVector<double>(robot.joints.size(), 180.0));
+        session.WriteInt(0); // joints type
+        session.WriteStatus(robot.ptr != 0 ? 0 : 1);
+        return true;
+    });
+    // MoveX moves a robot to the target immediately or adds the movement to a program, MoveXb also sends the status of the end of the movement
+    auto move = [this](bool blocking){
+        return tHandler([this, blocking](RoboDKMockSession &session){
+            tMockInstruction instruction;
+            instruction.type = RoboDK::INS_TYPE_MOVE;
+            instruction.movetype = session.ReadInt();
+            int target_type = session.ReadInt();
+            QVector<double> values = session.ReadArray();
+            tMockItem target = getItem(session.ReadItem());
+            quint64 ptr = session.ReadItem();
+            instruction.name = (instruction.movetype == 1) ? "MoveJ" : "MoveL";
+            instruction.joint_target = (target_type == 1);
+            Mock_Pose_Identity(instruction.pose);
+            if (target_type == 1){
+                instruction.joints = values;
+            } else if (target_type == 2 && values.size() == 16){
+                memcpy(instruction.pose, values.constData(), sizeof(instruction.pose));
+            } else if (target_type == 3 && target.ptr != 0){
+                instruction.joint_target = !target.joints.isEmpty();
+                instruction.joints = target.joints;
+                memcpy(instruction.pose, target.pose, sizeof(instruction.pose));
+            } else {
+                session.WriteStatus(3, "Invalid target");
+                return true;
+            }
+            QMutexLocker lock(&_MUTEX);
+            tMockItem *item = _item(ptr);
+            if (item == nullptr){
+                session.WriteStatus(1);
+                return true;
+            }
+            if (item->type == RoboDK::ITEM_TYPE_PROGRAM){
+                item->instructions.append(instruction);
+            } else if (instruction.joint_target){
+                item->joints = instruction.joints;
+            } else {
+                QList<QVector<double> > solutions = _ik(*item, instruction.pose);
+                int closest = Mock_Closest(solutions, item->joints);
+                if (closest < 0){
+                    session.WriteStatus(3, "Target not reachable");
+                    return true;
+                }
+                item->joints = solutions[closest];
+            }
+            session.WriteStatus();
+            if (blocking){
+                session.WriteStatus();
+            }
+            return true;
+        });
+    };
+    _HANDLERS.insert("MoveX", move(false));
+    _HANDLERS.insert("MoveXb", move(true));
+    _HANDLERS.insert("WaitMove", [](RoboDKMockSession &session){
+        session.ReadItem();
+        // movements finish immediately: the second status follows right away
+        session.WriteStatus();
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("S_Speed4", [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        QVector<double> speed_accel = session.ReadArray();
+        tMockInstruction instruction;
+        instruction.name = QString("Set speed (%1 mm/s)").arg(speed_accel.value(0));
+        instruction.type = RoboDK::INS_TYPE_CHANGESPEED;
+        session.WriteStatus(_add_instruction(ptr, instruction) ? 0 : 1);
+        return true;
+    });
+    _HANDLERS.insert("S_ZoneData", [this](RoboDKMockSession &session){
+        double zonedata = session.ReadInt() / 1000.0;
+        quint64 ptr = session.ReadItem();
+        tMockInstruction instruction;
+        instruction.name = QString("Set rounding (%1)").arg(zonedata);
+        instruction.type = RoboDK::INS_TYPE_CODE;
+        session.WriteStatus(_add_instruction(ptr, instruction) ? 0 : 1);
+        return true;
+    });
+    auto set_io = [this](const QString &name){
+        return tHandler([this, name](RoboDKMockSession &session){
+            quint64 ptr = session.ReadItem();
+            QString io_var = session.ReadLine();
+            QString io_value = session.ReadLine();
+            tMockInstruction instruction;
+            instruction.name = name + " " + io_var + "=" + io_value;
+            instruction.type = RoboDK::INS_TYPE_EVENT;
+            session.WriteStatus(_add_instruction(ptr, instruction) ? 0 : 1);
+            return true;
+        });
+    };
+    _HANDLERS.insert("setDO", set_io("setDO"));
+    _HANDLERS.insert("setAO", set_io("setAO"));
+    _HANDLERS.insert("waitDI", [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        QString io_var = session.ReadLine();
+        QString io_value = session.ReadLine();
+        session.ReadInt(); // timeout
+        tMockInstruction instruction;
+        instruction.name = "waitDI " + io_var + "=" + io_value;
+        instruction.type = RoboDK::INS_TYPE_EVENT;
+        session.WriteStatus(_add_instruction(ptr, instruction) ? 0 : 1);
+        return true;
+    });
+    _HANDLERS.insert("RunPause", [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        double time_ms = session.ReadInt() / 1000.0;
+        tMockInstruction instruction;
+        instruction.name = QString("Pause (%1 ms)").arg(time_ms);
+        instruction.type = RoboDK::INS_TYPE_PAUSE;
+        session.WriteStatus(_add_instruction(ptr, instruction) ? 0 : 1);
+        return true;
+    });
+    _HANDLERS.insert("RunCode2", [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        QString code = session.ReadLine();
+        session.ReadInt(); // run type
+        tMockInstruction instruction;
+        instruction.name = code;
+        instruction.type = RoboDK::INS_TYPE_CODE;
+        bool found = _add_instruction(ptr, instruction);
+        session.WriteInt(0); // program status
+        session.WriteStatus(found ? 0 : 1);
+        return true;
+    });
+    _HANDLERS.insert("Prog_Nins", [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        QMutexLocker lock(&_MUTEX);
+        tMockItem *item = _item(ptr);
+        session.WriteInt(item != nullptr ? item->instructions.length() : -1);
+        session.WriteStatus(item != nullptr ? 0 : 1);
+        return true;
+    });
+    _HANDLERS.insert("Prog_GIns", [this](RoboDKMockSession &session){
+        quint64 ptr = session.ReadItem();
+        qint32 ins_id = session.ReadInt();
+        QMutexLocker lock(&_MUTEX);
+        tMockItem *item = _item(ptr);
+        if (item == nullptr || ins_id < 0 || ins_id >= item->instructions.length()){
+            session.WriteLine("");
+            session.WriteInt(RoboDK::INS_TYPE_INVALID);
+            session.WriteStatus(3, "Invalid instruction id");
+            return true;
+        }
+        const tMockInstruction &instruction = item->instructions[ins_id];
+        session.WriteLine(instruction.name);
+        session.WriteInt(instruction.type);
+        if (instruction.type == RoboDK::INS_TYPE_MOVE){
+            session.WriteInt(instruction.movetype);
+            session.WriteInt(instruction.joint_target ? 1 : 0);
+            session.WritePose(instruction.pose);
+            session.WriteArray(instruction.joints);
+        }
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("G_ProgJointList", [this](RoboDKMockSession &session){
+        session.ReadItem();
+        session.ReadArray(); // steps and flags
+        QString save_to_file = session.ReadLine();
+        if (save_to_file.isEmpty()){
+            int rows;
+            int cols;
+            {
+                QMutexLocker lock(&_MUTEX);
+                rows = _JOINTLIST_ROWS;
+                cols = _JOINTLIST_COLS;
+            }
+            QVector<double> values((qint64) rows * cols);
+            for (int i=0; i<values.size(); i++){
+                values[i] = i * 0.001;
+            }
+            session.WriteMatrix2D(rows, cols, values.constData());
+        }
+        session.WriteInt(0); // error code
+        session.WriteLine("");
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("AddShape3", [this](RoboDKMockSession &session){
+        session.ReadMatrix2D();
+        session.ReadItem(); // add to
+        session.ReadInt();  // override shapes
+        session.ReadArray(); // color
+        quint64 ptr = AddItem("Shape", RoboDK::ITEM_TYPE_OBJECT);
+        session.WriteItem(ptr, RoboDK::ITEM_TYPE_OBJECT);
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("FileRecvBin", [this](RoboDKMockSession &session){
+        QString file_remote = session.ReadLine();
+        qint32 nbytes = session.ReadInt();
+        session.ReadItem(); // attach to
+        bool load_file = session.ReadInt() != 0;
+        session.WriteStatus();
+        session.Flush();
+        QByteArray data = session.ReadBytes(nbytes);
+        if (!session.Ok()){
+            return false;
+        }
+        {
+            QMutexLocker lock(&_MUTEX);
+            _FILES.insert(file_remote, data);
+        }
+        if (load_file){
+            AddItem(QFileInfo(file_remote).completeBaseName(), RoboDK::ITEM_TYPE_STATION);
+        }
+        return true;
+    });
+    _HANDLERS.insert("G_Param", [](RoboDKMockSession &session){
+        QString name = session.ReadLine();
+        session.WriteLine("UNKNOWN " + name);
+        session.WriteStatus();
+        return true;
+    });
+    _HANDLERS.insert("QUIT", [](RoboDKMockSession &session){
+        session.WriteStatus();
+        session.Close();
+        return true;
+    });
+}
+
+
+#ifndef RDK_SKIP_NAMESPACE
+}
+#endif
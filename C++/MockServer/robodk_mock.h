@@ -0,0 +1,353 @@
+// Copyright 2015-2020 - RoboDK Inc. - https://robodk.com/
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// --------------------------------------------
+// --------------- DESCRIPTION ----------------
+// In-process mock of the RoboDK API server.
+// It speaks the CMD_START/READY handshake and implements the core commands of the RoboDK API
+// with an item table kept in memory, so that the C++ API can be exercised and benchmarked without RoboDK
+// (for example on a headless Linux build server).
+//
+// Each connection is served by its own thread. A fixed latency per command and a bandwidth limit can be
+// configured to emulate a remote RoboDK. Commands can be added or replaced with setHandler.
+//
+// Supported commands: G_Item, G_Item2, G_List_Items_ptr, G_List_Items_Type_ptr, G_Name, S_Name, G_Parent, S_Parent, S_Parent_Static,
+// Add_FRAME, Add_TARGET, Remove, G_Hlocal, S_Hlocal, G_Hlocal_Abs, S_Hlocal_Abs, S_Hlocals, S_Hlocal_AbsS,
+// G_Thetas, S_Thetas, G_ThetasList, S_ThetasList, G_FK, G_IK, G_IK_cmpl, G_Thetas_Config, G_RobLimits, G_ProgJointList, MoveX, MoveXb, WaitMove,
+// S_Speed4, S_ZoneData, setDO, setAO, waitDI, RunPause, RunCode2, Prog_Nins, Prog_GIns, AddShape3, FileRecvBin, G_Param and QUIT.
+// An unknown command is answered with an error and the connection is closed (its arguments can't be skipped).
+//
+// Items keep their parent in the station tree, but poses are not composed with the parents: the absolute pose is the local pose.
+//
+// Robots added with AddItem have simple forward kinematics: joint 1 rotates around Z and joints 2 to 4 translate along X, Y and Z (mm).
+// G_IK returns the joints of that model (the remaining joints are taken from the robot), so FK and IK are consistent.
+// Robots added with AddRobot are 6 axis robots defined by a DHM table (modified Denavit Hartenberg). The mock has its own implementation
+// of the DHM model, independent of the kinematics of the API (Kinematics): G_FK uses ForwardKinematics, G_IK and G_IK_cmpl use the closed form
+// InverseKinematics of a robot with a spherical wrist and G_Thetas_Config uses JointsConfig.
+//
+// Movements (MoveX) move a robot to the target immediately. A movement sent to a program is added to its instructions,
+// as well as speed, rounding, IO, pause and code instructions (see Prog_Nins and Prog_GIns).
+// --------------------------------------------
+
+
+#ifndef ROBODK_MOCK_H
+#define ROBODK_MOCK_H
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QList>
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+#include <QtCore/QMutex>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <functional>
+
+
+class QTcpSocket;
+class QThread;
+
+
+#ifndef RDK_SKIP_NAMESPACE
+namespace RoboDK_API {
+#endif
+
+
+class RoboDKMock;
+
+
+/// \brief The tMockInstruction struct is an instruction of a program of a RoboDKMock (see Prog_GIns).
+struct tMockInstruction {
+    /// Instruction name
+    QString name;
+
+    /// Instruction type (RoboDK::INS_TYPE_...)
+    int type;
+
+    /// Movement type (1 for joint movements, 2 for linear movements)
+    int movetype;
+
+    /// True if the target of the movement is given as joints
+    bool joint_target;
+
+    /// Pose of the target (column-major 4x4 matrix, like Mat)
+    double pose[16];
+
+    /// Joints of the target
+    QVector<double> joints;
+};
+
+
+/// \brief The tMockItem struct is an item of the station of a RoboDKMock.
+struct tMockItem {
+    /// Item pointer given to the clients
+    quint64 ptr;
+
+    /// Item name
+    QString name;
+
+    /// Item type (RoboDK::ITEM_TYPE_...)
+    int type;
+
+    /// Parent item (0 for the station)
+    quint64 parent;
+
+    /// Local pose (column-major 4x4 matrix, like Mat)
+    double pose[16];
+
+    /// Joints of a robot or a target
+    QVector<double> joints;
+
+    /// DHM table of a robot added with AddRobot: [alpha(deg), a(mm), theta(deg), d(mm)] for each joint (empty for the simple kinematics)
+    QVector<double> dhm;
+
+    /// Instructions of a program
+    QList<tMockInstruction> instructions;
+};
+
+
+/// \brief The RoboDKMockSession class is the connection of one client to a RoboDKMock.
+/// Command handlers read the request and write the response with it. The response is sent once the handler returns (or when Flush is called),
+/// after the latency and at the bandwidth configured in the RoboDKMock.
+class RoboDKMockSession {
+public:
+    RoboDKMockSession(RoboDKMock *mock, QTcpSocket *socket);
+
+    /// <summary>
+    /// Mock server that owns this session.
+    /// </summary>
+    RoboDKMock *Mock() const;
+
+    /// Read a line of the request (without the line feed)
+    QString ReadLine();
+    /// Read a 32 bit integer of the request
+    qint32 ReadInt();
+    /// Read an item pointer of the request
+    quint64 ReadItem();
+    /// Read a pose of the request (16 doubles, column-major)
+    bool ReadPose(double pose[16]);
+    /// Read an array of doubles of the request (size followed by the values)
+    QVector<double> ReadArray();
+    /// Read a 2D matrix of the request. Returns the values column by column.
+    QVector<double> ReadMatrix2D(int *rows = nullptr, int *cols = nullptr);
+    /// Read raw bytes of the request
+    QByteArray ReadBytes(qint64 size);
+
+    void WriteLine(const QString &line);
+    void WriteInt(qint32 value);
+    void WriteItem(quint64 ptr, qint32 type);
+    void WritePose(const double pose[16]);
+    void WriteArray(const QVector<double> &values);
+    /// Write a 2D matrix given column by column
+    void WriteMatrix2D(int rows, int cols, const double *values);
+    void WriteBytes(const QByteArray &bytes);
+
+    /// <summary>
+    /// Write the status of the command. Statuses 2 and 3 (warning and error) are followed by the message.
+    /// </summary>
+    void WriteStatus(int status = 0, const QString &message = "");
+
+    /// <summary>
+    /// Send the response written so far (for commands that wait for the client after a first answer, such as FileRecvBin).
+    /// </summary>
+    void Flush();
+
+    /// <summary>
+    /// Close the connection once the current command is answered.
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Returns false once the client disconnected or a read failed.
+    /// </summary>
+    bool Ok() const;
+
+private:
+    friend class RoboDKMock;
+
+    bool _wait(qint64 size, bool line);
+    void _throttle(qint64 bytes);
+
+    RoboDKMock *_MOCK;
+    QTcpSocket *_SOCKET;
+    QByteArray _RESPONSE;  // response of the current command, sent by Flush
+    qint64 _THROTTLE_US;   // time owed to the bandwidth limit (us), slept once it reaches 1 ms
+    bool _OK;
+    bool _CLOSE;
+};
+
+
+/// \brief The RoboDKMock class is a lightweight RoboDK API server running in the calling process.
+/// \code
+/// RoboDKMock mock;
+/// mock.AddItem("UR10", RoboDK::ITEM_TYPE_ROBOT, QVector<double>(6, 0.0));
+/// mock.setLatency(2);
+/// mock.Listen();
+/// RoboDK rdk("127.0.0.1", mock.Port());
+/// Item robot = rdk.getItem("UR10");
+/// \endcode
+class RoboDKMock {
+public:
+    /// Command handler: reads the request of the command and writes the response. Returns false to close the connection.
+    typedef std::function<bool(RoboDKMockSession &session)> tHandler;
+
+    RoboDKMock();
+    ~RoboDKMock();
+
+    /// <summary>
+    /// Start listening on localhost.
+    /// </summary>
+    /// <param name="port">TCP port (0 to use any free port, see Port())</param>
+    /// <returns>True if the server is listening</returns>
+    bool Listen(int port = 0);
+
+    /// <summary>
+    /// Stop listening and close all the connections.
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Port the server is listening on (-1 if it is not listening).
+    /// </summary>
+    int Port() const;
+
+    /// <summary>
+    /// Delay added before every response (ms).
+    /// </summary>
+    void setLatency(int latency_ms);
+    int Latency() const;
+
+    /// <summary>
+    /// Limit the bytes per second sent and received by each connection (0 for no limit).
+    /// Responses are written in chunks of 10 ms of transfer (16 KB at most): a low bandwidth splits small responses across several reads of the client.
+    /// </summary>
+    void setBandwidth(qint64 bytes_per_second);
+    qint64 Bandwidth() const;
+
+    /// <summary>
+    /// Add or replace the handler of a command.
+    /// </summary>
+    void setHandler(const QString &command, const tHandler &handler);
+
+    /// <summary>
+    /// Add an item to the station.
+    /// </summary>
+    /// <param name="name">Item name</param>
+    /// <param name="type">Item type (RoboDK::ITEM_TYPE_...)</param>
+    /// <param name="joints">Joints of a robot or a target</param>
+    /// <param name="parent">Parent item (0 for the station)</param>
+    /// <returns>Item pointer</returns>
+    quint64 AddItem(const QString &name, int type, const QVector<double> &joints = QVector<double>(), quint64 parent = 0);
+
+    /// <summary>
+    /// Add a 6 axis robot defined by a DHM table (modified Denavit Hartenberg).
+    /// </summary>
+    /// <param name="name">Robot name</param>
+    /// <param name="dhm">[alpha(deg), a(mm), theta(deg), d(mm)] for each joint (24 values)</param>
+    /// <param name="joints">Current joints (all joints at 0 if empty)</param>
+    /// <returns>Item pointer (0 if the DHM table is not valid)</returns>
+    quint64 AddRobot(const QString &name, const QVector<double> &dhm, const QVector<double> &joints = QVector<double>());
+
+    /// <summary>
+    /// Forward kinematics of a robot of the station, as returned by G_FK.
+    /// </summary>
+    /// <param name="ptr">Robot pointer</param>
+    /// <param name="joints">Robot joints</param>
+    /// <param name="pose">Pose of the robot flange with respect to the robot base (column-major 4x4 matrix, like Mat)</param>
+    void ForwardKinematics(quint64 ptr, const QVector<double> &joints, double pose[16]) const;
+
+    /// <summary>
+    /// Inverse kinematics of a robot of the station, as returned by G_IK_cmpl.
+    /// Robots added with AddRobot are solved only if they have a spherical wrist like the usual 6 axis robots:
+    /// alpha = [0, -90, 0, -90, 90, -90] (deg) and d2 = d3 = d5 = a5 = a6 = 0.
+    /// </summary>
+    /// <param name="ptr">Robot pointer</param>
+    /// <param name="pose">Pose of the robot flange with respect to the robot base (column-major 4x4 matrix, like Mat)</param>
+    /// <returns>Up to 8 joint solutions (deg, within [-180, 180])</returns>
+    QList<QVector<double> > InverseKinematics(quint64 ptr, const double pose[16]) const;
+
+    /// <summary>
+    /// Configuration of a robot of the station for a set of joints, as returned by G_Thetas_Config.
+    /// </summary>
+    /// <param name="ptr">Robot pointer</param>
+    /// <param name="joints">Robot joints</param>
+    /// <param name="config">[REAR, LOWERARM, FLIP] flags (1 or 0)</param>
+    void JointsConfig(quint64 ptr, const QVector<double> &joints, double config[3]) const;
+
+    /// <summary>
+    /// Returns a copy of an item (the pointer is 0 if the item does not exist).
+    /// </summary>
+    tMockItem getItem(quint64 ptr) const;
+
+    /// <summary>
+    /// Returns a copy of all the items of the station.
+    /// </summary>
+    QList<tMockItem> Items() const;
+
+    /// <summary>
+    /// Size of the joint matrix returned by G_ProgJointList (rows per point and number of points).
+    /// </summary>
+    void setJointListSize(int rows, int cols);
+
+    /// <summary>
+    /// Returns the files received with FileRecvBin by remote file name.
+    /// </summary>
+    QHash<QString, QByteArray> Files() const;
+
+    /// <summary>
+    /// Number of commands served since Listen was called.
+    /// </summary>
+    int Commands() const;
+
+    /// <summary>
+    /// Commands received that have no handler.
+    /// </summary>
+    QStringList Unsupported() const;
+
+private:
+    friend class RoboDKMockSession;
+    friend class MockListener;
+    friend class MockConnection;
+
+    Q_DISABLE_COPY(RoboDKMock)
+
+    void _serve(QTcpSocket *socket);
+    tMockItem *_item(quint64 ptr);
+    void _remove(quint64 ptr);
+    void _fk(const tMockItem &robot, const QVector<double> &joints, double pose[16]) const;
+    QList<QVector<double> > _ik(const tMockItem &robot, const double pose[16]) const;
+    void _config(const tMockItem &robot, const QVector<double> &joints, double config[3]) const;
+    bool _add_instruction(quint64 ptr, const tMockInstruction &instruction);
+    void _default_handlers();
+
+    mutable QMutex _MUTEX;                 // protects the station and the settings below
+    QHash<QString, tHandler> _HANDLERS;
+    QList<tMockItem> _ITEMS;
+    quint64 _NEXT_PTR;
+    QHash<QString, QByteArray> _FILES;
+    QStringList _UNSUPPORTED;
+    int _LATENCY;
+    qint64 _BANDWIDTH;
+    int _JOINTLIST_ROWS;
+    int _JOINTLIST_COLS;
+
+    QThread *_LISTENER;                    // thread accepting the connections (nullptr if not listening)
+    QAtomicInt _STOP;                      // set by Close to stop the connections
+    QAtomicInt _COMMANDS;
+};
+
+
+#ifndef RDK_SKIP_NAMESPACE
+}
+#endif
+
+
+#endif // ROBODK_MOCK_H
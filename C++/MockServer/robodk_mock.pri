@@ -0,0 +1,19 @@
+#-------------------------------------------------
+#
+# In-process mock of the RoboDK API server.
+# Include it from the project of the tests or benchmarks to run the RoboDK C++ API without RoboDK,
+# for example on a headless build server:
+#     include(../MockServer/robodk_mock.pri)
+# The mock is compiled as part of that project, which also compiles the API (../Example/robodk_api.cpp).
+#
+#-------------------------------------------------
+
+QT += network
+
+INCLUDEPATH += $$PWD $$PWD/../Example
+
+SOURCES += \
+    $$PWD/robodk_mock.cpp
+
+HEADERS += \
+    $$PWD/robodk_mock.h
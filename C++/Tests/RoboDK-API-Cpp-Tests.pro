@@ -0,0 +1,37 @@
+#-------------------------------------------------
+#
+# Tests of the RoboDK C++ API.
+# The tests run against the in-process mock server (../MockServer),
+# RoboDK does not need to be installed or running.
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT += network
+
+TARGET = RoboDK-API-Cpp-Tests
+TEMPLATE = app
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# build the scalar code of the API instead of the SIMD code (SSE2/NEON): qmake CONFIG+=robodk_no_simd
+robodk_no_simd: DEFINES += ROBODK_API_NO_SIMD
+
+include(../MockServer/robodk_mock.pri)
+
+SOURCES += \
+        main.cpp \
+        tst_protocol.cpp \
+        tst_kinematics.cpp \
+        tst_mat.cpp \
+        tst_transport.cpp \
+    ../Example/robodk_api.cpp
+
+HEADERS += \
+        tst_protocol.h \
+        tst_kinematics.h \
+        tst_mat.h \
+        tst_transport.h \
+    ../Example/robodk_api.h
@@ -0,0 +1,24 @@
+// Runs the tests of the RoboDK C++ API against the in-process mock server.
+// Usage: RoboDK-API-Cpp-Tests [QtTest options]
+
+#include "tst_protocol.h"
+#include "tst_kinematics.h"
+#include "tst_mat.h"
+#include "tst_transport.h"
+#include <QtCore/QCoreApplication>
+#include <QtTest/QtTest>
+
+
+int main(int argc, char *argv[]){
+    QCoreApplication app(argc, argv);
+    int failed = 0;
+    TestProtocol protocol;
+    failed += QTest::qExec(&protocol, argc, argv);
+    TestKinematics kinematics;
+    failed += QTest::qExec(&kinematics, argc, argv);
+    TestMat mat;
+    failed += QTest::qExec(&mat, argc, argv);
+    TestTransport transport;
+    failed += QTest::qExec(&transport, argc, argv);
+    return failed;
+}
@@ -0,0 +1,501 @@
+#include "tst_kinematics.h"
+#include <QtCore/QFile>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QtTest>
+#include <cmath>
+
+
+#define TEST_FK_TOLERANCE 1e-9 // maximum error of the local forward kinematics (relative to the value)
+#define TEST_IK_TOLERANCE 1e-6 // maximum error of the forward kinematics of an inverse kinematics solution (relative to the value)
+#define TEST_JOINT_TOLERANCE 1e-6 // maximum error of the joints found by the inverse kinematics (deg)
+
+
+/// DHM table of the robot of the tests (6 axis robot with a spherical wrist): [alpha(deg), a(mm), theta(deg), d(mm)] for each joint
+static const double Test_DHM[24] = {
+    0, 0, 0, 400,
+    -90, 25, -90, 0,
+    0, 455, 0, 0,
+    -90, 35, 0, 420,
+    90, 0, 0, 0,
+    -90, 0, 180, 80
+};
+
+// Random joints between -range and range
+static tJoints Test_Random_Joints(QRandomGenerator &random, int ndofs, double range = 180.0){
+    tJoints joints(ndofs);
+    for (int j=0; j<ndofs; j++){
+        joints.Data()[j] = random.bounded(2.0 * range) - range;
+    }
+    return joints;
+}
+
+static QVector<double> Test_Vector(const tJoints &joints){
+    QVector<double> values(joints.Length());
+    for (int j=0; j<joints.Length(); j++){
+        values[j] = joints.ValuesD()[j];
+    }
+    return values;
+}
+
+
+void TestKinematics::init(){
+    _MOCK = new RoboDKMock();
+    QVector<double> dhm(24);
+    for (int i=0; i<24; i++){
+        dhm[i] = Test_DHM[i];
+    }
+    _ROBOT = _MOCK->AddRobot("Robot", dhm);
+    QVERIFY(_ROBOT != 0);
+    QVERIFY(_MOCK->Listen());
+    _RDK = new RoboDK("127.0.0.1", _MOCK->Port());
+    QVERIFY(_RDK->Connected());
+}
+
+void TestKinematics::cleanup(){
+    delete _RDK;
+    _RDK = nullptr;
+    delete _MOCK;
+    _MOCK = nullptr;
+}
+
+// Compare a pose with the forward kinematics of the mock
+bool TestKinematics::_same_pose(const Mat &pose, quint64 robot, const tJoints &joints, double tolerance){
+    double expected[16];
+    _MOCK->ForwardKinematics(robot, Test_Vector(joints), expected);
+    for (int i=0; i<16; i++){
+        if (fabs(pose.ValuesD()[i] - expected[i]) > tolerance * (1.0 + fabs(expected[i]))){
+            qDebug() << "Pose value" << i << "is" << pose.ValuesD()[i] << "instead of" << expected[i] << "for joints" << joints.ToString();
+            return false;
+        }
+    }
+    return true;
+}
+
+// All the solutions reach the pose (forward kinematics of the mock) and there is at least one solution
+bool TestKinematics::_solutions_reach(const Mat &pose, const QList<tJoints> &solutions){
+    if (solutions.isEmpty()){
+        qDebug() << "No solutions";
+        return false;
+    }
+    for (int i=0; i<solutions.length(); i++){
+        if (!_same_pose(pose, _ROBOT, solutions[i], TEST_IK_TOLERANCE)){
+            return false;
+        }
+    }
+    return true;
+}
+
+// Index of the solution equal to the joints (modulo 360 deg), -1 if none
+static int Test_Find_Solution(const QList<tJoints> &solutions, const tJoints &joints){
+    for (int i=0; i<solutions.length(); i++){
+        double error = 0;
+        for (int j=0; j<joints.Length(); j++){
+            error = qMax(error, fabs(remainder(solutions[i].ValuesD()[j] - joints.ValuesD()[j], 360.0)));
+        }
+        if (error < TEST_JOINT_TOLERANCE){
+            return i;
+        }
+    }
+    return -1;
+}
+
+// The kinematics identified from G_FK match the DHM model of the mock
+void TestKinematics::forwardKinematics(){
+    Item robot = _RDK->getItem("Robot");
+    Kinematics kin = robot.getKinematics();
+    QVERIFY(kin.Valid());
+    QCOMPARE(kin.DOFs(), 6);
+    QRandomGenerator random(10);
+    for (int i=0; i<1000; i++){
+        tJoints joints = Test_Random_Joints(random, 6);
+        QVERIFY(_same_pose(kin.SolveFK(joints), _ROBOT, joints, TEST_FK_TOLERANCE));
+    }
+    tJoints joints = Test_Random_Joints(random, 6);
+    QVERIFY(_same_pose(robot.SolveFK(joints), _ROBOT, joints, TEST_FK_TOLERANCE));
+}
+
+// Serial chain with a reversed joint, a prismatic axis, a base and a tool (G_FK of the mock is replaced)
+void TestKinematics::forwardKinematicsChain(){
+    QVector<double> dhm(24);
+    for (int i=0; i<24; i++){
+        dhm[i] = Test_DHM[i];
+    }
+    quint64 chain = _MOCK->AddRobot("Robot chain", dhm, QVector<double>(7, 0.0));
+    Mat base = Mat::XYZRPW_2_Mat(100, -200, 50, 10, 20, 30);
+    Mat tool = Mat::XYZRPW_2_Mat(5, 10, 150, 0, 45, 0);
+    // joint 3 is reversed and joint 7 moves the tool along the Z axis of the flange (mm)
+    auto chain_fk = [base, tool](RoboDKMock *mock, quint64 ptr, const QVector<double> &joints){
+        QVector<double> dhm_joints = joints.mid(0, 6);
+        dhm_joints[2] = -dhm_joints[2];
+        double flange[16];
+        mock->ForwardKinematics(ptr, dhm_joints, flange);
+        return base * Mat(flange) * Mat::transl(0, 0, joints[6]) * tool;
+    };
+    _MOCK->setHandler("G_FK", [chain, chain_fk](RoboDKMockSession &session){
+        QVector<double> joints = session.ReadArray();
+        quint64 ptr = session.ReadItem();
+        if (ptr == chain && joints.size() == 7){
+            session.WritePose(chain_fk(session.Mock(), ptr, joints).ValuesD());
+        } else {
+            double pose[16];
+            session.Mock()->ForwardKinematics(ptr, joints, pose);
+            session.WritePose(pose);
+        }
+        session.WriteStatus();
+        return true;
+    });
+
+    Item robot(_RDK, chain, RoboDK::ITEM_TYPE_ROBOT);
+    Kinematics kin = robot.getKinematics();
+    QVERIFY(kin.Valid());
+    QCOMPARE(kin.DOFs(), 7);
+    QVERIFY(kin.JointAxis(6, nullptr));
+    QRandomGenerator random(11);
+    for (int i=0; i<1000; i++){
+        tJoints joints = Test_Random_Joints(random, 7);
+        Mat expected = chain_fk(_MOCK, chain, Test_Vector(joints));
+        Mat pose = kin.SolveFK(joints);
+        for (int v=0; v<16; v++){
+            QVERIFY(fabs(pose.ValuesD()[v] - expected.ValuesD()[v]) <= TEST_FK_TOLERANCE * (1.0 + fabs(expected.ValuesD()[v])));
+        }
+    }
+}
+
+// The poses of a joint list are computed locally with the same result
+void TestKinematics::forwardKinematicsBatch(){
+    Item robot = _RDK->getItem("Robot");
+    const int npoints = 1000;
+    QRandomGenerator random(12);
+    tMatrix2D *joint_list = Matrix2D_Create();
+    Matrix2D_Set_Size(joint_list, 6, npoints);
+    QList<tJoints> joints;
+    for (int i=0; i<npoints; i++){
+        joints.append(Test_Random_Joints(random, 6));
+        memcpy(joint_list->data + 6*i, joints[i].ValuesD(), 6 * sizeof(double));
+    }
+    int commands = _MOCK->Commands();
+    QList<Mat> poses = robot.SolveFK(joint_list);
+    Matrix2D_Delete(&joint_list);
+    QCOMPARE(poses.length(), npoints);
+    // a few requests identify the kinematics, the poses are not requested one by one
+    QVERIFY(_MOCK->Commands() - commands < 30);
+    for (int i=0; i<npoints; i++){
+        QVERIFY(_same_pose(poses[i], _ROBOT, joints[i], TEST_FK_TOLERANCE));
+    }
+}
+
+// FK -> IK round trip: every solution reaches the pose and the original joints are one of the solutions
+void TestKinematics::inverseKinematics(){
+    Item robot = _RDK->getItem("Robot");
+    Kinematics kin = robot.getKinematics();
+    QVERIFY(kin.CanSolveIK());
+    QRandomGenerator random(20);
+    for (int i=0; i<1000; i++){
+        tJoints joints = Test_Random_Joints(random, 6, 170.0);
+        double pose_values[16];
+        _MOCK->ForwardKinematics(_ROBOT, Test_Vector(joints), pose_values);
+        Mat pose(pose_values);
+        QList<tJoints> solutions = kin.SolveIK_All(pose);
+        QVERIFY(solutions.length() <= 8);
+        QVERIFY(_solutions_reach(pose, solutions));
+        QVERIFY(Test_Find_Solution(solutions, joints) >= 0);
+        QVERIFY(Test_Find_Solution(QList<tJoints>() << kin.SolveIK(pose, joints), joints) >= 0);
+    }
+    tJoints joints = Test_Random_Joints(random, 6, 170.0);
+    Mat pose = robot.SolveFK(joints);
+    QVERIFY(_solutions_reach(pose, robot.SolveIK_All(pose)));
+}
+
+// Singular configurations: the solutions still reach the pose
+void TestKinematics::inverseKinematicsSingular(){
+    Item robot = _RDK->getItem("Robot");
+    Kinematics kin = robot.getKinematics();
+    QVERIFY(kin.CanSolveIK());
+
+    // wrist singularity: joints 4 and 6 are aligned
+    QRandomGenerator random(21);
+    for (int i=0; i<100; i++){
+        tJoints joints = Test_Random_Joints(random, 6, 170.0);
+        joints.Data()[4] = 0;
+        double pose_values[16];
+        _MOCK->ForwardKinematics(_ROBOT, Test_Vector(joints), pose_values);
+        QVERIFY(_solutions_reach(Mat(pose_values), kin.SolveIK_All(Mat(pose_values))));
+    }
+
+    // shoulder singularity: the wrist center is on the axis of joint 1 (Z axis of the base)
+    // the distance of the wrist center to the axis changes sign while joint 2 moves: find it by bisection
+    const double d6 = Test_DHM[23];
+    tJoints joints(6);
+    joints.Data()[3] = 30;
+    joints.Data()[4] = 40;
+    joints.Data()[5] = 50;
+    auto wrist_x = [&](double q2){
+        joints.Data()[1] = q2;
+        double pose_values[16];
+        _MOCK->ForwardKinematics(_ROBOT, Test_Vector(joints), pose_values);
+        return pose_values[12] - d6 * pose_values[8];
+    };
+    double q2_low = -180;
+    double q2_high = q2_low;
+    for (double q2=-175; q2<=180; q2+=5){
+        if ((wrist_x(q2_low) > 0) != (wrist_x(q2) > 0)){
+            q2_high = q2;
+            break;
+        }
+        q2_low = q2;
+    }
+    QVERIFY(q2_high > q2_low);
+    for (int i=0; i<60; i++){
+        double q2 = 0.5 * (q2_low + q2_high);
+        if ((wrist_x(q2_low) > 0) == (wrist_x(q2) > 0)){
+            q2_low = q2;
+        } else {
+            q2_high = q2;
+        }
+    }
+    QVERIFY(fabs(wrist_x(q2_low)) < 1e-9);
+    double pose_values[16];
+    _MOCK->ForwardKinematics(_ROBOT, Test_Vector(joints), pose_values);
+    QVERIFY(_solutions_reach(Mat(pose_values), kin.SolveIK_All(Mat(pose_values))));
+}
+
+// The batch inverse kinematics returns the same solutions as SolveIK_All
+void TestKinematics::inverseKinematicsBatch(){
+    Item robot = _RDK->getItem("Robot");
+    const int count = 200;
+    QRandomGenerator random(22);
+    QVector<double> poses(16 * count);
+    QList<tJoints> joints;
+    for (int i=0; i<count; i++){
+        joints.append(Test_Random_Joints(random, 6, 170.0));
+        _MOCK->ForwardKinematics(_ROBOT, Test_Vector(joints[i]), poses.data() + 16*i);
+    }
+    QVector<double> solutions(8 * 6 * count);
+    QVector<int> nsolutions(count);
+    QVERIFY(robot.SolveIK_All(poses.constData(), count, solutions.data(), nsolutions.data()));
+    for (int i=0; i<count; i++){
+        QList<tJoints> solutions_i;
+        for (int k=0; k<nsolutions[i]; k++){
+            solutions_i.append(tJoints(solutions.constData() + (8*i + k) * 6, 6));
+        }
+        QVERIFY(_solutions_reach(Mat(poses.constData() + 16*i), solutions_i));
+        QVERIFY(Test_Find_Solution(solutions_i, joints[i]) >= 0);
+    }
+}
+
+// The local inverse kinematics finds the same solutions and configurations as the inverse kinematics of the mock (derived independently)
+void TestKinematics::inverseKinematicsMock(){
+    Item robot = _RDK->getItem("Robot");
+    Kinematics kin = robot.getKinematics();
+    QVERIFY(kin.CanSolveIK());
+    QRandomGenerator random(23);
+    for (int i=0; i<500; i++){
+        tJoints joints = Test_Random_Joints(random, 6, 170.0);
+        double pose_values[16];
+        _MOCK->ForwardKinematics(_ROBOT, Test_Vector(joints), pose_values);
+        QList<QVector<double> > solutions_mock = _MOCK->InverseKinematics(_ROBOT, pose_values);
+        QList<tJoints> solutions = kin.SolveIK_All(Mat(pose_values));
+        QCOMPARE(solutions.length(), solutions_mock.length());
+        for (int k=0; k<solutions_mock.length(); k++){
+            tJoints joints_mock(solutions_mock[k].constData(), 6);
+            int index = Test_Find_Solution(solutions, joints_mock);
+            QVERIFY(index >= 0);
+            tConfig config;
+            double config_mock[3];
+            kin.JointsConfig(solutions[index], config);
+            _MOCK->JointsConfig(_ROBOT, solutions_mock[k], config_mock);
+            for (int c=0; c<3; c++){
+                QCOMPARE(config[c], config_mock[c]);
+            }
+        }
+    }
+}
+
+// RoboDK defines all the configuration flags the other way around: the flags are inverted when the kinematics are verified
+void TestKinematics::inverseKinematicsConfigMask(){
+    _MOCK->setHandler("G_Thetas_Config", [](RoboDKMockSession &session){
+        QVector<double> joints = session.ReadArray();
+        quint64 ptr = session.ReadItem();
+        double config[3];
+        session.Mock()->JointsConfig(ptr, joints, config);
+        session.WriteArray(QVector<double>() << 1.0 - config[0] << 1.0 - config[1] << 1.0 - config[2]);
+        session.WriteStatus();
+        return true;
+    });
+    Item robot = _RDK->getItem("Robot");
+    Kinematics kin = robot.getKinematics();
+    QVERIFY(kin.CanSolveIK());
+    QRandomGenerator random(24);
+    for (int i=0; i<200; i++){
+        tJoints joints = Test_Random_Joints(random, 6, 170.0);
+        tConfig config;
+        double config_mock[3];
+        kin.JointsConfig(joints, config);
+        _MOCK->JointsConfig(_ROBOT, Test_Vector(joints), config_mock);
+        for (int c=0; c<3; c++){
+            QCOMPARE(config[c], 1.0 - config_mock[c]);
+        }
+    }
+}
+
+// RoboDK returns a solution that is not one of the local solutions: the local inverse kinematics is disabled and RoboDK is used instead
+void TestKinematics::inverseKinematicsDisabled(){
+    _MOCK->setHandler("G_IK", [](RoboDKMockSession &session){
+        double pose[16];
+        session.ReadPose(pose);
+        quint64 ptr = session.ReadItem();
+        QList<QVector<double> > solutions = session.Mock()->InverseKinematics(ptr, pose);
+        QVector<double> joints = solutions.isEmpty() ? QVector<double>() : solutions[0];
+        if (!joints.isEmpty()){
+            joints[0] += 5.0;
+        }
+        session.WriteArray(joints);
+        session.WriteStatus();
+        return true;
+    });
+    Item robot = _RDK->getItem("Robot");
+    Kinematics kin = robot.getKinematics();
+    QVERIFY(kin.Valid());
+    QVERIFY(!kin.CanSolveIK());
+    QRandomGenerator random(25);
+    tJoints joints = Test_Random_Joints(random, 6, 170.0);
+    Mat pose = robot.SolveFK(joints);
+    int commands = _MOCK->Commands();
+    QList<tJoints> solutions = robot.SolveIK_All(pose);
+    QVERIFY(_MOCK->Commands() > commands);
+    QVERIFY(_solutions_reach(pose, solutions));
+    QVERIFY(Test_Find_Solution(solutions, joints) >= 0);
+}
+
+// The inverse kinematics of an item is computed locally: SolveIK returns the solution with the smallest maximum joint move from the current joints
+void TestKinematics::inverseKinematicsItem(){
+    Item robot = _RDK->getItem("Robot");
+    Kinematics kin = robot.getKinematics();
+    QVERIFY(kin.CanSolveIK());
+    QRandomGenerator random(26);
+    for (int i=0; i<50; i++){
+        tJoints joints = Test_Random_Joints(random, 6, 170.0);
+        tJoints current = Test_Random_Joints(random, 6, 170.0);
+        robot.setJoints(current);
+        Mat pose = robot.SolveFK(joints);
+        QList<tJoints> solutions = kin.SolveIK_All(pose);
+        int closest = -1;
+        double closest_move = 0;
+        for (int k=0; k<solutions.length(); k++){
+            double move = 0;
+            for (int j=0; j<6; j++){
+                move = qMax(move, fabs(solutions[k].ValuesD()[j] - current.ValuesD()[j]));
+            }
+            if (closest < 0 || move < closest_move){
+                closest = k;
+                closest_move = move;
+            }
+        }
+        QVERIFY(closest >= 0);
+
+        // only the current joints are requested
+        int commands = _MOCK->Commands();
+        tJoints solution = robot.SolveIK(pose);
+        QCOMPARE(_MOCK->Commands() - commands, 1);
+        QCOMPARE(Test_Find_Solution(solutions, solution), closest);
+
+        commands = _MOCK->Commands();
+        QCOMPARE(Test_Find_Solution(QList<tJoints>() << robot.SolveIK(pose, joints), joints), 0);
+        QList<tJoints> solutions_item = robot.SolveIK_All(pose);
+        tMatrix2D *mat2d = robot.SolveIK_All_Mat2D(pose);
+        QCOMPARE(_MOCK->Commands(), commands);
+        QCOMPARE(solutions_item.length(), solutions.length());
+        QCOMPARE(Matrix2D_Get_ncols(mat2d), solutions.length());
+        QCOMPARE(Matrix2D_Get_nrows(mat2d), 6 + 2);
+        for (int k=0; k<solutions.length(); k++){
+            QCOMPARE(Test_Find_Solution(solutions, solutions_item[k]), k);
+            QCOMPARE(Test_Find_Solution(solutions, tJoints(mat2d, k, 6)), k);
+        }
+        Matrix2D_Delete(&mat2d);
+    }
+}
+
+// A reachability map agrees with the inverse kinematics of the mock, and a map saved and opened again (memory-mapped) answers the same queries
+void TestKinematics::reachabilityMap(){
+    Item robot = _RDK->getItem("Robot");
+    // voxel centers are never on the axis of joint 1 for these orientations (shoulder singularity)
+    tXYZ origin = { -1050, -1050, -150 };
+    QList<Mat> orientations;
+    orientations << Mat() << Mat::rotx(M_PI) << Mat::roty(M_PI/2) << Mat::rotx(M_PI/2);
+    ReachabilityMap map;
+    QVERIFY(!map.Valid());
+    QVERIFY(map.setGrid(origin, 100.0, 21, 21, 15));
+    QVERIFY(map.setOrientations(orientations));
+    int reachable = map.Build(robot);
+    QVERIFY(map.Valid());
+    QVERIFY(reachable > 0 && reachable < map.Size());
+    QCOMPARE(map.Size(), 21 * 21 * 15);
+
+    int count = 0;
+    for (int v=0; v<map.Size(); v++){
+        tXYZ xyz;
+        map.VoxelCenter(v, xyz);
+        QCOMPARE(map.VoxelIndex(xyz), v);
+        quint64 bits = 0;
+        for (int o=0; o<orientations.length(); o++){
+            Mat pose = orientations[o];
+            pose.setPos(xyz);
+            if (!_MOCK->InverseKinematics(_ROBOT, pose.ValuesD()).isEmpty()){
+                bits |= quint64(1) << o;
+            }
+            QCOMPARE(map.Reachable(xyz, o), (bits >> o & 1) != 0);
+        }
+        QCOMPARE(map.ReachableBits(v), bits);
+        QCOMPARE(map.Reachable(xyz), bits != 0);
+        QCOMPARE(map.Solutions(v) > 0, bits != 0);
+        count += (bits != 0) ? 1 : 0;
+    }
+    QCOMPARE(reachable, count);
+    tXYZ outside = { 2000, 0, 0 };
+    QCOMPARE(map.VoxelIndex(outside), -1);
+    QVERIFY(!map.Reachable(outside));
+
+    // the opened map answers the same queries
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString filename = dir.filePath("robot.rmap");
+    QVERIFY(map.Save(filename));
+    ReachabilityMap opened;
+    QVERIFY(opened.Open(filename));
+    QVERIFY(opened.Valid());
+    for (int d=-1; d<3; d++){
+        QCOMPARE(opened.Size(d), map.Size(d));
+    }
+    QCOMPARE(opened.Orientations().length(), orientations.length());
+    for (int o=0; o<orientations.length(); o++){
+        for (int i=0; i<16; i++){
+            QCOMPARE(opened.Orientations()[o].ValuesD()[i], orientations[o].ValuesD()[i]);
+        }
+    }
+    for (int v=0; v<map.Size(); v++){
+        tXYZ xyz;
+        map.VoxelCenter(v, xyz);
+        QCOMPARE(opened.VoxelIndex(xyz), v);
+        QCOMPARE(opened.ReachableBits(v), map.ReachableBits(v));
+        QCOMPARE(opened.Solutions(v), map.Solutions(v));
+        QCOMPARE(opened.Reachable(xyz), map.Reachable(xyz));
+    }
+    opened.Close();
+    QVERIFY(!opened.Valid());
+
+    // a truncated file is rejected
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray data = file.readAll();
+    file.close();
+    QString truncated = dir.filePath("truncated.rmap");
+    QFile file_truncated(truncated);
+    QVERIFY(file_truncated.open(QIODevice::WriteOnly));
+    file_truncated.write(data.left(data.size() - 1));
+    file_truncated.close();
+    QVERIFY(!opened.Open(truncated));
+    QVERIFY(!opened.Valid());
+    QVERIFY(!opened.Open(dir.filePath("missing.rmap")));
+    QVERIFY(opened.Open(filename));
+}
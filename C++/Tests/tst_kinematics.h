@@ -0,0 +1,43 @@
+#ifndef TST_KINEMATICS_H
+#define TST_KINEMATICS_H
+
+#include "robodk_api.h"
+#include "robodk_mock.h"
+#include <QtCore/QObject>
+
+#ifndef RDK_SKIP_NAMESPACE
+using namespace RoboDK_API;
+#endif
+
+
+/// \brief The TestKinematics class tests the local kinematics (Kinematics) against the kinematics of the robots of a RoboDKMock.
+class TestKinematics : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void forwardKinematics();
+    void forwardKinematicsChain();
+    void forwardKinematicsBatch();
+    void inverseKinematics();
+    void inverseKinematicsSingular();
+    void inverseKinematicsBatch();
+    void inverseKinematicsMock();
+    void inverseKinematicsConfigMask();
+    void inverseKinematicsDisabled();
+    void inverseKinematicsItem();
+    void reachabilityMap();
+
+private:
+    bool _same_pose(const Mat &pose, quint64 robot, const tJoints &joints, double tolerance);
+    bool _solutions_reach(const Mat &pose, const QList<tJoints> &solutions);
+
+    RoboDKMock *_MOCK;
+    RoboDK *_RDK;
+    quint64 _ROBOT;
+};
+
+
+#endif // TST_KINEMATICS_H
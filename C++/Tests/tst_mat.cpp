@@ -0,0 +1,186 @@
+#include "tst_mat.h"
+#include <QtCore/QRandomGenerator>
+#include <QtTest/QtTest>
+#include <cmath>
+
+
+#define TEST_MAT_TOLERANCE 1e-12 // maximum error of a matrix value (relative to the value)
+
+
+// Compare 2 matrices value by value
+static bool Test_Same_Mat(const Mat &mat, const Mat &expected, double tolerance = TEST_MAT_TOLERANCE){
+    for (int i=0; i<16; i++){
+        if (fabs(mat.ValuesD()[i] - expected.ValuesD()[i]) > tolerance * (1.0 + fabs(expected.ValuesD()[i]))){
+            qDebug() << "Matrix value" << i << "is" << mat.ValuesD()[i] << "instead of" << expected.ValuesD()[i];
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reference product: c(i,j) = sum of a(i,k)*b(k,j)
+static Mat Test_Multiply(const Mat &a, const Mat &b){
+    double values[16];
+    for (int i=0; i<4; i++){
+        for (int j=0; j<4; j++){
+            double sum = 0.0;
+            for (int k=0; k<4; k++){
+                sum += a.Get(i, k) * b.Get(k, j);
+            }
+            values[j*4 + i] = sum;
+        }
+    }
+    return Mat(values);
+}
+
+// Random matrix (also the last row). The values are integers: the products are exact whatever the order of the sums.
+static Mat Test_Random_Mat(QRandomGenerator &random){
+    double values[16];
+    for (int i=0; i<16; i++){
+        values[i] = random.bounded(201) - 100;
+    }
+    return Mat(values);
+}
+
+// Random pose
+static Mat Test_Random_Pose(QRandomGenerator &random){
+    return Mat::transl(random.bounded(2000.0) - 1000.0, random.bounded(2000.0) - 1000.0, random.bounded(2000.0) - 1000.0)
+            * Mat::rotz(random.bounded(2*M_PI)) * Mat::roty(random.bounded(2*M_PI)) * Mat::rotx(random.bounded(2*M_PI));
+}
+
+
+void TestMat::initTestCase(){
+#if defined(ROBODK_API_NO_SIMD)
+    qInfo() << "Mat product: scalar";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    qInfo() << "Mat product: SSE2";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    qInfo() << "Mat product: NEON";
+#else
+    qInfo() << "Mat product: scalar";
+#endif
+}
+
+// Product of poses with values computed by hand
+void TestMat::multiply(){
+    // the rotation of 90 deg around Z turns the translation along X into a translation along Y
+    Mat pose = Mat::transl(1, 2, 3) * Mat::rotz(M_PI/2) * Mat::transl(10, 0, 0);
+    QVERIFY(Test_Same_Mat(pose, Mat(0, -1, 0, 1,
+                                     1, 0, 0, 12,
+                                     0, 0, 1, 3)));
+    Mat a(1, 2, 3, 4,
+          5, 6, 7, 8,
+          9, 10, 11, 12);
+    Mat b(2, 0, 1, -1,
+          0, 1, 0, 2,
+          1, 0, 3, 5);
+    QVERIFY(Test_Same_Mat(a * b, Mat(5, 2, 10, 22,
+                                     17, 6, 26, 50,
+                                     29, 10, 42, 78)));
+    Mat c = a;
+    c *= b;
+    QVERIFY(Test_Same_Mat(c, a * b));
+    QVERIFY((a * Mat()) == a);
+    QVERIFY(!(a * Mat(false)).Valid());
+}
+
+// Product of general matrices (also the last row) compared with the reference product
+void TestMat::multiplyRandom(){
+    QRandomGenerator random(3);
+    for (int n=0; n<1000; n++){
+        Mat a = Test_Random_Mat(random);
+        Mat b = Test_Random_Mat(random);
+        QVERIFY((a * b) == Test_Multiply(a, b));
+    }
+}
+
+// Inverse of a pose: with values computed by hand, and pose * inv = identity
+void TestMat::inverse(){
+    Mat pose = Mat::transl(1, 2, 3) * Mat::rotz(M_PI/2);
+    QVERIFY(Test_Same_Mat(pose.inv(), Mat(0, 1, 0, -2,
+                                          -1, 0, 0, 1,
+                                          0, 0, 1, -3)));
+    QRandomGenerator random(5);
+    for (int n=0; n<1000; n++){
+        Mat pose = Test_Random_Pose(random);
+        Mat pose_inv = pose.inv();
+        QVERIFY(Test_Same_Mat(pose * pose_inv, Mat(), 1e-12));
+        QVERIFY(Test_Same_Mat(pose_inv * pose, Mat(), 1e-12));
+        QVERIFY(Test_Same_Mat(pose_inv, pose.inverted(), 1e-9));
+    }
+}
+
+// Inverse of general matrices: with values computed by hand, singular matrices and m * inverted = identity
+void TestMat::inverted(){
+    Mat scale(2, 0, 0, 10,
+              0, 4, 0, 20,
+              0, 0, 5, 30);
+    bool invertible = false;
+    QVERIFY(Test_Same_Mat(scale.inverted(&invertible), Mat(0.5, 0, 0, -5,
+                                                           0, 0.25, 0, -5,
+                                                           0, 0, 0.2, -6)));
+    QVERIFY(invertible);
+
+    Mat singular(1, 2, 3, 4,
+                 2, 4, 6, 8,
+                 0, 0, 1, 0);
+    QVERIFY(Test_Same_Mat(singular.inverted(&invertible), Mat()));
+    QVERIFY(!invertible);
+
+    QRandomGenerator random(7);
+    for (int n=0; n<1000; n++){
+        Mat mat = Test_Random_Mat(random);
+        Mat mat_inv = mat.inverted(&invertible);
+        QVERIFY(invertible);
+        QVERIFY(Test_Same_Mat(mat * mat_inv, Mat(), 1e-8));
+    }
+}
+
+// translate and rotate multiply on the right (same as QMatrix4x4)
+void TestMat::rotateTranslate(){
+    Mat mat;
+    mat.translate(10, 0, 0);
+    mat.rotate(90, 0, 0, 1);
+    mat.translate(5, 0, 0);
+    QVERIFY(Test_Same_Mat(mat, Mat(0, -1, 0, 10,
+                                   1, 0, 0, 5,
+                                   0, 0, 1, 0)));
+
+    // the axis does not need to be normalized
+    Mat rot1;
+    rot1.rotate(30, 1, 1, 0);
+    Mat rot2;
+    rot2.rotate(30, 0.5, 0.5, 0);
+    QVERIFY(Test_Same_Mat(rot1, rot2));
+    // rotation of 120 deg around (1,1,1): X -> Y -> Z -> X
+    Mat rot3;
+    rot3.rotate(120, 1, 1, 1);
+    QVERIFY(Test_Same_Mat(rot3, Mat(0, 0, 1, 0,
+                                    1, 0, 0, 0,
+                                    0, 1, 0, 0), 1e-15));
+
+    QRandomGenerator random(11);
+    for (int n=0; n<100; n++){
+        Mat pose = Test_Random_Pose(random);
+        double angle = random.bounded(360.0) - 180.0;
+        Mat rotated = pose;
+        rotated.rotate(angle, 0, 0, 1);
+        QVERIFY(Test_Same_Mat(rotated, pose * Mat::rotz(angle * M_PI / 180.0)));
+        Mat translated = pose;
+        translated.translate(1, 2, 3);
+        QVERIFY(Test_Same_Mat(translated, pose * Mat::transl(1, 2, 3)));
+    }
+}
+
+// ValuesF and Values(float[16]) copy the values as floats
+void TestMat::valuesFloat(){
+    Mat pose = Mat::transl(1.25, -2.5, 1000.125) * Mat::rotx(0.3);
+    float values1[16];
+    float values2[16];
+    pose.ValuesF(values1);
+    pose.Values(values2);
+    for (int i=0; i<16; i++){
+        QCOMPARE(values1[i], (float) pose.ValuesD()[i]);
+        QCOMPARE(values2[i], values1[i]);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef TST_MAT_H
+#define TST_MAT_H
+
+#include "robodk_api.h"
+#include <QtCore/QObject>
+
+#ifndef RDK_SKIP_NAMESPACE
+using namespace RoboDK_API;
+#endif
+
+
+/// \brief The TestMat class tests the 4x4 matrix operations of Mat against reference values.
+/// The product uses the SIMD code of the target (SSE2 or NEON): build the tests with CONFIG+=robodk_no_simd to test the scalar code.
+class TestMat : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void multiply();
+    void multiplyRandom();
+    void inverse();
+    void inverted();
+    void rotateTranslate();
+    void valuesFloat();
+};
+
+
+#endif // TST_MAT_H
@@ -0,0 +1,819 @@
+#include "tst_protocol.h"
+#include <QtCore/QAtomicInt>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFuture>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QSemaphore>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+
+
+// Compare 2 poses value by value
+static bool Test_Same_Pose(const Mat &pose1, const Mat &pose2){
+    for (int i=0; i<16; i++){
+        if (qAbs(pose1.ValuesD()[i] - pose2.ValuesD()[i]) > 1e-9){
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool Test_Same_Pose(const Mat &pose1, const double pose2[16]){
+    return Test_Same_Pose(pose1, Mat(pose2));
+}
+
+#define TEST_ASYNC_TIMEOUT 5000 // maximum time to wait for the futures of RoboDKAsync (ms)
+
+
+void TestProtocol::init(){
+    _MOCK = new RoboDKMock();
+    _MOCK->AddItem("Robot", RoboDK::ITEM_TYPE_ROBOT, QVector<double>(6, 10.0));
+    _MOCK->AddItem("Frame 1", RoboDK::ITEM_TYPE_FRAME);
+    _MOCK->AddItem("Frame 2", RoboDK::ITEM_TYPE_FRAME);
+    _MOCK->AddItem("Frame 3", RoboDK::ITEM_TYPE_FRAME);
+    _MOCK->AddItem("Target", RoboDK::ITEM_TYPE_TARGET, QVector<double>() << 1 << 2 << 3 << 4 << 5 << 6);
+    _MOCK->AddItem("Prog", RoboDK::ITEM_TYPE_PROGRAM);
+    QVERIFY(_MOCK->Listen());
+    _RDK = new RoboDK("127.0.0.1", _MOCK->Port());
+    QVERIFY(_RDK->Connected());
+}
+
+void TestProtocol::cleanup(){
+    delete _RDK;
+    _RDK = nullptr;
+    delete _MOCK;
+    _MOCK = nullptr;
+}
+
+Item TestProtocol::_item(const QString &name){
+    return _RDK->getItem(name);
+}
+
+// Each call sends its request with a single write, requests of the same call are written together
+void TestProtocol::commandWrites(){
+    Item robot = _item("Robot");
+    Item frame = _item("Frame 1");
+    _RDK->ResetCommStats();
+    robot.Joints();
+    frame.setPose(Mat::transl(10, 20, 30));
+    frame.Pose();
+    _RDK->getItem("Frame 2");
+    QCOMPARE(_RDK->CommCommands(), (quint64) 4);
+    QCOMPARE(_RDK->CommWrites(), (quint64) 4);
+
+    QList<Item> frames;
+    frames << _item("Frame 1") << _item("Frame 2") << _item("Frame 3");
+    _RDK->ResetCommStats();
+    QCOMPARE(_RDK->Poses(frames).length(), 3);
+    QCOMPARE(_RDK->CommCommands(), (quint64) 3);
+    QCOMPARE(_RDK->CommWrites(), (quint64) 1);
+}
+
+// Statuses of pipelined commands are collected later and the failed commands are reported with their index
+void TestProtocol::pipelineErrors(){
+    Item frame1 = _item("Frame 1");
+    Item frame2 = _item("Frame 2");
+    Item invalid(_RDK, 0xdead, RoboDK::ITEM_TYPE_FRAME);
+    Mat pose1 = Mat::transl(1, 2, 3);
+    Mat pose2 = Mat::transl(4, 5, 6);
+    _RDK->PipelineStart();
+    QVERIFY(_RDK->PipelineActive());
+    frame1.setPose(pose1);
+    invalid.setPose(pose1);
+    frame2.setPose(pose2);
+    invalid.setPose(pose2);
+    QList<tPipelineError> errors;
+    QCOMPARE(_RDK->PipelineEnd(&errors), 2);
+    QVERIFY(!_RDK->PipelineActive());
+    QCOMPARE(errors.length(), 2);
+    QCOMPARE(errors[0].index, 1);
+    QCOMPARE(errors[0].command, QString("S_Hlocal"));
+    QCOMPARE(errors[0].status, 1);
+    QCOMPARE(errors[1].index, 3);
+    QVERIFY(Test_Same_Pose(frame1.Pose(), pose1));
+    QVERIFY(Test_Same_Pose(frame2.Pose(), pose2));
+}
+
+void TestProtocol::setPoses(){
+    QList<Item> frames;
+    frames << _item("Frame 1") << _item("Frame 2") << _item("Frame 3");
+    QList<Mat> poses;
+    poses << Mat::transl(1, 0, 0) << Mat::XYZRPW_2_Mat(10, 20, 30, 40, 50, 60) << Mat::transl(0, 0, 3);
+    _RDK->ResetCommStats();
+    QVERIFY(_RDK->setPoses(frames, poses));
+    QCOMPARE(_RDK->CommCommands(), (quint64) 1);
+    for (int i=0; i<frames.length(); i++){
+        QVERIFY(Test_Same_Pose(poses[i], _MOCK->getItem(frames[i].GetID()).pose));
+    }
+    QList<Mat> result = _RDK->Poses(frames);
+    QCOMPARE(result.length(), frames.length());
+    for (int i=0; i<frames.length(); i++){
+        QVERIFY(Test_Same_Pose(result[i], poses[i]));
+    }
+
+    // absolute poses (the frames are attached to the station)
+    poses.swap(0, 2);
+    QVERIFY(_RDK->setPosesAbs(frames, poses));
+    result = _RDK->PosesAbs(frames);
+    for (int i=0; i<frames.length(); i++){
+        QVERIFY(Test_Same_Pose(result[i], poses[i]));
+    }
+
+    // the number of poses must match and all items must be valid
+    QVERIFY(!_RDK->setPoses(frames, poses.mid(0, 2)));
+    frames.append(Item(_RDK, 0xdead, RoboDK::ITEM_TYPE_FRAME));
+    poses.append(Mat());
+    QVERIFY(!_RDK->setPoses(frames, poses));
+    QVERIFY(_RDK->Poses(QList<Item>()).isEmpty());
+}
+
+// The joints of a list of robots are set and retrieved with one command each, and the output list is reused
+void TestProtocol::jointsList(){
+    QList<Item> robots;
+    robots << _item("Robot") << Item(_RDK, _MOCK->AddItem("Robot 2", RoboDK::ITEM_TYPE_ROBOT, QVector<double>(6, 20.0)), RoboDK::ITEM_TYPE_ROBOT);
+    robots << Item(_RDK, _MOCK->AddItem("Robot 3", RoboDK::ITEM_TYPE_ROBOT, QVector<double>(7, 30.0)), RoboDK::ITEM_TYPE_ROBOT);
+    QList<tJoints> joints_list = _RDK->Joints(robots);
+    QCOMPARE(joints_list.length(), robots.length());
+    QCOMPARE(joints_list[0].Length(), 6);
+    QCOMPARE(joints_list[2].Length(), 7);
+    QCOMPARE(joints_list[1].ValuesD()[5], 20.0);
+
+    QList<tJoints> values;
+    for (int i=0; i<robots.length(); i++){
+        double jnts[7] = {i + 1.0, i + 2.0, i + 3.0, i + 4.0, i + 5.0, i + 6.0, i + 7.0};
+        values.append(tJoints(jnts, i == 2 ? 7 : 6));
+    }
+    _RDK->ResetCommStats();
+    QVERIFY(_RDK->setJoints(robots, values));
+    QCOMPARE(_RDK->CommCommands(), (quint64) 1);
+    for (int i=0; i<robots.length(); i++){
+        QVector<double> joints = _MOCK->getItem(robots[i].GetID()).joints;
+        QCOMPARE(tJoints(joints.constData(), joints.length()).ToString(), values[i].ToString());
+    }
+
+    // the existing list is filled in place: its elements are not reallocated
+    const tJoints *elements[3] = {&joints_list.at(0), &joints_list.at(1), &joints_list.at(2)};
+    _RDK->ResetCommStats();
+    QVERIFY(_RDK->Joints(robots, joints_list));
+    QCOMPARE(_RDK->CommCommands(), (quint64) 1);
+    QCOMPARE(joints_list.length(), robots.length());
+    for (int i=0; i<robots.length(); i++){
+        QCOMPARE(&joints_list.at(i), elements[i]);
+        QCOMPARE(joints_list[i].ToString(), values[i].ToString());
+    }
+    // a longer list is shrunk, keeping its first elements
+    QVERIFY(_RDK->Joints(robots.mid(0, 2), joints_list));
+    QCOMPARE(joints_list.length(), 2);
+    QCOMPARE(&joints_list.at(1), elements[1]);
+    QCOMPARE(joints_list[1].ToString(), values[1].ToString());
+
+    // the number of joints must match and all robots must be valid
+    QVERIFY(!_RDK->setJoints(robots, values.mid(0, 2)));
+    robots.append(Item(_RDK, 0xdead, RoboDK::ITEM_TYPE_ROBOT));
+    QVERIFY(!_RDK->Joints(robots, joints_list));
+    QCOMPARE(joints_list.length(), robots.length());
+    QCOMPARE(joints_list[3].Length(), 0);
+    QCOMPARE(_RDK->Joints(robots.mid(0, 1))[0].Length(), 6); // the link is still in sync
+}
+
+// The station index is built with one round trip, answers the lookups without RoboDK and follows the changes made through the link
+void TestProtocol::stationIndex(){
+    Item frame1 = _item("Frame 1");
+    Item frame2 = _item("Frame 2");
+    Item frame3 = _item("Frame 3");
+    Item robot = _item("Robot");
+    quint64 tool = _MOCK->AddItem("Tool frame", RoboDK::ITEM_TYPE_FRAME, QVector<double>(), frame1.GetID());
+    quint64 target2 = _MOCK->AddItem("Frame 2", RoboDK::ITEM_TYPE_TARGET, QVector<double>(), frame2.GetID());
+    int nitems = _MOCK->Items().length();
+
+    QVERIFY(!_RDK->IndexValid());
+    int commands = _MOCK->Commands();
+    QCOMPARE(_RDK->IndexRefresh(), nitems);
+    QVERIFY(_RDK->IndexValid());
+    QCOMPARE(_MOCK->Commands() - commands, 1 + 2*nitems); // G_List_Items_ptr, then G_Name and G_Parent of each item
+
+    // lookups by name, type and parent don't contact RoboDK
+    commands = _MOCK->Commands();
+    QCOMPARE(_RDK->IndexItem("Frame 1").GetID(), frame1.GetID());
+    QCOMPARE(_RDK->IndexItem("Frame 2").GetID(), frame2.GetID());
+    QCOMPARE(_RDK->IndexItem("Frame 2", RoboDK::ITEM_TYPE_TARGET).GetID(), target2);
+    QCOMPARE(_RDK->IndexItem("Frame 2", RoboDK::ITEM_TYPE_FRAME).GetID(), frame2.GetID());
+    QVERIFY(!_RDK->IndexItem("Frame 1", RoboDK::ITEM_TYPE_ROBOT).Valid());
+    QVERIFY(!_RDK->IndexItem("frame 1").Valid()); // exact name
+    QCOMPARE(_RDK->IndexType(robot), (int) RoboDK::ITEM_TYPE_ROBOT);
+    QCOMPARE(_RDK->IndexName(Item(_RDK, tool, RoboDK::ITEM_TYPE_FRAME)), QString("Tool frame"));
+    QCOMPARE(_RDK->IndexParent(Item(_RDK, tool, RoboDK::ITEM_TYPE_FRAME)).GetID(), frame1.GetID());
+    QCOMPARE(_RDK->IndexParent(Item(_RDK, target2, RoboDK::ITEM_TYPE_TARGET)).GetID(), frame2.GetID());
+    QVERIFY(!_RDK->IndexParent(frame1).Valid()); // attached to the station
+    QCOMPARE(_RDK->IndexType(Item(_RDK, 0xdead, RoboDK::ITEM_TYPE_FRAME)), -1);
+    QCOMPARE(_MOCK->Commands(), commands);
+
+    // new items
+    Item frame = _RDK->AddFrame("New frame", &frame3);
+    Item target = _RDK->AddTarget("New target", &frame, &robot);
+    Item root = _RDK->AddFrame("Root frame");
+    QCOMPARE(_RDK->IndexItem("New frame").GetID(), frame.GetID());
+    QCOMPARE(_RDK->IndexParent(frame).GetID(), frame3.GetID());
+    QCOMPARE(_RDK->IndexItem("New target", RoboDK::ITEM_TYPE_TARGET).GetID(), target.GetID());
+    QCOMPARE(_RDK->IndexParent(target).GetID(), frame.GetID());
+    QCOMPARE(_RDK->IndexItem("Root frame").GetID(), root.GetID());
+    QVERIFY(!_RDK->IndexParent(root).Valid());
+
+    // renamed and moved items
+    frame.setName("Renamed frame");
+    QVERIFY(!_RDK->IndexItem("New frame").Valid());
+    QCOMPARE(_RDK->IndexItem("Renamed frame").GetID(), frame.GetID());
+    QCOMPARE(_RDK->IndexName(frame), QString("Renamed frame"));
+    target.setParent(frame2);
+    QCOMPARE(_RDK->IndexParent(target).GetID(), frame2.GetID());
+    frame.setParentStatic(root);
+    QCOMPARE(_RDK->IndexParent(frame).GetID(), root.GetID());
+
+    // deleted items are removed with their childs
+    frame1.Delete();
+    QVERIFY(!_RDK->IndexItem("Frame 1").Valid());
+    QVERIFY(!_RDK->IndexItem("Tool frame").Valid());
+    QCOMPARE(_MOCK->getItem(tool).ptr, (quint64) 0);
+
+    // the index matches the station
+    QList<Item> items = _RDK->getItemList();
+    QCOMPARE(items.length(), _MOCK->Items().length());
+    for (int i=0; i<items.length(); i++){
+        QCOMPARE(_RDK->IndexName(items[i]), items[i].Name());
+        QCOMPARE(_RDK->IndexType(items[i]), _MOCK->getItem(items[i].GetID()).type);
+        QCOMPARE(_RDK->IndexParent(items[i]).GetID(), items[i].Parent().GetID());
+    }
+
+    _RDK->IndexInvalidate();
+    QVERIFY(!_RDK->IndexValid());
+    QVERIFY(!_RDK->IndexItem("Frame 2").Valid());
+}
+
+// An item of a pool changed through another link of the pool updates the index of the link that returned it
+void TestProtocol::stationIndexPool(){
+    RoboDKPool pool("127.0.0.1", _MOCK->Port(), 2);
+    RoboDK *owner = nullptr;
+    Item frame;
+    QSemaphore ready;
+    QSemaphore done;
+    // the link of the item stays leased by another thread: the calls of this thread use the other link
+    QThread *thread = QThread::create([&pool, &owner, &frame, &ready, &done](){
+        RoboDKLease lease(pool);
+        owner = lease.Link();
+        frame = owner->getItem("Frame 1");
+        owner->IndexRefresh();
+        ready.release();
+        done.acquire();
+    });
+    thread->start();
+    ready.acquire();
+    QVERIFY(owner->IndexValid());
+    QCOMPARE(frame.RDK(), owner);
+
+    frame.setName("Renamed frame");
+    frame.setParent(_item("Frame 2"));
+    QCOMPARE(pool.Count(), 2);
+    QCOMPARE(_MOCK->getItem(frame.GetID()).name, QString("Renamed frame"));
+    QCOMPARE(owner->IndexItem("Renamed frame").GetID(), frame.GetID());
+    QVERIFY(!owner->IndexItem("Frame 1").Valid());
+    QCOMPARE(owner->IndexParent(frame).GetID(), _item("Frame 2").GetID());
+    frame.Delete();
+    QVERIFY(!owner->IndexItem("Renamed frame").Valid());
+
+    done.release();
+    QVERIFY(thread->wait(10000));
+    delete thread;
+    QCOMPARE(pool.Leased(), 0);
+}
+
+// Queued movements are confirmed in order and a failed movement is reported with its index in the queue
+void TestProtocol::motionQueue(){
+    Item robot = _item("Robot");
+    Item target = _item("Target");
+    Item invalid(_RDK, 0xdead, RoboDK::ITEM_TYPE_TARGET);
+    QList<tPipelineError> errors;
+    {
+        MotionQueue queue(robot, 4);
+        for (int i=0; i<10; i++){
+            tJoints joints(6);
+            joints.Data()[0] = i;
+            queue.MoveJ(joints);
+            QVERIFY(queue.InFlight() <= 4);
+        }
+        queue.MoveL(invalid);
+        queue.MoveJ(target);
+        QCOMPARE(queue.Count(), 12);
+        QCOMPARE(queue.WaitDone(&errors), 1);
+        QCOMPARE(queue.InFlight(), 0);
+    }
+    QCOMPARE(errors.length(), 1);
+    QCOMPARE(errors[0].index, 10);
+    QCOMPARE(errors[0].command, QString("MoveXb"));
+    QCOMPARE(errors[0].status, 3);
+    QCOMPARE(_MOCK->getItem(robot.GetID()).joints, _MOCK->getItem(target.GetID()).joints);
+
+    // other commands wait for the queued movements
+    {
+        MotionQueue queue(robot, 16);
+        tJoints joints(6);
+        joints.Data()[5] = 45;
+        queue.MoveJ(joints);
+        QCOMPARE(robot.Joints().ValuesD()[5], 45.0);
+        QCOMPARE(queue.InFlight(), 0);
+    }
+}
+
+// A call aborted by its deadline returns right away, the link resynchronizes on the next call
+void TestProtocol::deadlineAbort(){
+    Item robot = _item("Robot");
+    _MOCK->setLatency(500);
+    QElapsedTimer timer;
+    timer.start();
+    {
+        DeadlineScope scope(_RDK, 50);
+        robot.Joints();
+        QVERIFY(scope.Aborted());
+    }
+    QVERIFY(timer.elapsed() < 400);
+    _MOCK->setLatency(0);
+    QVERIFY(_RDK->Connected());
+    int commands = _MOCK->Commands();
+    tJoints joints = robot.Joints();
+    QCOMPARE(joints.Length(), 6);
+    QCOMPARE(joints.ValuesD()[0], 10.0);
+    // G_Param with the synchronization marker and G_Thetas on the same connection
+    QCOMPARE(_MOCK->Commands(), commands + 2);
+    QVERIFY(_MOCK->Unsupported().isEmpty());
+}
+
+// An unsupported command is answered with an error and the connection is closed, later calls reconnect
+void TestProtocol::unsupportedCommand(){
+    Item robot = _item("Robot");
+    robot.Busy();
+    QVERIFY(_MOCK->Unsupported().contains("IsBusy"));
+    tJoints joints = robot.Joints();
+    QCOMPARE(joints.Length(), 6);
+    QCOMPARE(joints.ValuesD()[0], 10.0);
+}
+
+// The instructions of a ProgramBuilder are added in order and a failed instruction is reported with its index
+void TestProtocol::programBuilder(){
+    Item prog = _item("Prog");
+    const double values[6] = { 10, 20, 30, 40, 50, 60 };
+    ProgramBuilder builder;
+    builder.setSpeed(100);
+    builder.setRounding(1);
+    builder.MoveJ(tJoints(values, 6));
+    builder.MoveL(Mat::transl(100, 200, 300));
+    builder.setDO("DO1", "1");
+    builder.waitDI("DI1", "1", 1000);
+    builder.Pause(500);
+    builder.Comment("Done");
+    QCOMPARE(builder.Count(), 8);
+    QList<tPipelineError> errors;
+    QCOMPARE(builder.Commit(prog, &errors, 3), 0);
+    QVERIFY(errors.isEmpty());
+    QList<tMockInstruction> instructions = _MOCK->getItem(prog.GetID()).instructions;
+    QCOMPARE(instructions.length(), 8);
+    QCOMPARE(instructions[0].type, (int) RoboDK::INS_TYPE_CHANGESPEED);
+    QCOMPARE(instructions[2].name, QString("MoveJ"));
+    QVERIFY(instructions[2].joint_target);
+    QCOMPARE(instructions[2].joints, QVector<double>() << 10 << 20 << 30 << 40 << 50 << 60);
+    QCOMPARE(instructions[3].name, QString("MoveL"));
+    QVERIFY(!instructions[3].joint_target);
+    QVERIFY(Test_Same_Pose(Mat::transl(100, 200, 300), instructions[3].pose));
+    QCOMPARE(instructions[4].name, QString("setDO DO1=1"));
+    QCOMPARE(instructions[6].type, (int) RoboDK::INS_TYPE_PAUSE);
+    QCOMPARE(instructions[7].name, QString("Done"));
+
+    // the instructions are kept: commit them again with an output that fails
+    _MOCK->setHandler("setDO", [](RoboDKMockSession &session){
+        session.ReadItem();
+        session.ReadLine();
+        session.ReadLine();
+        session.WriteStatus(3, "Output not available");
+        return true;
+    });
+    QCOMPARE(builder.Commit(prog, &errors), 1);
+    QCOMPARE(errors[0].index, 4);
+    QCOMPARE(errors[0].command, QString("setDO"));
+    QCOMPARE(errors[0].status, 3);
+    QCOMPARE(errors[0].message, QString("Output not available"));
+    QCOMPARE(_MOCK->getItem(prog.GetID()).instructions.length(), 15);
+}
+
+// Instructions read back with pipelined Prog_GIns requests match the instructions read one by one
+void TestProtocol::programInstructions(){
+    Item prog = _item("Prog");
+    ProgramBuilder builder;
+    for (int i=0; i<20; i++){
+        tJoints joints(6);
+        joints.Data()[0] = i;
+        builder.MoveJ(joints);
+        builder.MoveL(Mat::transl(i, 0, 0));
+        builder.Comment("Point " + QString::number(i % 5));
+    }
+    QCOMPARE(builder.Commit(prog), 0);
+    QCOMPARE(prog.InstructionCount(), 60);
+
+    tProgramInstructions instructions;
+    QCOMPARE(prog.Instructions(&instructions, 0, -1, 4), 60);
+    QCOMPARE(instructions.type.size(), 60);
+    // names are stored once
+    QCOMPARE(instructions.names.length(), 2 + 5);
+    for (int i=0; i<60; i++){
+        QString name;
+        int instype;
+        int movetype;
+        bool isjointtarget;
+        Mat target;
+        tJoints joints;
+        prog.Instruction(i, name, instype, movetype, isjointtarget, target, joints);
+        QCOMPARE(instructions.names[instructions.name_id[i]], name);
+        QCOMPARE(instructions.type[i], instype);
+        QCOMPARE(instructions.move_type[i], movetype);
+        QCOMPARE(instructions.joint_target[i] != 0, isjointtarget);
+        if (instype == RoboDK::INS_TYPE_MOVE){
+            QVERIFY(Test_Same_Pose(target, instructions.poses.constData() + 16*i));
+            int start = instructions.joints_start[i];
+            int end = (i + 1 < 60) ? instructions.joints_start[i + 1] : instructions.joints.size();
+            QCOMPARE(end - start, joints.Length());
+            for (int j=0; j<joints.Length(); j++){
+                QCOMPARE(instructions.joints[start + j], joints.ValuesD()[j]);
+            }
+        }
+    }
+
+    // a range of instructions
+    QCOMPARE(prog.Instructions(&instructions, 55, 10), 5);
+    QCOMPARE(instructions.first, 55);
+    QCOMPARE(instructions.names[instructions.name_id[4]], QString("Point 4"));
+}
+
+// Threads share a pool with fewer links than threads: no more links are created than allowed and each thread gets the answers of its own calls
+void TestProtocol::poolThreads(){
+    const int nthreads = 8;
+    const int max_links = 3;
+    const int ncalls = 50;
+    QVector<quint64> ptrs;
+    for (int t=0; t<nthreads; t++){
+        ptrs.append(_MOCK->AddItem(QString("Thread %1").arg(t), RoboDK::ITEM_TYPE_FRAME));
+    }
+    _MOCK->setLatency(1);
+    RoboDKPool pool("127.0.0.1", _MOCK->Port(), max_links);
+    QAtomicInt errors;
+    QAtomicInt too_many_links;
+    QList<QThread*> threads;
+    for (int t=0; t<nthreads; t++){
+        threads.append(QThread::create([&pool, &errors, &too_many_links, &ptrs, t, ncalls, max_links](){
+            for (int i=0; i<ncalls; i++){
+                // a lease for a few calls, or a link leased by each call of the item
+                RoboDKLease *lease = (i % 2 == 0) ? new RoboDKLease(pool) : nullptr;
+                Item frame = pool.Link()->getItem(QString("Thread %1").arg(t));
+                if (lease == nullptr){
+                    pool.Release();
+                } else if (frame.RDK() != lease->Link()){
+                    errors.ref();
+                }
+                frame.setPose(Mat::transl(t, i, 0));
+                Mat pose = frame.Pose();
+                if (frame.GetID() != ptrs[t] || pose.ValuesD()[12] != t || pose.ValuesD()[13] != i){
+                    errors.ref();
+                }
+                if (pool.Count() > max_links){
+                    too_many_links.ref();
+                }
+                delete lease;
+            }
+        }));
+    }
+    for (int t=0; t<nthreads; t++){
+        threads[t]->start();
+    }
+    for (int t=0; t<nthreads; t++){
+        QVERIFY(threads[t]->wait(60000));
+    }
+    qDeleteAll(threads);
+    QCOMPARE(errors.load(), 0);
+    QCOMPARE(too_many_links.load(), 0);
+    QVERIFY(pool.Count() >= 1 && pool.Count() <= max_links);
+    QCOMPARE(pool.Leased(), 0);
+}
+
+// Responses arrive in small chunks (10 ms of transfer at the mock bandwidth): the calls are completed once their whole response is received
+void TestProtocol::asyncChunks(){
+    Item robot = _item("Robot");
+    Item frame = _item("Frame 1");
+    Mat pose = Mat::XYZRPW_2_Mat(1, 2, 3, 4, 5, 6);
+    frame.setPose(pose);
+    _MOCK->setBandwidth(2000); // 20 bytes per chunk
+    RoboDKAsync async(_RDK);
+    QVERIFY(async.Connected());
+    QFuture<tJoints> joints = async.Joints(robot);
+    QFuture<Mat> result = async.Pose(frame);
+    QFuture<Item> item = async.getItem("Frame 2");
+    QFuture<int> status = async.setPose(frame, Mat::transl(7, 8, 9));
+    QCOMPARE(async.Pending(), 4);
+    QTRY_VERIFY_WITH_TIMEOUT(status.isFinished(), TEST_ASYNC_TIMEOUT);
+    QVERIFY(joints.isFinished() && result.isFinished() && item.isFinished());
+    QCOMPARE(async.Pending(), 0);
+    QCOMPARE(joints.result().Length(), 6);
+    QCOMPARE(joints.result().ValuesD()[5], 10.0);
+    QVERIFY(Test_Same_Pose(result.result(), pose));
+    QCOMPARE(item.result().GetID(), _item("Frame 2").GetID());
+    QCOMPARE(status.result(), 0);
+    _MOCK->setBandwidth(0);
+    QVERIFY(Test_Same_Pose(frame.Pose(), Mat::transl(7, 8, 9)));
+}
+
+// An error status with its message fails the call only: the message is consumed and the next calls are read from the right place
+void TestProtocol::asyncErrorStatus(){
+    Item robot = _item("Robot");
+    Item frame = _item("Frame 1");
+    _MOCK->setHandler("G_Hlocal", [](RoboDKMockSession &session){
+        session.ReadItem();
+        double pose[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+        session.WritePose(pose);
+        session.WriteStatus(3, "Pose not available");
+        return true;
+    });
+    RoboDKAsync async(_RDK);
+    QFuture<Mat> result = async.Pose(frame);
+    QFuture<int> status = async.setPose(Item(_RDK, 0xdead, RoboDK::ITEM_TYPE_FRAME), Mat::transl(1, 2, 3));
+    QFuture<tJoints> joints = async.Joints(robot);
+    QTRY_VERIFY_WITH_TIMEOUT(joints.isFinished(), TEST_ASYNC_TIMEOUT);
+    QVERIFY(result.isFinished() && status.isFinished());
+    QVERIFY(!result.result().Valid());
+    QCOMPARE(status.result(), 1);
+    QCOMPARE(joints.result().Length(), 6);
+    QCOMPARE(joints.result().ValuesD()[0], 10.0);
+}
+
+// Arrays longer than the 16 values kept by a call are skipped entirely
+void TestProtocol::asyncLongArray(){
+    QVector<double> values;
+    for (int i=0; i<40; i++){
+        values.append(i);
+    }
+    Item robot(_RDK, _MOCK->AddItem("Long robot", RoboDK::ITEM_TYPE_ROBOT, values), RoboDK::ITEM_TYPE_ROBOT);
+    Item frame = _item("Frame 1");
+    Mat pose = Mat::transl(10, 20, 30);
+    frame.setPose(pose);
+    RoboDKAsync async(_RDK);
+    QFuture<tJoints> joints = async.Joints(robot);
+    QFuture<Mat> result = async.Pose(frame);
+    QTRY_VERIFY_WITH_TIMEOUT(result.isFinished(), TEST_ASYNC_TIMEOUT);
+    QVERIFY(joints.isFinished());
+    QCOMPARE(joints.result().Length(), 16);
+    QCOMPARE(joints.result().ValuesD()[15], 15.0);
+    QVERIFY(Test_Same_Pose(result.result(), pose));
+}
+
+// The connection is closed with calls pending: the call answered before is completed and the others fail
+void TestProtocol::asyncDisconnect(){
+    Item robot = _item("Robot");
+    Item frame = _item("Frame 1");
+    _MOCK->setHandler("G_Hlocal", [](RoboDKMockSession &session){
+        session.ReadItem();
+        return false; // close the connection without an answer
+    });
+    RoboDKAsync async(_RDK);
+    int idle = 0;
+    connect(&async, &RoboDKAsync::idle, [&idle](){ idle++; });
+    QFuture<tJoints> joints = async.Joints(robot);
+    QFuture<Mat> result = async.Pose(frame);
+    QFuture<int> status = async.setJoints(robot, tJoints(6));
+    QTRY_VERIFY_WITH_TIMEOUT(status.isFinished(), TEST_ASYNC_TIMEOUT);
+    QVERIFY(joints.isFinished() && result.isFinished());
+    QCOMPARE(joints.result().Length(), 6);
+    QVERIFY(!result.result().Valid());
+    QCOMPARE(status.result(), -1);
+    QCOMPARE(async.Pending(), 0);
+    QCOMPARE(idle, 1);
+    QCOMPARE(_MOCK->getItem(robot.GetID()).joints[0], 10.0);
+}
+
+// Calls recorded with StartCapture are served back by RoboDKReplay: the same calls get the same results without the mock
+void TestProtocol::captureReplay(){
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString trace_file = dir.filePath("capture.rdktrace");
+    // the same calls on the link to the mock and on the link to the replay server
+    auto calls = [](RoboDK *rdk){
+        QStringList results;
+        Item robot = rdk->getItem("Robot");
+        Item frame = rdk->getItem("Frame 1");
+        QList<Item> frames;
+        frames << frame << rdk->getItem("Frame 2") << rdk->getItem("Frame 3");
+        frame.setPose(Mat::XYZRPW_2_Mat(10, 20, 30, 40, 50, 60));
+        Item(rdk, 0xdead, RoboDK::ITEM_TYPE_FRAME).setPose(Mat::transl(1, 2, 3)); // error status
+        rdk->setPoses(frames.mid(1), QList<Mat>() << Mat::transl(1, 0, 0) << Mat::transl(0, 1, 0));
+        results << QString::number(robot.GetID()) << QString::number(frame.GetID());
+        results << robot.Joints().ToString();
+        double values[6] = {1, 2, 3, 4, 5, 6};
+        robot.setJoints(tJoints(values, 6));
+        results << robot.Joints().ToString();
+        QList<Mat> poses = rdk->Poses(frames);
+        for (int i=0; i<poses.length(); i++){
+            results << poses[i].ToString();
+        }
+        return results;
+    };
+
+    QVERIFY(_RDK->StartCapture(trace_file));
+    QStringList expected = calls(_RDK);
+    _RDK->StopCapture();
+    int commands = _MOCK->Commands();
+    QVERIFY(commands > 0);
+
+    RoboDKReplay replay;
+    QVERIFY(replay.Load(trace_file));
+    QVERIFY(replay.Commands().contains("S_Hlocals"));
+    QVERIFY(replay.Listen());
+    RoboDK rdk("127.0.0.1", replay.Port());
+    QVERIFY(rdk.Connected());
+    QStringList results = calls(&rdk);
+    QCOMPARE(results, expected);
+    QCOMPARE(replay.Mismatches(), 0);
+    // once the trace ends the server starts it again and waits for the first command
+    QTRY_COMPARE(replay.Served(), replay.Commands().length() + 1);
+    // the mock was not used
+    QCOMPARE(_MOCK->Commands(), commands);
+}
+
+// The statistics count the calls, requests and bytes of each command, and StatsJson is valid JSON with the same values
+void TestProtocol::commandStats(){
+    Item robot = _item("Robot");
+    QList<Item> frames;
+    frames << _item("Frame 1") << _item("Frame 2") << _item("Frame 3");
+    QVERIFY(!_RDK->StatsEnabled());
+    _RDK->setStats(true);
+    QVERIFY(_RDK->StatsEnabled());
+    for (int i=0; i<3; i++){
+        QCOMPARE(robot.Joints().Length(), 6);
+    }
+    double values[6] = {1, 2, 3, 4, 5, 6};
+    robot.setJoints(tJoints(values, 6));
+    robot.setJoints(tJoints(values, 6));
+    QCOMPARE(_RDK->Poses(frames).length(), 3);
+
+    // bytes of each request and response: command line, item (8), array (4 + 8 per value), pose (128) and status (4)
+    struct {
+        const char *command;
+        quint64 calls;
+        quint64 requests;
+        quint64 bytes_out;
+        quint64 bytes_in;
+    } expected[3] = {
+        { "G_Hlocal", 1, 3, 3 * (9 + 8), 3 * (128 + 4) },
+        { "G_Thetas", 3, 3, 3 * (9 + 8), 3 * (4 + 6*8 + 4) },
+        { "S_Thetas", 2, 2, 2 * (9 + 4 + 6*8 + 8), 2 * 4 }
+    };
+    QList<tCommandStats> stats = _RDK->Stats(); // sorted by command
+    QCOMPARE(stats.length(), 3);
+    for (int i=0; i<3; i++){
+        QCOMPARE(stats[i].command, QString(expected[i].command));
+        QCOMPARE(stats[i].calls, expected[i].calls);
+        QCOMPARE(stats[i].requests, expected[i].requests);
+        QCOMPARE(stats[i].bytes_out, expected[i].bytes_out);
+        QCOMPARE(stats[i].bytes_in, expected[i].bytes_in);
+        QCOMPARE(stats[i].total.Count(), expected[i].calls);
+        QCOMPARE(stats[i].wait.Count(), expected[i].calls);
+        QVERIFY(stats[i].total.Max() >= stats[i].wait.Max());
+    }
+
+    QJsonParseError error;
+    QJsonDocument json = QJsonDocument::fromJson(_RDK->StatsJson().toUtf8(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    QVERIFY(json.isArray());
+    QJsonArray commands = json.array();
+    QCOMPARE(commands.size(), 3);
+    for (int i=0; i<3; i++){
+        QJsonObject command = commands[i].toObject();
+        QCOMPARE(command.value("command").toString(), QString(expected[i].command));
+        QCOMPARE(command.value("calls").toDouble(), (double) expected[i].calls);
+        QCOMPARE(command.value("requests").toDouble(), (double) expected[i].requests);
+        QCOMPARE(command.value("bytes_out").toDouble(), (double) expected[i].bytes_out);
+        QCOMPARE(command.value("bytes_in").toDouble(), (double) expected[i].bytes_in);
+        QStringList phases;
+        phases << "send" << "wait" << "recv" << "total";
+        for (int p=0; p<phases.length(); p++){
+            QJsonObject histogram = command.value(phases[p]).toObject();
+            QVERIFY(histogram.contains("p50") && histogram.contains("p999"));
+            QVERIFY(histogram.value("min").toDouble() <= histogram.value("max").toDouble());
+        }
+        QCOMPARE(command.value("total").toObject().value("max").toDouble(), (double) stats[i].total.Max());
+    }
+
+    // nothing is collected once disabled
+    _RDK->ResetStats();
+    _RDK->setStats(false);
+    robot.Joints();
+    QVERIFY(_RDK->Stats().isEmpty());
+    QCOMPARE(QJsonDocument::fromJson(_RDK->StatsJson().toUtf8()).array().size(), 0);
+}
+
+// The tracer writes a valid Chrome trace: one event per call with its requests and bytes, the waits nested in their call, and one track per thread
+void TestProtocol::tracer(){
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString trace_file = dir.filePath("calls.json");
+    QSharedPointer<RoboDKTracer> tracer(new RoboDKTracer(trace_file));
+    QVERIFY(tracer->IsOpen());
+
+    Item robot = _item("Robot");
+    QList<Item> frames;
+    frames << _item("Frame 1") << _item("Frame 2") << _item("Frame 3");
+    _RDK->setTracer(tracer);
+    QCOMPARE(_RDK->Tracer(), tracer);
+    QCOMPARE(robot.Joints().Length(), 6);
+    frames[0].setPose(Mat::transl(1, 2, 3));
+    QCOMPARE(_RDK->Poses(frames).length(), 3);
+    _RDK->setTracer(QSharedPointer<RoboDKTracer>()); // the last call is written
+
+    // another link shares the tracer from its own thread
+    QThread *thread = QThread::create([this, tracer](){
+        RoboDK rdk("127.0.0.1", _MOCK->Port());
+        rdk.setTracer(tracer);
+        rdk.getItem("Robot").Joints();
+        rdk.setTracer(QSharedPointer<RoboDKTracer>());
+    });
+    thread->setObjectName("Worker");
+    thread->start();
+    QVERIFY(thread->wait(10000));
+    delete thread;
+    tracer->Close();
+    QVERIFY(!tracer->IsOpen());
+
+    QFile file(trace_file);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonParseError error;
+    QJsonDocument json = QJsonDocument::fromJson(file.readAll(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    QVERIFY(json.isArray());
+    QJsonArray events = json.array();
+
+    QHash<int, QString> threads;
+    QList<QJsonObject> calls;
+    QList<QJsonObject> waits;
+    for (int i=0; i<events.size(); i++){
+        QJsonObject event = events[i].toObject();
+        if (event.value("ph").toString() == "M"){
+            QCOMPARE(event.value("name").toString(), QString("thread_name"));
+            threads.insert(event.value("tid").toInt(), event.value("args").toObject().value("name").toString());
+            continue;
+        }
+        QCOMPARE(event.value("ph").toString(), QString("X"));
+        QVERIFY(threads.contains(event.value("tid").toInt())); // the name of a thread comes before its events
+        QVERIFY(event.value("dur").toDouble() >= 0);
+        if (event.value("cat").toString() == "call"){
+            calls.append(event);
+        } else {
+            QCOMPARE(event.value("cat").toString(), QString("wait"));
+            waits.append(event);
+        }
+    }
+    QCOMPARE(threads.size(), 2);
+    QCOMPARE(threads.value(2), QString("Worker"));
+
+    // calls in order, with the requests and bytes of each call (see commandStats)
+    struct {
+        const char *command;
+        int tid;
+        int requests;
+        int bytes_out;
+        int bytes_in;
+    } expected[5] = {
+        { "G_Thetas", 1, 1, 9 + 8, 4 + 6*8 + 4 },
+        { "S_Hlocal", 1, 1, 9 + 8 + 128, 4 },
+        { "G_Hlocal", 1, 3, 3 * (9 + 8), 3 * (128 + 4) },
+        { "G_Item", 2, 1, 7 + 6, 8 + 4 + 4 },
+        { "G_Thetas", 2, 1, 9 + 8, 4 + 6*8 + 4 }
+    };
+    QCOMPARE(calls.length(), 5);
+    for (int i=0; i<calls.length(); i++){
+        QJsonObject args = calls[i].value("args").toObject();
+        QCOMPARE(calls[i].value("name").toString(), QString(expected[i].command));
+        QCOMPARE(calls[i].value("tid").toInt(), expected[i].tid);
+        QCOMPARE(args.value("requests").toInt(), expected[i].requests);
+        QCOMPARE(args.value("bytes_out").toInt(), expected[i].bytes_out);
+        QCOMPARE(args.value("bytes_in").toInt(), expected[i].bytes_in);
+    }
+
+    // each wait is inside a call of its thread (1 us for the rounding of the timestamps)
+    QVERIFY(!waits.isEmpty());
+    for (int w=0; w<waits.length(); w++){
+        double start = waits[w].value("ts").toDouble();
+        double end = start + waits[w].value("dur").toDouble();
+        bool nested = false;
+        for (int c=0; c<calls.length() && !nested; c++){
+            double call_start = calls[c].value("ts").toDouble();
+            double call_end = call_start + calls[c].value("dur").toDouble();
+            nested = calls[c].value("tid").toInt() == waits[w].value("tid").toInt() && start >= call_start - 1 && end <= call_end + 1;
+        }
+        QVERIFY(nested);
+    }
+}
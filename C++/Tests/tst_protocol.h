@@ -0,0 +1,49 @@
+#ifndef TST_PROTOCOL_H
+#define TST_PROTOCOL_H
+
+#include "robodk_api.h"
+#include "robodk_mock.h"
+#include <QtCore/QObject>
+
+#ifndef RDK_SKIP_NAMESPACE
+using namespace RoboDK_API;
+#endif
+
+
+/// \brief The TestProtocol class tests the communication of the API with a RoboDKMock: requests, pipelined statuses and recovery of the link.
+class TestProtocol : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void commandWrites();
+    void pipelineErrors();
+    void setPoses();
+    void jointsList();
+    void stationIndex();
+    void stationIndexPool();
+    void motionQueue();
+    void deadlineAbort();
+    void unsupportedCommand();
+    void programBuilder();
+    void programInstructions();
+    void poolThreads();
+    void asyncChunks();
+    void asyncErrorStatus();
+    void asyncLongArray();
+    void asyncDisconnect();
+    void captureReplay();
+    void commandStats();
+    void tracer();
+
+private:
+    Item _item(const QString &name);
+
+    RoboDKMock *_MOCK;
+    RoboDK *_RDK;
+};
+
+
+#endif // TST_PROTOCOL_H
@@ -0,0 +1,140 @@
+#include "tst_transport.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+
+
+#define TEST_RING_SIZE 4096 // ring buffers of the shared memory transport (bytes): the large payloads wrap around many times
+
+
+void TestTransport::init(){
+    _MOCK = new RoboDKMock();
+    _MOCK->AddItem("Robot", RoboDK::ITEM_TYPE_ROBOT, QVector<double>(6, 10.0));
+    _MOCK->AddItem("Frame", RoboDK::ITEM_TYPE_FRAME);
+    _MOCK->AddItem("Prog", RoboDK::ITEM_TYPE_PROGRAM);
+    QVERIFY(_MOCK->Listen());
+
+    _SERVER_NAME = QString("RoboDK_API_Test_%1").arg(QCoreApplication::applicationPid());
+    _THREAD = new QThread();
+    _RELAY = new RoboDKRelay("127.0.0.1", _MOCK->Port());
+    _RELAY->moveToThread(_THREAD);
+    _THREAD->start();
+    bool listening = false;
+    QMetaObject::invokeMethod(_RELAY, [this, &listening](){ listening = _RELAY->Listen(_SERVER_NAME); }, Qt::BlockingQueuedConnection);
+    QVERIFY(listening);
+}
+
+void TestTransport::cleanup(){
+    _relay_close();
+    _THREAD->quit();
+    _THREAD->wait();
+    delete _RELAY; // the thread of the relay is finished
+    _RELAY = nullptr;
+    delete _THREAD;
+    _THREAD = nullptr;
+    delete _MOCK;
+    _MOCK = nullptr;
+}
+
+// Close the relay from its thread: the clients are disconnected
+void TestTransport::_relay_close(){
+    QMetaObject::invokeMethod(_RELAY, [this](){ _RELAY->Close(); }, Qt::BlockingQueuedConnection);
+}
+
+void TestTransport::_transports(){
+    QTest::addColumn<QString>("transport");
+    QTest::newRow("local socket") << "local";
+    QTest::newRow("shared memory") << "shared memory";
+}
+
+QSharedPointer<RoboDKTransport> TestTransport::_transport(){
+    QFETCH(QString, transport);
+    if (transport == "local"){
+        return QSharedPointer<RoboDKTransport>(new LocalTransport(_SERVER_NAME));
+    }
+    return QSharedPointer<RoboDKTransport>(new SharedMemoryTransport(TEST_RING_SIZE, _SERVER_NAME));
+}
+
+void TestTransport::roundTrip_data(){
+    _transports();
+}
+
+// Small calls go through the relay to the mock and back
+void TestTransport::roundTrip(){
+    RoboDK rdk(_transport(), "127.0.0.1", _MOCK->Port());
+    QVERIFY(rdk.Connected());
+    Item robot = rdk.getItem("Robot");
+    QVERIFY(robot.Valid());
+    tJoints joints = robot.Joints();
+    QCOMPARE(joints.Length(), 6);
+    QCOMPARE(joints.ValuesD()[0], 10.0);
+
+    Item frame = rdk.getItem("Frame");
+    Mat pose = Mat::XYZRPW_2_Mat(10, 20, 30, 40, 50, 60);
+    frame.setPose(pose);
+    Mat result = frame.Pose();
+    for (int i=0; i<16; i++){
+        QCOMPARE(result.ValuesD()[i], pose.ValuesD()[i]);
+    }
+}
+
+void TestTransport::largePayload_data(){
+    _transports();
+}
+
+// Requests and responses much larger than the ring buffers: the writer waits for the reader and the data wraps around the ring
+void TestTransport::largePayload(){
+    RoboDK rdk(_transport(), "127.0.0.1", _MOCK->Port());
+    QVERIFY(rdk.Connected());
+
+    // request: a file of 50 rings
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QByteArray data(50 * TEST_RING_SIZE + 123, 0);
+    QRandomGenerator random(30);
+    for (int i=0; i<data.size(); i++){
+        data[i] = (char) random.bounded(256);
+    }
+    QFile file(dir.filePath("large.bin"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(data), (qint64) data.size());
+    file.close();
+    QVERIFY(rdk.FileSet(file.fileName(), "large.bin", false));
+    QCOMPARE(_MOCK->Files().value("large.bin"), data);
+
+    // response: a joint list of about 60 rings
+    const int rows = 6;
+    const int cols = 5000;
+    _MOCK->setJointListSize(rows, cols);
+    Item prog = rdk.getItem("Prog");
+    QString error_msg;
+    tMatrix2D *joint_list = nullptr;
+    QCOMPARE(prog.InstructionListJoints(error_msg, &joint_list), 0);
+    QVERIFY(joint_list != nullptr);
+    QCOMPARE(Matrix2D_Get_nrows(joint_list), rows);
+    QCOMPARE(Matrix2D_Get_ncols(joint_list), cols);
+    for (int i=0; i<rows*cols; i++){
+        QCOMPARE(joint_list->data[i], i * 0.001);
+    }
+    Matrix2D_Delete(&joint_list);
+
+    // the link is still in sync
+    QCOMPARE(rdk.getItem("Robot").Joints().ValuesD()[0], 10.0);
+}
+
+void TestTransport::relayShutdown_data(){
+    _transports();
+}
+
+// The client sees that the relay is gone and does not reconnect while the relay is not listening
+void TestTransport::relayShutdown(){
+    RoboDK rdk(_transport(), "127.0.0.1", _MOCK->Port());
+    QVERIFY(rdk.Connected());
+    QCOMPARE(rdk.getItem("Robot").Joints().Length(), 6);
+    _relay_close();
+    QTRY_VERIFY(!rdk.Connected());
+    QVERIFY(!rdk.ConnectWait(100));
+}
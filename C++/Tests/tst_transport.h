@@ -0,0 +1,43 @@
+#ifndef TST_TRANSPORT_H
+#define TST_TRANSPORT_H
+
+#include "robodk_api.h"
+#include "robodk_mock.h"
+#include <QtCore/QObject>
+
+class QThread;
+
+#ifndef RDK_SKIP_NAMESPACE
+using namespace RoboDK_API;
+#endif
+
+
+/// \brief The TestTransport class tests the local socket and shared memory transports with a RoboDKRelay forwarding to a RoboDKMock.
+/// The relay runs in its own thread, like it would run next to RoboDK, so that the blocking calls of the test don't stall it.
+class TestTransport : public QObject {
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void roundTrip_data();
+    void roundTrip();
+    void largePayload_data();
+    void largePayload();
+    void relayShutdown_data();
+    void relayShutdown();
+
+private:
+    void _transports();
+    QSharedPointer<RoboDKTransport> _transport();
+    void _relay_close();
+
+    RoboDKMock *_MOCK;
+    QThread *_THREAD;
+    RoboDKRelay *_RELAY;
+    QString _SERVER_NAME;
+};
+
+
+#endif // TST_TRANSPORT_H